@@ -0,0 +1,203 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Base64.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <wx/stopwatch.h>
+
+/* The approximate number of bytes pushed through each measurement. */
+static const size_t VOLUME = 16 * 1024 * 1024;
+
+// {{{ Legacy implementation
+/* The codec as it was before the raw buffer API, for comparison. */
+namespace Legacy {
+	static char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	static char AlphabetPosition(char c) {
+		char *pos = std::strchr(alphabet, c);
+		return pos ? pos - alphabet : 0;
+	}
+
+	static void Decode(const wxString &base64, char *data) {
+		char *c = data;
+
+		for (size_t i = 0; i < base64.Length(); i += 4) {
+			wxUint32 buffer;
+			wxString slice(base64.Mid(i, 4));
+
+			buffer = AlphabetPosition(slice[0]) * 67108864 + AlphabetPosition(slice[1]) * 1048576;
+			*c++ = static_cast<char>(buffer >> 24);
+			if (slice[2] != wxT('=')) {
+				buffer += AlphabetPosition(slice[2]) * 16384;
+				*c++ = static_cast<char>(buffer >> 16);
+				if (slice[3] != wxT('=')) {
+					buffer += AlphabetPosition(slice[3]) * 256;
+					*c++ = static_cast<char>(buffer >> 8);
+				}
+			}
+		}
+	}
+
+	static wxString Encode(const char *s, size_t length) {
+		const char *ptr = s;
+		wxString enc;
+
+		for (; length >= 3 && ptr <= (s + length - 3); ptr += 3) {
+			wxUint32 bufVal = ptr[0] * 16777216 + ptr[1] * 65536 + ptr[2] * 256;
+			for (size_t i = 0; i < 4; ++i) {
+				unsigned char c = bufVal >> 26;
+				bufVal = bufVal << 6;
+				enc += alphabet[c];
+			}
+		}
+
+		if (ptr < (s + length)) {
+			char rem = (s + length) - ptr;
+			wxUint32 bufVal = ptr[0] * 16777216;
+			if (rem == 2) {
+				bufVal += ptr[1] * 65536;
+			}
+			for (char i = 0; i <= rem; i++) {
+				unsigned char c = bufVal >> 26;
+				bufVal = bufVal << 6;
+				enc += alphabet[c];
+			}
+			enc << (rem == 1 ? wxT("==") : wxT("="));
+		}
+
+		return enc;
+	}
+}
+// }}}
+
+// {{{ class Base64Bench
+class Base64Bench : public Benchmark {
+	public:
+		Base64Bench() : Benchmark(wxT("Base64")) {}
+
+		void Run() {
+			// A short string, a typical property value and a large source file.
+			RunWorkload(wxT("64b"), 64);
+			RunWorkload(wxT("4k"), 4096);
+			RunWorkload(wxT("256k"), 262144);
+		}
+
+	protected:
+		/* Reports throughput in MB/s of decoded data. */
+		void ReportRate(const wxString &metric, size_t bytes, long ms) {
+			if (ms < 1) {
+				ms = 1;
+			}
+			Report(metric, (bytes / 1048576.0) / (ms / 1000.0), wxT("MB/s"));
+		}
+
+		void RunWorkload(const wxString &name, size_t size) {
+			std::string data(size, '\0');
+			for (size_t i = 0; i < size; i++) {
+				data[i] = static_cast<char>(std::rand() % 128);
+			}
+
+			size_t iterations = VOLUME / size;
+			std::vector<char> encoded(Base64::EncodedLength(size));
+			std::vector<char> decoded(size);
+			wxString encodedString(Base64::Encode(data.data(), size));
+			Base64::Encode(data.data(), size, &encoded[0], encoded.size());
+
+			/* The legacy code is slow enough that it gets a smaller
+			 * volume to keep the run time reasonable. */
+			size_t legacyIterations = iterations / 16 + 1;
+
+			wxStopWatch legacyEncodeTimer;
+			for (size_t i = 0; i < legacyIterations; i++) {
+				Legacy::Encode(data.data(), size);
+			}
+			ReportRate(name + wxT(".legacy.encode"), legacyIterations * size, legacyEncodeTimer.Time());
+
+			wxStopWatch legacyDecodeTimer;
+			for (size_t i = 0; i < legacyIterations; i++) {
+				Legacy::Decode(encodedString, &decoded[0]);
+			}
+			ReportRate(name + wxT(".legacy.decode"), legacyIterations * size, legacyDecodeTimer.Time());
+
+			Base64::Implementation original = Base64::GetImplementation();
+			Base64::Implementation implementations[] = { Base64::SCALAR, Base64::SSE2, Base64::AVX2 };
+			const wxChar *names[] = { wxT("scalar"), wxT("sse2"), wxT("avx2") };
+
+			for (size_t impl = 0; impl < sizeof(implementations) / sizeof(implementations[0]); impl++) {
+				if (!Base64::SetImplementation(implementations[impl])) {
+					continue;
+				}
+
+				AllocationCounter stringAllocations;
+				wxStopWatch stringTimer;
+				for (size_t i = 0; i < iterations; i++) {
+					Base64::Encode(data.data(), size);
+				}
+				long stringTime = stringTimer.Time();
+				stringAllocations.Stop();
+				ReportRate(name + wxT(".") + names[impl] + wxT(".encode_string"), iterations * size, stringTime);
+				ReportAllocations(name + wxT(".") + names[impl] + wxT(".encode_string"), stringAllocations, iterations);
+
+				AllocationCounter encodeAllocations;
+				wxStopWatch encodeTimer;
+				for (size_t i = 0; i < iterations; i++) {
+					Base64::Encode(data.data(), size, &encoded[0], encoded.size());
+				}
+				long encodeTime = encodeTimer.Time();
+				encodeAllocations.Stop();
+				ReportRate(name + wxT(".") + names[impl] + wxT(".encode"), iterations * size, encodeTime);
+				ReportAllocations(name + wxT(".") + names[impl] + wxT(".encode"), encodeAllocations, iterations);
+
+				AllocationCounter decodeAllocations;
+				wxStopWatch decodeTimer;
+				for (size_t i = 0; i < iterations; i++) {
+					Base64::Decode(&encoded[0], encoded.size(), &decoded[0], decoded.size());
+				}
+				long decodeTime = decodeTimer.Time();
+				decodeAllocations.Stop();
+				ReportRate(name + wxT(".") + names[impl] + wxT(".decode"), iterations * size, decodeTime);
+				ReportAllocations(name + wxT(".") + names[impl] + wxT(".decode"), decodeAllocations, iterations);
+			}
+
+			Base64::SetImplementation(original);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(Base64Bench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,336 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+/* The running allocation totals, updated from every thread. */
+static volatile unsigned long allocationCount = 0;
+static volatile unsigned long allocationBytes = 0;
+static volatile long allocationLive = 0;
+
+// {{{ static void CountAllocation(size_t size)
+static inline void CountAllocation(size_t size) {
+#ifdef __GNUC__
+	__sync_fetch_and_add(&allocationCount, 1UL);
+	__sync_fetch_and_add(&allocationBytes, static_cast<unsigned long>(size));
+#else
+	++allocationCount;
+	allocationBytes += size;
+#endif
+}
+// }}}
+// {{{ static void CountLive(long delta)
+static inline void CountLive(long delta) {
+#ifdef __GNUC__
+	__sync_fetch_and_add(&allocationLive, delta);
+#else
+	allocationLive += delta;
+#endif
+}
+// }}}
+// {{{ static std::string JSONString(const wxString &s)
+static std::string JSONString(const wxString &s) {
+	std::string in(static_cast<const char *>(s.mb_str(wxConvUTF8)));
+	std::string out("\"");
+
+	for (std::string::const_iterator i = in.begin(); i != in.end(); i++) {
+		if (*i == '"' || *i == '\\') {
+			out += '\\';
+			out += *i;
+		}
+		else if (static_cast<unsigned char>(*i) < 0x20) {
+			char escape[8];
+			std::sprintf(escape, "\\u%04x", static_cast<unsigned int>(*i));
+			out += escape;
+		}
+		else {
+			out += *i;
+		}
+	}
+
+	return out + "\"";
+}
+// }}}
+
+// {{{ Allocation hooks
+#ifdef __GLIBC__
+/* wxString allocates its buffers with malloc() rather than operator new, as
+ * does expat, so on glibc we interpose the malloc family itself and count
+ * everything. */
+extern "C" {
+	extern void *__libc_calloc(size_t count, size_t size);
+	extern void __libc_free(void *ptr);
+	extern void *__libc_malloc(size_t size);
+	extern void *__libc_realloc(void *ptr, size_t size);
+
+	/* The memory still held is tracked by the usable size of each
+	 * block, since that's all free() can find out. */
+	void *calloc(size_t count, size_t size) throw () {
+		CountAllocation(count * size);
+
+		void *ptr = __libc_calloc(count, size);
+		if (ptr) {
+			CountLive(malloc_usable_size(ptr));
+		}
+		return ptr;
+	}
+
+	void free(void *ptr) throw () {
+		if (ptr) {
+			CountLive(-static_cast<long>(malloc_usable_size(ptr)));
+		}
+		__libc_free(ptr);
+	}
+
+	void *malloc(size_t size) throw () {
+		CountAllocation(size);
+
+		void *ptr = __libc_malloc(size);
+		if (ptr) {
+			CountLive(malloc_usable_size(ptr));
+		}
+		return ptr;
+	}
+
+	void *realloc(void *ptr, size_t size) throw () {
+		CountAllocation(size);
+
+		long old = (ptr ? static_cast<long>(malloc_usable_size(ptr)) : 0);
+		void *grown = __libc_realloc(ptr, size);
+		if (grown) {
+			CountLive(static_cast<long>(malloc_usable_size(grown)) - old);
+		}
+		else if (size == 0) {
+			CountLive(-old);
+		}
+		return grown;
+	}
+}
+#else
+/* Elsewhere only operator new is counted, which misses wxString and expat,
+ * so the figures are only comparable between runs on the same platform. */
+void *operator new(size_t size) throw (std::bad_alloc) {
+	CountAllocation(size);
+
+	void *ptr = std::malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void *operator new[](size_t size) throw (std::bad_alloc) {
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) throw () {
+	CountAllocation(size);
+	return std::malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &nt) throw () {
+	return operator new(size, nt);
+}
+
+void operator delete(void *ptr) throw () {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) throw () {
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) throw () {
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) throw () {
+	std::free(ptr);
+}
+#endif
+// }}}
+
+// {{{ AllocationCounter::AllocationCounter()
+AllocationCounter::AllocationCounter() : stoppedAllocations(0), stoppedBytes(0), stoppedLive(0) {
+	Reset();
+}
+// }}}
+
+// {{{ unsigned long AllocationCounter::GetAllocations() const
+unsigned long AllocationCounter::GetAllocations() const {
+	return (running ? allocationCount : stoppedAllocations) - allocations;
+}
+// }}}
+// {{{ unsigned long AllocationCounter::GetBytes() const
+unsigned long AllocationCounter::GetBytes() const {
+	return (running ? allocationBytes : stoppedBytes) - bytes;
+}
+// }}}
+// {{{ long AllocationCounter::GetRetainedBytes() const
+long AllocationCounter::GetRetainedBytes() const {
+	return (running ? allocationLive : stoppedLive) - live;
+}
+// }}}
+// {{{ void AllocationCounter::Reset()
+void AllocationCounter::Reset() {
+	allocations = allocationCount;
+	bytes = allocationBytes;
+	live = allocationLive;
+	running = true;
+}
+// }}}
+// {{{ void AllocationCounter::Stop()
+void AllocationCounter::Stop() {
+	stoppedAllocations = allocationCount;
+	stoppedBytes = allocationBytes;
+	stoppedLive = allocationLive;
+	running = false;
+}
+// }}}
+
+// {{{ Benchmark::Benchmark(const wxString &name)
+Benchmark::Benchmark(const wxString &name) : name(name) {
+	GetRegistry().push_back(this);
+}
+// }}}
+// {{{ Benchmark::~Benchmark()
+Benchmark::~Benchmark() {
+	GetRegistry().remove(this);
+}
+// }}}
+
+// {{{ int Benchmark::RunAll(const wxString &filter)
+int Benchmark::RunAll(const wxString &filter) {
+	int run = 0;
+	std::list<Benchmark *> &registry = GetRegistry();
+
+	for (std::list<Benchmark *>::iterator i = registry.begin(); i != registry.end(); i++) {
+		if (filter.IsEmpty() || (*i)->GetName().StartsWith(filter)) {
+			std::printf("%s\n", static_cast<const char *>((*i)->GetName().mb_str()));
+			(*i)->Run();
+			++run;
+		}
+	}
+
+	return run;
+}
+// }}}
+// {{{ bool Benchmark::WriteJSON(const wxString &file)
+bool Benchmark::WriteJSON(const wxString &file) {
+	std::FILE *fp = std::fopen(file.mb_str(wxConvFile), "w");
+	if (!fp) {
+		return false;
+	}
+
+	std::list<Result> &results = GetResults();
+	wxString current;
+	bool first = true;
+
+	std::fprintf(fp, "{\n  \"benchmarks\": [");
+	for (std::list<Result>::const_iterator i = results.begin(); i != results.end(); i++) {
+		if (first || i->benchmark != current) {
+			if (!first) {
+				std::fprintf(fp, "\n      ]\n    },");
+			}
+			std::fprintf(fp, "\n    {\n      \"name\": %s,\n      \"metrics\": [", JSONString(i->benchmark).c_str());
+			current = i->benchmark;
+			first = true;
+		}
+
+		std::fprintf(fp, "%s\n        {\"name\": %s, \"value\": %.6g, \"unit\": %s}", first ? "" : ",", JSONString(i->metric).c_str(), i->value, JSONString(i->unit).c_str());
+		first = false;
+	}
+	if (!results.empty()) {
+		std::fprintf(fp, "\n      ]\n    }");
+	}
+	std::fprintf(fp, "\n  ]\n}\n");
+
+	return (std::fclose(fp) == 0);
+}
+// }}}
+
+// {{{ void Benchmark::Report(const wxString &metric, double value, const wxString &unit)
+void Benchmark::Report(const wxString &metric, double value, const wxString &unit) {
+	Result result;
+	result.benchmark = name;
+	result.metric = metric;
+	result.unit = unit;
+	result.value = value;
+	GetResults().push_back(result);
+
+	std::printf("  %-40s %14.3f %s\n", static_cast<const char *>(metric.mb_str()), value, static_cast<const char *>(unit.mb_str()));
+}
+// }}}
+// {{{ void Benchmark::ReportAllocations(const wxString &metric, const AllocationCounter &counter, unsigned long operations)
+void Benchmark::ReportAllocations(const wxString &metric, const AllocationCounter &counter, unsigned long operations) {
+	if (operations == 0) {
+		operations = 1;
+	}
+
+	Report(metric + wxT(".allocs_per_op"), static_cast<double>(counter.GetAllocations()) / operations, wxT("allocs"));
+	Report(metric + wxT(".bytes_per_op"), static_cast<double>(counter.GetBytes()) / operations, wxT("bytes"));
+}
+// }}}
+// {{{ void Benchmark::ReportTime(const wxString &metric, long ms, unsigned long operations)
+void Benchmark::ReportTime(const wxString &metric, long ms, unsigned long operations) {
+	if (operations == 0) {
+		operations = 1;
+	}
+
+	Report(metric + wxT(".time_per_op"), ms * 1000.0 / operations, wxT("us"));
+}
+// }}}
+
+// {{{ std::list<Benchmark *> &Benchmark::GetRegistry()
+std::list<Benchmark *> &Benchmark::GetRegistry() {
+	/* A function static avoids depending on the order that static
+	 * benchmark instances are constructed in. */
+	static std::list<Benchmark *> registry;
+	return registry;
+}
+// }}}
+// {{{ std::list<Benchmark::Result> &Benchmark::GetResults()
+std::list<Benchmark::Result> &Benchmark::GetResults() {
+	static std::list<Result> results;
+	return results;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,225 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef BENCH_BENCHMARK_H
+#define BENCH_BENCHMARK_H
+
+#include <list>
+
+#include <wx/string.h>
+
+/**
+ * Counts the heap allocations made since it was constructed or last reset.
+ * Allocations are counted process wide, so nothing else should be running
+ * while a measurement is taken.
+ */
+class AllocationCounter {
+	public:
+		/** Constructs a counter starting from the current totals. */
+		AllocationCounter();
+
+		/**
+		 * Returns the number of allocations made since the counter
+		 * was started, up until it was stopped.
+		 *
+		 * @return The number of allocations.
+		 */
+		unsigned long GetAllocations() const;
+
+		/**
+		 * Returns the number of bytes requested since the counter
+		 * was started, up until it was stopped.
+		 *
+		 * @return The number of bytes.
+		 */
+		unsigned long GetBytes() const;
+
+		/**
+		 * Returns the number of bytes allocated since the counter
+		 * was started that were still allocated when it was stopped.
+		 * This is only tracked on glibc, where it's measured in
+		 * usable block sizes and so includes the allocator's
+		 * rounding; elsewhere it's always 0.
+		 *
+		 * @return The number of bytes, which can be negative if
+		 * more was freed than allocated.
+		 */
+		long GetRetainedBytes() const;
+
+		/** Restarts the counter from the current totals. */
+		void Reset();
+
+		/**
+		 * Stops the counter, so that allocations made while the
+		 * results are reported aren't included in them.
+		 */
+		void Stop();
+
+	private:
+		/** The allocation total when the counter was started. */
+		unsigned long allocations;
+
+		/** The byte total when the counter was started. */
+		unsigned long bytes;
+
+		/** The bytes still allocated when the counter was started. */
+		long live;
+
+		/** Whether the counter is still counting. */
+		bool running;
+
+		/** The allocation total when the counter was stopped. */
+		unsigned long stoppedAllocations;
+
+		/** The byte total when the counter was stopped. */
+		unsigned long stoppedBytes;
+
+		/**
+		 * The bytes still allocated when the counter was stopped.
+		 */
+		long stoppedLive;
+};
+
+/**
+ * The base class for benchmarks. Each benchmark registers itself with
+ * BENCHMARK_REGISTRATION() and reports its results as named metrics.
+ */
+class Benchmark {
+	public:
+		/**
+		 * Constructs and registers a benchmark.
+		 *
+		 * @param[in] name The name of the benchmark.
+		 */
+		Benchmark(const wxString &name);
+
+		virtual ~Benchmark();
+
+		/**
+		 * Returns the benchmark name.
+		 *
+		 * @return The name.
+		 */
+		inline const wxString &GetName() const { return name; }
+
+		/** Runs the benchmark, reporting results as it goes. */
+		virtual void Run() = 0;
+
+		/**
+		 * Runs every registered benchmark whose name starts with
+		 * the given filter.
+		 *
+		 * @param[in] filter The name prefix to match, if any.
+		 * @return The number of benchmarks run.
+		 */
+		static int RunAll(const wxString &filter = wxEmptyString);
+
+		/**
+		 * Writes every result reported so far to a file as JSON,
+		 * grouped by benchmark, so that runs can be compared.
+		 *
+		 * @param[in] file The file to write.
+		 * @return True if the file was written.
+		 */
+		static bool WriteJSON(const wxString &file);
+
+	protected:
+		/**
+		 * Reports a single result.
+		 *
+		 * @param[in] metric The name of the metric.
+		 * @param[in] value The measured value.
+		 * @param[in] unit The unit of the value.
+		 */
+		void Report(const wxString &metric, double value, const wxString &unit);
+
+		/**
+		 * Reports the allocations and bytes allocated per operation
+		 * as the metrics <metric>.allocs_per_op and
+		 * <metric>.bytes_per_op.
+		 *
+		 * @param[in] metric The prefix for the metric names.
+		 * @param[in] counter The counter covering the operations.
+		 * @param[in] operations The number of operations performed.
+		 */
+		void ReportAllocations(const wxString &metric, const AllocationCounter &counter, unsigned long operations);
+
+		/**
+		 * Reports the mean time taken per operation in microseconds
+		 * as the metric <metric>.time_per_op.
+		 *
+		 * @param[in] metric The prefix for the metric name.
+		 * @param[in] ms The total time taken in milliseconds.
+		 * @param[in] operations The number of operations performed.
+		 */
+		void ReportTime(const wxString &metric, long ms, unsigned long operations);
+
+	private:
+		/** A single reported result. */
+		class Result {
+			public:
+				/** The name of the benchmark that reported it. */
+				wxString benchmark;
+
+				/** The name of the metric. */
+				wxString metric;
+
+				/** The unit of the value. */
+				wxString unit;
+
+				/** The measured value. */
+				double value;
+		};
+
+		/** The benchmark name. */
+		wxString name;
+
+		/**
+		 * Returns the list of registered benchmarks.
+		 *
+		 * @return The registry.
+		 */
+		static std::list<Benchmark *> &GetRegistry();
+
+		/**
+		 * Returns the results reported so far, in order.
+		 *
+		 * @return The results.
+		 */
+		static std::list<Result> &GetResults();
+};
+
+/** Registers a benchmark class by creating a static instance of it. */
+#define BENCHMARK_REGISTRATION(cls) static cls cls##Instance
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
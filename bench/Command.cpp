@@ -0,0 +1,109 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Connection.h"
+#include "DBGp/MessageArguments.h"
+
+#include <string>
+
+#include <wx/stopwatch.h>
+#include <wx/strconv.h>
+
+/* The number of commands built for each measurement. */
+static const unsigned long COMMANDS = 100000;
+
+// {{{ class CommandBench
+class CommandBench : public Benchmark {
+	public:
+		CommandBench() : Benchmark(wxT("Command")) {}
+
+		void Run() {
+			DBGp::MessageArguments property;
+			property.Append(wxT("-d"), wxT("0")).Append(wxT("-c"), wxT("0")).Append(wxT("-n"), wxT("$this->items[12]")).Append(wxT("-m"), wxT("4096")).Append(wxT("-p"), wxT("0"));
+
+			DBGp::MessageArguments breakpoint;
+			breakpoint.Append(wxT("-t"), wxT("conditional")).Append(wxT("-f"), wxT("file:///var/www/app/src/Controller/IndexController.php")).Append(wxT("-n"), wxT("142"));
+
+			AllocationCounter argumentsAllocations;
+			wxStopWatch argumentsTimer;
+			for (unsigned long i = 0; i < COMMANDS; i++) {
+				property.GetArguments();
+			}
+			long argumentsTime = argumentsTimer.Time();
+			argumentsAllocations.Stop();
+			ReportTime(wxT("arguments"), argumentsTime, COMMANDS);
+			ReportAllocations(wxT("arguments"), argumentsAllocations, COMMANDS);
+
+			// A condition, and a larger eval of the sort watches send.
+			std::string condition(64, 'c');
+			std::string eval(4096, 'e');
+
+			RunWorkload(wxT("property_get"), property, NULL, 0, COMMANDS);
+			RunWorkload(wxT("breakpoint_set"), breakpoint, condition.data(), condition.length(), COMMANDS);
+			RunWorkload(wxT("eval.4k"), DBGp::MessageArguments(), eval.data(), eval.length(), COMMANDS / 10);
+		}
+
+	protected:
+		/* Builds the same command repeatedly, both on its own and
+		 * with the charset conversion SendCommand() does after it. */
+		void RunWorkload(const wxString &name, const DBGp::MessageArguments &args, const char *data, size_t dataLength, unsigned long commands) {
+			wxString command(name.BeforeFirst(wxT('.')));
+
+			AllocationCounter formatAllocations;
+			wxStopWatch formatTimer;
+			for (unsigned long i = 0; i < commands; i++) {
+				DBGp::Connection::FormatCommand(command, args, i, data, dataLength);
+			}
+			long formatTime = formatTimer.Time();
+			formatAllocations.Stop();
+			ReportTime(name + wxT(".format"), formatTime, commands);
+			ReportAllocations(name + wxT(".format"), formatAllocations, commands);
+
+			AllocationCounter sendAllocations;
+			wxStopWatch sendTimer;
+			for (unsigned long i = 0; i < commands; i++) {
+				wxString message(DBGp::Connection::FormatCommand(command, args, i, data, dataLength));
+#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
+				wxCharBuffer buffer(wxConvISO8859_1.cWX2MB(message.wc_str()));
+#endif
+			}
+			long sendTime = sendTimer.Time();
+			sendAllocations.Stop();
+			ReportTime(name + wxT(".send_buffer"), sendTime, commands);
+			ReportAllocations(name + wxT(".send_buffer"), sendAllocations, commands);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(CommandBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
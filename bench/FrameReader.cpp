@@ -0,0 +1,169 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/FrameReader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <wx/stopwatch.h>
+
+/* The number of messages pushed through each run. */
+static const int MESSAGES = 2000;
+
+// {{{ class CountingSource
+/* Hands out a fixed buffer of frames, returning at most one "segment" per
+ * read to model how much data the kernel has available at a time. Every call
+ * to Read() stands in for a recv() system call. */
+class CountingSource : public DBGp::FrameReader::Source {
+	public:
+		CountingSource(const std::string &data, size_t segment) : data(data), position(0), reads(0), segment(segment) {}
+
+		size_t Read(char *buffer, size_t length) throw (DBGp::SocketError) {
+			size_t available = data.length() - position;
+
+			if (available == 0) {
+				throw DBGp::SocketError(wxT("End of data."));
+			}
+
+			if (available > segment) {
+				available = segment;
+			}
+			if (available > length) {
+				available = length;
+			}
+
+			std::memcpy(buffer, data.data() + position, available);
+			position += available;
+			++reads;
+
+			return available;
+		}
+
+		inline unsigned long GetReads() const { return reads; }
+
+	private:
+		const std::string &data;
+		size_t position;
+		unsigned long reads;
+		size_t segment;
+};
+// }}}
+
+// {{{ class FrameReaderBench
+class FrameReaderBench : public Benchmark {
+	public:
+		FrameReaderBench() : Benchmark(wxT("FrameReader")) {}
+
+		void Run() {
+			RunWorkload(wxT("status"), 180, 1448);
+			RunWorkload(wxT("context_get"), 4096, 1448);
+			RunWorkload(wxT("context_get.bulk"), 4096, 65536);
+			RunWorkload(wxT("property_get"), 262144, 65536);
+
+			/* A stream packet and a response arriving together:
+			 * two 185 byte frames available per wakeup. */
+			RunWorkload(wxT("stream+response"), 180, 370);
+		}
+
+	protected:
+		/* Builds the data for MESSAGES frames of the given payload
+		 * size, then reads it back both the way GetMessage() used to
+		 * and through FrameReader. The segment is the most data
+		 * available to any one read. */
+		void RunWorkload(const wxString &name, size_t payloadSize, size_t segment) {
+			std::string payload(payloadSize, 'x');
+			std::string data;
+			char length[32];
+
+			std::sprintf(length, "%lu", static_cast<unsigned long>(payloadSize));
+			for (int i = 0; i < MESSAGES; i++) {
+				data.append(length);
+				data.push_back('\0');
+				data.append(payload);
+				data.push_back('\0');
+			}
+
+			wxStopWatch legacyTimer;
+			CountingSource legacy(data, segment);
+			for (int i = 0; i < MESSAGES; i++) {
+				ReadLegacy(legacy);
+			}
+			long legacyTime = legacyTimer.Time();
+
+			wxStopWatch bufferedTimer;
+			CountingSource buffered(data, segment);
+			DBGp::FrameReader reader;
+			const char *frame;
+			size_t frameLength;
+			for (int i = 0; i < MESSAGES; i++) {
+				while (!reader.NextFrame(frame, frameLength)) {
+					reader.Fill(buffered);
+				}
+			}
+			long bufferedTime = bufferedTimer.Time();
+
+			Report(name + wxT(".legacy.reads_per_message"), static_cast<double>(legacy.GetReads()) / MESSAGES, wxT("reads"));
+			Report(name + wxT(".buffered.reads_per_message"), static_cast<double>(buffered.GetReads()) / MESSAGES, wxT("reads"));
+			Report(name + wxT(".legacy.time_per_message"), legacyTime * 1000.0 / MESSAGES, wxT("us"));
+			Report(name + wxT(".buffered.time_per_message"), bufferedTime * 1000.0 / MESSAGES, wxT("us"));
+		}
+
+		/* The read pattern of the old Connection::GetMessage(): the
+		 * length a byte at a time, then the payload, then the NULL. */
+		void ReadLegacy(CountingSource &source) {
+			std::string lengthBuffer;
+			char c;
+
+			source.Read(&c, 1);
+			while (c != 0) {
+				lengthBuffer += c;
+				source.Read(&c, 1);
+			}
+
+			size_t length = std::strtoul(lengthBuffer.c_str(), NULL, 10);
+			std::vector<char> message(length + 1);
+			size_t read = 0;
+			while (read < length) {
+				read += source.Read(&message[read], length - read);
+			}
+			source.Read(&message[length], 1);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(FrameReaderBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
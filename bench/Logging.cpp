@@ -0,0 +1,128 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+/* Model a release build, whatever this one is. */
+#define DBGP_LOG_LEVEL 0
+
+#include "Benchmark.h"
+#include "DBGp/Log.h"
+#include "DBGp/ProtocolLog.h"
+
+#include <string>
+
+#include <wx/mstream.h>
+#include <wx/sstream.h>
+#include <wx/stopwatch.h>
+#include <wx/strconv.h>
+#include <wx/xml/xml.h>
+
+/* The number of messages handled in each run. */
+static const int MESSAGES = 200;
+
+// {{{ static std::string BuildResponse(size_t properties)
+/* Builds a context_get response with the given number of Base64 encoded
+ * string properties, which is about as large as responses usually get. */
+static std::string BuildResponse(size_t properties) {
+	std::string response("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"context_get\" transaction_id=\"1\" context=\"0\">");
+
+	for (size_t i = 0; i < properties; i++) {
+		response += "<property name=\"$value\" fullname=\"$value\" type=\"string\" size=\"48\" encoding=\"base64\"><![CDATA[VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZy4uLi4=]]></property>";
+	}
+	response += "</response>";
+
+	return response;
+}
+// }}}
+
+// {{{ class LoggingBench
+class LoggingBench : public Benchmark {
+	public:
+		LoggingBench() : Benchmark(wxT("Logging")) {}
+
+		void Run() {
+			RunWorkload(wxT("status"), 0);
+			RunWorkload(wxT("context_get"), 50);
+			RunWorkload(wxT("context_get.large"), 2000);
+		}
+
+	protected:
+		/* Measures the logging done for each received message: first
+		 * the conversions the connection used to do unconditionally,
+		 * then the compiled out macros, then the sampled protocol log
+		 * recording one message in sixteen. */
+		void RunWorkload(const wxString &name, size_t properties) {
+			std::string payload(BuildResponse(properties));
+			wxMemoryInputStream is(payload.data(), payload.length());
+			wxXmlDocument doc;
+			wxMBConv *conv = &wxConvISO8859_1;
+			size_t sink = 0;
+
+			doc.Load(is);
+
+			wxStopWatch eagerTimer;
+			for (int i = 0; i < MESSAGES; i++) {
+				wxString rx(payload.data(), *conv, payload.length());
+				wxStringOutputStream os;
+				doc.Save(os);
+				sink += rx.length() + os.GetString().length();
+			}
+			long eagerTime = eagerTimer.Time();
+
+			wxStopWatch lazyTimer;
+			for (int i = 0; i < MESSAGES; i++) {
+				DBGp::ProtocolLog::Record(this, DBGp::ProtocolLog::RECEIVED, payload.data(), payload.length());
+				DBGP_LOG_PROTOCOL((wxT("RX(%lu): %s"), (unsigned long) payload.length(), DBGp::LogPayload(payload.data(), payload.length(), conv).Format().c_str()));
+				DBGP_LOG_PROTOCOL((wxT("Decoded XML: %s"), DBGp::LogDocument(doc).Format().c_str()));
+			}
+			long lazyTime = lazyTimer.Time();
+
+			DBGp::ProtocolLog::Enable(16);
+			wxStopWatch sampledTimer;
+			for (int i = 0; i < MESSAGES; i++) {
+				DBGp::ProtocolLog::Record(this, DBGp::ProtocolLog::RECEIVED, payload.data(), payload.length());
+			}
+			long sampledTime = sampledTimer.Time();
+			DBGp::ProtocolLog::Disable();
+
+			Report(name + wxT(".bytes"), static_cast<double>(payload.length()), wxT("bytes"));
+			Report(name + wxT(".eager.time_per_message"), eagerTime * 1000.0 / MESSAGES, wxT("us"));
+			Report(name + wxT(".compiled_out.time_per_message"), lazyTime * 1000.0 / MESSAGES, wxT("us"));
+			Report(name + wxT(".sampled.time_per_message"), sampledTime * 1000.0 / MESSAGES, wxT("us"));
+
+			// Keeps the eager conversions from being optimised away.
+			Report(name + wxT(".eager.characters"), static_cast<double>(sink) / MESSAGES, wxT("chars"));
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(LoggingBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
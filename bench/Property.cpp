@@ -0,0 +1,389 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Base64.h"
+#include "DBGp/Connection.h"
+#include "DBGp/Context.h"
+#include "DBGp/Property.h"
+#include "DBGp/PropertyBuilder.h"
+#include "DBGp/ResponseParser.h"
+#include "DBGp/Server.h"
+#include "DBGp/StackLevel.h"
+
+#include <cstdio>
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <wx/socket.h>
+#include <wx/stopwatch.h>
+#include <wx/strconv.h>
+#include <wx/xml/xml.h>
+
+/* The shape of each context: this many variables, each an array or object
+ * nested this deep with this many children at each level. That's a little
+ * over 50,000 properties per context. */
+static const unsigned int FAN_OUT = 16;
+static const unsigned int NESTING = 2;
+static const unsigned int VARIABLES = 184;
+
+// {{{ static void AppendProperty(std::string &xml, const std::string &name, const std::string &fullName, unsigned int nesting, bool mapped)
+/* Appends a property in the form Xdebug sends it, along with its children
+ * down to the given nesting level. Unmapped properties use types that
+ * aren't in the typemap, as engines that report class names or
+ * uninitialized values as types do. */
+static void AppendProperty(std::string &xml, const std::string &name, const std::string &fullName, unsigned int nesting, bool mapped) {
+	if (nesting == 0) {
+		std::string value("value of " + fullName);
+		char size[32];
+
+		std::sprintf(size, "%lu", static_cast<unsigned long>(value.length()));
+		xml += "<property name=\"" + name + "\" fullname=\"" + fullName + "\" type=\"" + (mapped ? "string" : "uninitialized") + "\" constant=\"0\" children=\"0\" size=\"" + size + "\" encoding=\"base64\"><![CDATA[";
+		xml += static_cast<const char *>(Base64::Encode(value.data(), value.length()).mb_str(wxConvISO8859_1));
+		xml += "]]></property>";
+		return;
+	}
+
+	// Alternate between arrays and objects on the way down.
+	bool object = (nesting % 2 == 0);
+	char count[32];
+
+	std::sprintf(count, "%u", FAN_OUT);
+	xml += "<property name=\"" + name + "\" fullname=\"" + fullName + "\" type=\"" + (object ? (mapped ? "object\" classname=\"Entity" : "Entity\" classname=\"Entity") : (mapped ? "array" : "list")) + "\" constant=\"0\" children=\"1\" numchildren=\"" + count + "\" page=\"0\" pagesize=\"" + count + "\">";
+
+	for (unsigned int i = 0; i < FAN_OUT; i++) {
+		char child[32];
+		std::sprintf(child, object ? "prop%u" : "%u", i);
+		AppendProperty(xml, child, fullName + (object ? "-&gt;" : "[") + child + (object ? "" : "]"), nesting - 1, mapped);
+	}
+
+	xml += "</property>";
+}
+// }}}
+
+// {{{ class CannedConnection
+/* A connection that answers every command from a fixed set of responses,
+ * parsing them exactly as it would if they'd been read from a socket. */
+class CannedConnection : public DBGp::Connection {
+	public:
+		CannedConnection(DBGp::Server *server) : DBGp::Connection(new wxSocketClient, server) {
+			typemap.AddType(DBGp::Type(DBGp::Type::BOOL, wxT("bool"), wxT("xsd:boolean")));
+			typemap.AddType(DBGp::Type(DBGp::Type::INT, wxT("int"), wxT("xsd:decimal")));
+			typemap.AddType(DBGp::Type(DBGp::Type::FLOAT, wxT("float"), wxT("xsd:double")));
+			typemap.AddType(DBGp::Type(DBGp::Type::STRING, wxT("string"), wxT("xsd:string")));
+			typemap.AddType(DBGp::Type(DBGp::Type::NULLTYPE, wxT("null"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::HASH, wxT("array"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::OBJECT, wxT("object"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::RESOURCE, wxT("resource"), wxEmptyString));
+		}
+
+		/* Sets the body of the response to send for a command. */
+		void SetResponse(const wxString &command, const std::string &body) {
+			responses[command] = body;
+		}
+
+	protected:
+		typedef std::list<std::pair<DBGp::TransactionID, wxString> > PendingList;
+
+		PendingList pending;
+		std::map<wxString, std::string> responses;
+
+		wxXmlDocument GetMessage() throw (DBGp::MalformedDocumentError, DBGp::SocketError, DBGp::SocketDestroyedError) {
+			if (pending.empty()) {
+				throw DBGp::SocketError(wxSOCKET_IOERR);
+			}
+
+			std::string command(static_cast<const char *>(pending.front().second.mb_str(wxConvISO8859_1)));
+			char id[32];
+
+			std::sprintf(id, "%lu", pending.front().first);
+			std::string payload("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"" + command + "\" transaction_id=\"" + id + "\">");
+			payload += responses[pending.front().second];
+			payload += "</response>";
+			pending.pop_front();
+
+			return ParseMessage(payload.c_str(), payload.length());
+		}
+
+		DBGp::TransactionID SendCommand(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::SocketError, DBGp::SocketDestroyedError) {
+			DBGp::TransactionID id = GetTransactionID();
+			pending.push_back(std::make_pair(id, command));
+			return id;
+		}
+};
+// }}}
+
+// {{{ class PropertyBench
+class PropertyBench : public Benchmark {
+	public:
+		PropertyBench() : Benchmark(wxT("Property")) {}
+
+		void Run() {
+			std::string properties, unmapped;
+			for (unsigned int i = 0; i < VARIABLES; i++) {
+				char name[32];
+				std::sprintf(name, "$var%u", i);
+				AppendProperty(properties, name, name, NESTING, true);
+				AppendProperty(unmapped, name, name, NESTING, false);
+			}
+
+			// Any free port will do: nothing ever connects to it.
+			DBGp::Server server(0);
+			CannedConnection *conn = new CannedConnection(&server);
+			conn->SetResponse(wxT("context_names"), "<context name=\"Locals\" id=\"0\"/><context name=\"Superglobals\" id=\"1\"/>");
+			conn->SetResponse(wxT("context_get"), properties);
+
+			std::string header("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"context_get\" transaction_id=\"1\" context=\"0\">");
+			std::string payload(header + properties + "</response>");
+			MeasureBuilder(conn, payload, wxT("context_get.build"));
+			MeasureBuilder(conn, header + unmapped + "</response>", wxT("context_get.build_unmapped"));
+			MeasureMemory(conn, payload);
+
+			wxXmlNode stack(wxXML_ELEMENT_NODE, wxT("stack"));
+			stack.AddProperty(wxT("level"), wxT("0"));
+			stack.AddProperty(wxT("type"), wxT("file"));
+			stack.AddProperty(wxT("filename"), wxT("file:///var/www/app/index.php"));
+			stack.AddProperty(wxT("lineno"), wxT("42"));
+
+			MeasureRetrieval(conn, &stack);
+			MeasureCopies(conn, &stack);
+			MeasureLookups(conn, &stack);
+
+			delete conn;
+		}
+
+	protected:
+		/* Holds every property in a context the way the properties
+		 * panel does, once for each tree item, then lets them all go
+		 * again. */
+		void HoldProperties(const DBGp::Property::PropertyMap &properties) {
+			std::vector<DBGp::Property *> items;
+			std::vector<DBGp::Property *> pending;
+
+			for (DBGp::Property::PropertyMap::const_iterator i = properties.begin(); i != properties.end(); i++) {
+				pending.push_back(i->second);
+			}
+
+			while (!pending.empty()) {
+				DBGp::Property *prop = pending.back();
+				pending.pop_back();
+
+				prop->Ref();
+				items.push_back(prop);
+
+				for (size_t i = 0; i < prop->GetChildCount(); i++) {
+					pending.push_back(prop->GetChildAt(i));
+				}
+			}
+
+			for (std::vector<DBGp::Property *>::iterator i = items.begin(); i != items.end(); i++) {
+				(*i)->Unref();
+			}
+		}
+
+		/* Streams a context_get response straight into properties, as
+		 * the connection does for every frame the user looks at. The
+		 * time includes freeing the properties again. */
+		void MeasureBuilder(DBGp::Connection *conn, const std::string &payload, const wxString &metric) {
+			const unsigned long runs = 20;
+			DBGp::ResponseParser parser(&wxConvISO8859_1);
+
+			AllocationCounter allocations;
+			wxStopWatch timer;
+			for (unsigned long i = 0; i < runs; i++) {
+				DBGp::Property::PropertyMap properties;
+				DBGp::PropertyBuilder builder(conn, NULL, 0, properties);
+				parser.Parse(payload.data(), payload.length(), builder);
+
+				for (DBGp::Property::PropertyMap::iterator j = properties.begin(); j != properties.end(); j++) {
+					j->second->Unref();
+				}
+			}
+			long ms = timer.Time();
+			allocations.Stop();
+
+			ReportTime(metric, ms, runs);
+			ReportAllocations(metric, allocations, runs);
+		}
+
+		/* Copies a large property, a context full of them and a whole
+		 * stack level, all of which share their properties with the
+		 * original, and holds a context's worth of properties. */
+		void MeasureCopies(DBGp::Connection *conn, wxXmlNode *stack) {
+			DBGp::StackLevel level(conn, stack);
+			level.RetrieveProperties();
+
+			DBGp::Context *context = level.GetContexts().begin()->second;
+			DBGp::Property *property = context->GetProperties().begin()->second;
+
+			const unsigned long propertyRuns = 2000;
+			AllocationCounter propertyAllocations;
+			wxStopWatch propertyTimer;
+			for (unsigned long i = 0; i < propertyRuns; i++) {
+				DBGp::Property copy(*property);
+			}
+			long propertyTime = propertyTimer.Time();
+			propertyAllocations.Stop();
+			ReportTime(wxT("copy.property"), propertyTime, propertyRuns);
+			ReportAllocations(wxT("copy.property"), propertyAllocations, propertyRuns);
+
+			const unsigned long contextRuns = 20;
+			AllocationCounter contextAllocations;
+			wxStopWatch contextTimer;
+			for (unsigned long i = 0; i < contextRuns; i++) {
+				DBGp::Context copy(*context);
+			}
+			long contextTime = contextTimer.Time();
+			contextAllocations.Stop();
+			ReportTime(wxT("copy.context"), contextTime, contextRuns);
+			ReportAllocations(wxT("copy.context"), contextAllocations, contextRuns);
+
+			const unsigned long levelRuns = 10;
+			AllocationCounter levelAllocations;
+			wxStopWatch levelTimer;
+			for (unsigned long i = 0; i < levelRuns; i++) {
+				DBGp::StackLevel copy(level);
+			}
+			long levelTime = levelTimer.Time();
+			levelAllocations.Stop();
+			ReportTime(wxT("copy.stack_level"), levelTime, levelRuns);
+			ReportAllocations(wxT("copy.stack_level"), levelAllocations, levelRuns);
+
+			const unsigned long panelRuns = 10;
+			AllocationCounter panelAllocations;
+			wxStopWatch panelTimer;
+			for (unsigned long i = 0; i < panelRuns; i++) {
+				HoldProperties(context->GetProperties());
+			}
+			long panelTime = panelTimer.Time();
+			panelAllocations.Stop();
+			ReportTime(wxT("panel.hold_context"), panelTime, panelRuns);
+			ReportAllocations(wxT("panel.hold_context"), panelAllocations, panelRuns);
+		}
+
+		/* Looks up variables and their children by name the way hover
+		 * does, half of them misses. */
+		void MeasureLookups(DBGp::Connection *conn, wxXmlNode *stack) {
+			DBGp::StackLevel level(conn, stack);
+			level.RetrieveProperties();
+			const DBGp::Context *context = level.GetContexts().begin()->second;
+
+			const unsigned long runs = 1000000;
+			const wxString names[] = { wxT("$var7"), wxT("$missing"), wxT("$var150"), wxT("$this") };
+			const wxString children[] = { wxT("prop3"), wxT("3"), wxT("prop12"), wxT("missing") };
+			DBGp::Property *prop = context->FindProperty(names[0]);
+
+			AllocationCounter propertyAllocations;
+			wxStopWatch propertyTimer;
+			for (unsigned long i = 0; i < runs; i++) {
+				context->FindProperty(names[i % 4]);
+			}
+			long propertyTime = propertyTimer.Time();
+			propertyAllocations.Stop();
+			ReportTime(wxT("lookup.find_property"), propertyTime, runs);
+			ReportAllocations(wxT("lookup.find_property"), propertyAllocations, runs);
+
+			AllocationCounter childAllocations;
+			wxStopWatch childTimer;
+			for (unsigned long i = 0; i < runs; i++) {
+				prop->FindChild(children[i % 4]);
+			}
+			long childTime = childTimer.Time();
+			childAllocations.Stop();
+			ReportTime(wxT("lookup.find_child"), childTime, runs);
+			ReportAllocations(wxT("lookup.find_child"), childAllocations, runs);
+
+			// Hovers resolve full names through the whole frame.
+			const wxString fullNames[] = { wxT("$var7->prop3"), wxT("$missing"), wxT("$var150[3]"), wxT("$var7") };
+
+			AllocationCounter fullNameAllocations;
+			wxStopWatch fullNameTimer;
+			for (unsigned long i = 0; i < runs; i++) {
+				level.FindProperty(fullNames[i % 4]);
+			}
+			long fullNameTime = fullNameTimer.Time();
+			fullNameAllocations.Stop();
+			ReportTime(wxT("lookup.find_full_name"), fullNameTime, runs);
+			ReportAllocations(wxT("lookup.find_full_name"), fullNameAllocations, runs);
+		}
+
+		/* Builds a context's properties once and reports the memory
+		 * they hold on to once the response has been parsed. */
+		void MeasureMemory(DBGp::Connection *conn, const std::string &payload) {
+			unsigned long count = 0;
+			unsigned long level = VARIABLES;
+			for (unsigned int i = 0; i <= NESTING; i++) {
+				count += level;
+				level *= FAN_OUT;
+			}
+
+			DBGp::Property::PropertyMap properties;
+			AllocationCounter allocations;
+			{
+				DBGp::ResponseParser parser(&wxConvISO8859_1);
+				DBGp::PropertyBuilder builder(conn, NULL, 0, properties);
+				parser.Parse(payload.data(), payload.length(), builder);
+			}
+			allocations.Stop();
+
+			Report(wxT("context_get.retained_per_property"), static_cast<double>(allocations.GetRetainedBytes()) / count, wxT("bytes"));
+
+			for (DBGp::Property::PropertyMap::iterator i = properties.begin(); i != properties.end(); i++) {
+				i->second->Unref();
+			}
+		}
+
+		/* Retrieves every context of a fresh stack level through the
+		 * connection: context_names, then the pipelined context_gets. */
+		void MeasureRetrieval(DBGp::Connection *conn, wxXmlNode *stack) {
+			const unsigned long runs = 10;
+
+			AllocationCounter allocations;
+			wxStopWatch timer;
+			for (unsigned long i = 0; i < runs; i++) {
+				DBGp::StackLevel level(conn, stack);
+				level.RetrieveProperties();
+			}
+			long ms = timer.Time();
+			allocations.Stop();
+
+			ReportTime(wxT("stack_level.retrieve"), ms, runs);
+			ReportAllocations(wxT("stack_level.retrieve"), allocations, runs);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(PropertyBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,268 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Reactor.h"
+#include "DBGp/ReactorSession.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <wx/init.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+/* The number of simulated engines held open at once. */
+static const int SESSIONS = 1000;
+
+/* How long to wait for every session to be set up, in milliseconds. */
+static const int TIMEOUT = 30000;
+
+// {{{ static double Now()
+/* Returns a monotonic timestamp in milliseconds. */
+static double Now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+// }}}
+// {{{ static long ResidentBytes()
+static long ResidentBytes() {
+	long size = 0, resident = 0;
+	FILE *statm = std::fopen("/proc/self/statm", "r");
+
+	if (statm) {
+		if (std::fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+			resident = 0;
+		}
+		std::fclose(statm);
+	}
+	return resident * sysconf(_SC_PAGESIZE);
+}
+// }}}
+
+// {{{ class LoadHandler
+/* Records when each simulated engine's init packet reaches the handler. The
+ * engines identify themselves by using their index as the IDE key. */
+class LoadHandler : public DBGp::Reactor::Handler {
+	public:
+		LoadHandler(int sessions) : closed(0), initialised(0), ready(sessions, 0.0) {}
+
+		void OnSessionClosed(DBGp::ReactorSession *session) throw () {
+			wxMutexLocker lock(mutex);
+			closed++;
+		}
+
+		void OnSessionInit(DBGp::ReactorSession *session, wxXmlDocument &init) throw () {
+			double now = Now();
+			unsigned long index;
+
+			if (session->GetIDEKey().ToULong(&index) && index < ready.size()) {
+				wxMutexLocker lock(mutex);
+				ready[index] = now;
+				initialised++;
+			}
+		}
+
+		int GetClosed() { wxMutexLocker lock(mutex); return closed; }
+		int GetInitialised() { wxMutexLocker lock(mutex); return initialised; }
+		std::vector<double> GetReady() { wxMutexLocker lock(mutex); return ready; }
+
+	private:
+		int closed;
+		int initialised;
+		wxMutex mutex;
+		std::vector<double> ready;
+};
+// }}}
+
+// {{{ class ReactorBench
+class ReactorBench : public Benchmark {
+	public:
+		ReactorBench() : Benchmark(wxT("Reactor")) {}
+
+		void Run() {
+			wxInitializer init;
+			int sessions = RaiseDescriptorLimit();
+
+			if (sessions < SESSIONS) {
+				std::fprintf(stderr, "Only %d sessions fit in the file descriptor limit.\n", sessions);
+			}
+
+			LoadHandler handler(sessions);
+			DBGp::Reactor reactor(&handler);
+			try {
+				reactor.Start(0, true);
+			}
+			catch (DBGp::SocketError e) {
+				std::fprintf(stderr, "Unable to start the reactor: %s\n", static_cast<const char *>(e.GetMessage().mb_str()));
+				return;
+			}
+
+			long baseline = ResidentBytes();
+			std::vector<double> started(sessions);
+			std::vector<int> engines;
+			double begin = Now();
+
+			for (int i = 0; i < sessions; i++) {
+				started[i] = Now();
+
+				int fd = Connect(reactor.GetPort());
+				if (fd == -1) {
+					std::fprintf(stderr, "Connection %d failed.\n", i);
+					break;
+				}
+				engines.push_back(fd);
+				SendInit(fd, i);
+			}
+
+			int expected = static_cast<int>(engines.size());
+			for (int waited = 0; waited < TIMEOUT && handler.GetInitialised() < expected; waited += 10) {
+				wxMilliSleep(10);
+			}
+			double setup = Now() - begin;
+			long resident = ResidentBytes();
+
+			/* Latency runs from connect() to the init packet
+			 * reaching the handler, so it covers accepting, reading
+			 * and parsing. */
+			std::vector<double> ready(handler.GetReady());
+			std::vector<double> latencies;
+			for (int i = 0; i < expected; i++) {
+				if (ready[i] > 0.0) {
+					latencies.push_back(ready[i] - started[i]);
+				}
+			}
+			std::sort(latencies.begin(), latencies.end());
+
+			Report(wxT("sessions.held"), static_cast<double>(reactor.GetSessionCount()), wxT("sessions"));
+			Report(wxT("sessions.initialised"), static_cast<double>(latencies.size()), wxT("sessions"));
+			Report(wxT("setup.total_time"), setup, wxT("ms"));
+			Report(wxT("setup.rate"), latencies.size() * 1000.0 / setup, wxT("sessions/s"));
+			if (!latencies.empty()) {
+				double total = 0.0;
+				for (std::vector<double>::const_iterator i = latencies.begin(); i != latencies.end(); i++) {
+					total += *i;
+				}
+
+				Report(wxT("accept_latency.mean"), total * 1000.0 / latencies.size(), wxT("us"));
+				Report(wxT("accept_latency.p50"), latencies[latencies.size() / 2] * 1000.0, wxT("us"));
+				Report(wxT("accept_latency.p99"), latencies[latencies.size() * 99 / 100] * 1000.0, wxT("us"));
+				Report(wxT("accept_latency.max"), latencies.back() * 1000.0, wxT("us"));
+			}
+
+			/* This includes the client side of each connection,
+			 * which is a few bytes of bookkeeping here; the socket
+			 * buffers themselves live in the kernel. */
+			if (expected > 0) {
+				Report(wxT("memory.resident_per_session"), static_cast<double>(resident - baseline) / expected, wxT("bytes"));
+			}
+			Report(wxT("memory.session_object"), static_cast<double>(sizeof(DBGp::ReactorSession)), wxT("bytes"));
+
+			double teardown = Now();
+			for (std::vector<int>::const_iterator i = engines.begin(); i != engines.end(); i++) {
+				close(*i);
+			}
+			for (int waited = 0; waited < TIMEOUT && handler.GetClosed() < expected; waited += 10) {
+				wxMilliSleep(10);
+			}
+			Report(wxT("teardown.total_time"), Now() - teardown, wxT("ms"));
+		}
+
+	protected:
+		/* Opens a blocking connection to the reactor, returning -1 on
+		 * failure. */
+		int Connect(wxUint16 port) {
+			struct sockaddr_in addr;
+			int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+			if (fd == -1) {
+				return -1;
+			}
+
+			std::memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = htons(port);
+
+			if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+				close(fd);
+				return -1;
+			}
+			return fd;
+		}
+
+		/* Each simulated engine needs a descriptor at each end, so
+		 * raise the soft limit as far as it'll go and work out how
+		 * many sessions fit. */
+		int RaiseDescriptorLimit() {
+			struct rlimit limit;
+
+			if (getrlimit(RLIMIT_NOFILE, &limit) == -1) {
+				return SESSIONS;
+			}
+
+			limit.rlim_cur = limit.rlim_max;
+			setrlimit(RLIMIT_NOFILE, &limit);
+			getrlimit(RLIMIT_NOFILE, &limit);
+
+			// Leave some headroom for everything else.
+			if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= static_cast<rlim_t>(SESSIONS * 2 + 64)) {
+				return SESSIONS;
+			}
+			return static_cast<int>((limit.rlim_cur - 64) / 2);
+		}
+
+		void SendInit(int fd, int index) {
+			char payload[512], frame[544];
+			int payloadLength = std::sprintf(payload, "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<init xmlns=\"urn:debugger_protocol_v1\" appid=\"%d\" idekey=\"%d\" language=\"PHP\" protocol_version=\"1.0\" fileuri=\"file:///var/www/index.php\"/>", index, index);
+			int headerLength = std::sprintf(frame, "%d", payloadLength) + 1;
+
+			std::memcpy(frame + headerLength, payload, payloadLength + 1);
+			send(fd, frame, headerLength + payloadLength + 1, 0);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(ReactorBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
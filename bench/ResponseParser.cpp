@@ -0,0 +1,111 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Base64.h"
+#include "DBGp/ResponseParser.h"
+
+#include <cstdlib>
+#include <string>
+
+#include <wx/stopwatch.h>
+#include <wx/strconv.h>
+
+/* The approximate number of decoded bytes pushed through each
+ * measurement. */
+static const size_t VOLUME = 16 * 1024 * 1024;
+
+// {{{ class NullHandler
+/* Accepts the parsed elements and throws them away, so the parser and
+ * decoder are all that's measured. */
+class NullHandler : public DBGp::ResponseParser::Handler {
+	public:
+		void OnStartElement(const wxString &name, const DBGp::ResponseParser::Attributes &attributes) throw (DBGp::Error) {}
+		void OnEndElement(const wxString &name, const wxString &content) throw (DBGp::Error) {}
+};
+// }}}
+
+// {{{ class ResponseParserBench
+class ResponseParserBench : public Benchmark {
+	public:
+		ResponseParserBench() : Benchmark(wxT("ResponseParser")) {}
+
+		void Run() {
+			// Output a line at a time, a chunk of a page and a large dump.
+			RunWorkload(wxT("stream.64b"), 64);
+			RunWorkload(wxT("stream.4k"), 4096);
+			RunWorkload(wxT("stream.256k"), 262144);
+		}
+
+	protected:
+		/* Parses the same stream packet repeatedly, once with its
+		 * content Base64 encoded as engines send it and once as plain
+		 * text for comparison. */
+		void RunWorkload(const wxString &name, size_t size) {
+			std::string data(size, '\0');
+			for (size_t i = 0; i < size; i++) {
+				data[i] = static_cast<char>('a' + std::rand() % 26);
+			}
+
+			std::string header("<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n<stream type=\"stdout\"");
+			std::string encoded(header + " encoding=\"base64\"><![CDATA[" + static_cast<const char *>(Base64::Encode(data.data(), size).mb_str(wxConvISO8859_1)) + "]]></stream>");
+			std::string raw(header + "><![CDATA[" + data + "]]></stream>");
+
+			Measure(name + wxT(".base64"), encoded, size);
+			Measure(name + wxT(".raw"), raw, size);
+		}
+
+		void Measure(const wxString &name, const std::string &payload, size_t size) {
+			DBGp::ResponseParser parser(&wxConvISO8859_1);
+			NullHandler handler;
+			unsigned long messages = VOLUME / size;
+
+			AllocationCounter allocations;
+			wxStopWatch timer;
+			for (unsigned long i = 0; i < messages; i++) {
+				parser.Parse(payload.data(), payload.length(), handler);
+			}
+			long ms = timer.Time();
+			allocations.Stop();
+
+			if (ms < 1) {
+				ms = 1;
+			}
+			Report(name + wxT(".rate"), (messages * size / 1048576.0) / (ms / 1000.0), wxT("MB/s"));
+			ReportTime(name, ms, messages);
+			ReportAllocations(name, allocations, messages);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(ResponseParserBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,70 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+
+#include <cstdio>
+
+#include <wx/log.h>
+#include <wx/string.h>
+
+int main(int argc, char **argv) {
+	// Keep debug logging from the library out of the results.
+	wxLog::SetActiveTarget((wxLog *) new wxLogNull);
+
+	wxString filter, json;
+	for (int i = 1; i < argc; i++) {
+		wxString arg(argv[i], wxConvLibc);
+
+		if (arg.StartsWith(wxT("--json="), &json)) {
+			continue;
+		}
+		else if (arg.StartsWith(wxT("-"))) {
+			std::fprintf(stderr, "Usage: %s [--json=FILE] [FILTER]\n", argv[0]);
+			return 1;
+		}
+		filter = arg;
+	}
+
+	if (Benchmark::RunAll(filter) == 0) {
+		std::fprintf(stderr, "No benchmarks matched.\n");
+		return 1;
+	}
+
+	if (!json.IsEmpty() && !Benchmark::WriteJSON(json)) {
+		std::fprintf(stderr, "Unable to write results to %s.\n", static_cast<const char *>(json.mb_str(wxConvFile)));
+		return 1;
+	}
+
+	return 0;
+}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,256 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Transport.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* The number of round trips timed for each transport. */
+static const int ROUND_TRIPS = 500;
+
+/* The number of commands in each pipelined burst, as sent during the init
+ * handshake and when breakpoints are restored. */
+static const int BURST = 4;
+
+static const char RESPONSE[] = "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"status\" transaction_id=\"1\" status=\"break\" reason=\"ok\"/>";
+
+// {{{ static double Now()
+/* Returns a monotonic timestamp in microseconds. */
+static double Now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000.0 + ts.tv_nsec / 1000.0;
+}
+// }}}
+// {{{ static void *RunEngine(void *arg)
+/* A minimal engine: every NULL terminated command gets the same response.
+ * The length and payload go out in separate writes, as several engines
+ * send them. */
+static void *RunEngine(void *arg) {
+	int fd = *static_cast<int *>(arg);
+	char buffer[4096], header[32];
+	int headerLength = std::sprintf(header, "%lu", static_cast<unsigned long>(sizeof(RESPONSE) - 1)) + 1;
+	ssize_t received;
+
+	while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+		for (ssize_t i = 0; i < received; i++) {
+			if (buffer[i] == '\0') {
+				send(fd, header, headerLength, MSG_NOSIGNAL);
+				send(fd, RESPONSE, sizeof(RESPONSE), MSG_NOSIGNAL);
+			}
+		}
+	}
+
+	close(fd);
+	return NULL;
+}
+// }}}
+// {{{ static bool ReadResponses(int fd, int count, const DBGp::Transport &transport)
+/* Reads complete frames, each of which holds two NULL bytes. */
+static bool ReadResponses(int fd, int count, const DBGp::Transport &transport) {
+	char buffer[4096];
+	int nulls = 0;
+
+	while (nulls < count * 2) {
+		ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+
+		if (received <= 0) {
+			return false;
+		}
+		transport.RestoreQuickAck(fd);
+		nulls += std::count(buffer, buffer + received, '\0');
+	}
+
+	return true;
+}
+// }}}
+
+// {{{ class TransportBench
+class TransportBench : public Benchmark {
+	public:
+		TransportBench() : Benchmark(wxT("Transport")) {}
+
+		void Run() {
+			DBGp::Transport defaults, nagle, noDelay;
+			char path[64];
+
+			// Plain sockets, as Server used to accept them.
+			nagle.SetNoDelay(false);
+			nagle.SetQuickAck(false);
+			Measure(wxT("tcp_nagle"), nagle);
+
+			noDelay.SetQuickAck(false);
+			Measure(wxT("tcp_nodelay"), noDelay);
+
+			Measure(wxT("tcp_default"), defaults);
+
+			std::sprintf(path, "/tmp/dubnium-bench-%d.sock", static_cast<int>(getpid()));
+			DBGp::Transport unixSocket;
+			unixSocket.SetPath(wxString(path, wxConvFile));
+			Measure(wxT("unix"), unixSocket);
+			unlink(path);
+		}
+
+	protected:
+		/* Sets up a listener and a connected engine for the
+		 * transport, returning the IDE's end of the connection, which
+		 * has had the transport's options applied. */
+		int Connect(const DBGp::Transport &transport, int &engine) {
+			struct sockaddr_in in;
+			struct sockaddr_un un;
+			struct sockaddr *addr;
+			socklen_t addrLength;
+			int domain;
+
+			if (transport.GetFamily() == DBGp::Transport::UNIX) {
+				std::memset(&un, 0, sizeof(un));
+				un.sun_family = AF_UNIX;
+				std::strncpy(un.sun_path, transport.GetPath().mb_str(wxConvFile), sizeof(un.sun_path) - 1);
+				unlink(un.sun_path);
+
+				addr = reinterpret_cast<struct sockaddr *>(&un);
+				addrLength = sizeof(un);
+				domain = AF_UNIX;
+			}
+			else {
+				std::memset(&in, 0, sizeof(in));
+				in.sin_family = AF_INET;
+				in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				in.sin_port = 0;
+
+				addr = reinterpret_cast<struct sockaddr *>(&in);
+				addrLength = sizeof(in);
+				domain = AF_INET;
+			}
+
+			int listener = socket(domain, SOCK_STREAM, 0);
+			if (listener == -1 || bind(listener, addr, addrLength) == -1 || listen(listener, 1) == -1 || getsockname(listener, addr, &addrLength) == -1) {
+				if (listener != -1) {
+					close(listener);
+				}
+				return -1;
+			}
+
+			// Engines connect with the system's default options.
+			engine = socket(domain, SOCK_STREAM, 0);
+			if (engine == -1 || connect(engine, addr, addrLength) == -1) {
+				close(listener);
+				return -1;
+			}
+
+			int ide = accept(listener, NULL, NULL);
+			close(listener);
+			if (ide != -1) {
+				transport.Configure(ide);
+			}
+			return ide;
+		}
+
+		void Measure(const wxString &name, const DBGp::Transport &transport) {
+			pthread_t thread;
+			int engine, ide = Connect(transport, engine);
+			std::vector<double> singles, bursts;
+
+			if (ide == -1) {
+				std::fprintf(stderr, "Unable to connect over %s.\n", static_cast<const char *>(transport.GetURI().mb_str()));
+				return;
+			}
+			pthread_create(&thread, NULL, RunEngine, &engine);
+
+			// One command at a time, as when stepping.
+			for (int i = 0; i < ROUND_TRIPS; i++) {
+				double start = Now();
+
+				send(ide, "status -i 1", 12, MSG_NOSIGNAL);
+				if (!ReadResponses(ide, 1, transport)) {
+					break;
+				}
+				singles.push_back(Now() - start);
+			}
+
+			/* A burst of commands written separately before any
+			 * response is read, as SendCommandAsync() does. */
+			for (int i = 0; i < ROUND_TRIPS; i++) {
+				double start = Now();
+
+				for (int j = 0; j < BURST; j++) {
+					send(ide, "status -i 1", 12, MSG_NOSIGNAL);
+				}
+				if (!ReadResponses(ide, BURST, transport)) {
+					break;
+				}
+				bursts.push_back(Now() - start);
+			}
+
+			shutdown(ide, SHUT_WR);
+			pthread_join(thread, NULL);
+			close(ide);
+
+			ReportLatencies(name + wxT(".round_trip"), singles);
+			ReportLatencies(name + wxT(".burst"), bursts);
+		}
+
+		void ReportLatencies(const wxString &name, std::vector<double> &latencies) {
+			double total = 0.0;
+
+			if (latencies.empty()) {
+				return;
+			}
+
+			std::sort(latencies.begin(), latencies.end());
+			for (std::vector<double>::const_iterator i = latencies.begin(); i != latencies.end(); i++) {
+				total += *i;
+			}
+
+			Report(name + wxT(".mean"), total / latencies.size(), wxT("us"));
+			Report(name + wxT(".p50"), latencies[latencies.size() / 2], wxT("us"));
+			Report(name + wxT(".p99"), latencies[latencies.size() * 99 / 100], wxT("us"));
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(TransportBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
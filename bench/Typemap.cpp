@@ -0,0 +1,107 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Benchmark.h"
+#include "DBGp/Typemap.h"
+
+#include <wx/stopwatch.h>
+
+/* The number of lookups made for each measurement. */
+static const unsigned long LOOKUPS = 1000000;
+
+// {{{ class TypemapBench
+class TypemapBench : public Benchmark {
+	public:
+		TypemapBench() : Benchmark(wxT("Typemap")) {}
+
+		void Run() {
+			// Xdebug's typemap, as every property lookup sees it.
+			DBGp::Typemap typemap;
+			typemap.AddType(DBGp::Type(DBGp::Type::BOOL, wxT("bool"), wxT("xsd:boolean")));
+			typemap.AddType(DBGp::Type(DBGp::Type::INT, wxT("int"), wxT("xsd:decimal")));
+			typemap.AddType(DBGp::Type(DBGp::Type::FLOAT, wxT("float"), wxT("xsd:double")));
+			typemap.AddType(DBGp::Type(DBGp::Type::STRING, wxT("string"), wxT("xsd:string")));
+			typemap.AddType(DBGp::Type(DBGp::Type::NULLTYPE, wxT("null"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::HASH, wxT("array"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::OBJECT, wxT("object"), wxEmptyString));
+			typemap.AddType(DBGp::Type(DBGp::Type::RESOURCE, wxT("resource"), wxEmptyString));
+
+			const wxString hits[] = { wxT("string"), wxT("int"), wxT("array"), wxT("object"), wxT("bool"), wxT("null"), wxT("float"), wxT("resource") };
+			const size_t count = sizeof(hits) / sizeof(hits[0]);
+
+			AllocationCounter hitAllocations;
+			wxStopWatch hitTimer;
+			for (unsigned long i = 0; i < LOOKUPS; i++) {
+				typemap.GetType(hits[i % count]);
+			}
+			long hitTime = hitTimer.Time();
+			hitAllocations.Stop();
+			ReportTime(wxT("get_type.hit"), hitTime, LOOKUPS);
+			ReportAllocations(wxT("get_type.hit"), hitAllocations, LOOKUPS);
+
+			/* Properties of types the engine didn't list (Xdebug's
+			 * "uninitialized", for one) end up here, and the
+			 * exception is the expensive part. */
+			const wxString miss(wxT("uninitialized"));
+			unsigned long misses = LOOKUPS / 10;
+
+			AllocationCounter missAllocations;
+			wxStopWatch missTimer;
+			for (unsigned long i = 0; i < misses; i++) {
+				try {
+					typemap.GetType(miss);
+				}
+				catch (DBGp::NotFoundError e) {
+				}
+			}
+			long missTime = missTimer.Time();
+			missAllocations.Stop();
+			ReportTime(wxT("get_type.miss"), missTime, misses);
+			ReportAllocations(wxT("get_type.miss"), missAllocations, misses);
+
+			// The same misses without the exception.
+			DBGp::Type type;
+			AllocationCounter tryAllocations;
+			wxStopWatch tryTimer;
+			for (unsigned long i = 0; i < LOOKUPS; i++) {
+				typemap.TryGetType(i % 2 ? miss : hits[i % count], type);
+			}
+			long tryTime = tryTimer.Time();
+			tryAllocations.Stop();
+			ReportTime(wxT("try_get_type.mixed"), tryTime, LOOKUPS);
+			ReportAllocations(wxT("try_get_type.mixed"), tryAllocations, LOOKUPS);
+		}
+};
+// }}}
+
+BENCHMARK_REGISTRATION(TypemapBench);
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -30,22 +30,137 @@
 // }}}
 
 #include "DBGp/Base64.h"
+#include "DBGp/Base64SIMD.h"
 #include "DBGp/Utility.h"
 
-#include <cstring>
+#include <vector>
 
 namespace Base64 {
-	char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-	// {{{ char AlphabetPosition(char c) throw (DecoderError)
-	char AlphabetPosition(char c) throw (DecoderError) {
-		char *pos = std::strchr(alphabet, c);
-		if (pos) {
-			return pos - alphabet;
+	static const signed char INVALID = -1;
+	static const signed char WHITESPACE = -2;
+
+	/* The position of each character within the alphabet, or INVALID or
+	 * WHITESPACE for characters that aren't in it. */
+	static const signed char positions[256] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -2, -2, -1, -1, -2, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+		52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+		-1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+		15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+		-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+		41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+	};
+
+	static Implementation DetectImplementation();
+
+	/* Chosen during static initialisation, so that there's no need to
+	 * lock when checking it later. */
+	static Implementation current = DetectImplementation();
+
+	// {{{ static size_t DecodeScalar(const char *base64, size_t length, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError)
+	static size_t DecodeScalar(const char *base64, size_t length, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError) {
+		const char *ptr = base64;
+		const char *end = base64 + length;
+		char *c = data;
+		char *dataEnd = data + dataLength;
+		wxUint32 buffer = 0;
+		int bits = 0;
+
+		while (ptr < end && *ptr != '=') {
+			/* Handle a whole quartet at once if we're on a
+			 * boundary and it contains nothing unusual. */
+			if (bits == 0 && end - ptr >= 4 && dataEnd - c >= 3) {
+				int a = positions[static_cast<unsigned char>(ptr[0])];
+				int b = positions[static_cast<unsigned char>(ptr[1])];
+				int d = positions[static_cast<unsigned char>(ptr[2])];
+				int e = positions[static_cast<unsigned char>(ptr[3])];
+
+				if ((a | b | d | e) >= 0) {
+					wxUint32 group = (a << 18) | (b << 12) | (d << 6) | e;
+					*c++ = static_cast<char>(group >> 16);
+					*c++ = static_cast<char>(group >> 8);
+					*c++ = static_cast<char>(group);
+					ptr += 4;
+					continue;
+				}
+			}
+
+			signed char value = positions[static_cast<unsigned char>(*ptr)];
+			if (value == WHITESPACE) {
+				++ptr;
+				continue;
+			}
+			else if (value == INVALID) {
+				throw DecoderError(wxString(wxT("Unexpected character in input: ") + static_cast<wxChar>(*ptr)));
+			}
+			++ptr;
+
+			buffer = (buffer << 6) | value;
+			bits += 6;
+			if (bits >= 8) {
+				bits -= 8;
+				if (c >= dataEnd) {
+					throw InsufficientBufferError(wxT("Buffer too small (got ") + DBGp::IntToString(dataLength) + wxT(" bytes)."));
+				}
+				*c++ = static_cast<char>(buffer >> bits);
+			}
 		}
-		throw DecoderError(wxString(wxT("Unexpected character in input: ") + static_cast<wxChar>(c)));
+
+		return c - data;
+	}
+	// }}}
+	// {{{ static Implementation DetectImplementation()
+	static Implementation DetectImplementation() {
+		if (IsSupported(AVX2)) {
+			return AVX2;
+		}
+		else if (IsSupported(SSE2)) {
+			return SSE2;
+		}
+		return SCALAR;
 	}
 	// }}}
+	// {{{ static size_t EncodeScalar(const char *data, size_t length, char *base64)
+	static size_t EncodeScalar(const char *data, size_t length, char *base64) {
+		const unsigned char *ptr = reinterpret_cast<const unsigned char *>(data);
+		const unsigned char *end = ptr + length;
+		char *c = base64;
+
+		for (; end - ptr >= 3; ptr += 3) {
+			wxUint32 group = (ptr[0] << 16) | (ptr[1] << 8) | ptr[2];
+			*c++ = alphabet[group >> 18];
+			*c++ = alphabet[(group >> 12) & 0x3f];
+			*c++ = alphabet[(group >> 6) & 0x3f];
+			*c++ = alphabet[group & 0x3f];
+		}
+
+		if (ptr < end) {
+			wxUint32 group = ptr[0] << 16;
+			if (end - ptr == 2) {
+				group |= ptr[1] << 8;
+			}
+
+			*c++ = alphabet[group >> 18];
+			*c++ = alphabet[(group >> 12) & 0x3f];
+			*c++ = (end - ptr == 2) ? alphabet[(group >> 6) & 0x3f] : '=';
+			*c++ = '=';
+		}
+
+		return c - base64;
+	}
+	// }}}
+
 	// {{{ size_t DataLength(const wxString &base64)
 	size_t DataLength(const wxString &base64) {
 		size_t length = 3 * (base64.Length() / 4);
@@ -60,70 +175,122 @@ namespace Base64 {
 		return length;
 	}
 	// }}}
-	// {{{ void Decode(const wxString &base64, char *data) throw (DecoderError, InsufficientBufferError)
+	// {{{ void Decode(const wxString &base64, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError)
 	void Decode(const wxString &base64, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError) {
-		char *c = data;
 		size_t reqLen = DataLength(base64);
 
 		wxASSERT(data != NULL);
 
-		if (reqLen < dataLength) {
+		if (dataLength < reqLen) {
 			throw InsufficientBufferError(wxT("Buffer too small (required ") + DBGp::IntToString(reqLen) + wxT(" bytes, got ") + DBGp::IntToString(dataLength) + wxT(" bytes."));
 		}
 
-		for (size_t i = 0; i < base64.Length(); i += 4) {
-			wxUint32 buffer;
-			wxString slice(base64.Mid(i, 4));
-
-			buffer = AlphabetPosition(slice[0]) * 67108864 + AlphabetPosition(slice[1]) * 1048576;
-			*c = static_cast<char>(buffer >> 24);
-			++c;
-			if (slice[2] != wxT('=')) {
-				buffer += AlphabetPosition(slice[2]) * 16384;
-				*c = static_cast<char>(buffer >> 16);
-				++c;
-				if (slice[3] != wxT('=')) {
-					buffer += AlphabetPosition(slice[3]) * 256;
-					*c = static_cast<char>(buffer >> 8);
-					++c;
-				}
-			}
+		// Anything outside ASCII will be rejected by the decoder anyway.
+		const wxCharBuffer ascii(base64.ToAscii());
+		size_t length = Decode(ascii.data(), base64.Length(), data, dataLength);
+
+		if (dataLength > length) {
+			data[length] = 0;
+		}
+	}
+	// }}}
+	// {{{ size_t Decode(const char *base64, size_t length, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError)
+	size_t Decode(const char *base64, size_t length, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError) {
+		size_t read = 0;
+		size_t written = 0;
+
+		wxASSERT(data != NULL);
+
+		/* Each kernel stops at the first block it can't handle, and
+		 * the next one down picks up from there. */
+#ifdef BASE64_HAVE_AVX2
+		if (current == AVX2) {
+			size_t step;
+			written += SIMD::DecodeAVX2(base64, length, data, dataLength, step);
+			read += step;
+		}
+#endif
+#ifdef BASE64_HAVE_SSE2
+		if (current == AVX2 || current == SSE2) {
+			size_t step;
+			written += SIMD::DecodeSSE2(base64 + read, length - read, data + written, dataLength - written, step);
+			read += step;
+		}
+#endif
+
+		return written + DecodeScalar(base64 + read, length - read, data + written, dataLength - written);
+	}
+	// }}}
+	// {{{ size_t Encode(const char *data, size_t length, char *base64, size_t base64Length) throw (InsufficientBufferError)
+	size_t Encode(const char *data, size_t length, char *base64, size_t base64Length) throw (InsufficientBufferError) {
+		size_t read = 0;
+		char *c = base64;
+
+		wxASSERT(base64 != NULL);
+
+		if (base64Length < EncodedLength(length)) {
+			throw InsufficientBufferError(wxT("Buffer too small (required ") + DBGp::IntToString(EncodedLength(length)) + wxT(" bytes, got ") + DBGp::IntToString(base64Length) + wxT(" bytes."));
 		}
 
-		if (dataLength > reqLen) {
-			*c = 0;
+#ifdef BASE64_HAVE_AVX2
+		if (current == AVX2) {
+			size_t step = SIMD::EncodeAVX2(data, length, c);
+			read += step;
+			c += 4 * (step / 3);
 		}
+#endif
+#ifdef BASE64_HAVE_SSE2
+		if (current == AVX2 || current == SSE2) {
+			size_t step = SIMD::EncodeSSE2(data + read, length - read, c);
+			read += step;
+			c += 4 * (step / 3);
+		}
+#endif
+
+		c += EncodeScalar(data + read, length - read, c);
+		return c - base64;
 	}
 	// }}}
 	// {{{ wxString Encode(const char *s, size_t length)
 	wxString Encode(const char *s, size_t length) {
-		const char *ptr = s;
-		wxString enc;
-
-		for (; ptr <= (s + length - 3); ptr += 3) {
-			wxUint32 bufVal = ptr[0] * 16777216 + ptr[1] * 65536 + ptr[2] * 256;
-			for (size_t i = 0; i < 4; ++i) {
-				unsigned char c = bufVal >> 26;
-				bufVal = bufVal << 6;
-				enc += alphabet[c];
-			}
-		}
+		std::vector<char> buffer(EncodedLength(length) + 1);
+		size_t encodedLength = Encode(s, length, &buffer[0], buffer.size());
 
-		if (ptr < (s + length)) {
-			char rem = (s + length) - ptr;
-			wxUint32 bufVal = ptr[0] * 16777216;
-			if (rem == 2) {
-				bufVal += ptr[1] * 65536;
-			}
-			for (char i = 0; i <= rem; i++) {
-				unsigned char c = bufVal >> 26;
-				bufVal = bufVal << 6;
-				enc += alphabet[c];
-			}
-			enc << (rem == 1 ? wxT("==") : wxT("="));
+		buffer[encodedLength] = '\0';
+		return wxString::FromAscii(&buffer[0]);
+	}
+	// }}}
+	// {{{ Implementation GetImplementation()
+	Implementation GetImplementation() {
+		return current;
+	}
+	// }}}
+	// {{{ bool IsSupported(Implementation implementation)
+	bool IsSupported(Implementation implementation) {
+		switch (implementation) {
+			case SCALAR:
+				return true;
+#ifdef BASE64_HAVE_SSE2
+			case SSE2:
+				return SIMD::HasSSE2();
+#endif
+#ifdef BASE64_HAVE_AVX2
+			case AVX2:
+				return SIMD::HasAVX2();
+#endif
+			default:
+				return false;
+		}
+	}
+	// }}}
+	// {{{ bool SetImplementation(Implementation implementation)
+	bool SetImplementation(Implementation implementation) {
+		if (!IsSupported(implementation)) {
+			return false;
 		}
 
-		return enc;
+		current = implementation;
+		return true;
 	}
 	// }}}
 }
@@ -40,6 +40,10 @@
  * General Base64 handling functions. These are clean-room implementations,
  * which means that bugs have doubtless been resurrected that other
  * implementations have long since dealt with.
+ *
+ * The raw buffer functions do the real work; the wxString versions are
+ * wrappers around them. Where the CPU supports it, the bulk of each buffer
+ * is handled by SIMD code, with the choice made once at startup.
  */
 namespace Base64 {
 	/** Exception class for Base64 decoding errors. */
@@ -65,6 +69,16 @@ namespace Base64 {
 			inline InsufficientBufferError(const wxString &message) : Error(message) {}
 	};
 
+	/** The available implementations of the codec. */
+	typedef enum {
+		/** Portable table driven code. */
+		SCALAR,
+		/** SSE2 kernels, with scalar code for the remainder. */
+		SSE2,
+		/** AVX2 kernels, falling back to SSE2 and scalar code. */
+		AVX2
+	} Implementation;
+
 	/**
 	 * Calculates the number of bytes encoded within a Base64 string.
 	 *
@@ -88,6 +102,47 @@ namespace Base64 {
 	 */
 	void Decode(const wxString &base64, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError);
 
+	/**
+	 * Decodes a raw Base64 encoded buffer, as received from the
+	 * debugging engine. Whitespace within the input is ignored.
+	 *
+	 * @param[in] base64 The Base64 encoded buffer.
+	 * @param[in] length The length of the encoded buffer.
+	 * @param[out] data The buffer to write the decoded data to. The
+	 * required length can be calculated by MaxDataLength.
+	 * @param[in] dataLength The allocated size of the data parameter.
+	 * @return The number of bytes written to data.
+	 * @throws DecoderError Thrown if the Base64 buffer included an unknown
+	 * character.
+	 * @throws InsufficientBufferError Thrown if the buffer passed in is
+	 * not large enough.
+	 */
+	size_t Decode(const char *base64, size_t length, char *data, size_t dataLength) throw (DecoderError, InsufficientBufferError);
+
+	/**
+	 * Calculates the number of characters needed to encode data of the
+	 * given length, including padding.
+	 *
+	 * @param[in] length The length of the data.
+	 * @return The encoded length.
+	 */
+	inline size_t EncodedLength(size_t length) { return 4 * ((length + 2) / 3); }
+
+	/**
+	 * Encodes binary data to Base64 within a caller supplied buffer. The
+	 * buffer is not NULL-terminated.
+	 *
+	 * @param[in] data The data to encode.
+	 * @param[in] length The length of the data.
+	 * @param[out] base64 The buffer to write the encoded data to. The
+	 * required length can be calculated by EncodedLength.
+	 * @param[in] base64Length The allocated size of the base64 parameter.
+	 * @return The number of characters written to base64.
+	 * @throws InsufficientBufferError Thrown if the buffer passed in is
+	 * not large enough.
+	 */
+	size_t Encode(const char *data, size_t length, char *base64, size_t base64Length) throw (InsufficientBufferError);
+
 	/**
 	 * Encodes a binary string to Base64.
 	 *
@@ -96,6 +151,43 @@ namespace Base64 {
 	 * @return The Base64 encoded string.
 	 */
 	wxString Encode(const char *s, size_t length);
+
+	/**
+	 * Returns the implementation currently in use. By default, this is
+	 * the fastest one supported by the CPU.
+	 *
+	 * @return The implementation.
+	 */
+	Implementation GetImplementation();
+
+	/**
+	 * Returns whether an implementation was compiled in and is supported
+	 * by the CPU.
+	 *
+	 * @param[in] implementation The implementation to check.
+	 * @return True if it can be used.
+	 */
+	bool IsSupported(Implementation implementation);
+
+	/**
+	 * Calculates the largest number of bytes that a raw Base64 buffer of
+	 * the given length can decode to.
+	 *
+	 * @param[in] length The length of the encoded buffer.
+	 * @return The maximum decoded length.
+	 */
+	inline size_t MaxDataLength(size_t length) { return 3 * ((length + 3) / 4); }
+
+	/**
+	 * Switches to a different implementation. This is mostly useful for
+	 * testing and benchmarking; it isn't safe to call while another
+	 * thread is encoding or decoding.
+	 *
+	 * @param[in] implementation The implementation to use.
+	 * @return True if the implementation was selected, or false if it
+	 * isn't supported.
+	 */
+	bool SetImplementation(Implementation implementation);
 }
 
 #endif
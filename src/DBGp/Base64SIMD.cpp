@@ -0,0 +1,280 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Base64SIMD.h"
+
+#if defined(BASE64_HAVE_AVX2)
+#include <immintrin.h>
+#elif defined(BASE64_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && defined(BASE64_HAVE_SSE2)
+#include <intrin.h>
+#endif
+
+namespace Base64 {
+	namespace SIMD {
+		// {{{ bool HasSSE2()
+		bool HasSSE2() {
+#if defined(BASE64_HAVE_SSE2) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 1);
+			return (info[3] & (1 << 26)) != 0;
+#elif defined(BASE64_HAVE_SSE2)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("sse2");
+#else
+			return false;
+#endif
+		}
+		// }}}
+		// {{{ bool HasAVX2()
+		bool HasAVX2() {
+#if defined(BASE64_HAVE_AVX2) && defined(_MSC_VER)
+			int info[4];
+
+			/* The CPU has to support AVX and the OS has to be
+			 * saving the YMM registers before AVX2 is any use. */
+			__cpuid(info, 1);
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) {
+				return false;
+			}
+			if ((_xgetbv(0) & 6) != 6) {
+				return false;
+			}
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#elif defined(BASE64_HAVE_AVX2)
+			// libgcc checks the OS support for us.
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#else
+			return false;
+#endif
+		}
+		// }}}
+
+#ifdef BASE64_HAVE_SSE2
+		// {{{ size_t DecodeSSE2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read)
+		BASE64_TARGET("sse2") size_t DecodeSSE2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read) {
+			const char *in = base64;
+			char *out = data;
+
+			while (static_cast<size_t>(base64 + length - in) >= 16 && static_cast<size_t>(data + dataLength - out) >= 12) {
+				__m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+
+				/* SSE2 has no byte shuffle, so classify each
+				 * character by range instead of by lookup. The
+				 * comparisons are signed, so bytes above 0x7f
+				 * fall outside every range. */
+				__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(src, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(src, _mm_set1_epi8('Z' + 1)));
+				__m128i lower = _mm_and_si128(_mm_cmpgt_epi8(src, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(src, _mm_set1_epi8('z' + 1)));
+				__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(src, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(src, _mm_set1_epi8('9' + 1)));
+				__m128i plus = _mm_cmpeq_epi8(src, _mm_set1_epi8('+'));
+				__m128i slash = _mm_cmpeq_epi8(src, _mm_set1_epi8('/'));
+
+				__m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(_mm_or_si128(digit, plus), slash));
+				if (_mm_movemask_epi8(valid) != 0xffff) {
+					break;
+				}
+
+				__m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-65));
+				shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(-71)));
+				shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(4)));
+				shift = _mm_or_si128(shift, _mm_and_si128(plus, _mm_set1_epi8(19)));
+				shift = _mm_or_si128(shift, _mm_and_si128(slash, _mm_set1_epi8(16)));
+				__m128i values = _mm_add_epi8(src, shift);
+
+				// Merge pairs of sextets, then pairs of those.
+				__m128i merged = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00ff)), 6), _mm_srli_epi16(values, 8));
+				merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+
+				unsigned int words[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(words), merged);
+				for (int i = 0; i < 4; i++) {
+					*out++ = static_cast<char>(words[i] >> 16);
+					*out++ = static_cast<char>(words[i] >> 8);
+					*out++ = static_cast<char>(words[i]);
+				}
+
+				in += 16;
+			}
+
+			read = in - base64;
+			return out - data;
+		}
+		// }}}
+		// {{{ size_t EncodeSSE2(const char *data, size_t length, char *base64)
+		BASE64_TARGET("sse2") size_t EncodeSSE2(const char *data, size_t length, char *base64) {
+			const unsigned char *in = reinterpret_cast<const unsigned char *>(data);
+			const unsigned char *end = in + length;
+			char *out = base64;
+
+			while (end - in >= 12) {
+				unsigned char indices[16];
+
+				for (int i = 0; i < 4; i++) {
+					indices[i * 4] = in[0] >> 2;
+					indices[i * 4 + 1] = ((in[0] & 0x03) << 4) | (in[1] >> 4);
+					indices[i * 4 + 2] = ((in[1] & 0x0f) << 2) | (in[2] >> 6);
+					indices[i * 4 + 3] = in[2] & 0x3f;
+					in += 3;
+				}
+
+				/* Start everything at 'A' and then nudge each
+				 * range of the alphabet into place. */
+				__m128i idx = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices));
+				__m128i ascii = _mm_add_epi8(idx, _mm_set1_epi8('A'));
+				ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(25)), _mm_set1_epi8(6)));
+				ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpgt_epi8(idx, _mm_set1_epi8(51)), _mm_set1_epi8(-75)));
+				ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpeq_epi8(idx, _mm_set1_epi8(62)), _mm_set1_epi8(-15)));
+				ascii = _mm_add_epi8(ascii, _mm_and_si128(_mm_cmpeq_epi8(idx, _mm_set1_epi8(63)), _mm_set1_epi8(-12)));
+
+				_mm_storeu_si128(reinterpret_cast<__m128i *>(out), ascii);
+				out += 16;
+			}
+
+			return in - reinterpret_cast<const unsigned char *>(data);
+		}
+		// }}}
+#endif
+
+#ifdef BASE64_HAVE_AVX2
+		// {{{ size_t DecodeAVX2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read)
+		BASE64_TARGET("avx2") size_t DecodeAVX2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read) {
+			const char *in = base64;
+			char *out = data;
+
+			/* Lookup tables indexed by the low and high nibbles of
+			 * each character: a character is valid if the bits
+			 * it picks out of each don't overlap. The roll table
+			 * gives the offset for each range, with '/' (which
+			 * shares its high nibble with '+') special cased. */
+			const __m256i lutLo = _mm256_setr_epi8(
+				0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+				0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+			const __m256i lutHi = _mm256_setr_epi8(
+				0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+				0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+			const __m256i lutRoll = _mm256_setr_epi8(
+				0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+			const __m256i mask2F = _mm256_set1_epi8(0x2f);
+
+			while (static_cast<size_t>(base64 + length - in) >= 32 && static_cast<size_t>(data + dataLength - out) >= 32) {
+				__m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+				__m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(src, 4), mask2F);
+				__m256i loNibbles = _mm256_and_si256(src, mask2F);
+				__m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+				__m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+
+				if (!_mm256_testz_si256(lo, hi)) {
+					break;
+				}
+
+				__m256i eq2F = _mm256_cmpeq_epi8(src, mask2F);
+				__m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(eq2F, hiNibbles));
+				__m256i values = _mm256_add_epi8(src, roll);
+
+				// Merge the sextets into 24 bit groups.
+				__m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+				merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+
+				// Then pack the groups together, big endian.
+				merged = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(
+					2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+					2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+				merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1));
+
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), merged);
+				in += 32;
+				out += 24;
+			}
+
+			read = in - base64;
+			return out - data;
+		}
+		// }}}
+		// {{{ size_t EncodeAVX2(const char *data, size_t length, char *base64)
+		BASE64_TARGET("avx2") size_t EncodeAVX2(const char *data, size_t length, char *base64) {
+			const char *in = data;
+			char *out = base64;
+
+			/* The offsets from each sextet to its character,
+			 * indexed by the reduced values computed below. */
+			const __m256i shiftLUT = _mm256_setr_epi8(
+				'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+				'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+				'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+				'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+			while (static_cast<size_t>(data + length - in) >= 28) {
+				// 12 bytes of input in each lane.
+				__m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+				__m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 12));
+				__m256i src = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+				// Spread each 3 byte group over a 32 bit word.
+				src = _mm256_shuffle_epi8(src, _mm256_setr_epi8(
+					1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+					1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+				// Then move each sextet into its own byte.
+				__m256i t0 = _mm256_and_si256(src, _mm256_set1_epi32(0x0fc0fc00));
+				__m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+				__m256i t2 = _mm256_and_si256(src, _mm256_set1_epi32(0x003f03f0));
+				__m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+				__m256i indices = _mm256_or_si256(t1, t3);
+
+				/* Reduce each index to a position in the shift
+				 * table: 0 for a-z, 1-10 for the digits, 11 and 12
+				 * for '+' and '/', and 13 for A-Z. */
+				__m256i reduced = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+				__m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+				reduced = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+				__m256i ascii = _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, reduced), indices);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(out), ascii);
+
+				in += 24;
+				out += 32;
+			}
+
+			return in - data;
+		}
+		// }}}
+#endif
+	}
+}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
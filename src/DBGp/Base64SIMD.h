@@ -0,0 +1,124 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_BASE64SIMD_H
+#define DBGP_BASE64SIMD_H
+
+#include <cstddef>
+
+/* The vectorised kernels need either a compiler that can target instruction
+ * sets on a per-function basis, so that the rest of the library is still
+ * built for the baseline CPU, or one that makes the intrinsics available
+ * unconditionally. */
+#if (defined(__i386__) || defined(__x86_64__)) && (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define BASE64_HAVE_SSE2 1
+#define BASE64_HAVE_AVX2 1
+#define BASE64_TARGET(isa) __attribute__((target(isa)))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#define BASE64_HAVE_SSE2 1
+#if _MSC_VER >= 1700
+#define BASE64_HAVE_AVX2 1
+#endif
+#define BASE64_TARGET(isa)
+#endif
+
+/**
+ * Vectorised Base64 kernels. These only handle the bulk of the input: each
+ * processes as many whole blocks as it can and leaves the remainder (along
+ * with anything it doesn't understand, such as whitespace or padding) to the
+ * scalar code in Base64.cpp. None of them throw.
+ */
+namespace Base64 {
+	namespace SIMD {
+		/**
+		 * Returns whether the running CPU supports SSE2.
+		 *
+		 * @return True if the SSE2 kernels can be used.
+		 */
+		bool HasSSE2();
+
+		/**
+		 * Returns whether the running CPU and operating system
+		 * support AVX2.
+		 *
+		 * @return True if the AVX2 kernels can be used.
+		 */
+		bool HasAVX2();
+
+#ifdef BASE64_HAVE_SSE2
+		/**
+		 * Decodes blocks of 16 characters. Decoding stops at the first
+		 * block that contains anything other than the Base64
+		 * alphabet.
+		 *
+		 * @param[in] base64 The Base64 encoded buffer.
+		 * @param[in] length The length of the encoded buffer.
+		 * @param[out] data The buffer to decode into.
+		 * @param[in] dataLength The space available in data.
+		 * @param[out] read The number of characters consumed, which
+		 * is always a multiple of four.
+		 * @return The number of bytes written to data.
+		 */
+		size_t DecodeSSE2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read);
+
+		/**
+		 * Encodes blocks of 12 bytes.
+		 *
+		 * @param[in] data The data to encode.
+		 * @param[in] length The length of the data.
+		 * @param[out] base64 The buffer to encode into, which must
+		 * have room for 4 characters per 3 bytes consumed.
+		 * @return The number of bytes consumed, which is always a
+		 * multiple of three.
+		 */
+		size_t EncodeSSE2(const char *data, size_t length, char *base64);
+#endif
+
+#ifdef BASE64_HAVE_AVX2
+		/**
+		 * Decodes blocks of 32 characters. As DecodeSSE2(), although
+		 * each block writes a full 32 bytes to data, of which 24 are
+		 * decoded data.
+		 */
+		size_t DecodeAVX2(const char *base64, size_t length, char *data, size_t dataLength, size_t &read);
+
+		/**
+		 * Encodes blocks of 24 bytes. As EncodeSSE2(), although the
+		 * input has to have 4 readable bytes beyond each block.
+		 */
+		size_t EncodeAVX2(const char *data, size_t length, char *base64);
+#endif
+	}
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
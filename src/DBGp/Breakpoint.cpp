@@ -30,6 +30,7 @@
 // }}}
 
 #include "DBGp/Breakpoint.h"
+#include "DBGp/BreakpointBatch.h"
 #include "DBGp/Connection.h"
 #include "DBGp/Utility.h"
 
@@ -39,12 +40,39 @@
 
 using namespace DBGp;
 
+// {{{ template <typename T> static bool Assign(T &field, const T &value)
+template <typename T> static bool Assign(T &field, const T &value) {
+	if (field == value) {
+		return false;
+	}
+
+	field = value;
+	return true;
+}
+// }}}
+// {{{ static int FindMethodSeparator(const wxString &function)
+static int FindMethodSeparator(const wxString &function) {
+	int pos = function.Find(wxT("::"));
+
+	// :: or -> are both valid separators.
+	if (pos == wxNOT_FOUND) {
+		pos = function.Find(wxT("->"));
+	}
+
+	return pos;
+}
+// }}}
+
 // {{{ Breakpoint::Breakpoint(Connection *conn)
-Breakpoint::Breakpoint(Connection *conn) : conn(conn), enabled(true), hitCondition(HIT_GE), hitCount(0), hitValue(0), isSet(false), temporary(false), type(LINE) {
+Breakpoint::Breakpoint(Connection *conn) : batch(NULL), conn(conn), enabled(true), hitCondition(HIT_GE), hitCount(0), hitValue(0), isSet(false), resolved(true), temporary(false), type(LINE) {
 }
 // }}}
 // {{{ Breakpoint::~Breakpoint()
 Breakpoint::~Breakpoint() {
+	if (batch) {
+		batch->Remove(this);
+	}
+
 	if (isSet) {
 		try {
 			conn->SendCommandImmediate(wxT("breakpoint_remove"), MessageArguments().Append(wxT("-d"), id));
@@ -143,25 +171,7 @@ void Breakpoint::Get() throw (EngineError, SocketError) {
 
 	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node; node = node->GetNext()) {
 		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("breakpoint")) {
-			id = node->GetPropVal(wxT("id"), wxEmptyString);
-			enabled = (node->GetPropVal(wxT("state"), wxT("disabled")) == wxT("enabled"));
-			fileName = node->GetPropVal(wxT("filename"), wxEmptyString);
-			function = node->GetPropVal(wxT("function"), wxEmptyString);
-			exception = node->GetPropVal(wxT("exception"), wxEmptyString);
-			lineNo = StringToInt(node->GetPropVal(wxT("lineno"), wxT("0")));
-			hitCount = StringToInt(node->GetPropVal(wxT("hit_count"), wxT("0")));
-			hitValue = StringToInt(node->GetPropVal(wxT("hit_value"), wxT("0")));
-			hitCondition = StringToHitCondition(node->GetPropVal(wxT("hit_condition"), wxT(">=")));
-			type = StringToType(node->GetPropVal(wxT("type"), wxT("line")));
-
-			expression = wxEmptyString;
-			for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext()) {
-				if (child->GetType() == wxXML_ELEMENT_NODE && child->GetName() == wxT("expression")) {
-					expression = child->GetNodeContent();
-					break;
-				}
-			}
-
+			Load(node);
 			break;
 		}
 	}
@@ -169,44 +179,19 @@ void Breakpoint::Get() throw (EngineError, SocketError) {
 // }}}
 // {{{ void Breakpoint::Set() throw (EngineError, SocketError) 
 void Breakpoint::Set() throw (EngineError, SocketError) {
-	char *data = NULL;
-	size_t dataLength = 0;
-	MessageArguments args(5,
-			wxT("-t"), TypeToString(type).c_str(),
-			wxT("-s"), enabled ? wxT("enabled") : wxT("disabled"),
-			wxT("-h"), IntToString(hitValue).c_str(),
-			wxT("-o"), HitConditionToString(hitCondition).c_str(),
-			wxT("-r"), temporary ? wxT("1") : wxT("0"));
-
-	switch (type) {
-		case LINE:
-			args.Append(wxT("-f"), fileName).Append(wxT("-n"), IntToString(lineNo));
-			break;
-
-		case CALL:
-		case RETURN:
-			// Hack to workaround XDebug bug #411.
-			if (SetMethodBreakpoint(args)) {
-				return;
-			}
-
-			args.Append(wxT("-m"), function);
-			break;
-
-		case EXCEPTION:
-			args.Append(wxT("-x"), exception);
-			break;
-
-		default:
-#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
-			data = conn->conv->cWX2MB(expression.c_str()).release();
-#else
-			data = expression.c_str();
-#endif
-			dataLength = std::strlen(data);
+	if (batch) {
+		return;
+	}
 
+	// Hack to workaround XDebug bug #411.
+	if (IsMethod() && SetMethodBreakpoint()) {
+		return;
 	}
 
+	size_t dataLength = 0;
+	char *data = GetData(dataLength);
+	MessageArguments args(GetArguments(false));
+
 	if (isSet) {
 		conn->SendCommandWait(wxT("breakpoint_update"), args.Append(wxT("-d"), id), data, dataLength);
 	}
@@ -215,12 +200,7 @@ void Breakpoint::Set() throw (EngineError, SocketError) {
 		id = doc.GetRoot()->GetPropVal(wxT("id"), wxEmptyString);
 	}
 
-#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
-	if (data) {
-		delete[] data;
-	}
-#endif
-
+	FreeData(data);
 	isSet = true;
 }
 // }}}
@@ -288,51 +268,140 @@ wxString Breakpoint::TypeToString(Type type) {
 }
 // }}}
 
-// {{{ bool Breakpoint::SetMethodBreakpoint(const MessageArguments &args) throw (SocketError)
-bool Breakpoint::SetMethodBreakpoint(MessageArguments args) throw (SocketError) {
-	/* XDebug has a bug (#411) that means that we have to use a
-	 * non-standard way of setting class/object breakpoints. We'll do this
-	 * by basically replicating the Set codepath with the non-standard
-	 * method and seeing what we get back -- if we get an exception, we'll
-	 * carry on with the traditional method. */
-	int pos = wxNOT_FOUND;
-
-	// :: or -> are both valid separators.
-	if ((pos = function.Find(wxT("::"))) == wxNOT_FOUND) {
-		pos = function.Find(wxT("->"));
+// {{{ void Breakpoint::Forget()
+void Breakpoint::Forget() {
+	id = wxEmptyString;
+	isSet = false;
+}
+// }}}
+// {{{ void Breakpoint::FreeData(char *data)
+void Breakpoint::FreeData(char *data) {
+#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
+	if (data) {
+		delete[] data;
 	}
+#endif
+}
+// }}}
+// {{{ MessageArguments Breakpoint::GetArguments(bool method) const
+MessageArguments Breakpoint::GetArguments(bool method) const {
+	MessageArguments args(5,
+			wxT("-t"), TypeToString(type).c_str(),
+			wxT("-s"), enabled ? wxT("enabled") : wxT("disabled"),
+			wxT("-h"), IntToString(hitValue).c_str(),
+			wxT("-o"), HitConditionToString(hitCondition).c_str(),
+			wxT("-r"), temporary ? wxT("1") : wxT("0"));
+	int pos = wxNOT_FOUND;
 
-	if (pos != wxNOT_FOUND) {
-		wxString cls(function.Left(pos));
-		wxString method(function.Mid(pos + 2));
-
-		args.Append(wxT("-a"), cls);
-		args.Append(wxT("-m"), method);
+	switch (type) {
+		case LINE:
+			args.Append(wxT("-f"), fileName).Append(wxT("-n"), IntToString(lineNo));
+			break;
 
-		try {
-			if (isSet) {
-				conn->SendCommandWait(wxT("breakpoint_update"), args.Append(wxT("-d"), id));
+		case CALL:
+		case RETURN:
+			if (method && (pos = FindMethodSeparator(function)) != wxNOT_FOUND) {
+				args.Append(wxT("-a"), function.Left(pos));
+				args.Append(wxT("-m"), function.Mid(pos + 2));
 			}
 			else {
-				wxXmlDocument doc(conn->SendCommandWait(wxT("breakpoint_set"), args));
-				id = doc.GetRoot()->GetPropVal(wxT("id"), wxEmptyString);
+				args.Append(wxT("-m"), function);
 			}
-			
-			isSet = true;
-			return true;
+			break;
+
+		case EXCEPTION:
+			args.Append(wxT("-x"), exception);
+			break;
+
+		default:
+			break;
+	}
+
+	return args;
+}
+// }}}
+// {{{ char *Breakpoint::GetData(size_t &length) const
+char *Breakpoint::GetData(size_t &length) const {
+	char *data = NULL;
+
+	length = 0;
+	if (type == CONDITIONAL || type == WATCH) {
+#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
+		data = conn->GetConverter()->cWX2MB(expression.c_str()).release();
+#else
+		data = const_cast<char *>(expression.c_str());
+#endif
+		length = std::strlen(data);
+	}
+
+	return data;
+}
+// }}}
+// {{{ bool Breakpoint::IsMethod() const
+bool Breakpoint::IsMethod() const {
+	return (type == CALL || type == RETURN) && FindMethodSeparator(function) != wxNOT_FOUND;
+}
+// }}}
+// {{{ bool Breakpoint::Load(wxXmlNode *node)
+bool Breakpoint::Load(wxXmlNode *node) {
+	bool changed = false;
+	wxString expr;
+
+	for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext()) {
+		if (child->GetType() == wxXML_ELEMENT_NODE && child->GetName() == wxT("expression")) {
+			expr = child->GetNodeContent();
+			break;
 		}
-		catch (EngineError e) {
-			/* The engine doesn't understand -a (which means it's
-			 * compliant with the DBGp standard), so we'll just
-			 * fall through to the return false at the end of the
-			 * method. */
+	}
+
+	changed |= Assign(id, node->GetPropVal(wxT("id"), wxEmptyString));
+	changed |= Assign(enabled, node->GetPropVal(wxT("state"), wxT("disabled")) == wxT("enabled"));
+	changed |= Assign(resolved, node->GetPropVal(wxT("resolved"), wxT("resolved")) != wxT("unresolved"));
+	changed |= Assign(fileName, node->GetPropVal(wxT("filename"), wxEmptyString));
+	changed |= Assign(function, node->GetPropVal(wxT("function"), wxEmptyString));
+	changed |= Assign(exception, node->GetPropVal(wxT("exception"), wxEmptyString));
+	changed |= Assign(lineNo, StringToInt(node->GetPropVal(wxT("lineno"), wxT("0"))));
+	changed |= Assign(hitCount, StringToInt(node->GetPropVal(wxT("hit_count"), wxT("0"))));
+	changed |= Assign(hitValue, StringToInt(node->GetPropVal(wxT("hit_value"), wxT("0"))));
+	changed |= Assign(hitCondition, StringToHitCondition(node->GetPropVal(wxT("hit_condition"), wxT(">="))));
+	changed |= Assign(type, StringToType(node->GetPropVal(wxT("type"), wxT("line"))));
+	changed |= Assign(expression, expr);
+
+	return changed;
+}
+// }}}
+// {{{ bool Breakpoint::SetMethodBreakpoint() throw (SocketError)
+bool Breakpoint::SetMethodBreakpoint() throw (SocketError) {
+	/* XDebug has a bug (#411) that means that we have to use a
+	 * non-standard way of setting class/object breakpoints. We'll do this
+	 * by basically replicating the Set codepath with the non-standard
+	 * method and seeing what we get back -- if we get an exception, we'll
+	 * carry on with the traditional method. */
+	MessageArguments args(GetArguments(true));
+
+	try {
+		if (isSet) {
+			conn->SendCommandWait(wxT("breakpoint_update"), args.Append(wxT("-d"), id));
 		}
-		catch (...) {
-			/* It's a bigger error than just "the engine doesn't
-			 * know what -a is because it's non-standard", so we'll
-			 * rethrow and let the caller handle it. */
-			throw;
+		else {
+			wxXmlDocument doc(conn->SendCommandWait(wxT("breakpoint_set"), args));
+			id = doc.GetRoot()->GetPropVal(wxT("id"), wxEmptyString);
 		}
+		
+		isSet = true;
+		return true;
+	}
+	catch (EngineError e) {
+		/* The engine doesn't understand -a (which means it's
+		 * compliant with the DBGp standard), so we'll just
+		 * fall through to the return false at the end of the
+		 * method. */
+	}
+	catch (...) {
+		/* It's a bigger error than just "the engine doesn't
+		 * know what -a is because it's non-standard", so we'll
+		 * rethrow and let the caller handle it. */
+		throw;
 	}
 
 	return false;
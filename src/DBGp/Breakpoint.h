@@ -33,20 +33,38 @@
 #define DBGP_BREAKPOINT_H
 
 #include <wx/string.h>
+#include <wx/xml/xml.h>
 
 #include "DBGp/Error/Error.h"
 #include "DBGp/MessageArguments.h"
 
 namespace DBGp {
+	class BreakpointBatch;
 	class Connection;
 
 	/**
 	 * Class representing a set breakpoint within the debugger. This class
 	 * (mostly) transparently handles the various breakpoint_get,
 	 * breakpoint_set and breakpoint_update calls required.
+	 *
+	 * Each setter sends the breakpoint to the debugging engine straight
+	 * away, unless the breakpoint belongs to a BreakpointBatch, in which
+	 * case nothing is sent until the batch is.
 	 */
 	class Breakpoint {
 		public:
+			/**
+			 * Allow BreakpointBatch instances to send breakpoints
+			 * on their behalf.
+			 */
+			friend class BreakpointBatch;
+
+			/**
+			 * Allow Connection instances to update breakpoints
+			 * from a breakpoint_list response.
+			 */
+			friend class Connection;
+
 			/** Possible hit conditions. */
 			typedef enum {
 				/** Greater than or equal to the value. */
@@ -141,6 +159,17 @@ namespace DBGp {
 			 */
 			int GetHitCount() throw (EngineError, SocketError);
 
+			/**
+			 * Returns the hit count as of the last time the
+			 * breakpoint was retrieved from the debugging engine,
+			 * either with Get() or
+			 * Connection::RefreshBreakpoints(). Unlike
+			 * GetHitCount(), this doesn't send anything.
+			 *
+			 * @return The last known hit count.
+			 */
+			inline int GetLastHitCount() const { return hitCount; }
+
 			/**
 			 * Returns the current hit value.
 			 *
@@ -188,6 +217,16 @@ namespace DBGp {
 			 */
 			inline bool IsEnabled() const { return enabled; }
 
+			/**
+			 * Returns a flag indicating if the debugging engine
+			 * has resolved the breakpoint to a location it can
+			 * break on. Engines that don't report resolution
+			 * leave this set.
+			 *
+			 * @return True if the breakpoint is resolved.
+			 */
+			inline bool IsResolved() const { return resolved; }
+
 			/**
 			 * Sets the breakpoint to break when a specific
 			 * function is called.
@@ -334,7 +373,9 @@ namespace DBGp {
 			/**
 			 * Sends the current status of the breakpoint to the
 			 * debugging engine. This needs to be called after the
-			 * breakpoint type has been set.
+			 * breakpoint type has been set, but isn't needed after
+			 * calling a setter, since they call it themselves. If
+			 * the breakpoint belongs to a batch, this does nothing.
 			 *
 			 * @throws EngineError Thrown if the debugging engine
 			 * returns an error.
@@ -380,6 +421,12 @@ namespace DBGp {
 			static wxString TypeToString(Type type);
 
 		private:
+			/**
+			 * The batch the breakpoint will be sent with, or NULL
+			 * if changes are sent immediately.
+			 */
+			BreakpointBatch *batch;
+
 			/** The DBGp connection. */
 			Connection *conn;
 
@@ -419,6 +466,12 @@ namespace DBGp {
 			/** The line number to break on. */
 			int lineNo;
 
+			/**
+			 * The flag indicating whether the engine has resolved
+			 * the breakpoint.
+			 */
+			bool resolved;
+
 			/**
 			 * A flag indicating whether the breakpoint is
 			 * temporary.
@@ -428,17 +481,67 @@ namespace DBGp {
 			/** The breakpoint type. */
 			Type type;
 
+			/**
+			 * Forgets the server-assigned ID, for breakpoints that
+			 * the debugging engine no longer has, such as
+			 * temporary breakpoints that have been hit.
+			 */
+			void Forget();
+
+			/**
+			 * Builds the arguments for a breakpoint_set or
+			 * breakpoint_update command, other than the ID.
+			 *
+			 * @param[in] method Whether to split the function name
+			 * for XDebug's non-standard -a option, if it's a
+			 * method.
+			 * @return The arguments.
+			 */
+			MessageArguments GetArguments(bool method) const;
+
+			/**
+			 * Returns the data to send with a breakpoint_set or
+			 * breakpoint_update command.
+			 *
+			 * @param[out] length The length of the data.
+			 * @return The data, which must be freed with
+			 * FreeData(), or NULL if the type doesn't need any.
+			 */
+			char *GetData(size_t &length) const;
+
+			/**
+			 * Frees data returned by GetData().
+			 *
+			 * @param[in] data The data.
+			 */
+			static void FreeData(char *data);
+
+			/**
+			 * Checks if the function to break on is a class or
+			 * object method.
+			 *
+			 * @return True if the breakpoint is on a method.
+			 */
+			bool IsMethod() const;
+
+			/**
+			 * Updates the breakpoint from a breakpoint element
+			 * returned by the debugging engine.
+			 *
+			 * @param[in] node The breakpoint element.
+			 * @return True if anything changed.
+			 */
+			bool Load(wxXmlNode *node);
+
 			/**
 			 * An internal function to try setting a method breakpoint using XDebug's non-standard -a option.
 			 *
-			 * @param[in] args The arguments that have already been
-			 *                 set for the message within Set().
 			 * @return True if the breakpoint was set within this
 			 *         function.
 			 * @throws SocketError Thrown if a communications error
 			 *                     occurs.
 			 */
-			bool SetMethodBreakpoint(MessageArguments args) throw (SocketError);
+			bool SetMethodBreakpoint() throw (SocketError);
 	};
 }
 
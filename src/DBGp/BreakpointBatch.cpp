@@ -0,0 +1,169 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/BreakpointBatch.h"
+
+#include <wx/log.h>
+
+using namespace DBGp;
+
+// {{{ BreakpointBatch::BreakpointBatch(Connection *conn)
+BreakpointBatch::BreakpointBatch(Connection *conn) : conn(conn) {
+}
+// }}}
+// {{{ BreakpointBatch::~BreakpointBatch()
+BreakpointBatch::~BreakpointBatch() {
+	for (Connection::BreakpointList::iterator i = breakpoints.begin(); i != breakpoints.end(); i++) {
+		(*i)->batch = NULL;
+	}
+}
+// }}}
+
+// {{{ void BreakpointBatch::Add(Breakpoint *breakpoint)
+void BreakpointBatch::Add(Breakpoint *breakpoint) {
+	wxASSERT(breakpoint != NULL);
+
+	if (breakpoint->batch != this) {
+		if (breakpoint->batch) {
+			breakpoint->batch->Remove(breakpoint);
+		}
+
+		breakpoint->batch = this;
+		breakpoints.push_back(breakpoint);
+	}
+}
+// }}}
+// {{{ Breakpoint *BreakpointBatch::CreateBreakpoint()
+Breakpoint *BreakpointBatch::CreateBreakpoint() {
+	Breakpoint *breakpoint = conn->CreateBreakpoint();
+	Add(breakpoint);
+	return breakpoint;
+}
+// }}}
+// {{{ void BreakpointBatch::Remove(Breakpoint *breakpoint)
+void BreakpointBatch::Remove(Breakpoint *breakpoint) {
+	wxASSERT(breakpoint != NULL);
+
+	if (breakpoint->batch == this) {
+		breakpoints.remove(breakpoint);
+		breakpoint->batch = NULL;
+	}
+}
+// }}}
+// {{{ size_t BreakpointBatch::Send() throw (SocketError)
+size_t BreakpointBatch::Send() throw (SocketError) {
+	Connection::BreakpointList sending;
+	PendingList pending;
+	size_t accepted = 0;
+
+	sending.swap(breakpoints);
+	for (Connection::BreakpointList::iterator i = sending.begin(); i != sending.end(); i++) {
+		(*i)->batch = NULL;
+	}
+
+	/* Method breakpoints go out with XDebug's -a option first, as
+	 * Breakpoint::Set() does. The ones a standards compliant engine
+	 * rejects are sent again in the standard form in a second burst. */
+	for (Connection::BreakpointList::iterator i = sending.begin(); i != sending.end(); i++) {
+		pending.push_back(SendBreakpoint(*i, (*i)->IsMethod()));
+	}
+
+	while (!pending.empty()) {
+		PendingList retry;
+
+		for (PendingList::iterator i = pending.begin(); i != pending.end(); i++) {
+			Breakpoint *bp = i->breakpoint;
+
+			try {
+				wxXmlDocument doc(conn->WaitForResponse(i->id));
+
+				if (!bp->isSet) {
+					bp->id = doc.GetRoot()->GetPropVal(wxT("id"), wxEmptyString);
+					bp->isSet = true;
+				}
+				accepted++;
+				continue;
+			}
+			catch (SocketError e) {
+				throw;
+			}
+			catch (Error e) {
+				if (i->method) {
+					retry.push_back(*i);
+					continue;
+				}
+				wxLogError(wxT("Error setting breakpoint: %s."), e.GetMessage().c_str());
+			}
+
+			if (!bp->isSet) {
+				conn->RemoveBreakpoint(bp);
+			}
+		}
+
+		pending.clear();
+		for (PendingList::iterator i = retry.begin(); i != retry.end(); i++) {
+			pending.push_back(SendBreakpoint(i->breakpoint, false));
+		}
+	}
+
+	return accepted;
+}
+// }}}
+
+// {{{ BreakpointBatch::Pending BreakpointBatch::SendBreakpoint(Breakpoint *breakpoint, bool method) throw (SocketError)
+BreakpointBatch::Pending BreakpointBatch::SendBreakpoint(Breakpoint *breakpoint, bool method) throw (SocketError) {
+	Pending pending;
+	size_t dataLength = 0;
+	char *data = breakpoint->GetData(dataLength);
+	MessageArguments args(breakpoint->GetArguments(method));
+
+	pending.breakpoint = breakpoint;
+	pending.method = method;
+
+	try {
+		if (breakpoint->isSet) {
+			pending.id = conn->SendCommandAsync(wxT("breakpoint_update"), args.Append(wxT("-d"), breakpoint->id), NULL, data, dataLength);
+		}
+		else {
+			pending.id = conn->SendCommandAsync(wxT("breakpoint_set"), args, NULL, data, dataLength);
+		}
+	}
+	catch (SocketError e) {
+		Breakpoint::FreeData(data);
+		throw;
+	}
+
+	Breakpoint::FreeData(data);
+	return pending;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
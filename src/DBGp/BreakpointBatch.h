@@ -0,0 +1,151 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_BREAKPOINTBATCH_H
+#define DBGP_BREAKPOINTBATCH_H
+
+#include "DBGp/Breakpoint.h"
+#include "DBGp/Connection.h"
+
+#include <vector>
+
+namespace DBGp {
+	/**
+	 * Collects breakpoint definitions and sends them to the debugging
+	 * engine together. Every breakpoint_set and breakpoint_update command
+	 * is sent before any response is read, so a batch costs a single
+	 * round trip however many breakpoints it holds.
+	 *
+	 * Breakpoints in a batch are configured with the normal Breakpoint
+	 * setters, which don't send anything until Send() is called.
+	 */
+	class BreakpointBatch {
+		public:
+			/**
+			 * Constructs an empty batch.
+			 *
+			 * @param[in] conn The DBGp connection.
+			 */
+			BreakpointBatch(Connection *conn);
+
+			/**
+			 * Destroys the batch. Any breakpoints that haven't been
+			 * sent go back to sending their changes immediately.
+			 */
+			~BreakpointBatch();
+
+			/**
+			 * Adds an existing breakpoint to the batch, so that
+			 * further changes to it are deferred until the batch
+			 * is sent.
+			 *
+			 * @param[in] breakpoint The breakpoint to add.
+			 */
+			void Add(Breakpoint *breakpoint);
+
+			/**
+			 * Creates a new breakpoint within the connection and
+			 * adds it to the batch. The breakpoint is owned by
+			 * the connection, as with
+			 * Connection::CreateBreakpoint().
+			 *
+			 * @return The new breakpoint object.
+			 */
+			Breakpoint *CreateBreakpoint();
+
+			/**
+			 * Checks if the batch holds any breakpoints.
+			 *
+			 * @return True if there is nothing to send.
+			 */
+			inline bool IsEmpty() const { return breakpoints.empty(); }
+
+			/**
+			 * Removes a breakpoint from the batch without sending
+			 * it.
+			 *
+			 * @param[in] breakpoint The breakpoint to remove.
+			 */
+			void Remove(Breakpoint *breakpoint);
+
+			/**
+			 * Sends every breakpoint in the batch and records the
+			 * IDs the engine assigns. New breakpoints that the
+			 * engine rejects are logged, removed from the
+			 * connection and deleted. The batch is empty
+			 * afterwards.
+			 *
+			 * @return The number of breakpoints the engine
+			 * accepted.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 */
+			size_t Send() throw (SocketError);
+
+		private:
+			/** A breakpoint command awaiting its response. */
+			typedef struct {
+				/** The breakpoint that was sent. */
+				Breakpoint *breakpoint;
+				/** The transaction ID of the command. */
+				TransactionID id;
+				/** Whether XDebug's -a option was used. */
+				bool method;
+			} Pending;
+
+			/** Container for commands awaiting responses. */
+			typedef std::vector<Pending> PendingList;
+
+			/** The breakpoints in the batch. */
+			Connection::BreakpointList breakpoints;
+
+			/** The DBGp connection. */
+			Connection *conn;
+
+			/**
+			 * Sends the breakpoint_set or breakpoint_update
+			 * command for a breakpoint without waiting for the
+			 * response.
+			 *
+			 * @param[in] breakpoint The breakpoint to send.
+			 * @param[in] method Whether to use XDebug's
+			 * non-standard -a option for method breakpoints.
+			 * @return The pending command.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 */
+			Pending SendBreakpoint(Breakpoint *breakpoint, bool method) throw (SocketError);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -30,7 +30,12 @@
 // }}}
 
 #include "DBGp/Connection.h"
+#include "DBGp/DocumentBuilder.h"
+#include "DBGp/Log.h"
+#include "DBGp/ProtocolLog.h"
+#include "DBGp/SPSCQueue.h"
 #include "DBGp/Server.h"
+#include "DBGp/Tracer.h"
 #include "DBGp/Utility.h"
 #include "DBGp/Event/ConnectionEvent.h"
 #include "DBGp/Event/StatusChangeEvent.h"
@@ -41,7 +46,6 @@
 
 #include <wx/log.h>
 #include <wx/mstream.h>
-#include <wx/sstream.h>
 #include <wx/strconv.h>
 
 using namespace DBGp;
@@ -52,8 +56,235 @@ using namespace DBGp;
 //END_EVENT_TABLE()
 // }}}
 
+/* Private event used to wake ourselves up when frames have been left in the
+ * buffer, or when the I/O thread has queued messages. */
+static const wxEventType wxEVT_DBGP_PENDING_FRAMES = wxNewEventType();
+
+/* The number of parsed messages the I/O thread can get ahead of the main
+ * thread by before it stops reading. */
+static const size_t IO_QUEUE_CAPACITY = 64;
+
+/* How long the I/O thread waits for input, in milliseconds, before checking
+ * whether it has been asked to stop. */
+static const long IO_POLL_INTERVAL = 100;
+
+// {{{ class SocketSource
+/* Adapts a wxSocketBase to the FrameReader::Source interface. */
+class SocketSource : public FrameReader::Source {
+	public:
+		SocketSource(wxSocketBase *socket, const Transport &transport) : socket(socket), transport(transport) {}
+
+		size_t Read(char *buffer, size_t length) throw (SocketError) {
+			socket->Read(buffer, static_cast<wxUint32>(length));
+			if (socket->Error()) {
+				throw SocketError(socket->LastError());
+			}
+			else if (socket->LastCount() == 0) {
+				throw SocketError(wxT("Connection closed by the debugging engine."));
+			}
+
+			transport.RestoreQuickAck(socket);
+			return socket->LastCount();
+		}
+
+	private:
+		wxSocketBase *socket;
+		const Transport &transport;
+};
+// }}}
+
+// {{{ class Connection::IOThread
+/* Reads, frames and parses incoming messages off the main thread. Parsed
+ * messages are handed back through a single producer, single consumer queue,
+ * so neither side takes a lock to pass a message; the semaphore only exists
+ * so that a blocked WaitForResponse() has something to sleep on.
+ *
+ * Only pointers cross the queue. wxString's reference counting isn't thread
+ * safe in wxWidgets 2.8, so everything behind a pointer is built on this
+ * thread and never touched here again once it's been pushed. */
+namespace DBGp {
+	class Connection::IOThread : public wxThread {
+		public:
+			IOThread(Connection *conn) : wxThread(wxTHREAD_JOINABLE), conn(conn), finished(false), notified(false), queue(IO_QUEUE_CAPACITY), stopping(false) {}
+
+			/* Called by the main thread before it drains the queue
+			 * in response to a notification. */
+			void ClearNotified() {
+				notified = false;
+				DBGP_MEMORY_BARRIER();
+			}
+
+			inline bool IsEmpty() const { return queue.IsEmpty(); }
+
+			/* Returns false if block is false and nothing is
+			 * queued. */
+			bool Pop(wxXmlDocument &doc, bool block) throw (MalformedDocumentError, SocketError) {
+				Item item;
+
+				while (!queue.Pop(item)) {
+					if (!block) {
+						return false;
+					}
+					else if (finished) {
+						// Anything pushed before finished was set is visible now.
+						DBGP_MEMORY_BARRIER();
+						if (!queue.Pop(item)) {
+							throw SocketError(wxT("The connection's I/O thread has stopped."));
+						}
+						break;
+					}
+					ready.Wait();
+				}
+
+				if (item.doc) {
+					doc = *item.doc;
+					delete item.doc;
+					return true;
+				}
+
+				wxString message(item.error->GetMessage());
+				delete item.error;
+				if (item.fatal) {
+					throw SocketError(message);
+				}
+				throw MalformedDocumentError(message);
+			}
+
+			void Stop() {
+				stopping = true;
+				Wait();
+			}
+
+		protected:
+			virtual ExitCode Entry() {
+				SocketSource source(conn->socket, conn->server->GetTransport());
+				const char *payload;
+				size_t length;
+				Statistics::Timing timing;
+
+				while (!stopping) {
+					try {
+						if (!conn->NextFrame(payload, length, timing)) {
+							// Wait in short slices so Stop() is noticed promptly.
+							if (conn->socket->WaitForRead(0, IO_POLL_INTERVAL)) {
+								wxMutexLocker lock(conn->socketMutex);
+								conn->FillReader(source);
+							}
+							continue;
+						}
+					}
+					catch (SocketError e) {
+						Push(Item(new Error(e.GetMessage()), true));
+						break;
+					}
+
+					Item item;
+					try {
+						item.doc = new wxXmlDocument(conn->ParseMessage(payload, length, timing));
+					}
+					catch (MalformedDocumentError e) {
+						item.error = new Error(e.GetMessage());
+					}
+
+					if (!Push(item)) {
+						delete item.doc;
+						delete item.error;
+						break;
+					}
+				}
+
+				finished = true;
+				DBGP_MEMORY_BARRIER();
+				ready.Post();
+				return 0;
+			}
+
+		private:
+			struct Item {
+				Item() : doc(NULL), error(NULL), fatal(false) {}
+				Item(Error *error, bool fatal) : doc(NULL), error(error), fatal(fatal) {}
+
+				wxXmlDocument *doc;
+				Error *error;
+				bool fatal;
+			};
+
+			Connection *conn;
+			volatile bool finished;
+			volatile bool notified;
+			SPSCQueue<Item> queue;
+			wxSemaphore ready;
+			volatile bool stopping;
+
+			/* Returns false if asked to stop while waiting for
+			 * space in the queue. */
+			bool Push(const Item &item) {
+				while (!queue.Push(item)) {
+					if (stopping) {
+						return false;
+					}
+					wxThread::Sleep(1);
+				}
+				ready.Post();
+
+				/* One wakeup covers everything queued until the
+				 * main thread gets around to draining it. */
+				if (!notified) {
+					notified = true;
+					DBGP_MEMORY_BARRIER();
+
+					wxCommandEvent e(wxEVT_DBGP_PENDING_FRAMES);
+					wxPostEvent(conn, e);
+				}
+				return true;
+			}
+	};
+}
+// }}}
+// {{{ class Connection::MessageBuilder
+/* Builds incoming messages, diverting the body of responses to their
+ * transaction's stream handler where one has been set. The stream mutex is
+ * held from finding the handler until the builder is destroyed. */
+namespace DBGp {
+	class Connection::MessageBuilder : public DocumentBuilder {
+		public:
+			MessageBuilder(Connection *conn, wxXmlDocument &doc) : DocumentBuilder(doc), conn(conn), locked(false) {}
+
+			~MessageBuilder() {
+				if (locked) {
+					conn->streamMutex.Unlock();
+				}
+			}
+
+		protected:
+			Connection *conn;
+			bool locked;
+
+			virtual ResponseParser::Handler *GetStreamHandler(const wxXmlNode *root) throw () {
+				wxString id;
+
+				if (root->GetName() == wxT("response") && root->GetPropVal(wxT("transaction_id"), &id)) {
+					conn->streamMutex.Lock();
+
+					StreamMap::iterator i = conn->streams.find(StringToULong(id));
+					if (i != conn->streams.end()) {
+						ResponseParser::Handler *stream = i->second;
+
+						conn->streams.erase(i);
+						locked = true;
+						return stream;
+					}
+
+					conn->streamMutex.Unlock();
+				}
+				return NULL;
+			}
+	};
+}
+// }}}
+
 // {{{ Connection::Connection(wxSocketBase *socket, Server *server)
-Connection::Connection(wxSocketBase *socket, Server *server) : wxEvtHandler(), handler(server->parent), server(server), socket(socket), status(STARTING), txID(0) {
+Connection::Connection(wxSocketBase *socket, Server *server) : wxEvtHandler(), frameStart(0), handler(server->parent), lastRead(0), maxChildren(32), maxDepth(1), server(server), socket(socket), status(STARTING), thread(NULL), txID(0), waitDepth(0) {
 	wxASSERT(socket != NULL);
 	wxASSERT(server != NULL);
 
@@ -64,6 +295,7 @@ Connection::Connection(wxSocketBase *socket, Server *server) : wxEvtHandler(), h
 	conv = &wxConvISO8859_1;
 
 	Connect(-1, wxEVT_SOCKET, wxSocketEventHandler(Connection::OnSocket));
+	Connect(-1, wxEVT_DBGP_PENDING_FRAMES, wxCommandEventHandler(Connection::OnPendingFrames));
 	socket->SetEventHandler(*this, -1);
 	socket->SetNotify(wxSOCKET_INPUT_FLAG | wxSOCKET_LOST_FLAG);
 	socket->Notify(true);
@@ -74,11 +306,22 @@ Connection::Connection(wxSocketBase *socket, Server *server) : wxEvtHandler(), h
 // {{{ Connection::~Connection()
 Connection::~Connection() {
 	Close();
+
+	for (TransactionMap::iterator i = transactions.begin(); i != transactions.end(); i++) {
+		delete i->second;
+	}
 }
 // }}}
 
 // {{{ void Connection::Close()
 void Connection::Close() {
+	// The thread has to be gone before the socket it reads from.
+	if (thread) {
+		thread->Stop();
+		delete thread;
+		thread = NULL;
+	}
+
 	if (socket) {
 		socket->Destroy();
 	}
@@ -99,6 +342,48 @@ void Connection::SetEventHandler(wxEvtHandler *handler) {
 	//SetNextHandler(handler);
 }
 // }}}
+// {{{ bool Connection::StartIOThread()
+bool Connection::StartIOThread() {
+	if (thread) {
+		return true;
+	}
+	else if (socket == NULL) {
+		return false;
+	}
+
+	/* The thread does its own waiting, so socket events would only
+	 * cause the main thread to read from under it. */
+	socket->Notify(false);
+	socket->SetFlags(wxSOCKET_BLOCK);
+
+	thread = new IOThread(this);
+	if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+		wxLogError(wxT("Unable to start the connection's I/O thread."));
+		delete thread;
+		thread = NULL;
+
+		socket->SetFlags(wxSOCKET_NONE);
+		socket->Notify(true);
+		return false;
+	}
+
+	return true;
+}
+// }}}
+// {{{ bool Connection::StartRecording(const wxString &file)
+bool Connection::StartRecording(const wxString &file) {
+	if (!recorder.Open(file)) {
+		wxLogError(wxT("Unable to record the session to %s."), file.c_str());
+		return false;
+	}
+	return true;
+}
+// }}}
+// {{{ void Connection::StopRecording()
+void Connection::StopRecording() {
+	recorder.Close();
+}
+// }}}
 
 // {{{ void Connection::Break() throw (SocketError, UnsupportedFeatureError)
 void Connection::Break() throw (SocketError, UnsupportedFeatureError) {
@@ -232,12 +517,7 @@ void Connection::Stop() throw (SocketError) {
 Typemap &Connection::TypemapGet() throw (EngineError, MalformedDocumentError, SocketError) {
 	if (typemap.GetTypes().size() == 0) {
 		wxXmlDocument doc(SendCommandWait(wxT("typemap_get"), MessageArguments()));
-
-		for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
-			if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("map")) {
-				typemap.AddType(Type(Type::StringToCommonType(node->GetPropVal(wxT("type"), wxEmptyString)), node->GetPropVal(wxT("name"), wxEmptyString), node->GetPropVal(wxT("xsi:type"), wxEmptyString)));
-			}
-		}
+		ParseTypemap(doc.GetRoot());
 	}
 
 	return typemap;
@@ -271,6 +551,44 @@ const Connection::BreakpointList &Connection::GetBreakpoints() const {
 	return breakpoints;
 }
 // }}}
+// {{{ Connection::BreakpointList Connection::RefreshBreakpoints() throw (EngineError, MalformedDocumentError, SocketError)
+Connection::BreakpointList Connection::RefreshBreakpoints() throw (EngineError, MalformedDocumentError, SocketError) {
+	std::map<wxString, Breakpoint *> known;
+	BreakpointList changed;
+
+	for (BreakpointList::iterator i = breakpoints.begin(); i != breakpoints.end(); i++) {
+		if ((*i)->isSet) {
+			known[(*i)->GetID()] = *i;
+		}
+	}
+
+	wxXmlDocument doc(SendCommandWait(wxT("breakpoint_list"), MessageArguments()));
+
+	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
+		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("breakpoint")) {
+			std::map<wxString, Breakpoint *>::iterator i = known.find(node->GetPropVal(wxT("id"), wxEmptyString));
+
+			if (i == known.end()) {
+				wxLogDebug(wxT("Ignoring unknown breakpoint ID '%s'."), node->GetPropVal(wxT("id"), wxEmptyString).c_str());
+				continue;
+			}
+
+			if (i->second->Load(node)) {
+				changed.push_back(i->second);
+			}
+			known.erase(i);
+		}
+	}
+
+	// Anything left has been deleted by the engine.
+	for (std::map<wxString, Breakpoint *>::iterator i = known.begin(); i != known.end(); i++) {
+		i->second->Forget();
+		changed.push_back(i->second);
+	}
+
+	return changed;
+}
+// }}}
 // {{{ void Connection::RemoveBreakpoint(Breakpoint *breakpoint)
 void Connection::RemoveBreakpoint(Breakpoint *breakpoint) {
 	wxASSERT(breakpoint != NULL);
@@ -301,6 +619,19 @@ wxString Connection::EngineStatusToString(Connection::EngineStatus status) {
 	}
 }
 // }}}
+// {{{ wxString Connection::FormatCommand(const wxString &command, MessageArguments args, TransactionID id, const char *data, size_t dataLength)
+wxString Connection::FormatCommand(const wxString &command, MessageArguments args, TransactionID id, const char *data, size_t dataLength) {
+	wxString message(command);
+
+	message << wxT(" ") << args.Append(wxT("-i"), IntToString(id)).GetArguments();
+	if (data && dataLength > 0) {
+		message << wxT(" -- ") << Base64::Encode(data, dataLength);
+	}
+	message << wxT('\0');
+
+	return message;
+}
+// }}}
 // {{{ Connection::EngineStatus Connection::StringToEngineStatus(const wxString &s) throw (NotFoundError)
 Connection::EngineStatus Connection::StringToEngineStatus(const wxString &s) throw (NotFoundError) {
 	wxString status(s.Lower());
@@ -323,88 +654,124 @@ Connection::EngineStatus Connection::StringToEngineStatus(const wxString &s) thr
 }
 // }}}
 
-// {{{ void Connection::CopyOutput() throw ()
-void Connection::CopyOutput() throw () {
-	try {
-		MessageArguments args(1, wxT("-c"), wxT("1"));
-		SendCommandImmediate(wxT("stdout"), args);
-		SendCommandImmediate(wxT("stderr"), args);
+// {{{ void Connection::DispatchMessage(wxXmlDocument &doc) throw (EngineError, MalformedDocumentError, SocketError)
+void Connection::DispatchMessage(wxXmlDocument &doc) throw (EngineError, MalformedDocumentError, SocketError) {
+	wxXmlNode *root = doc.GetRoot();
+	TransactionMap::iterator i = transactions.end();
+	unsigned long id = 0;
+
+	if (root->GetName() == wxT("response") && root->GetPropVal(wxT("transaction_id"), wxEmptyString).ToULong(&id)) {
+		i = transactions.find(id);
 	}
-	catch (Error e) {
-		wxLogError(wxT("Error redirecting output streams: %s."), e.GetMessage().c_str());
+
+	if (i == transactions.end()) {
+		/* Either not a response, or a response to a command sent
+		 * with SendCommandImmediate(). Either way, there's no one to
+		 * hand it to once it's been handled. */
+		HandleMessage(doc);
+		return;
 	}
-}
-// }}}
-// {{{ wxXmlDocument Connection::GetMessage() throw (SocketError, SocketDestroyedError)
-wxXmlDocument Connection::GetMessage() throw (MalformedDocumentError, SocketError, SocketDestroyedError) {
-	char c;
-	wxString lenBuf;
-	unsigned long length = 0, read = 0;
-	wxString message;
-	char *msgBuf;
-	wxMemoryInputStream *mis;
-	wxXmlDocument doc;
 
-	if (socket == NULL) {
-		throw SocketDestroyedError();
+	Transaction *transaction = i->second;
+	try {
+		HandleMessage(doc);
+	}
+	catch (EngineError e) {
+		transaction->error = new EngineError(e);
 	}
 
+	if (transaction->handler) {
+		/* The handler may well send more commands, so take the
+		 * transaction out of the table before calling it. */
+		transactions.erase(id);
 
-	wxLogDebug(wxT("Beginning receive..."));
-	
-	socket->Read(&c, 1);
-	if (socket->Error()) {
-		throw SocketError(wxT("Read error from socket."));
-	}
-	while (c != 0) {
-		lenBuf += c;
-		socket->Read(&c, 1);
-		if (socket->Error()) {
-			throw SocketError(wxT("Read error from socket."));
+		try {
+			if (transaction->error) {
+				transaction->handler->OnError(this, *transaction->error);
+			}
+			else {
+				transaction->handler->OnResponse(this, doc);
+			}
+		}
+		catch (Error e) {
+			wxLogError(wxT("Error handling response to %s: %s"), transaction->command.c_str(), e.GetMessage().c_str());
 		}
-	}
-	lenBuf.ToULong(&length);
-	wxLogDebug(wxT("Expecting %lu bytes."), length);
 
-	if (length == 0) {
-		throw SocketError(wxT("Told to read 0 bytes."));
+		delete transaction;
 	}
+	else {
+		transaction->response = doc;
+		transaction->complete = true;
+	}
+}
+// }}}
+// {{{ void Connection::Drop(ConnectionFilter::Action action) throw ()
+void Connection::Drop(ConnectionFilter::Action action) throw () {
+	wxLogDebug(wxT("Connection dropped by filter (%s)."), action == ConnectionFilter::DETACH ? wxT("detach") : wxT("reject"));
 
-	msgBuf = new char[length + 1];
-	char *writeLoc = msgBuf;
-	while (read < length) {
-		socket->Read(writeLoc, length - read);
-		if (socket->Error()) {
-			wxLogError(wxT("Error reading from socket, attempting to recover."));
+	if (action == ConnectionFilter::DETACH) {
+		// Nothing is waiting on the response, so don't wait for it.
+		try {
+			SendCommand(wxT("detach"), MessageArguments(), NULL, 0);
 		}
-		else {
-			unsigned long passRead = socket->LastCount();
-			
-			wxASSERT(passRead <= (length - read));
-			read += passRead;
-			writeLoc += passRead;
-
-			wxLogDebug(wxT("Received chunk of %lu bytes; got %lu bytes of expected %lu."), passRead, read, length);
+		catch (SocketError e) {
+			wxLogDebug(wxT("Error detaching: %s"), e.GetMessage().c_str());
 		}
 	}
-	wxLogDebug(wxT("Reading terminating NULL."));
-	socket->Read(msgBuf + length, 1);
 
-	message = conv->cMB2WX(msgBuf);
-	wxLogDebug(wxT("RX(%lu): %s"), length, message.c_str());
+	status = STOPPED;
+	Close();
+	server->DropConnection(this);
+}
+// }}}
+// {{{ size_t Connection::FillReader(FrameReader::Source &source) throw (SocketError)
+size_t Connection::FillReader(FrameReader::Source &source) throw (SocketError) {
+	DBGP_TRACE("dbgp", "Read");
+	bool idle = (reader.GetBufferedLength() == 0);
+	size_t read = reader.Fill(source);
+
+	lastRead = GetMicroseconds();
+	if (idle) {
+		frameStart = lastRead;
+	}
+	return read;
+}
+// }}}
+// {{{ wxMBConv *Connection::GetConverter()
+wxMBConv *Connection::GetConverter() {
+	wxMutexLocker lock(socketMutex);
+	return conv;
+}
+// }}}
+// {{{ wxXmlDocument Connection::GetMessage() throw (MalformedDocumentError, SocketError, SocketDestroyedError)
+wxXmlDocument Connection::GetMessage() throw (MalformedDocumentError, SocketError, SocketDestroyedError) {
+	const char *payload;
+	size_t length;
+	Statistics::Timing timing;
+
+	if (socket == NULL) {
+		throw SocketDestroyedError();
+	}
 
-	mis = new wxMemoryInputStream(msgBuf, length);
-	if (!doc.Load(*mis)) {
-		delete mis;
-		delete[] msgBuf;
-		
-		throw MalformedDocumentError(wxT("Incoming XML document is malformed."));
+	if (thread) {
+		wxXmlDocument doc;
+		thread->Pop(doc, true);
+		return doc;
 	}
-	
-	delete mis;
-	delete[] msgBuf;
-	
-	return doc;
+
+	SocketSource source(socket, server->GetTransport());
+	while (!NextFrame(payload, length, timing)) {
+		size_t read = FillReader(source);
+		DBGP_LOG_DEBUG((wxT("Received chunk of %lu bytes; %lu bytes buffered."), (unsigned long) read, (unsigned long) reader.GetBufferedLength()));
+	}
+
+	return ParseMessage(payload, length, timing);
+}
+// }}}
+// {{{ void Connection::ForgetStream(TransactionID id) throw ()
+void Connection::ForgetStream(TransactionID id) throw () {
+	wxMutexLocker lock(streamMutex);
+	streams.erase(id);
 }
 // }}}
 // {{{ TransactionID Connection::GetTransactionID()
@@ -416,51 +783,25 @@ TransactionID Connection::GetTransactionID() {
 	return id;
 }
 // }}}
-// {{{ void Connection::HandleEncodedMessage(wxXmlNode *node)
-void Connection::HandleEncodedMessage(wxXmlNode *node) {
-	bool encoded = node->GetPropVal(wxT("encoding"), wxEmptyString) == wxT("base64");
-
-	for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext()) {
-		wxXmlNodeType type = child->GetType();
-		if (type == wxXML_ELEMENT_NODE) {
-			HandleEncodedMessage(child);
-		}
-		else if (encoded && (type == wxXML_TEXT_NODE || type == wxXML_CDATA_SECTION_NODE)) {
-			try {
-				wxString base64(child->GetContent());
-				size_t len = Base64::DataLength(base64);
-
-				char *data = new char[len+1];
-				Base64::Decode(base64, data, len);
-				data[len] = 0;
-				child->SetType(wxXML_CDATA_SECTION_NODE);
-				/* XXX We shouldn't really re-encode the raw
-				 * data, but wxXmlNode forces us to. Figure out
-				 * some way of avoiding this. */
-				child->SetContent(wxString(data, *conv));
-				delete[] data;
-			}
-			catch (Base64::DecoderError e) {
-				wxLogError(wxT("Error in Base64 decoding with data: %s"), child->GetContent().c_str());
-			}
-		}
-	}
-}
-// }}}
 // {{{ void Connection::HandleMessage(wxXmlDocument &doc) throw (EngineError, MalformedDocumentError, SocketError)
 void Connection::HandleMessage(wxXmlDocument &doc) throw (EngineError, MalformedDocumentError, SocketError) {
 	wxXmlNode *root = doc.GetRoot();
 
-	HandleEncodedMessage(root);
-
-	wxStringOutputStream os;
-	doc.Save(os);
-	wxLogDebug(wxT("Decoded XML: %s"), os.GetString().c_str());
+	DBGP_LOG_PROTOCOL((wxT("Decoded XML: %s"), LogDocument(doc).Format().c_str()));
 
 	if (root->GetName() == wxT("init")) {
-		NegotiateFeatures();
-		CopyOutput();
-		typemap = TypemapGet();
+		/* Decide whether we want the session at all before sending
+		 * anything, since negotiation costs several round trips. */
+		ConnectionFilter::Action action = server->GetFilter().Check(
+			root->GetPropVal(wxT("appid"), wxEmptyString),
+			root->GetPropVal(wxT("fileuri"), wxEmptyString),
+			root->GetPropVal(wxT("idekey"), wxEmptyString));
+		if (action != ConnectionFilter::ACCEPT) {
+			Drop(action);
+			return;
+		}
+
+		Initialise(root);
 
 		if (handler) {
 			ConnectionEvent e(this,
@@ -551,14 +892,121 @@ void Connection::HandleResponseError(wxXmlNode *error) throw (EngineError) {
 	throw EngineError(static_cast<wxUint16>(code), appErr, message);
 }
 // }}}
-// {{{ void Connection::NegotiateFeatures() throw ()
-void Connection::NegotiateFeatures() throw () {
+// {{{ void Connection::HandlePendingFrames() throw ()
+void Connection::HandlePendingFrames() throw () {
+	const char *payload;
+	size_t length;
+	Statistics::Timing timing;
+
+	try {
+		if (thread) {
+			wxXmlDocument doc;
+
+			/* Handling a message can close the connection, which
+			 * stops the thread. */
+			thread->ClearNotified();
+			while (thread && thread->Pop(doc, false)) {
+				DispatchMessage(doc);
+			}
+			return;
+		}
+
+		/* Frames are pulled out one at a time, since handling a
+		 * message can send synchronous commands of its own that will
+		 * consume frames from the same buffer. */
+		while (NextFrame(payload, length, timing)) {
+			wxXmlDocument doc(ParseMessage(payload, length, timing));
+
+			DispatchMessage(doc);
+		}
+	}
+	catch (EngineError e) {
+		wxLogError(wxT("Caught engine error in OnSocket: %s"), e.GetMessage().c_str());
+	}
+	catch (MalformedDocumentError e) {
+		wxLogError(wxT("Caught malformed document error in OnSocket: %s"), e.GetMessage().c_str());
+	}
+	catch (SocketError e) {
+		wxLogError(wxT("Caught socket error in OnSocket: %s"), e.GetMessage().c_str());
+		if (!thread) {
+			reader.Reset();
+		}
+	}
+
+	/* An error stops the I/O thread's queue being drained, so make sure
+	 * whatever was queued behind it isn't stranded. */
+	if (thread && !thread->IsEmpty()) {
+		wxCommandEvent e(wxEVT_DBGP_PENDING_FRAMES);
+		AddPendingEvent(e);
+	}
+}
+// }}}
+// {{{ void Connection::Initialise(wxXmlNode *init) throw ()
+void Connection::Initialise(wxXmlNode *init) throw () {
+	static const wxChar *commands[] = { wxT("break"), wxT("detach"), wxT("exec"), wxT("expr") };
+	static const size_t commandCount = sizeof(commands) / sizeof(commands[0]);
+
+	TransactionID commandIDs[commandCount], encodingID, maxChildrenID, maxDepthID, streamIDs[2], typemapID = 0;
+	wxString engine, engineVersion;
+
+	for (wxXmlNode *node = init->GetChildren(); node != NULL; node = node->GetNext()) {
+		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("engine")) {
+			engine = node->GetNodeContent();
+			engineVersion = node->GetPropVal(wxT("version"), wxEmptyString);
+		}
+	}
+
+	EngineProfileCache &cache = server->GetProfileCache();
+	wxString key(EngineProfileCache::MakeKey(init->GetPropVal(wxT("language"), wxEmptyString), engine, engineVersion, init->GetPropVal(wxT("protocol_version"), wxEmptyString)));
+	EngineProfile profile(maxChildren, maxDepth);
+	bool cached = cache.Find(key, profile);
+	bool complete = true;
+
+	wxLogDebug(wxT("Initialising connection (%s profile)."), cached ? wxT("cached") : wxT("new"));
+
+	/* Send everything before waiting for anything: the engine answers
+	 * in order, so the whole handshake costs a single round trip.
+	 * Settings are per session and always have to be sent, but what the
+	 * engine supports only has to be asked once per engine version. */
+	try {
+		encodingID = SendCommandAsync(wxT("feature_set"), MessageArguments().Append(wxT("-n"), wxT("encoding")).Append(wxT("-v"), wxT("UTF-8")));
+
+		if (!cached) {
+			for (size_t i = 0; i < commandCount; i++) {
+				commandIDs[i] = SendCommandAsync(wxT("feature_get"), MessageArguments().Append(wxT("-n"), commands[i]));
+			}
+		}
+
+		/* Keep max_depth small and page through children as
+		 * they're needed: large object graphs otherwise have to be
+		 * sent and parsed in full on every break. */
+		maxChildrenID = SendCommandAsync(wxT("feature_set"), MessageArguments().Append(wxT("-n"), wxT("max_children")).Append(wxT("-v"), IntToString(DEFAULT_MAX_CHILDREN)));
+		maxDepthID = SendCommandAsync(wxT("feature_set"), MessageArguments().Append(wxT("-n"), wxT("max_depth")).Append(wxT("-v"), IntToString(DEFAULT_MAX_DEPTH)));
+
+		MessageArguments copy(1, wxT("-c"), wxT("1"));
+		streamIDs[0] = SendCommandAsync(wxT("stdout"), copy);
+		streamIDs[1] = SendCommandAsync(wxT("stderr"), copy);
+
+		if (!cached) {
+			typemapID = SendCommandAsync(wxT("typemap_get"), MessageArguments());
+		}
+	}
+	catch (SocketError e) {
+		wxLogError(wxT("Error initialising connection: %s."), e.GetMessage().c_str());
+		return;
+	}
+
 	/* Attempt to set the encoding to UTF-8. XDebug will fail for now, but
 	 * that's OK, since I suspect it'll get Unicode support when PHP 6 is
 	 * closer. */
 	try {
-		if (FeatureSet(wxT("encoding"), wxT("UTF-8"))) {
+		/* ParseMessage() will normally have switched the converter
+		 * already, before anything pipelined after this response was
+		 * parsed; this only catches engines that don't say which
+		 * feature the response is for. */
+		if (WaitForResponse(encodingID).GetRoot()->GetPropVal(wxT("success"), wxT("0")) == wxT("1")) {
 			wxLogDebug(wxT("Encoding switched to UTF-8."));
+			SetConverter(&wxConvUTF8);
 		}
 		else {
 			wxLogDebug(wxT("Encoding remains ISO-8859-1."));
@@ -567,29 +1015,125 @@ void Connection::NegotiateFeatures() throw () {
 	catch (Error e) {
 		wxLogDebug(wxT("Error setting encoding: %s"), e.GetMessage().c_str());
 	}
-	
-	// Test extended commands.
-	TestCommand(wxT("break"));
-	TestCommand(wxT("detach"));
-	TestCommand(wxT("exec"));
-	TestCommand(wxT("expr"));
-
-	/* Set max_children and max_depth to fairly large values. In the longer
-	 * term, we might look at providing configuration options for these
-	 * figures, but for now, let's just get everything. Not so good for
-	 * people debugging over dialup... */
+
+	if (!cached) {
+		for (size_t i = 0; i < commandCount; i++) {
+			try {
+				wxXmlDocument doc(WaitForResponse(commandIDs[i]));
+				wxXmlNode *root = doc.GetRoot();
+
+				profile.commands[commands[i]] = (root->GetPropVal(wxT("supported"), wxT("0")) != wxT("0") && root->GetNodeContent() == wxT("1"));
+			}
+			catch (SocketError e) {
+				wxLogDebug(wxT("Error testing command: %s."), commands[i]);
+				profile.commands[commands[i]] = false;
+				complete = false;
+			}
+			catch (Error e) {
+				wxLogDebug(wxT("Error testing command: %s."), commands[i]);
+				profile.commands[commands[i]] = false;
+			}
+		}
+	}
+	for (std::map<wxString, bool>::const_iterator i = profile.commands.begin(); i != profile.commands.end(); i++) {
+		supported[i->first] = i->second;
+	}
+
+	maxChildren = NegotiateNumericFeature(wxT("max_children"), maxChildrenID, DEFAULT_MAX_CHILDREN, profile.maxChildren, !cached);
+	maxDepth = NegotiateNumericFeature(wxT("max_depth"), maxDepthID, DEFAULT_MAX_DEPTH, profile.maxDepth, !cached);
+
+	for (size_t i = 0; i < 2; i++) {
+		try {
+			WaitForResponse(streamIDs[i]);
+		}
+		catch (Error e) {
+			wxLogError(wxT("Error redirecting output streams: %s."), e.GetMessage().c_str());
+		}
+	}
+
+	if (cached) {
+		typemap = profile.typemap;
+	}
+	else {
+		try {
+			wxXmlDocument doc(WaitForResponse(typemapID));
+			ParseTypemap(doc.GetRoot());
+		}
+		catch (SocketError e) {
+			wxLogError(wxT("Error retrieving typemap: %s."), e.GetMessage().c_str());
+			complete = false;
+		}
+		catch (Error e) {
+			wxLogError(wxT("Error retrieving typemap: %s."), e.GetMessage().c_str());
+		}
+
+		// Don't let a connection that died half way poison the cache.
+		if (complete) {
+			profile.maxChildren = maxChildren;
+			profile.maxDepth = maxDepth;
+			profile.typemap = typemap;
+			cache.Store(key, profile);
+		}
+	}
+}
+// }}}
+// {{{ unsigned int Connection::NegotiateNumericFeature(const wxString &name, TransactionID id, unsigned int value, unsigned int fallback, bool query) throw ()
+unsigned int Connection::NegotiateNumericFeature(const wxString &name, TransactionID id, unsigned int value, unsigned int fallback, bool query) throw () {
 	try {
-		FeatureSet(wxT("max_children"), wxT("1000"));
-		FeatureSet(wxT("max_depth"), wxT("100"));
+		if (WaitForResponse(id).GetRoot()->GetPropVal(wxT("success"), wxT("0")) == wxT("1")) {
+			return value;
+		}
+
+		// This is the only part of the handshake that can't be pipelined.
+		if (query) {
+			wxString current(FeatureGet(name));
+			if (!current.IsEmpty()) {
+				return StringToInt(current);
+			}
+		}
 	}
 	catch (Error e) {
-		wxLogError(wxT("Error setting children/depth: %s"), e.GetMessage().c_str());
+		wxLogDebug(wxT("Error setting %s: %s"), name.c_str(), e.GetMessage().c_str());
+	}
+
+	return fallback;
+}
+// }}}
+// {{{ bool Connection::NextFrame(const char *&payload, size_t &length, Statistics::Timing &timing) throw (SocketError)
+bool Connection::NextFrame(const char *&payload, size_t &length, Statistics::Timing &timing) throw (SocketError) {
+	if (!reader.NextFrame(payload, length)) {
+		return false;
+	}
+
+	timing.firstByte = frameStart;
+	timing.lastByte = lastRead;
+
+	// Anything left over arrived with the last read.
+	frameStart = lastRead;
+	return true;
+}
+// }}}
+// {{{ void Connection::OnPendingFrames(wxCommandEvent &event) throw ()
+void Connection::OnPendingFrames(wxCommandEvent &event) throw () {
+	/* This can arrive while a wait is in progress further up the stack;
+	 * the wait will pick up anything that's pending itself. The I/O
+	 * thread still has to be told this notification was used up, or it
+	 * will never post another once the wait is over. */
+	if (waitDepth > 0) {
+		if (thread) {
+			thread->ClearNotified();
+		}
+		return;
+	}
+
+	if (thread || ReadAvailable()) {
+		HandlePendingFrames();
 	}
 }
 // }}}
 // {{{ void Connection::OnSocket(wxSocketEvent &event) throw ()
 void Connection::OnSocket(wxSocketEvent &event) throw () {
-	wxLogDebug(wxT("OnSocket called; event %d."), event.GetSocketEvent());
+	DBGP_LOG_DEBUG((wxT("OnSocket called; event %d."), event.GetSocketEvent()));
 
 	// TODO: Send event.
 	if (event.GetSocketEvent() == wxSOCKET_LOST) {
@@ -604,39 +1148,108 @@ void Connection::OnSocket(wxSocketEvent &event) throw () {
 		return;
 	}
 
-	try {
-		wxXmlDocument doc(GetMessage());
+	/* Socket events are disabled while the I/O thread is running, but
+	 * one may have been queued before it started. While waiting, the
+	 * wait loop is the one reading. */
+	if (socket == NULL || thread || waitDepth > 0) {
+		return;
+	}
 
-		HandleMessage(doc);
+	if (ReadAvailable()) {
+		HandlePendingFrames();
 	}
-	catch (EngineError e) {
-		wxLogError(wxT("Caught engine error in OnSocket: %s"), e.GetMessage().c_str());
+}
+// }}}
+// {{{ wxXmlDocument Connection::ParseMessage(const char *payload, size_t length) throw (MalformedDocumentError)
+wxXmlDocument Connection::ParseMessage(const char *payload, size_t length, const Statistics::Timing &timing) throw (MalformedDocumentError) {
+	wxXmlDocument doc;
+	MessageBuilder builder(this, doc);
+	wxMBConv *conv = GetConverter();
+	ResponseParser parser(conv);
+	Statistics::Timing handled(timing);
+	wxUint64 start;
+	DBGP_TRACE("dbgp", "ParseMessage");
+
+	ProtocolLog::Record(this, ProtocolLog::RECEIVED, payload, length);
+	recorder.Record(SessionRecorder::RECEIVED, payload, length);
+	DBGP_LOG_PROTOCOL((wxT("RX(%lu): %s"), (unsigned long) length, LogPayload(payload, length, conv).Format().c_str()));
+
+	start = GetMicroseconds();
+	parser.Parse(payload, length, builder);
+	if (!doc.IsOk()) {
+		throw MalformedDocumentError(wxT("Incoming XML document has no root element."));
 	}
-	catch (MalformedDocumentError e) {
-		wxLogError(wxT("Caught malformed document error in OnSocket: %s"), e.GetMessage().c_str());
+
+	handled.parse = GetMicroseconds() - start;
+	handled.decode = parser.GetDecodeTime();
+
+	wxXmlNode *root = doc.GetRoot();
+	unsigned long id;
+	if (root->GetName() == wxT("response") && root->GetPropVal(wxT("transaction_id"), wxEmptyString).ToULong(&id)) {
+		statistics.RecordResponse(this, root->GetPropVal(wxT("command"), wxEmptyString), id, length, handled);
 	}
-	catch (SocketError e) {
-		wxLogError(wxT("Caught socket error in OnSocket: %s"), e.GetMessage().c_str());
+	else {
+		statistics.RecordReceived(root->GetName(), length, handled);
 	}
+
+	/* The engine switches encoding as soon as it has answered, so the
+	 * switch has to happen here, in order with the frames, rather than
+	 * when Initialise() gets around to the response: anything pipelined
+	 * behind it may already have been parsed by then. The spec names the
+	 * attribute feature_name, but Xdebug sends feature. UTF-8 is the
+	 * only encoding we ever ask for. */
+	if (root->GetName() == wxT("response") && root->GetPropVal(wxT("command"), wxEmptyString) == wxT("feature_set") && root->GetPropVal(wxT("success"), wxT("0")) == wxT("1")) {
+		wxString feature(root->GetPropVal(wxT("feature"), root->GetPropVal(wxT("feature_name"), wxEmptyString)));
+
+		if (feature == wxT("encoding")) {
+			SetConverter(&wxConvUTF8);
+		}
+	}
+
+	return doc;
+}
+// }}}
+// {{{ void Connection::ParseTypemap(wxXmlNode *response)
+void Connection::ParseTypemap(wxXmlNode *response) {
+	for (wxXmlNode *node = response->GetChildren(); node != NULL; node = node->GetNext()) {
+		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("map")) {
+			typemap.AddType(Type(Type::StringToCommonType(node->GetPropVal(wxT("type"), wxEmptyString)), node->GetPropVal(wxT("name"), wxEmptyString), node->GetPropVal(wxT("xsi:type"), wxEmptyString)));
+		}
+	}
+}
+// }}}
+// {{{ bool Connection::ReadAvailable() throw ()
+bool Connection::ReadAvailable() throw () {
+	/* A single read will pick up everything that has arrived so far,
+	 * which may well be more than one frame. Events can also be stale if
+	 * SendCommandWait() has already consumed the data, in which case
+	 * there's nothing to read and we shouldn't block waiting for it. */
+	if (socket && socket->IsData()) {
+		try {
+			SocketSource source(socket, server->GetTransport());
+			size_t read = FillReader(source);
+			DBGP_LOG_DEBUG((wxT("Received chunk of %lu bytes; %lu bytes buffered."), (unsigned long) read, (unsigned long) reader.GetBufferedLength()));
+		}
+		catch (SocketError e) {
+			wxLogError(wxT("Caught socket error in OnSocket: %s"), e.GetMessage().c_str());
+			return false;
+		}
+	}
+	return true;
 }
 // }}}
 // {{{ TransactionID Connection::SendCommand(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError, SocketDestroyedError)
 TransactionID Connection::SendCommand(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError, SocketDestroyedError) {
 	const char *buffer;
 	size_t bufferLen;
-	wxString message(command), txString;
 	TransactionID txID = GetTransactionID();
+	DBGP_TRACE("dbgp", "SendCommand");
 
 	if (socket == NULL) {
 		throw SocketDestroyedError();
 	}
 
-	txString = IntToString(txID);
-	message << wxT(" ") << args.Append(wxT("-i"), txString).GetArguments();
-	if (data && dataLength > 0) {
-		message << wxT(" -- ") << Base64::Encode(data, dataLength);
-	}
-	message << wxT('\0');
+	wxString message(FormatCommand(command, args, txID, data, dataLength));
 
 #if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
 	/* In Unicode mode, cWX2MB returns a wxCharBuffer rather than a char *,
@@ -645,7 +1258,7 @@ TransactionID Connection::SendCommand(const wxString &command, MessageArguments
 	 * memory straight back to our keeping and delete it later, rather than
 	 * having to special case further and have buffer be a different type
 	 * depending on the compilation mode. */
-	buffer = conv->cWX2MB(message.wc_str()).release();
+	buffer = GetConverter()->cWX2MB(message.wc_str()).release();
 #else
 	/* We could call cWX2MB here as well, but it's a no-op, so we'll just
 	 * call c_str() and be done with it. */
@@ -653,8 +1266,18 @@ TransactionID Connection::SendCommand(const wxString &command, MessageArguments
 #endif
 
 	bufferLen = std::strlen(buffer) + 1;
-	wxLogDebug(wxT("TX(%u): %s"), bufferLen, message.c_str());
+	ProtocolLog::Record(this, ProtocolLog::SENT, buffer, bufferLen - 1);
+	recorder.Record(SessionRecorder::SENT, buffer, bufferLen - 1);
+	DBGP_LOG_PROTOCOL((wxT("TX(%lu): %s"), (unsigned long) bufferLen, message.c_str()));
+
+	// The I/O thread may well have the response before Write() returns.
+	statistics.RecordSent(this, command, txID, bufferLen);
+
+	socketMutex.Lock();
 	socket->Write(buffer, bufferLen);
+	bool error = socket->Error();
+	wxSocketError lastError = socket->LastError();
+	socketMutex.Unlock();
 
 #if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
 	/* As we took ownership of the buffer's memory by calling
@@ -662,87 +1285,160 @@ TransactionID Connection::SendCommand(const wxString &command, MessageArguments
 	delete[] buffer;
 #endif
 
-	if (socket->Error()) {
-		throw SocketError(socket->LastError());
+	if (error) {
+		throw SocketError(lastError);
 	}
 
 	return txID;
 }
 // }}}
+// {{{ TransactionID Connection::SendCommandAsync(const wxString &command, MessageArguments args, ResponseHandler *handler, const char *data, size_t dataLength, ResponseParser::Handler *stream) throw (SocketError, SocketDestroyedError)
+TransactionID Connection::SendCommandAsync(const wxString &command, MessageArguments args, ResponseHandler *handler, const char *data, size_t dataLength, ResponseParser::Handler *stream) throw (SocketError, SocketDestroyedError) {
+	TransactionID id;
+
+	/* The I/O thread can start parsing the response as soon as the
+	 * command has been written, so the stream handler has to be
+	 * registered before it can look for it. */
+	wxMutexLocker lock(streamMutex);
+
+	try {
+		id = SendCommand(command, args, data, dataLength);
+	}
+	catch (...) {
+		delete handler;
+		throw;
+	}
+
+	if (stream) {
+		streams[id] = stream;
+	}
+	transactions[id] = new Transaction(command, handler);
+
+	return id;
+}
+// }}}
 // {{{ void Connection::SendCommandImmediate(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError, SocketDestroyedError)
 void Connection::SendCommandImmediate(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError, SocketDestroyedError) {
 	SendCommand(command, args, data, dataLength);
 }
 // }}}
+// {{{ wxXmlDocument Connection::SendCommandStreamed(const wxString &command, MessageArguments args, ResponseParser::Handler &stream) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError)
+wxXmlDocument Connection::SendCommandStreamed(const wxString &command, MessageArguments args, ResponseParser::Handler &stream) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError) {
+	try {
+		return WaitForResponse(SendCommandAsync(command, args, NULL, NULL, 0, &stream));
+	}
+	catch (NotFoundError e) {
+		throw MalformedDocumentError(e.GetMessage());
+	}
+}
+// }}}
 // {{{ wxXmlDocument Connection::SendCommandWait(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError)
 wxXmlDocument Connection::SendCommandWait(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError) {
-	wxString txID;
-
-	if (socket == NULL) {
-		throw SocketDestroyedError();
-	}
-
-	/* Acquire BFL and disable socket notifications so we can get the
-	 * response here without waking the input handler. */
-	pendingMutex.Lock();
-	socket->Notify(false);
+	TransactionID id = SendCommandAsync(command, args, NULL, data, dataLength);
 
 	try {
-		txID = IntToString(SendCommand(command, args, data, dataLength));
+		return WaitForResponse(id);
 	}
-	catch (Error e) {
-		socket->Notify(true);
-		pendingMutex.Unlock();
+	catch (NotFoundError e) {
+		// Can't happen, since we registered the transaction above.
+		throw MalformedDocumentError(e.GetMessage());
+	}
+}
+// }}}
+// {{{ void Connection::SetConverter(wxMBConv *conv)
+void Connection::SetConverter(wxMBConv *conv) {
+	wxMutexLocker lock(socketMutex);
+	this->conv = conv;
+}
+// }}}
+// {{{ wxXmlDocument Connection::WaitForResponse(TransactionID id) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError, SocketDestroyedError)
+wxXmlDocument Connection::WaitForResponse(TransactionID id) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError, SocketDestroyedError) {
+	TransactionMap::iterator i = transactions.find(id);
 
-		throw;
+	if (i == transactions.end() || i->second->handler != NULL) {
+		throw NotFoundError(wxT("No response is pending for transaction ") + IntToString(id) + wxT("."));
 	}
 
-	while (true) {
-		wxXmlDocument doc;
-		wxXmlNode *root;
+	Transaction *transaction = i->second;
+
+	if (!transaction->complete) {
+		DBGP_TRACE("dbgp", "Wait");
+		BeginWait();
+
 		try {
-			doc = GetMessage();
-			root = doc.GetRoot();
+			while (!transaction->complete) {
+				wxXmlDocument doc(GetMessage());
 
-			HandleMessage(doc);
+				try {
+					DispatchMessage(doc);
+				}
+				catch (EngineError e) {
+					/* An error for a command that nobody is
+					 * waiting on; it's not ours to throw. */
+					wxLogError(wxT("Caught engine error while waiting for a response: %s"), e.GetMessage().c_str());
+				}
+			}
 		}
-		catch (Error e) {
-			/* Clean up and rethrow. Oh, for a RAII wxMutex or C++
-			 * supporting finally... */
-			socket->Notify(true);
-			pendingMutex.Unlock();
+		catch (...) {
+			EndWait();
+			ForgetStream(id);
+			transactions.erase(id);
+			delete transaction;
 
 			throw;
 		}
-		if (root->GetName() == wxT("response")) {
-			// Check the returned transaction ID.
-			wxString recvTx(root->GetPropVal(wxT("transaction_id"), wxEmptyString));
-			if (recvTx == txID) {
-				socket->Notify(true);
-				pendingMutex.Unlock();
 
-				return doc;
-			}
-			else {
-				wxLogDebug(wxT("Unexpected transaction ID '%s' in response."), recvTx.c_str());
-			}
-		}
-		else {
-			/* This should have been handled by HandleMessage(), so we'll
-			 * ignore it. */
-			wxLogDebug(wxT("Got non-response packet '%s' from debugger engine, ignoring."), root->GetName().c_str());
-		}
+		EndWait();
+	}
+
+	transactions.erase(id);
+
+	if (transaction->error) {
+		EngineError e(*transaction->error);
+		delete transaction;
+		throw e;
 	}
+
+	wxXmlDocument doc(transaction->response);
+	delete transaction;
+
+	return doc;
 }
 // }}}
-// {{{ void Connection::TestCommand(const wxString &command) throw ()
-void Connection::TestCommand(const wxString &command) throw () {
-	try {
-		supported[command] = (FeatureGet(command) == wxT("1"));
+
+// {{{ void Connection::BeginWait() throw ()
+void Connection::BeginWait() throw () {
+	/* Socket events are still delivered while we wait if the wait yields
+	 * to the event loop, but OnSocket ignores them until we're done. */
+	waitDepth++;
+}
+// }}}
+// {{{ void Connection::EndWait() throw ()
+void Connection::EndWait() throw () {
+	if (--waitDepth > 0) {
+		return;
 	}
-	catch (Error e) {
-		wxLogDebug(wxT("Error testing command: %s."), command.c_str());
-		supported[command] = false;
+
+	/* Anything that arrived along with the response, or whose socket
+	 * event was ignored while we waited, won't generate an event of its
+	 * own, so make sure it gets handled. A malformed frame will be
+	 * reported by the pending frame handler. */
+	bool pending;
+	if (thread) {
+		pending = !thread->IsEmpty();
+	}
+	else {
+		try {
+			pending = reader.HasFrame() || (socket && socket->IsData());
+		}
+		catch (SocketError e) {
+			pending = true;
+		}
+	}
+
+	if (pending) {
+		wxCommandEvent e(wxEVT_DBGP_PENDING_FRAMES);
+		AddPendingEvent(e);
 	}
 }
 // }}}
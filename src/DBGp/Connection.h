@@ -38,14 +38,21 @@
 #include <wx/event.h>
 #include <wx/socket.h>
 #include <wx/string.h>
+#include <wx/thread.h>
 #include <wx/xml/xml.h>
 
 #include "DBGp/Base64.h"
 #include "DBGp/Breakpoint.h"
+#include "DBGp/ConnectionFilter.h"
 #include "DBGp/Error/Error.h"
+#include "DBGp/FrameReader.h"
 #include "DBGp/MessageArguments.h"
 #include "DBGp/Property.h"
+#include "DBGp/ResponseHandler.h"
+#include "DBGp/ResponseParser.h"
+#include "DBGp/SessionRecorder.h"
 #include "DBGp/Stack.h"
+#include "DBGp/Statistics.h"
 #include "DBGp/Typemap.h"
 
 namespace DBGp {
@@ -67,6 +74,12 @@ namespace DBGp {
 			 */
 			friend class Breakpoint;
 
+			/**
+			 * Allow BreakpointBatch instances to pipeline
+			 * breakpoint commands.
+			 */
+			friend class BreakpointBatch;
+
 			/**
 			 * Allow Context instances to directly communicate with
 			 * the debugging engine.
@@ -94,6 +107,19 @@ namespace DBGp {
 			/** Container for breakpoints within the connection. */
 			typedef std::list<Breakpoint *> BreakpointList;
 
+			/**
+			 * The number of children we ask the engine to send in
+			 * each page of a property.
+			 */
+			static const unsigned int DEFAULT_MAX_CHILDREN = 100;
+
+			/**
+			 * The number of levels of nested properties we ask the
+			 * engine to send in each response. Anything deeper is
+			 * retrieved on demand.
+			 */
+			static const unsigned int DEFAULT_MAX_DEPTH = 1;
+
 			/** The possible states of the DBGp engine. */
 			typedef enum {
 				/** Engine starting, yet to run. */
@@ -130,7 +156,59 @@ namespace DBGp {
 
 			void Close();
 			bool CommandSupported(const wxString &command);
-			inline void Destroy() { socket->Destroy(); }
+			inline void Destroy() { Close(); }
+
+			/**
+			 * Returns the number of children the debugging engine
+			 * will send in each page of a property, as negotiated
+			 * at initialisation.
+			 *
+			 * @return The page size.
+			 */
+			inline unsigned int GetMaxChildren() const { return maxChildren; }
+
+			/**
+			 * Returns the depth of nested properties the debugging
+			 * engine will send in each response, as negotiated at
+			 * initialisation.
+			 *
+			 * @return The maximum depth.
+			 */
+			inline unsigned int GetMaxDepth() const { return maxDepth; }
+
+			/**
+			 * Returns the traffic and latency figures for each
+			 * command sent and message received on this
+			 * connection.
+			 *
+			 * @return The statistics.
+			 */
+			inline Statistics &GetStatistics() { return statistics; }
+
+			/**
+			 * Returns the last engine status we know about,
+			 * without asking the engine.
+			 *
+			 * @return The engine status.
+			 */
+			inline EngineStatus GetStatus() const { return status; }
+
+			/**
+			 * Checks if the traffic on this connection is being
+			 * recorded.
+			 *
+			 * @return True if StartRecording() has succeeded and
+			 * StopRecording() hasn't since been called.
+			 */
+			inline bool IsRecording() const { return recorder.IsOpen(); }
+
+			/**
+			 * Checks if incoming messages are being read on a
+			 * dedicated I/O thread.
+			 *
+			 * @return True if StartIOThread() has succeeded.
+			 */
+			inline bool IsThreaded() const { return thread != NULL; }
 
 			/**
 			 * Sets the event handler.
@@ -140,6 +218,37 @@ namespace DBGp {
 			 */
 			void SetEventHandler(wxEvtHandler *handler);
 
+			/**
+			 * Moves reading, framing and parsing of incoming
+			 * messages onto a dedicated thread, which hands parsed
+			 * messages back to the main thread through a lock-free
+			 * queue. Messages that nothing is waiting on are
+			 * dispatched from the event loop, so they never block
+			 * it. This should be called before the init packet has
+			 * been handled, and can't be undone.
+			 *
+			 * @return True if the thread is running.
+			 */
+			bool StartIOThread();
+
+			/**
+			 * Starts recording every message received from and
+			 * command sent to the debugging engine, in the format
+			 * read by SessionReplay. Any recording already in
+			 * progress is finished first.
+			 *
+			 * @param[in] file The file to record to. It will be
+			 * overwritten.
+			 * @return True if the recording has started.
+			 */
+			bool StartRecording(const wxString &file);
+
+			/**
+			 * Finishes the recording started by StartRecording(),
+			 * if any.
+			 */
+			void StopRecording();
+
 			/**
 			 * Tells the debugging engine to immediately break.
 			 *
@@ -311,6 +420,23 @@ namespace DBGp {
 			 */
 			const BreakpointList &GetBreakpoints() const;
 
+			/**
+			 * Refreshes the state of every breakpoint from the
+			 * debugging engine with a single breakpoint_list
+			 * command, rather than a breakpoint_get for each.
+			 * Results are matched to breakpoints by ID; breakpoints
+			 * the engine no longer has (such as temporary
+			 * breakpoints that have been hit) lose their ID, and
+			 * breakpoints we don't know about are ignored.
+			 *
+			 * @return The breakpoints that changed.
+			 * @throws EngineError Thrown if the debugging engine
+			 * returns an error.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 */
+			BreakpointList RefreshBreakpoints() throw (EngineError, MalformedDocumentError, SocketError);
+
 			/**
 			 * Removes a breakpoint. The breakpoint will be deleted
 			 * within this function, so it should not be referenced
@@ -340,6 +466,19 @@ namespace DBGp {
 			 */
 			static wxString EngineStatusToString(EngineStatus status);
 
+			/**
+			 * Builds the wire form of a command, up to and including
+			 * the terminating NULL, but before charset conversion.
+			 *
+			 * @param[in] command The command name.
+			 * @param[in] args The command arguments.
+			 * @param[in] id The transaction ID to send with it.
+			 * @param[in] data Any data to Base64 encode and append.
+			 * @param[in] dataLength The length of the data.
+			 * @return The formatted command.
+			 */
+			static wxString FormatCommand(const wxString &command, MessageArguments args, TransactionID id, const char *data = NULL, size_t dataLength = 0);
+
 			/**
 			 * Converts a DBGp status string to an EngineStatus.
 			 *
@@ -351,24 +490,105 @@ namespace DBGp {
 			static EngineStatus StringToEngineStatus(const wxString &s) throw (NotFoundError);
 
 		protected:
+			/**
+			 * The state kept for each command that is awaiting a
+			 * response from the debugging engine.
+			 */
+			class Transaction {
+				public:
+					/**
+					 * Constructs a new transaction.
+					 *
+					 * @param[in] command The command sent.
+					 * @param[in] handler The handler to
+					 * call, or NULL if the response will be
+					 * collected with WaitForResponse().
+					 */
+					Transaction(const wxString &command, ResponseHandler *handler) : command(command), complete(false), error(NULL), handler(handler) {}
+
+					/** Destructor. */
+					~Transaction() { delete error; delete handler; }
+
+					/** The command that was sent. */
+					wxString command;
+
+					/** Whether the response has arrived. */
+					bool complete;
+
+					/** The engine error returned, if any. */
+					EngineError *error;
+
+					/** The handler to call, if any. */
+					ResponseHandler *handler;
+
+					/** The response, once it has arrived. */
+					wxXmlDocument response;
+			};
+
+			/**
+			 * The thread that reads and parses incoming messages
+			 * when StartIOThread() has been called.
+			 */
+			class IOThread;
+
+			/**
+			 * The DocumentBuilder used for incoming messages,
+			 * which diverts responses to their transaction's
+			 * stream handler.
+			 */
+			class MessageBuilder;
+
+			/**
+			 * Container for stream handlers, keyed by the
+			 * transaction ID of the response they receive.
+			 */
+			typedef std::map<TransactionID, ResponseParser::Handler *> StreamMap;
+
+			/** Container for transactions, keyed by ID. */
+			typedef std::map<TransactionID, Transaction *> TransactionMap;
+
 			/** Breakpoints defined within the connection. */
 			BreakpointList breakpoints;
 
-			/** The conversion object for the encoding in use. */
+			/**
+			 * The conversion object for the encoding in use. It's
+			 * switched by whichever thread parses the engine's
+			 * response to setting the encoding, so it's only
+			 * accessed through GetConverter() and SetConverter().
+			 */
 			wxMBConv *conv;
 
+			/**
+			 * When the first byte of the next frame in the reader
+			 * was read.
+			 */
+			wxUint64 frameStart;
+
 			/** The event handler to call. */
 			wxEvtHandler *handler;
 
+			/** When data was last read into the reader. */
+			wxUint64 lastRead;
+
+			/** The negotiated max_children feature value. */
+			unsigned int maxChildren;
+
+			/** The negotiated max_depth feature value. */
+			unsigned int maxDepth;
+
 			/**
-			 * Mutex to prevent multiple commands being sent up
-			 * simultaneously. We don't <em>absolutely</em> need
-			 * this, given the transaction ID support in DBGp, but
-			 * it simplifies things greatly, since we're not that
-			 * interested in asynchronous requests being sent up to
-			 * the debugging engine.
+			 * The buffered reader that incoming frames are split
+			 * out of. Any partial frame is kept here between
+			 * socket events. Once the I/O thread has started, it
+			 * is only touched by that thread.
+			 */
+			FrameReader reader;
+
+			/**
+			 * Records the traffic on this connection when
+			 * StartRecording() has been called.
 			 */
-			wxMutex pendingMutex;
+			SessionRecorder recorder;
 
 			/**
 			 * A pointer back to the server that spawned this
@@ -379,15 +599,48 @@ namespace DBGp {
 			/** The TCP socket to the debugging engine. */
 			wxSocketBase *socket;
 
+			/**
+			 * The mutex serialising reads on the I/O thread with
+			 * writes from the main thread, since wxSocketBase
+			 * keeps its error state per object. It also guards
+			 * the conversion object.
+			 */
+			wxMutex socketMutex;
+
+			/** Per-command traffic and latency figures. */
+			Statistics statistics;
+
 			/** The current engine status. */
 			EngineStatus status;
 
+			/**
+			 * Stream handlers for responses that haven't been
+			 * parsed yet.
+			 */
+			StreamMap streams;
+
+			/**
+			 * The mutex protecting the stream handlers. It's held
+			 * for the whole of a parse that uses one, so a handler
+			 * can't be forgotten while it's in use.
+			 */
+			wxMutex streamMutex;
+
 			/** Support status of extended commands. */
 			std::map<wxString, bool> supported;
 
+			/** The I/O thread, if one has been started. */
+			IOThread *thread;
+
 			/** The current transaction ID. */
 			TransactionID txID;
 
+			/**
+			 * Commands that have been sent, but whose responses
+			 * haven't yet been collected.
+			 */
+			TransactionMap transactions;
+
 			/** The debugging engine's typemap. */
 			Typemap typemap;
 
@@ -398,14 +651,59 @@ namespace DBGp {
 			wxMutex txMutex;
 
 			/**
-			 * Configures the debugging engine to copy data
-			 * destined for stdout and stderr to us.
+			 * The number of WaitForResponse() calls currently on
+			 * the stack.
 			 */
-			void CopyOutput() throw ();
+			unsigned int waitDepth;
 
 			/**
-			 * Retrieves the next DBGp message waiting on the
-			 * socket. This will block if no message if waiting.
+			 * Routes a message to the transaction it answers, if
+			 * any, after handling it. Engine errors are recorded
+			 * against their transaction rather than thrown.
+			 *
+			 * @param[in] doc The message.
+			 * @throws EngineError Thrown if a response that
+			 * nothing is waiting for contains an error.
+			 * @throws MalformedDocumentError Thrown if the message
+			 * is malformed.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 */
+			void DispatchMessage(wxXmlDocument &doc) throw (EngineError, MalformedDocumentError, SocketError);
+
+			/**
+			 * Drops a connection that the server's filter has
+			 * turned away, without negotiating anything with the
+			 * engine. The connection is removed from the server
+			 * once control returns to the event loop.
+			 *
+			 * @param[in] action Whether to detach or simply close
+			 * the socket.
+			 */
+			void Drop(ConnectionFilter::Action action) throw ();
+
+			/**
+			 * Performs a single read into the frame reader, noting
+			 * when the data arrived for the statistics.
+			 *
+			 * @param[in] source The source to read from.
+			 * @return The number of bytes read.
+			 * @throws SocketError Thrown if the read fails.
+			 */
+			size_t FillReader(FrameReader::Source &source) throw (SocketError);
+
+			/**
+			 * Returns the conversion object for the encoding in
+			 * use. This may be called from any thread.
+			 *
+			 * @return The conversion object.
+			 */
+			wxMBConv *GetConverter();
+
+			/**
+			 * Retrieves the next DBGp message, either from the
+			 * frames already buffered or from the socket. This
+			 * will block if no message is waiting.
 			 *
 			 * @return The XML document created from the message.
 			 * @throws SocketError Thrown if a communications error
@@ -424,15 +722,6 @@ namespace DBGp {
 			 */
 			TransactionID GetTransactionID();
 
-			/**
-			 * Decodes encoded data within a message. Base64 errors
-			 * will be logged but otherwise ignored.
-			 *
-			 * @param[in,out] node The response element in the XML
-			 * document.
-			 */
-			void HandleEncodedMessage(wxXmlNode *node);
-
 			/**
 			 * Examines a message returned from the debugging
 			 * engine and performs any actions that are
@@ -468,15 +757,78 @@ namespace DBGp {
 			 */
 			void HandleResponseError(wxXmlNode *error) throw (EngineError);
 
+			/**
+			 * Forgets the stream handler registered for a
+			 * transaction, waiting for it to finish if a response
+			 * is being parsed into it.
+			 *
+			 * @param[in] id The transaction ID.
+			 */
+			void ForgetStream(TransactionID id) throw ();
+
+			/**
+			 * Handles every complete frame that is currently
+			 * buffered, or every message the I/O thread has
+			 * queued. Errors are logged rather than thrown.
+			 */
+			void HandlePendingFrames() throw ();
+
+			/**
+			 * Removes the next complete frame from the frame
+			 * reader, along with when it arrived.
+			 *
+			 * @param[out] payload Set to the start of the payload.
+			 * @param[out] length Set to the length of the payload.
+			 * @param[out] timing Set to when the first and last
+			 * bytes of the frame were read.
+			 * @return True if a frame was available.
+			 * @throws SocketError Thrown if the buffered data
+			 * isn't a valid frame.
+			 */
+			bool NextFrame(const char *&payload, size_t &length, Statistics::Timing &timing) throw (SocketError);
+
 			/**
 			 * Negotiates the features that we want with the
-			 * debugging engine.
+			 * debugging engine, has it copy stdout and stderr to
+			 * us and retrieves its typemap. Every command is sent
+			 * in a single burst before any response is waited
+			 * for, and anything already known from the server's
+			 * profile cache for this engine isn't asked for at
+			 * all.
 			 *
+			 * @param[in] init The init packet.
 			 * @todo Actually retrieve the encoding if we can't set
 			 * it to UTF-8 and see if we have a conversion class in
 			 * wxWidgets for it.
 			 */
-			void NegotiateFeatures() throw ();
+			void Initialise(wxXmlNode *init) throw ();
+
+			/**
+			 * Works out the value in effect for a numeric feature
+			 * from the response to setting it.
+			 *
+			 * @param[in] name The feature name.
+			 * @param[in] id The transaction ID of the feature_set
+			 * command.
+			 * @param[in] value The value requested.
+			 * @param[in] fallback The value to assume if the
+			 * engine can't tell us what it's using.
+			 * @param[in] query Whether to ask the engine for the
+			 * value in effect if it refused ours. This costs
+			 * another round trip.
+			 * @return The value in effect.
+			 */
+			unsigned int NegotiateNumericFeature(const wxString &name, TransactionID id, unsigned int value, unsigned int fallback, bool query) throw ();
+
+			/**
+			 * Event handler posted to ourselves when frames are
+			 * left in the buffer after a synchronous command,
+			 * since no socket event will arrive for them, and by
+			 * the I/O thread when it has queued messages.
+			 *
+			 * @param[in] event The event.
+			 */
+			void OnPendingFrames(wxCommandEvent &event) throw ();
 
 			/**
 			 * Event handler when there is a socket event: either
@@ -487,6 +839,41 @@ namespace DBGp {
 			 */
 			void OnSocket(wxSocketEvent &event) throw ();
 
+			/**
+			 * Parses a frame payload into an XML document. Encoded
+			 * content is decoded as it's parsed, and the body of a
+			 * response whose transaction has a stream handler is
+			 * sent to that handler rather than into the document.
+			 *
+			 * The message is recorded in the statistics, along
+			 * with how long it took to parse and decode.
+			 *
+			 * @param[in] payload The NULL terminated payload.
+			 * @param[in] length The length of the payload.
+			 * @param[in] timing When the frame arrived, if known.
+			 * @return The XML document.
+			 * @throws MalformedDocumentError Thrown if the payload
+			 * isn't a well formed XML document.
+			 */
+			wxXmlDocument ParseMessage(const char *payload, size_t length, const Statistics::Timing &timing = Statistics::Timing()) throw (MalformedDocumentError);
+
+			/**
+			 * Fills the typemap from a typemap_get response.
+			 *
+			 * @param[in] response The response element.
+			 */
+			void ParseTypemap(wxXmlNode *response);
+
+			/**
+			 * Reads whatever has arrived on the socket into the
+			 * frame reader without blocking. Only used when there
+			 * is no I/O thread.
+			 *
+			 * @return False if a socket error occurred, which
+			 * will have been logged.
+			 */
+			bool ReadAvailable() throw ();
+
 			/**
 			 * Low-level function to send a command.
 			 * 
@@ -507,10 +894,45 @@ namespace DBGp {
 			 */
 			virtual TransactionID SendCommand(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError, SocketDestroyedError);
 
+			/**
+			 * Sends a command to the debugging engine without
+			 * waiting for the response, which allows any number of
+			 * commands to be in flight at once.
+			 *
+			 * If a handler is given, it will be called when the
+			 * response arrives, whether that happens in the socket
+			 * event handler or while waiting for another response.
+			 * Otherwise, the returned transaction ID acts as a
+			 * future: the response is kept until it's collected
+			 * with WaitForResponse(), which must be called.
+			 *
+			 * @param[in] command The command to execute.
+			 * @param[in] args The arguments to the command.
+			 * @param[in] handler The handler to call with the
+			 * response, or NULL. The connection takes ownership
+			 * of the handler.
+			 * @param[in] data The data to be encoded and sent up
+			 * with the command, if any.
+			 * @param[in] dataLength The length of the data to be
+			 * sent. Ignored if data is NULL.
+			 * @param[in] stream The handler to stream the body of
+			 * the response to, if any. It must remain valid until
+			 * the response has been collected or ForgetStream()
+			 * has been called, and may be called from the I/O
+			 * thread.
+			 * @return The transaction ID associated with the
+			 * command.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 * @throws SocketDestroyedError Thrown if the socket
+			 * has already been destroyed.
+			 */
+			TransactionID SendCommandAsync(const wxString &command, MessageArguments args, ResponseHandler *handler = NULL, const char *data = NULL, size_t dataLength = 0, ResponseParser::Handler *stream = NULL) throw (SocketError, SocketDestroyedError);
+
 			/**
 			 * Sends a command to the debugging engine and does not
 			 * wait for a response. Any response will be picked up
-			 * by OnInput and ignored.
+			 * by OnSocket and ignored.
 			 *
 			 * @param[in] command The command to execute.
 			 * @param[in] args The arguments to the command.
@@ -533,8 +955,8 @@ namespace DBGp {
 			 * that certain commands may not return a response
 			 * immediately. In that case, this function will block
 			 * until it receives a response. Some callbacks may be
-			 * called while waiting if stream messages are
-			 * received, though.
+			 * called while waiting if stream messages or responses
+			 * to asynchronous commands are received, though.
 			 *
 			 * @param[in] command The command to execute.
 			 * @param[in] args The arguments to the command.
@@ -555,13 +977,72 @@ namespace DBGp {
 			virtual wxXmlDocument SendCommandWait(const wxString &command, MessageArguments args, const char *data = NULL, size_t dataLength = 0) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError);
 
 			/**
-			 * Tests if a command is supported.
+			 * Sends a command to the debugging engine and waits
+			 * for a response, with everything below the root
+			 * element of the response (other than errors) sent
+			 * straight to a stream handler as it is parsed.
 			 *
-			 * @param[in] command The command to test for.
+			 * @param[in] command The command to execute.
+			 * @param[in] args The arguments to the command.
+			 * @param[in] stream The handler to stream the
+			 * response to.
+			 * @return The XML document sent back by the server,
+			 * which will only contain the root element.
+			 * @throws EngineError Thrown if the debugging engine
+			 * returns an error.
+			 * @throws MalformedDocumentError Thrown if the
+			 * response is malformed.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 * @throws SocketDestroyedError Thrown if the socket
+			 * has already been destroyed.
 			 */
-			void TestCommand(const wxString &command) throw ();
+			wxXmlDocument SendCommandStreamed(const wxString &command, MessageArguments args, ResponseParser::Handler &stream) throw (EngineError, MalformedDocumentError, SocketError, SocketDestroyedError);
+
+			/**
+			 * Switches the conversion object used for messages
+			 * from here on. This may be called from any thread.
+			 *
+			 * @param[in] conv The new conversion object.
+			 */
+			void SetConverter(wxMBConv *conv);
+
+			/**
+			 * Waits for the response to a command sent with
+			 * SendCommandAsync() without a handler. Responses to
+			 * other commands that arrive in the meantime are
+			 * routed to their own transactions.
+			 *
+			 * @param[in] id The transaction ID of the command.
+			 * @return The response document.
+			 * @throws EngineError Thrown if the debugging engine
+			 * returned an error for the command.
+			 * @throws MalformedDocumentError Thrown if a message
+			 * is malformed.
+			 * @throws NotFoundError Thrown if no response is
+			 * pending for the transaction ID.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 * @throws SocketDestroyedError Thrown if the socket
+			 * has already been destroyed.
+			 */
+			wxXmlDocument WaitForResponse(TransactionID id) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError, SocketDestroyedError);
 
 			//DECLARE_EVENT_TABLE()
+
+		private:
+			/**
+			 * Marks the start of a wait for responses, during
+			 * which socket events are ignored. Calls may be
+			 * nested.
+			 */
+			void BeginWait() throw ();
+
+			/**
+			 * Marks the end of a wait, and makes sure anything
+			 * that arrived during the outermost one is handled.
+			 */
+			void EndWait() throw ();
 	};
 }
 
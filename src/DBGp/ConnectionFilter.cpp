@@ -0,0 +1,78 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/ConnectionFilter.h"
+
+using namespace DBGp;
+
+// {{{ ConnectionFilter::ConnectionFilter(Action defaultAction)
+ConnectionFilter::ConnectionFilter(Action defaultAction) : defaultAction(defaultAction) {
+}
+// }}}
+
+// {{{ void ConnectionFilter::AddRule(Field field, const wxString &pattern, Action action)
+void ConnectionFilter::AddRule(Field field, const wxString &pattern, Action action) {
+	rules.push_back(Rule(field, pattern, action));
+}
+// }}}
+// {{{ ConnectionFilter::Action ConnectionFilter::Check(const wxString &appID, const wxString &fileURI, const wxString &ideKey) const
+ConnectionFilter::Action ConnectionFilter::Check(const wxString &appID, const wxString &fileURI, const wxString &ideKey) const {
+	for (std::list<Rule>::const_iterator i = rules.begin(); i != rules.end(); i++) {
+		const wxString *value;
+
+		switch (i->field) {
+			case APPID:
+				value = &appID;
+				break;
+			case FILEURI:
+				value = &fileURI;
+				break;
+			case IDEKEY:
+			default:
+				value = &ideKey;
+				break;
+		}
+
+		if (value->Matches(i->pattern)) {
+			return i->action;
+		}
+	}
+
+	return defaultAction;
+}
+// }}}
+// {{{ void ConnectionFilter::Clear()
+void ConnectionFilter::Clear() {
+	rules.clear();
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
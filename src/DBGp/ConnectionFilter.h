@@ -0,0 +1,146 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_CONNECTIONFILTER_H
+#define DBGP_CONNECTIONFILTER_H
+
+#include <list>
+
+#include <wx/string.h>
+
+namespace DBGp {
+	/**
+	 * A set of rules deciding whether to accept new connections, based
+	 * purely on the attributes of the init packet. Because nothing else
+	 * is needed, the decision can be made before any commands are sent to
+	 * the engine, so unwanted sessions never cost a feature negotiation.
+	 *
+	 * Rules are checked in the order they were added and the first
+	 * matching rule wins; if none match, the default action is used.
+	 */
+	class ConnectionFilter {
+		public:
+			/** What to do with a matching connection. */
+			typedef enum {
+				/** Accept the connection as normal. */
+				ACCEPT,
+				/** Close the socket without sending anything. */
+				REJECT,
+				/**
+				 * Send a detach command, which lets the
+				 * script carry on without a debugger, and
+				 * then close the socket.
+				 */
+				DETACH
+			} Action;
+
+			/** The init packet attribute a rule matches on. */
+			typedef enum {
+				APPID,
+				FILEURI,
+				IDEKEY
+			} Field;
+
+			/**
+			 * Constructs a filter with no rules.
+			 *
+			 * @param[in] defaultAction The action to take when no
+			 * rule matches.
+			 */
+			ConnectionFilter(Action defaultAction = ACCEPT);
+
+			/**
+			 * Adds a rule to the end of the filter.
+			 *
+			 * @param[in] field The attribute to match.
+			 * @param[in] pattern The pattern to match against,
+			 * which can contain the * and ? wildcards.
+			 * @param[in] action The action to take on a match.
+			 */
+			void AddRule(Field field, const wxString &pattern, Action action);
+
+			/**
+			 * Decides what to do with a new connection.
+			 *
+			 * @param[in] appID The appid attribute of the init
+			 * packet.
+			 * @param[in] fileURI The fileuri attribute.
+			 * @param[in] ideKey The idekey attribute.
+			 * @return The action to take.
+			 */
+			Action Check(const wxString &appID, const wxString &fileURI, const wxString &ideKey) const;
+
+			/** Removes every rule. The default action is kept. */
+			void Clear();
+
+			/**
+			 * Returns the action taken when no rule matches.
+			 *
+			 * @return The default action.
+			 */
+			inline Action GetDefaultAction() const { return defaultAction; }
+
+			/**
+			 * Returns whether any rules have been added.
+			 *
+			 * @return True if there are no rules.
+			 */
+			inline bool IsEmpty() const { return rules.empty(); }
+
+			/**
+			 * Sets the action taken when no rule matches.
+			 *
+			 * @param[in] action The new default action.
+			 */
+			inline void SetDefaultAction(Action action) { defaultAction = action; }
+
+		private:
+			/** A single filtering rule. */
+			class Rule {
+				public:
+					inline Rule(Field field, const wxString &pattern, Action action) : action(action), field(field), pattern(pattern) {}
+
+					Action action;
+					Field field;
+					wxString pattern;
+			};
+
+			/** The action taken when no rule matches. */
+			Action defaultAction;
+
+			/** The rules, in the order they're checked. */
+			std::list<Rule> rules;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
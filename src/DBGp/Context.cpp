@@ -31,6 +31,7 @@
 
 #include "DBGp/Context.h"
 #include "DBGp/Connection.h"
+#include "DBGp/PropertyBuilder.h"
 #include "DBGp/StackLevel.h"
 #include "DBGp/Utility.h"
 
@@ -39,68 +40,100 @@
 using namespace DBGp;
 
 // {{{ Context::Context(Connection *conn, StackLevel *level, const wxString &id, const wxString &name)
-Context::Context(Connection *conn, StackLevel *level, const wxString &id, const wxString &name) : conn(conn), id(id), level(level), name(name) {
-	RetrieveProperties();
+Context::Context(Connection *conn, StackLevel *level, const wxString &id, const wxString &name) : conn(conn), id(id), index(NULL), level(level), name(name), propertiesRetrieved(false) {
 }
 // }}}
 // {{{ Context::Context(const Context &context)
-Context::Context(const Context &context) : conn(context.conn), id(context.id), level(context.level), name(context.name) {
-	for (Property::PropertyMap::const_iterator i = context.properties.begin(); i != context.properties.end(); i++) {
-		Property *prop = new Property(*(i->second));
-		prop->context = this;
-		properties[i->first] = prop;
+Context::Context(const Context &context) : conn(context.conn), id(context.id), index(NULL), level(context.level), name(context.name), order(context.order), properties(context.properties), propertiesRetrieved(context.propertiesRetrieved) {
+	// The properties are shared with the original, not copied.
+	for (Property::PropertyMap::iterator i = properties.begin(); i != properties.end(); i++) {
+		i->second->Ref();
 	}
 }
 // }}}
 // {{{ Context::~Context()
 Context::~Context() {
+	InvalidateIndex();
+
 	for (Property::PropertyMap::iterator i = properties.begin(); i != properties.end(); i++) {
-		delete i->second;
+		// Anything still holding the property mustn't point back at us.
+		i->second->DetachContext(this);
+		i->second->Unref();
 	}
 }
 // }}}
 
+// {{{ Property *Context::FindProperty(const wxString &name) const
+Property *Context::FindProperty(const wxString &name) const {
+	if (!propertiesRetrieved) {
+		return NULL;
+	}
+
+	if (index == NULL) {
+		index = new PropertyHash(properties.size());
+		for (Property::PropertyMap::const_iterator i = properties.begin(); i != properties.end(); i++) {
+			(*index)[i->first] = i->second;
+		}
+	}
+
+	PropertyHash::const_iterator i = index->find(name);
+	return (i != index->end() ? i->second : NULL);
+}
+// }}}
 // {{{ const Property::PropertyMap &Context::GetProperties() const throw (EngineError, SocketError)
 const Property::PropertyMap &Context::GetProperties() const throw (EngineError, SocketError) {
+	RetrieveProperties();
 	return properties;
 }
 // }}}
+// {{{ const Property::PropertyVector &Context::GetPropertiesInOrder() const throw (EngineError, SocketError)
+const Property::PropertyVector &Context::GetPropertiesInOrder() const throw (EngineError, SocketError) {
+	RetrieveProperties();
+	return order;
+}
+// }}}
 // {{{ Property *Context::GetProperty(const wxString &name) throw (EngineError, NotFoundError, SocketError)
 Property *Context::GetProperty(const wxString &name) throw (EngineError, NotFoundError, SocketError) {
 	RetrieveProperties();
-	Property::PropertyMap::iterator i = properties.find(name);
-	if (i == properties.end()) {
+	Property *prop = FindProperty(name);
+	if (prop == NULL) {
 		throw NotFoundError(wxT("Property '") + name + wxT("' not found."));
 	}
-	return i->second;
+	return prop;
 }
 // }}}
 
 // {{{ void Context::UpdateProperties() throw (EngineError, SocketError)
 void Context::UpdateProperties() throw (EngineError, SocketError) {
 	for (Property::PropertyMap::iterator i = properties.begin(); i != properties.end(); i++) {
-		delete i->second;
+		i->second->Unref();
 	}
+	order.clear();
+	properties.clear();
+	propertiesRetrieved = false;
+	InvalidateIndex();
+
 	RetrieveProperties();
 }
 // }}}
 
-// {{{ void Context::RetrieveProperties() throw (EngineError, SocketError)
-void Context::RetrieveProperties() throw (EngineError, SocketError) {
-	if (properties.size() > 0) {
+// {{{ void Context::InvalidateIndex() const
+void Context::InvalidateIndex() const {
+	delete index;
+	index = NULL;
+}
+// }}}
+// {{{ void Context::RetrieveProperties() const throw (EngineError, SocketError)
+void Context::RetrieveProperties() const throw (EngineError, SocketError) {
+	if (propertiesRetrieved) {
 		return;
 	}
 
 	MessageArguments args(2, wxT("-d"), IntToString(level->GetLevel()).c_str(), wxT("-c"), id.c_str());
-	wxXmlDocument doc(conn->SendCommandWait(wxT("context_get"), args));
+	PropertyBuilder builder(conn, const_cast<Context *>(this), level->GetLevel(), properties, &order);
 
-	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
-		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("property")) {
-			Property *prop = new Property(conn, this, level->GetLevel());
-			prop->ParsePropertyElement(node);
-			properties[prop->GetName()] = prop;
-		}
-	}
+	conn->SendCommandStreamed(wxT("context_get"), args, builder);
+	propertiesRetrieved = true;
 }
 // }}}
 
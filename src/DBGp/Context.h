@@ -43,6 +43,10 @@ namespace DBGp {
 	/** A class representing a context within a stack frame. */
 	class Context {
 		public:
+			/* StackLevel needs to be able to stream pipelined
+			 * context_get responses into our properties. */
+			friend class StackLevel;
+
 			/**
 			 * Constructs a new Context object.
 			 *
@@ -64,6 +68,17 @@ namespace DBGp {
 			/** Context destructor. */
 			virtual ~Context();
 
+			/**
+			 * Looks up a property that has already been retrieved,
+			 * without going back to the engine or throwing if it
+			 * isn't there, as hover lookups need.
+			 *
+			 * @param[in] name The property to look for.
+			 * @return The property, or NULL if it doesn't exist or
+			 * the properties haven't been retrieved yet.
+			 */
+			Property *FindProperty(const wxString &name) const;
+
 			/**
 			 * Returns the context ID.
 			 *
@@ -79,7 +94,9 @@ namespace DBGp {
 			inline wxString GetName() const { return name; }
 
 			/**
-			 * Returns the properties defined within the context.
+			 * Returns the properties defined within the context,
+			 * retrieving them from the engine if this is the first
+			 * time they've been requested.
 			 *
 			 * @return The defined properties.
 			 * @throws EngineError Thrown if the debugging engine
@@ -89,6 +106,20 @@ namespace DBGp {
 			 */
 			const Property::PropertyMap &GetProperties() const throw (EngineError, SocketError);
 
+			/**
+			 * Returns the properties defined within the context in
+			 * the order the engine sent them, retrieving them from
+			 * the engine if this is the first time they've been
+			 * requested.
+			 *
+			 * @return The defined properties.
+			 * @throws EngineError Thrown if the debugging engine
+			 * returns an error.
+			 * @throws SocketError Thrown if a communications error
+			 * occurs.
+			 */
+			const Property::PropertyVector &GetPropertiesInOrder() const throw (EngineError, SocketError);
+
 			/**
 			 * Retrieves a specific property from the context.
 			 *
@@ -110,6 +141,15 @@ namespace DBGp {
 			 */
 			inline StackLevel *GetStackLevel() const { return level; }
 
+			/**
+			 * Checks if the properties within the context have
+			 * already been retrieved from the engine.
+			 *
+			 * @return True if the properties are available without
+			 * a round trip to the engine.
+			 */
+			inline bool HasProperties() const { return propertiesRetrieved; }
+
 			/**
 			 * Forces an update of the properties within the
 			 * context.
@@ -128,14 +168,32 @@ namespace DBGp {
 			/** The context ID. */
 			wxString id;
 
+			/**
+			 * The properties indexed by name, built the first time
+			 * FindProperty() needs it.
+			 */
+			mutable PropertyHash *index;
+
 			/** The context's stack level. */
 			StackLevel *level;
 
 			/** The context name. */
 			wxString name;
 
+			/**
+			 * The same properties as the map, in the order the
+			 * engine sent them.
+			 */
+			mutable Property::PropertyVector order;
+
 			/** The properties defined within the context. */
-			Property::PropertyMap properties;
+			mutable Property::PropertyMap properties;
+
+			/** Whether the properties have been retrieved yet. */
+			mutable bool propertiesRetrieved;
+
+			/** Throws away the index of properties by name. */
+			void InvalidateIndex() const;
 
 			/**
 			 * Checks if we have the properties within the context
@@ -149,7 +207,7 @@ namespace DBGp {
 			 * rather than just setting the features to high values
 			 * in Connection.
 			 */
-			void RetrieveProperties() throw (EngineError, SocketError);
+			void RetrieveProperties() const throw (EngineError, SocketError);
 	};
 }
 
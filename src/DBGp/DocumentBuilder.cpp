@@ -0,0 +1,95 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/DocumentBuilder.h"
+
+using namespace DBGp;
+
+// {{{ DocumentBuilder::DocumentBuilder(wxXmlDocument &doc)
+DocumentBuilder::DocumentBuilder(wxXmlDocument &doc) : doc(doc), stream(NULL), streamDepth(0) {
+}
+// }}}
+
+// {{{ void DocumentBuilder::OnEndElement(const wxString &name, const wxString &content) throw (Error)
+void DocumentBuilder::OnEndElement(const wxString &name, const wxString &content) throw (Error) {
+	if (streamDepth > 0) {
+		--streamDepth;
+		stream->OnEndElement(name, content);
+		return;
+	}
+
+	wxXmlNode *node = nodes.back();
+	nodes.pop_back();
+
+	if (!content.IsEmpty()) {
+		node->AddChild(new wxXmlNode(wxXML_TEXT_NODE, wxEmptyString, content));
+	}
+}
+// }}}
+// {{{ void DocumentBuilder::OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error)
+void DocumentBuilder::OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error) {
+	if (streamDepth > 0) {
+		++streamDepth;
+		stream->OnStartElement(name, attributes);
+		return;
+	}
+
+	// Errors always go into the document, since Connection handles them.
+	if (stream && nodes.size() == 1 && name != wxT("error")) {
+		streamDepth = 1;
+		stream->OnStartElement(name, attributes);
+		return;
+	}
+
+	wxXmlNode *node = new wxXmlNode(wxXML_ELEMENT_NODE, name);
+	for (ResponseParser::Attributes::const_iterator i = attributes.begin(); i != attributes.end(); i++) {
+		node->AddProperty(i->first, i->second);
+	}
+
+	if (nodes.empty()) {
+		doc.SetRoot(node);
+		nodes.push_back(node);
+		stream = GetStreamHandler(node);
+	}
+	else {
+		nodes.back()->AddChild(node);
+		nodes.push_back(node);
+	}
+}
+// }}}
+
+// {{{ ResponseParser::Handler *DocumentBuilder::GetStreamHandler(const wxXmlNode *root) throw ()
+ResponseParser::Handler *DocumentBuilder::GetStreamHandler(const wxXmlNode *root) throw () {
+	return NULL;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,97 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_DOCUMENTBUILDER_H
+#define DBGP_DOCUMENTBUILDER_H
+
+#include <vector>
+
+#include <wx/xml/xml.h>
+
+#include "DBGp/ResponseParser.h"
+
+namespace DBGp {
+	/**
+	 * A ResponseParser handler that builds a wxXmlDocument, for the
+	 * (generally small) responses that are easiest to deal with as a
+	 * tree. Encoded content has already been decoded by the parser, so
+	 * the document never holds Base64 data.
+	 *
+	 * Subclasses can divert everything below the root element (other
+	 * than errors) to another handler by overriding GetStreamHandler(),
+	 * in which case the document only ends up holding the root element.
+	 */
+	class DocumentBuilder : public ResponseParser::Handler {
+		public:
+			/**
+			 * Constructs a new builder.
+			 *
+			 * @param[out] doc The document to build into.
+			 */
+			DocumentBuilder(wxXmlDocument &doc);
+			virtual ~DocumentBuilder() {}
+
+			virtual void OnEndElement(const wxString &name, const wxString &content) throw (Error);
+			virtual void OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error);
+
+		protected:
+			/**
+			 * Called once the root element has been opened to
+			 * find out if the rest of the message should be sent
+			 * elsewhere.
+			 *
+			 * @param[in] root The root element.
+			 * @return The handler to divert to, or NULL to build
+			 * the whole document.
+			 */
+			virtual ResponseParser::Handler *GetStreamHandler(const wxXmlNode *root) throw ();
+
+		private:
+			/** The document being built. */
+			wxXmlDocument &doc;
+
+			/** The open elements, innermost last. */
+			std::vector<wxXmlNode *> nodes;
+
+			/** The handler elements are being diverted to. */
+			ResponseParser::Handler *stream;
+
+			/**
+			 * The number of diverted elements currently open, or
+			 * zero if we're building the document.
+			 */
+			unsigned int streamDepth;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
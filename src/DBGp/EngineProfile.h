@@ -0,0 +1,74 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_ENGINEPROFILE_H
+#define DBGP_ENGINEPROFILE_H
+
+#include <map>
+
+#include <wx/string.h>
+
+#include "DBGp/Typemap.h"
+
+namespace DBGp {
+	/**
+	 * What we learnt about a debugging engine while initialising a
+	 * connection to it. Engines of the same version support the same
+	 * things, so a profile from one connection lets later connections
+	 * skip most of the handshake.
+	 */
+	class EngineProfile {
+		public:
+			/** The extended commands the engine supports. */
+			std::map<wxString, bool> commands;
+
+			/** The max_children value in effect. */
+			unsigned int maxChildren;
+
+			/** The max_depth value in effect. */
+			unsigned int maxDepth;
+
+			/** The engine's typemap. */
+			Typemap typemap;
+
+			/**
+			 * Constructs an empty profile.
+			 *
+			 * @param[in] maxChildren The initial max_children.
+			 * @param[in] maxDepth The initial max_depth.
+			 */
+			inline EngineProfile(unsigned int maxChildren = 0, unsigned int maxDepth = 0) : maxChildren(maxChildren), maxDepth(maxDepth) {}
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
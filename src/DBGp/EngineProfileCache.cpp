@@ -0,0 +1,86 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/EngineProfileCache.h"
+
+using namespace DBGp;
+
+// {{{ bool EngineProfileCache::Find(const wxString &key, EngineProfile &profile) const
+bool EngineProfileCache::Find(const wxString &key, EngineProfile &profile) const {
+	if (key.IsEmpty()) {
+		return false;
+	}
+
+	wxMutexLocker lock(mutex);
+	std::map<wxString, EngineProfile>::const_iterator i = profiles.find(key);
+
+	if (i == profiles.end()) {
+		return false;
+	}
+	profile = i->second;
+	return true;
+}
+// }}}
+// {{{ void EngineProfileCache::Clear()
+void EngineProfileCache::Clear() {
+	wxMutexLocker lock(mutex);
+	profiles.clear();
+}
+// }}}
+// {{{ size_t EngineProfileCache::GetCount() const
+size_t EngineProfileCache::GetCount() const {
+	wxMutexLocker lock(mutex);
+	return profiles.size();
+}
+// }}}
+// {{{ void EngineProfileCache::Store(const wxString &key, const EngineProfile &profile)
+void EngineProfileCache::Store(const wxString &key, const EngineProfile &profile) {
+	if (key.IsEmpty()) {
+		return;
+	}
+
+	wxMutexLocker lock(mutex);
+	profiles[key] = profile;
+}
+// }}}
+
+// {{{ wxString EngineProfileCache::MakeKey(const wxString &language, const wxString &engine, const wxString &engineVersion, const wxString &protocolVersion)
+wxString EngineProfileCache::MakeKey(const wxString &language, const wxString &engine, const wxString &engineVersion, const wxString &protocolVersion) {
+	if (language.IsEmpty() || protocolVersion.IsEmpty()) {
+		return wxEmptyString;
+	}
+
+	// None of these can contain a newline, so it makes a safe separator.
+	return language + wxT("\n") + engine + wxT("\n") + engineVersion + wxT("\n") + protocolVersion;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,106 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_ENGINEPROFILECACHE_H
+#define DBGP_ENGINEPROFILECACHE_H
+
+#include <map>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+
+#include "DBGp/EngineProfile.h"
+
+namespace DBGp {
+	/**
+	 * Caches engine profiles, keyed by the language, engine and protocol
+	 * version reported in the init packet. PHP opens a new connection
+	 * for every request, so after the first one almost every connection
+	 * finds its profile here.
+	 */
+	class EngineProfileCache {
+		public:
+			/**
+			 * Looks up a profile.
+			 *
+			 * @param[in] key The key created by MakeKey().
+			 * @param[out] profile Set to the cached profile, if
+			 * there is one.
+			 * @return True if a profile was found.
+			 */
+			bool Find(const wxString &key, EngineProfile &profile) const;
+
+			/** Empties the cache. */
+			void Clear();
+
+			/**
+			 * Returns the number of cached profiles.
+			 *
+			 * @return The number of profiles.
+			 */
+			size_t GetCount() const;
+
+			/**
+			 * Adds or replaces a profile.
+			 *
+			 * @param[in] key The key created by MakeKey().
+			 * @param[in] profile The profile.
+			 */
+			void Store(const wxString &key, const EngineProfile &profile);
+
+			/**
+			 * Builds a cache key. An empty key means that the
+			 * engine didn't identify itself well enough to be
+			 * cached.
+			 *
+			 * @param[in] language The language attribute of the
+			 * init packet.
+			 * @param[in] engine The name of the engine.
+			 * @param[in] engineVersion The version attribute of
+			 * the engine element.
+			 * @param[in] protocolVersion The protocol_version
+			 * attribute of the init packet.
+			 * @return The key.
+			 */
+			static wxString MakeKey(const wxString &language, const wxString &engine, const wxString &engineVersion, const wxString &protocolVersion);
+
+		private:
+			/** Protects the profile map. */
+			mutable wxMutex mutex;
+
+			/** The profiles, by key. */
+			std::map<wxString, EngineProfile> profiles;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,189 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/FrameReader.h"
+
+#include <cstring>
+
+using namespace DBGp;
+
+/* The longest length field we're prepared to accept. Anything beyond this is
+ * garbage, rather than a frame we'd ever want to allocate memory for. */
+static const size_t MAX_LENGTH_DIGITS = 10;
+
+// {{{ FrameReader::FrameReader(size_t chunkSize)
+FrameReader::FrameReader(size_t chunkSize) : buffer(NULL), capacity(0), chunkSize(chunkSize), start(0), end(0) {
+	wxASSERT(chunkSize > 0);
+}
+// }}}
+// {{{ FrameReader::~FrameReader()
+FrameReader::~FrameReader() {
+	delete[] buffer;
+}
+// }}}
+
+// {{{ void FrameReader::Append(const char *data, size_t length)
+void FrameReader::Append(const char *data, size_t length) {
+	Reserve(length);
+	std::memcpy(buffer + end, data, length);
+	end += length;
+}
+// }}}
+// {{{ size_t FrameReader::Fill(Source &source) throw (SocketError)
+size_t FrameReader::Fill(Source &source) throw (SocketError) {
+	size_t headerLength, payloadLength;
+	size_t wanted = chunkSize;
+
+	/* If we already know how big the frame we're in the middle of is,
+	 * make sure the rest of it can arrive in one read. */
+	if (ParseHeader(headerLength, payloadLength)) {
+		size_t remaining = headerLength + payloadLength + 1 - (end - start);
+		if (remaining > wanted) {
+			wanted = remaining;
+		}
+	}
+
+	Reserve(wanted);
+
+	size_t read = source.Read(buffer + end, capacity - end);
+	wxASSERT(read <= capacity - end);
+	end += read;
+
+	return read;
+}
+// }}}
+// {{{ bool FrameReader::HasFrame() throw (SocketError)
+bool FrameReader::HasFrame() throw (SocketError) {
+	size_t headerLength, payloadLength;
+
+	if (ParseHeader(headerLength, payloadLength)) {
+		return (end - start) >= (headerLength + payloadLength + 1);
+	}
+	return false;
+}
+// }}}
+// {{{ bool FrameReader::NextFrame(const char *&payload, size_t &length) throw (SocketError)
+bool FrameReader::NextFrame(const char *&payload, size_t &length) throw (SocketError) {
+	size_t headerLength, payloadLength;
+
+	if (!ParseHeader(headerLength, payloadLength)) {
+		return false;
+	}
+
+	size_t frameLength = headerLength + payloadLength + 1;
+	if ((end - start) < frameLength) {
+		return false;
+	}
+
+	if (buffer[start + frameLength - 1] != '\0') {
+		throw SocketError(wxT("Frame is missing its terminating NULL."));
+	}
+
+	payload = buffer + start + headerLength;
+	length = payloadLength;
+	start += frameLength;
+
+	return true;
+}
+// }}}
+// {{{ void FrameReader::Reset()
+void FrameReader::Reset() {
+	start = end = 0;
+}
+// }}}
+
+// {{{ bool FrameReader::ParseHeader(size_t &headerLength, size_t &payloadLength) const throw (SocketError)
+bool FrameReader::ParseHeader(size_t &headerLength, size_t &payloadLength) const throw (SocketError) {
+	size_t length = 0;
+
+	for (size_t i = start; i < end; i++) {
+		char c = buffer[i];
+
+		if (c == '\0') {
+			if (i == start || length == 0) {
+				throw SocketError(wxT("Told to read 0 bytes."));
+			}
+
+			headerLength = i - start + 1;
+			payloadLength = length;
+			return true;
+		}
+		else if (c < '0' || c > '9') {
+			throw SocketError(wxT("Malformed length in frame header."));
+		}
+		else if (i - start >= MAX_LENGTH_DIGITS) {
+			throw SocketError(wxT("Frame length is too long."));
+		}
+
+		length = length * 10 + (c - '0');
+	}
+
+	return false;
+}
+// }}}
+// {{{ void FrameReader::Reserve(size_t length)
+void FrameReader::Reserve(size_t length) {
+	if (start == end) {
+		start = end = 0;
+	}
+
+	if (capacity - end >= length) {
+		return;
+	}
+
+	// Move any partial frame back to the start of the buffer first.
+	if (start > 0) {
+		std::memmove(buffer, buffer + start, end - start);
+		end -= start;
+		start = 0;
+
+		if (capacity - end >= length) {
+			return;
+		}
+	}
+
+	size_t newCapacity = (capacity > 0 ? capacity : chunkSize);
+	while (newCapacity - end < length) {
+		newCapacity *= 2;
+	}
+
+	char *newBuffer = new char[newCapacity];
+	if (buffer) {
+		std::memcpy(newBuffer, buffer, end);
+		delete[] buffer;
+	}
+
+	buffer = newBuffer;
+	capacity = newCapacity;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,201 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_FRAMEREADER_H
+#define DBGP_FRAMEREADER_H
+
+#include <cstddef>
+
+#include "DBGp/Error/Error.h"
+
+namespace DBGp {
+	/**
+	 * A buffered reader for the frames sent by DBGp debugging engines.
+	 * Each frame is made up of the payload length in ASCII digits, a NULL
+	 * byte, the payload itself and a terminating NULL byte.
+	 *
+	 * Rather than reading the length a byte at a time, the reader pulls
+	 * data from its source in large chunks and splits the frames out of
+	 * its own buffer, so a single read can yield several complete frames,
+	 * and a partial frame is simply kept until the rest of it arrives.
+	 */
+	class FrameReader {
+		public:
+			/**
+			 * An abstract source of raw data for the reader,
+			 * generally wrapping a socket.
+			 */
+			class Source {
+				public:
+					virtual ~Source() {}
+
+					/**
+					 * Reads whatever data is available, up to
+					 * the given length. Implementations should
+					 * block until at least one byte is
+					 * available.
+					 *
+					 * @param[out] buffer The buffer to read
+					 * into.
+					 * @param[in] length The space available in
+					 * the buffer.
+					 * @return The number of bytes read.
+					 * @throws SocketError Thrown if the read
+					 * fails.
+					 */
+					virtual size_t Read(char *buffer, size_t length) throw (SocketError) = 0;
+			};
+
+			/** The default number of bytes requested per read. */
+			static const size_t DEFAULT_CHUNK_SIZE = 65536;
+
+			/**
+			 * Constructs a new, empty frame reader.
+			 *
+			 * @param[in] chunkSize The minimum number of bytes to
+			 * request from the source on each read.
+			 */
+			FrameReader(size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+			/** Destructor. */
+			~FrameReader();
+
+			/**
+			 * Appends raw data to the buffer. This is mostly
+			 * useful when the data has been read by some other
+			 * means.
+			 *
+			 * @param[in] data The data to append.
+			 * @param[in] length The length of the data.
+			 */
+			void Append(const char *data, size_t length);
+
+			/**
+			 * Performs a single read from the source into the
+			 * buffer. If a partial frame is buffered, enough space
+			 * is requested to complete it in one read.
+			 *
+			 * @param[in] source The source to read from.
+			 * @return The number of bytes read.
+			 * @throws SocketError Thrown if the read fails.
+			 */
+			size_t Fill(Source &source) throw (SocketError);
+
+			/**
+			 * Returns the buffered data that hasn't been consumed
+			 * yet. The pointer remains valid until the next call
+			 * to Append(), Fill() or Reset().
+			 *
+			 * @return The start of the unconsumed data.
+			 */
+			inline const char *GetBufferedData() const { return buffer + start; }
+
+			/**
+			 * Returns the number of bytes currently buffered.
+			 *
+			 * @return The number of bytes buffered.
+			 */
+			inline size_t GetBufferedLength() const { return end - start; }
+
+			/**
+			 * Checks whether a complete frame is buffered.
+			 *
+			 * @return True if NextFrame() will return a frame.
+			 * @throws SocketError Thrown if the buffered data
+			 * isn't a valid frame.
+			 */
+			bool HasFrame() throw (SocketError);
+
+			/**
+			 * Removes the next complete frame from the buffer.
+			 * The payload pointer remains valid (and NULL
+			 * terminated) until the next call to Append(), Fill()
+			 * or Reset().
+			 *
+			 * @param[out] payload Set to the start of the payload.
+			 * @param[out] length Set to the length of the payload.
+			 * @return True if a frame was available, false
+			 * otherwise.
+			 * @throws SocketError Thrown if the buffered data
+			 * isn't a valid frame.
+			 */
+			bool NextFrame(const char *&payload, size_t &length) throw (SocketError);
+
+			/** Discards all buffered data. */
+			void Reset();
+
+		protected:
+			/** The buffer. */
+			char *buffer;
+
+			/** The allocated size of the buffer. */
+			size_t capacity;
+
+			/** The minimum number of bytes to request per read. */
+			size_t chunkSize;
+
+			/** The offset of the first unconsumed byte. */
+			size_t start;
+
+			/** The offset just past the last buffered byte. */
+			size_t end;
+
+			/**
+			 * Parses the frame header at the start of the buffer.
+			 *
+			 * @param[out] headerLength Set to the length of the
+			 * header, including its NULL byte.
+			 * @param[out] payloadLength Set to the length of the
+			 * payload.
+			 * @return True if a complete header is buffered.
+			 * @throws SocketError Thrown if the header is
+			 * malformed.
+			 */
+			bool ParseHeader(size_t &headerLength, size_t &payloadLength) const throw (SocketError);
+
+			/**
+			 * Ensures there are at least the given number of bytes
+			 * of free space after the buffered data.
+			 *
+			 * @param[in] length The number of bytes required.
+			 */
+			void Reserve(size_t length);
+
+		private:
+			/** Frame readers own their buffer, so can't be copied. */
+			FrameReader(const FrameReader &);
+			FrameReader &operator=(const FrameReader &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,177 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Histogram.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace DBGp;
+
+// {{{ Histogram::Histogram()
+Histogram::Histogram() {
+	Reset();
+}
+// }}}
+
+// {{{ wxUint64 Histogram::GetHighestTrackable()
+wxUint64 Histogram::GetHighestTrackable() {
+	return (static_cast<wxUint64>(1) << MAX_BITS) - 1;
+}
+// }}}
+// {{{ double Histogram::GetMean() const
+double Histogram::GetMean() const {
+	if (count == 0) {
+		return 0.0;
+	}
+	return static_cast<double>(total) / static_cast<double>(count);
+}
+// }}}
+// {{{ wxUint64 Histogram::GetPercentile(double percentile) const
+wxUint64 Histogram::GetPercentile(double percentile) const {
+	if (count == 0) {
+		return 0;
+	}
+	else if (percentile <= 0.0) {
+		return GetMin();
+	}
+	else if (percentile >= 100.0) {
+		return maximum;
+	}
+
+	wxUint64 target = static_cast<wxUint64>(std::ceil(percentile / 100.0 * static_cast<double>(count)));
+	wxUint64 seen = 0;
+
+	if (target == 0) {
+		target = 1;
+	}
+
+	for (unsigned int i = 0; i < BUCKET_COUNT; i++) {
+		seen += buckets[i];
+		if (seen >= target) {
+			wxUint64 limit = GetBucketLimit(i);
+
+			if (limit > maximum) {
+				return maximum;
+			}
+			else if (limit < minimum) {
+				return minimum;
+			}
+			return limit;
+		}
+	}
+
+	return maximum;
+}
+// }}}
+// {{{ void Histogram::Merge(const Histogram &other)
+void Histogram::Merge(const Histogram &other) {
+	if (other.count == 0) {
+		return;
+	}
+
+	for (unsigned int i = 0; i < BUCKET_COUNT; i++) {
+		buckets[i] += other.buckets[i];
+	}
+
+	if (count == 0 || other.minimum < minimum) {
+		minimum = other.minimum;
+	}
+	if (other.maximum > maximum) {
+		maximum = other.maximum;
+	}
+
+	count += other.count;
+	total += other.total;
+}
+// }}}
+// {{{ void Histogram::Record(wxUint64 value)
+void Histogram::Record(wxUint64 value) {
+	buckets[GetBucket(value)]++;
+
+	if (count == 0 || value < minimum) {
+		minimum = value;
+	}
+	if (value > maximum) {
+		maximum = value;
+	}
+
+	count++;
+	total += value;
+}
+// }}}
+// {{{ void Histogram::Reset()
+void Histogram::Reset() {
+	std::memset(buckets, 0, sizeof(buckets));
+	count = 0;
+	maximum = 0;
+	minimum = 0;
+	total = 0;
+}
+// }}}
+
+// {{{ unsigned int Histogram::GetBucket(wxUint64 value)
+unsigned int Histogram::GetBucket(wxUint64 value) {
+	if (value < (static_cast<wxUint64>(1) << EXACT_BITS)) {
+		return static_cast<unsigned int>(value);
+	}
+	else if (value > GetHighestTrackable()) {
+		return BUCKET_COUNT - 1;
+	}
+
+	unsigned int msb = EXACT_BITS;
+	while ((value >> (msb + 1)) != 0) {
+		msb++;
+	}
+
+	/* The top EXACT_BITS bits of the value, less the leading one, pick
+	 * the sub-bucket within its power of two. */
+	unsigned int shift = msb - (EXACT_BITS - 1);
+	unsigned int sub = static_cast<unsigned int>(value >> shift) - SUB_BUCKETS;
+
+	return (1 << EXACT_BITS) + (msb - EXACT_BITS) * SUB_BUCKETS + sub;
+}
+// }}}
+// {{{ wxUint64 Histogram::GetBucketLimit(unsigned int bucket)
+wxUint64 Histogram::GetBucketLimit(unsigned int bucket) {
+	if (bucket < (1 << EXACT_BITS)) {
+		return bucket;
+	}
+
+	unsigned int offset = bucket - (1 << EXACT_BITS);
+	unsigned int shift = offset / SUB_BUCKETS + 1;
+	wxUint64 low = static_cast<wxUint64>(offset % SUB_BUCKETS + SUB_BUCKETS) << shift;
+
+	return low + (static_cast<wxUint64>(1) << shift) - 1;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
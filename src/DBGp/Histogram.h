@@ -0,0 +1,184 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_HISTOGRAM_H
+#define DBGP_HISTOGRAM_H
+
+#include <wx/defs.h>
+
+namespace DBGp {
+	/**
+	 * A fixed size histogram of non-negative integer values, in the style
+	 * of HdrHistogram. Small values are counted exactly; above that, each
+	 * power of two is split into the same number of linear sub-buckets,
+	 * so every recorded value is kept to within a fixed relative error
+	 * (about 6%) no matter how large it is, and recording a value is a
+	 * couple of shifts and an increment.
+	 *
+	 * Values larger than GetHighestTrackable() are counted in the top
+	 * bucket, although the exact maximum is still kept.
+	 */
+	class Histogram {
+		public:
+			/** Constructs an empty histogram. */
+			Histogram();
+
+			/**
+			 * Returns the number of values recorded.
+			 *
+			 * @return The count.
+			 */
+			inline wxUint64 GetCount() const { return count; }
+
+			/**
+			 * Returns the largest value that gets a bucket of its
+			 * own.
+			 *
+			 * @return The highest trackable value.
+			 */
+			static wxUint64 GetHighestTrackable();
+
+			/**
+			 * Returns the largest value recorded.
+			 *
+			 * @return The maximum, or 0 if nothing has been
+			 * recorded.
+			 */
+			inline wxUint64 GetMax() const { return maximum; }
+
+			/**
+			 * Returns the mean of the values recorded.
+			 *
+			 * @return The mean, or 0 if nothing has been recorded.
+			 */
+			double GetMean() const;
+
+			/**
+			 * Returns the smallest value recorded.
+			 *
+			 * @return The minimum, or 0 if nothing has been
+			 * recorded.
+			 */
+			inline wxUint64 GetMin() const { return count > 0 ? minimum : 0; }
+
+			/**
+			 * Returns the value below which the given percentage
+			 * of recorded values fall. The result is the highest
+			 * value equivalent to the bucket the percentile falls
+			 * in, clamped to the recorded range.
+			 *
+			 * @param[in] percentile The percentile, from 0 to 100.
+			 * @return The value, or 0 if nothing has been
+			 * recorded.
+			 */
+			wxUint64 GetPercentile(double percentile) const;
+
+			/**
+			 * Returns the sum of the values recorded.
+			 *
+			 * @return The total.
+			 */
+			inline wxUint64 GetTotal() const { return total; }
+
+			/**
+			 * Adds every value recorded in another histogram to
+			 * this one.
+			 *
+			 * @param[in] other The histogram to merge.
+			 */
+			void Merge(const Histogram &other);
+
+			/**
+			 * Records a value.
+			 *
+			 * @param[in] value The value.
+			 */
+			void Record(wxUint64 value);
+
+			/** Discards every recorded value. */
+			void Reset();
+
+		protected:
+			/**
+			 * The number of bits counted exactly. Each power of
+			 * two above 2^EXACT_BITS is split into
+			 * 2^(EXACT_BITS - 1) sub-buckets.
+			 */
+			static const unsigned int EXACT_BITS = 5;
+
+			/** The number of sub-buckets per power of two. */
+			static const unsigned int SUB_BUCKETS = 1 << (EXACT_BITS - 1);
+
+			/**
+			 * The highest power of two tracked. With values in
+			 * microseconds, this covers a bit over an hour.
+			 */
+			static const unsigned int MAX_BITS = 32;
+
+			/** The total number of buckets. */
+			static const unsigned int BUCKET_COUNT = (1 << EXACT_BITS) + (MAX_BITS - EXACT_BITS) * SUB_BUCKETS;
+
+			/** The count of values within each bucket. */
+			wxUint32 buckets[BUCKET_COUNT];
+
+			/** The number of values recorded. */
+			wxUint64 count;
+
+			/** The largest value recorded. */
+			wxUint64 maximum;
+
+			/** The smallest value recorded. */
+			wxUint64 minimum;
+
+			/** The sum of the values recorded. */
+			wxUint64 total;
+
+			/**
+			 * Returns the bucket a value is counted in.
+			 *
+			 * @param[in] value The value.
+			 * @return The bucket index.
+			 */
+			static unsigned int GetBucket(wxUint64 value);
+
+			/**
+			 * Returns the largest value counted in a bucket.
+			 *
+			 * @param[in] bucket The bucket index.
+			 * @return The highest equivalent value.
+			 */
+			static wxUint64 GetBucketLimit(unsigned int bucket);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,164 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_LOG_H
+#define DBGP_LOG_H
+
+#include <cstddef>
+
+#include <wx/log.h>
+#include <wx/strconv.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/xml/xml.h>
+
+/* Compile-time log levels. Anything above DBGP_LOG_LEVEL is compiled out
+ * entirely, arguments included, so expensive formatting such as converting
+ * whole payloads costs nothing in builds that would never show it. The
+ * disabled forms still compile their arguments behind a constant false
+ * condition, so they can't rot and variables only used for logging don't
+ * trigger warnings. */
+
+/** No library logging beyond warnings and errors. */
+#define DBGP_LOG_LEVEL_NONE 0
+
+/** Connection and session events. */
+#define DBGP_LOG_LEVEL_DEBUG 1
+
+/** Complete protocol payloads, in and out. */
+#define DBGP_LOG_LEVEL_PROTOCOL 2
+
+/* Debug builds of wxWidgets get everything; release builds get nothing,
+ * since wxLogDebug() discards it anyway. Define DBGP_LOG_LEVEL to
+ * override. */
+#ifndef DBGP_LOG_LEVEL
+#ifdef __WXDEBUG__
+#define DBGP_LOG_LEVEL DBGP_LOG_LEVEL_PROTOCOL
+#else
+#define DBGP_LOG_LEVEL DBGP_LOG_LEVEL_NONE
+#endif
+#endif
+
+/**
+ * Logs a debug message if DBGP_LOG_LEVEL includes debug messages. The
+ * arguments are given as they would be to wxLogDebug(), wrapped in an
+ * extra set of parentheses.
+ */
+#if DBGP_LOG_LEVEL >= DBGP_LOG_LEVEL_DEBUG
+#define DBGP_LOG_DEBUG(args) wxLogDebug args
+#else
+#define DBGP_LOG_DEBUG(args) do { if (0) { wxLogDebug args; } } while (0)
+#endif
+
+/**
+ * Logs a protocol message if DBGP_LOG_LEVEL includes payloads, logging is
+ * enabled and we're on the main thread, since wxWidgets 2.8 logging isn't
+ * thread safe. The arguments are only evaluated if the message will be
+ * logged, so LogPayload and LogDocument formatters can be passed freely.
+ */
+#if DBGP_LOG_LEVEL >= DBGP_LOG_LEVEL_PROTOCOL
+#define DBGP_LOG_PROTOCOL(args) do { if (wxLog::IsEnabled() && wxThread::IsMain()) { wxLogDebug args; } } while (0)
+#else
+#define DBGP_LOG_PROTOCOL(args) do { if (0) { wxLogDebug args; } } while (0)
+#endif
+
+namespace DBGp {
+	/**
+	 * Formats a raw protocol payload for logging. Nothing is converted
+	 * until Format() is called, so these are cheap to construct.
+	 */
+	class LogPayload {
+		public:
+			/** The default number of bytes formatted. */
+			static const size_t DEFAULT_LIMIT = 65536;
+
+			/**
+			 * Constructs a formatter. The payload isn't copied,
+			 * so must outlive the formatter.
+			 *
+			 * @param[in] data The payload.
+			 * @param[in] length The length of the payload, in
+			 * bytes.
+			 * @param[in] conv The converter for the payload
+			 * encoding, or NULL for UTF-8.
+			 */
+			inline LogPayload(const char *data, size_t length, wxMBConv *conv = NULL) : conv(conv), data(data), length(length) {}
+
+			/**
+			 * Converts the payload. Payloads longer than the limit
+			 * are truncated, with a note of how much was left out.
+			 *
+			 * @param[in] limit The most bytes to convert.
+			 * @return The payload as a string.
+			 */
+			wxString Format(size_t limit = DEFAULT_LIMIT) const;
+
+		protected:
+			/** The payload converter, or NULL for UTF-8. */
+			wxMBConv *conv;
+
+			/** The payload. */
+			const char *data;
+
+			/** The payload length, in bytes. */
+			size_t length;
+	};
+
+	/**
+	 * Formats a parsed document for logging. The document isn't
+	 * serialised until Format() is called.
+	 */
+	class LogDocument {
+		public:
+			/**
+			 * Constructs a formatter.
+			 *
+			 * @param[in] doc The document, which must outlive the
+			 * formatter.
+			 */
+			inline LogDocument(const wxXmlDocument &doc) : doc(doc) {}
+
+			/**
+			 * Serialises the document.
+			 *
+			 * @return The document as XML.
+			 */
+			wxString Format() const;
+
+		protected:
+			/** The document to format. */
+			const wxXmlDocument &doc;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
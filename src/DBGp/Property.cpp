@@ -32,115 +32,461 @@
 #include "DBGp/Property.h"
 #include "DBGp/Connection.h"
 #include "DBGp/Context.h"
+#include "DBGp/PropertyBuilder.h"
+#include "DBGp/StackLevel.h"
 #include "DBGp/Utility.h"
 
+#include <algorithm>
+#include <map>
+#include <new>
+#include <vector>
+
 using namespace DBGp;
 
+/* A property_get sent by RetrieveChildren() and not yet collected. */
+struct PendingChildren {
+	PropertyBuilder *builder;
+	Property *prop;
+	size_t retrieved;
+};
+
 // {{{ Property::Property(Connection *conn, Context *context, unsigned int depth, Property *parent)
-Property::Property(Connection *conn, Context *context, unsigned int depth, Property *parent) : conn(conn), context(context), depth(depth), parent(parent) {
+Property::Property(Connection *conn, Context *context, unsigned int depth, Property *parent) : address(NULL), arena(parent ? parent->arena : new PropertyArena), childCapacity(0), childCount(0), children(NULL), className(NULL), conn(conn), constant(false), context(context), contextID(NULL), data(NULL), depth(depth), fullName(NULL), hasChildren(false), inArena(false), index(NULL), indexed(false), key(NULL), lookup(NULL), name(NULL), nextPage(0), numChildren(0), parent(parent), references(1), size(0), type(NULL) {
 	wxASSERT(conn != NULL);
+
+	if (parent) {
+		arena->Ref();
+	}
+	InheritContextID();
 }
 // }}}
 // {{{ Property::Property(const Property &p)
 Property::Property(const Property &p) :
 	address(p.address),
+	arena(p.arena),
+	childCapacity(p.childCount),
+	childCount(p.childCount),
+	children(NULL),
 	className(p.className),
 	conn(p.conn),
 	constant(p.constant),
 	context(p.context),
+	contextID(p.contextID),
 	data(p.data),
 	depth(p.depth),
 	fullName(p.fullName),
 	hasChildren(p.hasChildren),
+	inArena(false),
+	index(NULL),
+	indexed(false),
 	key(p.key),
+	lookup(NULL),
 	name(p.name),
+	nextPage(p.nextPage),
+	numChildren(p.numChildren),
 	parent(p.parent),
+	references(1),
 	size(p.size),
 	type(p.type) {
-	for (PropertyMap::const_iterator i = p.children.begin(); i != p.children.end(); i++) {
-		Property *prop = new Property(*(i->second));
-		prop->parent = this;
-		children[i->first] = prop;
+	/* The strings stay in the original's arena, and the children are
+	 * shared with the original rather than copied, so a copy only costs
+	 * one level of pointers however large the tree underneath is. The
+	 * pointer array itself can't be shared: the original reuses it when
+	 * its children are replaced or paged in. */
+	arena->Ref();
+	if (childCount > 0) {
+		children = static_cast<Property **>(arena->Allocate(childCount * sizeof(Property *)));
+		std::copy(p.children, p.children + childCount, children);
 	}
+	for (size_t i = 0; i < childCount; i++) {
+		children[i]->Ref();
+	}
+}
+// }}}
+// {{{ Property::Property(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent)
+Property::Property(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent) : address(NULL), arena(arena), childCapacity(0), childCount(0), children(NULL), className(NULL), conn(conn), constant(false), context(context), contextID(NULL), data(NULL), depth(depth), fullName(NULL), hasChildren(false), inArena(true), index(NULL), indexed(false), key(NULL), lookup(NULL), name(NULL), nextPage(0), numChildren(0), parent(parent), references(1), size(0), type(NULL) {
+	wxASSERT(conn != NULL);
+
+	arena->Ref();
+	InheritContextID();
 }
 // }}}
 // {{{ Property::~Property()
 Property::~Property() {
-	for (PropertyMap::iterator i = children.begin(); i != children.end(); i++) {
-		delete i->second;
+	Unindex();
+	ClearChildren();
+
+	// Unref() releases the arena for properties that live in it.
+	if (!inArena) {
+		arena->Unref();
+	}
+}
+// }}}
+
+// {{{ Property *Property::FindChild(const wxString &name) const
+Property *Property::FindChild(const wxString &name) const {
+	if (childCount == 0) {
+		return NULL;
 	}
+
+	if (lookup == NULL) {
+		lookup = new PropertyHash(childCount);
+		for (size_t i = 0; i < childCount; i++) {
+			(*lookup)[children[i]->GetName()] = children[i];
+		}
+	}
+
+	PropertyHash::const_iterator i = lookup->find(name);
+	return (i != lookup->end() ? i->second : NULL);
 }
 // }}}
+// {{{ Property *Property::GetChild(const wxString &name) throw (EngineError, NotFoundError, SocketError)
+Property *Property::GetChild(const wxString &name) throw (EngineError, NotFoundError, SocketError) {
+	for (;;) {
+		Property *child = FindChild(name);
+		if (child) {
+			return child;
+		}
 
-// {{{ Property *Property::GetChild(const wxString &name) throw (NotFoundError)
-Property *Property::GetChild(const wxString &name) throw (NotFoundError) {
-	for (PropertyMap::iterator i = children.begin(); i != children.end(); i++) {
-		if (i->second->GetName() == name) {
-			return i->second;
+		if (!HasMoreChildren()) {
+			break;
 		}
+		RetrieveChildren();
 	}
 	throw NotFoundError(wxT("Requested child property '") + name + wxT("' not found."));
 }
 // }}}
+// {{{ const Property::PropertyMap &Property::GetChildren() const
+const Property::PropertyMap &Property::GetChildren() const {
+	if (index == NULL) {
+		index = new PropertyMap;
+		for (size_t i = 0; i < childCount; i++) {
+			(*index)[children[i]->GetName()] = children[i];
+		}
+	}
+	return *index;
+}
+// }}}
+// {{{ void Property::Ref() const
+void Property::Ref() const {
+	++references;
+}
+// }}}
+// {{{ void Property::RetrieveChildren() throw (EngineError, SocketError)
+void Property::RetrieveChildren() throw (EngineError, SocketError) {
+	if (!HasMoreChildren()) {
+		return;
+	}
+
+	size_t retrieved = childCount;
+	MessageArguments args(GetPropertyArguments());
+	args.Append(wxT("-p"), IntToString(nextPage));
+
+	PropertyBuilder builder(conn, context, depth, this, false);
+	conn->SendCommandStreamed(wxT("property_get"), args, builder);
+
+	/* If the engine didn't give us anything new, there's no point asking
+	 * it again for the same page. */
+	if (childCount == retrieved) {
+		numChildren = childCount;
+	}
+}
+// }}}
+// {{{ void Property::RetrieveChildren(const PropertyVector &props) throw (EngineError, MalformedDocumentError, SocketError)
+void Property::RetrieveChildren(const PropertyVector &props) throw (EngineError, MalformedDocumentError, SocketError) {
+	typedef std::map<TransactionID, PendingChildren> PendingMap;
+	PendingMap pending;
+
+	try {
+		for (PropertyVector::const_iterator i = props.begin(); i != props.end(); i++) {
+			Property *prop = *i;
+
+			if (prop->HasMoreChildren()) {
+				MessageArguments args(prop->GetPropertyArguments());
+				args.Append(wxT("-p"), IntToString(prop->nextPage));
+
+				PendingChildren p;
+				p.builder = new PropertyBuilder(prop->conn, prop->context, prop->depth, prop, false);
+				p.prop = prop;
+				p.retrieved = prop->childCount;
+
+				TransactionID id;
+				try {
+					id = prop->conn->SendCommandAsync(wxT("property_get"), args, NULL, NULL, 0, p.builder);
+				}
+				catch (...) {
+					delete p.builder;
+					throw;
+				}
+				pending[id] = p;
+			}
+		}
+	}
+	catch (...) {
+		for (PendingMap::iterator i = pending.begin(); i != pending.end(); i++) {
+			i->second.prop->conn->ForgetStream(i->first);
+			delete i->second.builder;
+		}
+		throw;
+	}
 
+	PendingMap::iterator i = pending.begin();
+	try {
+		for (; i != pending.end(); i++) {
+			Property *prop = i->second.prop;
+
+			prop->conn->WaitForResponse(i->first);
+			if (prop->childCount == i->second.retrieved) {
+				prop->numChildren = prop->childCount;
+			}
+		}
+	}
+	catch (...) {
+		// Collect the remaining responses so they don't linger.
+		for (i++; i != pending.end(); i++) {
+			try {
+				i->second.prop->conn->WaitForResponse(i->first);
+			}
+			catch (...) {}
+		}
+
+		for (i = pending.begin(); i != pending.end(); i++) {
+			delete i->second.builder;
+		}
+
+		try {
+			throw;
+		}
+		catch (NotFoundError e) {
+			throw MalformedDocumentError(e.GetMessage());
+		}
+	}
+
+	for (i = pending.begin(); i != pending.end(); i++) {
+		delete i->second.builder;
+	}
+}
+// }}}
+// {{{ void Property::Unref() const
+void Property::Unref() const {
+	wxASSERT(references > 0);
+	if (--references == 0) {
+		if (inArena) {
+			/* The memory belongs to the arena, which can only go
+			 * once we're finished with it. */
+			PropertyArena *owner = arena;
+			this->~Property();
+			owner->Unref();
+		}
+		else {
+			delete this;
+		}
+	}
+}
+// }}}
 // {{{ void Property::Update() throw (EngineError, SocketError)
 void Property::Update() throw (EngineError, SocketError) {
-	wxXmlDocument doc(conn->SendCommandWait(wxT("property_get"), GetPropertyArguments()));
+	PropertyBuilder builder(conn, context, depth, this, true);
+	conn->SendCommandStreamed(wxT("property_get"), GetPropertyArguments(), builder);
+}
+// }}}
 
-	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
-		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("property")) {
-			ParsePropertyElement(node);
-			break;
+// {{{ Property *Property::Create(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent)
+Property *Property::Create(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent) {
+	return new (arena->Allocate(sizeof(Property))) Property(arena, conn, context, depth, parent);
+}
+// }}}
+// {{{ void Property::AddChildren(Property *const *props, size_t count)
+void Property::AddChildren(Property *const *props, size_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	/* A whole response's worth of children arrives at once, so the
+	 * first batch is allocated at exactly the right size, and further
+	 * pages grow the array geometrically. */
+	size_t needed = childCount + count;
+	if (needed > childCapacity) {
+		size_t capacity = (childCount == 0 ? count : std::max(needed, childCapacity * 2));
+		Property **grown = static_cast<Property **>(arena->Allocate(capacity * sizeof(Property *)));
+		std::copy(children, children + childCount, grown);
+		children = grown;
+		childCapacity = capacity;
+	}
+
+	// Later pages replace any children with the same name.
+	bool merge = (childCount > 0);
+	for (size_t i = 0; i < count; i++) {
+		Property *existing = (merge ? FindChild(props[i]->GetName()) : NULL);
+		if (existing) {
+			Property **slot = std::find(children, children + childCount, existing);
+			ReleaseChild(*slot);
+			*slot = (*lookup)[props[i]->GetName()] = props[i];
+		}
+		else {
+			children[childCount++] = props[i];
 		}
 	}
+
+	InvalidateIndexes();
+}
+// }}}
+// {{{ void Property::ClearChildren()
+void Property::ClearChildren() {
+	for (size_t i = 0; i < childCount; i++) {
+		ReleaseChild(children[i]);
+	}
+	childCount = 0;
+
+	InvalidateIndexes();
 }
 // }}}
+// {{{ void Property::DetachContext(const Context *context)
+void Property::DetachContext(const Context *context) {
+	if (this->context == context) {
+		// The index belongs to the context's level, so we can't stay in it.
+		Unindex();
+		this->context = NULL;
+	}
 
+	for (size_t i = 0; i < childCount; i++) {
+		children[i]->DetachContext(context);
+	}
+}
+// }}}
 // {{{ MessageArguments Property::GetPropertyArguments() const
 MessageArguments Property::GetPropertyArguments() const {
 	MessageArguments args(3,
 			wxT("-d"), IntToString(depth).c_str(),
-			wxT("-c"), context->GetID().c_str(),
-			wxT("-n"), fullName.c_str());
+			wxT("-c"), PropertyArena::ToString(contextID).c_str(),
+			wxT("-n"), GetFullName().c_str());
 
-	if (address != wxEmptyString) {
-		args.Append(wxT("-a"), address);
+	if (address) {
+		args.Append(wxT("-a"), GetAddress());
 	}
 
-	if (key != wxEmptyString) {
-		args.Append(wxT("-k"), key);
+	if (key) {
+		args.Append(wxT("-k"), GetKey());
 	}
 
 	return args;
 }
 // }}}
-// {{{ void Property::ParsePropertyElement(wxXmlNode *node)
-void Property::ParsePropertyElement(wxXmlNode *node) {
-	address = node->GetPropVal(wxT("address"), wxEmptyString);
-	className = node->GetPropVal(wxT("classname"), wxEmptyString);
-	constant = (node->GetPropVal(wxT("constant"), wxT("0")) == wxT("1"));
-	fullName = node->GetPropVal(wxT("fullname"), wxEmptyString);
-	hasChildren = (node->GetPropVal(wxT("children"), wxT("0")) == wxT("1"));
-	key = node->GetPropVal(wxT("key"), wxEmptyString);
-	name = node->GetPropVal(wxT("name"), wxEmptyString);
-	size = StringToULong(node->GetPropVal(wxT("size"), wxT("0")));
+// {{{ void Property::InheritContextID()
+void Property::InheritContextID() {
+	/* The ID is kept separately, since the context can go away while
+	 * the property is still shared. A child paged in later lives in a
+	 * different arena to its parent, and may outlive it. */
+	if (parent && parent->arena == arena) {
+		contextID = parent->contextID;
+	}
+	else if (parent) {
+		contextID = arena->Intern(PropertyArena::ToString(parent->contextID));
+	}
+	else if (context) {
+		contextID = arena->Intern(context->GetID());
+	}
+}
+// }}}
+// {{{ void Property::InvalidateIndexes()
+void Property::InvalidateIndexes() {
+	// Both are rebuilt the next time they're needed.
+	delete index;
+	index = NULL;
 
-	try {
-		type = conn->TypemapGet().GetType(node->GetPropVal(wxT("type"), wxT("undefined")));
+	delete lookup;
+	lookup = NULL;
+}
+// }}}
+// {{{ void Property::ParseAttributes(const ResponseParser::Attributes &attributes)
+void Property::ParseAttributes(const ResponseParser::Attributes &attributes) {
+	address = arena->Store(ResponseParser::GetAttribute(attributes, wxT("address")));
+	className = arena->Intern(ResponseParser::GetAttribute(attributes, wxT("classname")));
+	constant = (ResponseParser::GetAttribute(attributes, wxT("constant"), wxT("0")) == wxT("1"));
+	fullName = arena->Store(ResponseParser::GetAttribute(attributes, wxT("fullname")));
+	hasChildren = (ResponseParser::GetAttribute(attributes, wxT("children"), wxT("0")) == wxT("1"));
+	key = arena->Intern(ResponseParser::GetAttribute(attributes, wxT("key")));
+	name = arena->Store(ResponseParser::GetAttribute(attributes, wxT("name")));
+	size = StringToULong(ResponseParser::GetAttribute(attributes, wxT("size"), wxT("0")));
+
+	// The typemap is only consulted once per type per response.
+	wxString typeName(ResponseParser::GetAttribute(attributes, wxT("type"), wxT("undefined")));
+	const char *internedName = arena->Intern(typeName);
+	type = arena->FindType(internedName);
+	if (type == NULL) {
+		/* This can be called while a response is still being parsed,
+		 * so we can't risk TypemapGet() going back to the engine
+		 * here. Types the engine didn't list are left undefined. */
+		Type found;
+		conn->typemap.TryGetType(typeName, found);
+		type = arena->InternType(internedName, found);
+	}
+}
+// }}}
+// {{{ void Property::ParseChildCount(const ResponseParser::Attributes &attributes, PropertyMap::size_type parsed)
+void Property::ParseChildCount(const ResponseParser::Attributes &attributes, PropertyMap::size_type parsed) {
+	/* The engine only sends as many children as max_children and
+	 * max_depth allow; numchildren tells us how many there are in total,
+	 * and the rest are paged in by RetrieveChildren(). */
+	ResponseParser::Attributes::const_iterator count = attributes.find(wxT("numchildren"));
+	if (!hasChildren) {
+		numChildren = 0;
+	}
+	else if (count != attributes.end()) {
+		numChildren = StringToInt(count->second);
+	}
+	else if (parsed > 0) {
+		numChildren = childCount;
+	}
+	else {
+		// We don't know how many there are, but there's at least one.
+		numChildren = childCount + 1;
 	}
-	catch (Error e) {
-		type = Type();
+
+	if (parsed > 0) {
+		nextPage = StringToInt(ResponseParser::GetAttribute(attributes, wxT("page"), IntToString(nextPage))) + 1;
+	}
+}
+// }}}
+// {{{ void Property::ParsePropertyElement(wxXmlNode *node)
+void Property::ParsePropertyElement(wxXmlNode *node) {
+	ResponseParser::Attributes attributes;
+	for (wxXmlProperty *attribute = node->GetProperties(); attribute != NULL; attribute = attribute->GetNext()) {
+		attributes[attribute->GetName()] = attribute->GetValue();
 	}
 
-	data = node->GetNodeContent();
+	ParseAttributes(attributes);
+	data = arena->Store(node->GetNodeContent());
 
+	std::vector<Property *> parsed;
 	for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext()) {
 		if (child->GetType() == wxXML_ELEMENT_NODE && child->GetName() == wxT("property")) {
-			Property *prop = new Property(conn, context, depth, this);
+			Property *prop = Create(arena, conn, context, depth, this);
 			prop->ParsePropertyElement(child);
-			children[prop->GetName()] = prop;
+			parsed.push_back(prop);
 		}
 	}
+
+	if (!parsed.empty()) {
+		AddChildren(&parsed[0], parsed.size());
+	}
+	ParseChildCount(attributes, parsed.size());
+}
+// }}}
+// {{{ void Property::ReleaseChild(Property *child)
+void Property::ReleaseChild(Property *child) {
+	// A child that's still held elsewhere mustn't point back at us.
+	if (child->parent == this && child->IsShared()) {
+		child->parent = NULL;
+	}
+	child->Unref();
+}
+// }}}
+// {{{ void Property::Unindex()
+void Property::Unindex() {
+	if (indexed && context) {
+		context->GetStackLevel()->UnindexProperty(this);
+	}
 }
 // }}}
 
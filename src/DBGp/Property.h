@@ -32,68 +32,142 @@
 #ifndef DBGP_PROPERTY_H
 #define DBGP_PROPERTY_H
 
+#include <vector>
+
+#include <wx/hashmap.h>
 #include <wx/string.h>
 #include <wx/xml/xml.h>
 
 #include "DBGp/Error/Error.h"
 #include "DBGp/MessageArguments.h"
+#include "DBGp/PropertyArena.h"
+#include "DBGp/ResponseParser.h"
 #include "DBGp/Type.h"
 
 namespace DBGp {
 	class Connection;
 	class Context;
+	class Property;
+
+	WX_DECLARE_STRING_HASH_MAP(Property *, PropertyHash);
 
 	class Property {
 		friend class Connection;
 		friend class Context;
+		friend class PropertyBuilder;
+		friend class StackLevel;
 
 		public:
 			typedef std::map<wxString, Property *> PropertyMap;
+			typedef std::vector<Property *> PropertyVector;
 
 			Property(Connection *conn, Context *context, unsigned int depth, Property *parent = NULL);
 			Property(const Property &p);
 			virtual ~Property();
 
-			inline wxString GetAddress() const { return address; }
-			inline const PropertyMap &GetChildren() const { return children; }
-			inline wxString GetClassName() const { return className; }
+			inline wxString GetAddress() const { return PropertyArena::ToString(address); }
+			inline Property *GetChildAt(size_t i) const { return children[i]; }
+			inline size_t GetChildCount() const { return childCount; }
+			const PropertyMap &GetChildren() const;
+			inline wxString GetClassName() const { return PropertyArena::ToString(className); }
 			inline Context *GetContext() const { return context; }
-			inline wxString GetData() const { return data; }
+			inline wxString GetData() const { return PropertyArena::ToString(data); }
 			inline unsigned int GetDepth() const { return depth; }
-			inline wxString GetFullName() const { return fullName; }
-			inline wxString GetKey() const { return key; }
-			inline wxString GetName() const { return name; }
+			inline wxString GetFullName() const { return PropertyArena::ToString(fullName); }
+			inline wxString GetKey() const { return PropertyArena::ToString(key); }
+			inline wxString GetName() const { return PropertyArena::ToString(name); }
+			inline unsigned int GetNumChildren() const { return numChildren; }
 			inline Property *GetParent() { return parent; }
 			inline unsigned long GetSize() const { return size; }
-			inline Type GetType() const { return type; }
+			inline Type GetType() const { return (type ? *type : Type()); }
 
 			inline bool HasChildren() const { return hasChildren; }
+			inline bool HasMoreChildren() const { return (hasChildren && childCount < numChildren); }
 			inline bool HasParent() const { return (parent != NULL); }
 			inline bool IsConstant() const { return constant; }
+			inline bool IsShared() const { return (references > 1); }
+
+			/* FindChild() only looks at the children retrieved so
+			 * far, and returns NULL rather than throwing or going
+			 * back to the engine for more. */
+			Property *FindChild(const wxString &name) const;
+			Property *GetChild(const wxString &name) throw (EngineError, NotFoundError, SocketError);
 
-			Property *GetChild(const wxString &name) throw (NotFoundError);
+			/* Properties are reference counted, starting with the
+			 * reference held by whoever created them, so the same
+			 * tree can be held by the context, the UI and any copies
+			 * at once. Unref() deletes the property once the last
+			 * reference is gone. Counts aren't atomic, and neither
+			 * are those of the wxStrings involved. A PropertyBuilder
+			 * streaming a response runs on the I/O thread, where it
+			 * refs, unrefs and indexes the properties it builds; that
+			 * is only safe because whoever sent the command stays in
+			 * WaitForResponse() on the main thread until the response
+			 * has been collected, and nothing dispatched during the
+			 * wait may touch the properties being rebuilt. Otherwise,
+			 * properties are only used on the main thread.
+			 *
+			 * Properties built from a response live in that
+			 * response's PropertyArena, along with their strings and
+			 * child arrays, so they must never be deleted directly.
+			 * GetChildAt() returns the children in the order the
+			 * engine sent them; GetChildren() indexes them by name,
+			 * which costs a map the first time it's called. */
+			void Ref() const;
+			void Unref() const;
 
+			void RetrieveChildren() throw (EngineError, SocketError);
+
+			/* Retrieves the next page of children of each of the
+			 * given properties, sending every property_get before
+			 * waiting on any of them, so the lot costs one round
+			 * trip. */
+			static void RetrieveChildren(const PropertyVector &props) throw (EngineError, MalformedDocumentError, SocketError);
 			void Update() throw (EngineError, SocketError);
 
 		private:
-			wxString address;
-			PropertyMap children;
-			wxString className;
+			const char *address;
+			PropertyArena *arena;
+			size_t childCapacity;
+			size_t childCount;
+			Property **children;
+			const char *className;
 			Connection *conn;
 			bool constant;
 			Context *context;
-			wxString data;
+			const char *contextID;
+			const char *data;
 			unsigned int depth;
-			wxString fullName;
+			const char *fullName;
 			bool hasChildren;
-			wxString key;
-			wxString name;
+			bool inArena;
+			mutable PropertyMap *index;
+			bool indexed;
+			const char *key;
+			mutable PropertyHash *lookup;
+			const char *name;
+			unsigned int nextPage;
+			unsigned int numChildren;
 			Property *parent;
+			mutable unsigned int references;
 			unsigned long size;
-			Type type;
+			const Type *type;
+
+			Property(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent);
+
+			static Property *Create(PropertyArena *arena, Connection *conn, Context *context, unsigned int depth, Property *parent = NULL);
 
 			MessageArguments GetPropertyArguments() const;
+			void AddChildren(Property *const *props, size_t count);
+			void ClearChildren();
+			void DetachContext(const Context *context);
+			void InheritContextID();
+			void InvalidateIndexes();
+			void ParseAttributes(const ResponseParser::Attributes &attributes);
+			void ParseChildCount(const ResponseParser::Attributes &attributes, PropertyMap::size_type parsed);
 			void ParsePropertyElement(wxXmlNode *node);
+			void ReleaseChild(Property *child);
+			void Unindex();
 	};
 }
 
@@ -0,0 +1,235 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/PropertyArena.h"
+
+#include <cstring>
+
+#include <wx/strconv.h>
+
+using namespace DBGp;
+
+/* Everything allocated is aligned to this, which covers the pointers and
+ * longs properties are made of. */
+static const size_t ALIGNMENT = sizeof(double) > sizeof(void *) ? sizeof(double) : sizeof(void *);
+
+// {{{ PropertyArena::PropertyArena()
+PropertyArena::PropertyArena() : cursor(NULL), references(1), remaining(0), reserved(0), stringCount(0) {
+}
+// }}}
+// {{{ PropertyArena::~PropertyArena()
+PropertyArena::~PropertyArena() {
+	for (std::vector<TypeEntry>::iterator i = types.begin(); i != types.end(); i++) {
+		delete i->type;
+	}
+
+	for (std::vector<char *>::iterator i = chunks.begin(); i != chunks.end(); i++) {
+		delete[] *i;
+	}
+}
+// }}}
+
+// {{{ void *PropertyArena::Allocate(size_t size)
+void *PropertyArena::Allocate(size_t size) {
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	if (size > remaining) {
+		/* Each chunk is twice the size of the last, up to a limit, so
+		 * a single property costs a kilobyte but a large context only
+		 * needs a handful of chunks. The tail of the old chunk is
+		 * simply abandoned. */
+		size_t chunkSize = (reserved < MIN_CHUNK ? MIN_CHUNK : reserved);
+		if (chunkSize > MAX_CHUNK) {
+			chunkSize = MAX_CHUNK;
+		}
+		if (chunkSize < size) {
+			chunkSize = size;
+		}
+
+		cursor = new char[chunkSize];
+		chunks.push_back(cursor);
+		remaining = chunkSize;
+		reserved += chunkSize;
+	}
+
+	void *memory = cursor;
+	cursor += size;
+	remaining -= size;
+	return memory;
+}
+// }}}
+// {{{ const Type *PropertyArena::FindType(const char *name) const
+const Type *PropertyArena::FindType(const char *name) const {
+	// There are rarely more than a handful of types in a response.
+	for (std::vector<TypeEntry>::const_iterator i = types.begin(); i != types.end(); i++) {
+		if (i->name == name) {
+			return i->type;
+		}
+	}
+	return NULL;
+}
+// }}}
+// {{{ const char *PropertyArena::Intern(const wxString &s)
+const char *PropertyArena::Intern(const wxString &s) {
+	size_t length = Encode(s, scratch);
+	if (length == 0) {
+		return NULL;
+	}
+
+	const char *bytes = &scratch[0];
+	if ((stringCount + 1) * 2 > strings.size()) {
+		GrowStrings();
+	}
+
+	size_t mask = strings.size() - 1;
+	for (size_t slot = Hash(bytes, length) & mask; ; slot = (slot + 1) & mask) {
+		const char *existing = strings[slot];
+		if (existing == NULL) {
+			strings[slot] = Copy(bytes, length);
+			stringCount++;
+			return strings[slot];
+		}
+		if (GetLength(existing) == length && std::memcmp(existing, bytes, length) == 0) {
+			return existing;
+		}
+	}
+}
+// }}}
+// {{{ const Type *PropertyArena::InternType(const char *name, const Type &type)
+const Type *PropertyArena::InternType(const char *name, const Type &type) {
+	const Type *existing = FindType(name);
+	if (existing) {
+		return existing;
+	}
+
+	types.push_back(TypeEntry(name, new Type(type)));
+	return types.back().type;
+}
+// }}}
+// {{{ void PropertyArena::Ref()
+void PropertyArena::Ref() {
+	++references;
+}
+// }}}
+// {{{ const char *PropertyArena::Store(const wxString &s)
+const char *PropertyArena::Store(const wxString &s) {
+	size_t length = Encode(s, scratch);
+	return (length > 0 ? Copy(&scratch[0], length) : NULL);
+}
+// }}}
+// {{{ wxString PropertyArena::ToString(const char *s)
+wxString PropertyArena::ToString(const char *s) {
+	if (s == NULL) {
+		return wxEmptyString;
+	}
+
+#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
+	return wxString(s, wxConvUTF8, GetLength(s));
+#else
+	return wxString(s, GetLength(s));
+#endif
+}
+// }}}
+// {{{ void PropertyArena::Unref()
+void PropertyArena::Unref() {
+	wxASSERT(references > 0);
+	if (--references == 0) {
+		delete this;
+	}
+}
+// }}}
+
+// {{{ const char *PropertyArena::Copy(const char *bytes, size_t length)
+const char *PropertyArena::Copy(const char *bytes, size_t length) {
+	char *memory = static_cast<char *>(Allocate(sizeof(wxUint32) + length + 1));
+	*reinterpret_cast<wxUint32 *>(memory) = static_cast<wxUint32>(length);
+
+	char *s = memory + sizeof(wxUint32);
+	std::memcpy(s, bytes, length);
+	s[length] = '\0';
+	return s;
+}
+// }}}
+// {{{ size_t PropertyArena::Encode(const wxString &s, std::vector<char> &buffer)
+size_t PropertyArena::Encode(const wxString &s, std::vector<char> &buffer) {
+	if (s.empty()) {
+		return 0;
+	}
+
+#if defined(wxUSE_UNICODE) && wxUSE_UNICODE == 1
+	/* Passing the length means embedded NULs survive, and that the
+	 * result isn't NUL terminated. */
+	size_t length = wxConvUTF8.FromWChar(NULL, 0, s.wc_str(), s.length());
+	if (length == wxCONV_FAILED || length == 0) {
+		return 0;
+	}
+
+	buffer.resize(length);
+	wxConvUTF8.FromWChar(&buffer[0], length, s.wc_str(), s.length());
+#else
+	size_t length = s.length();
+	buffer.resize(length);
+	std::memcpy(&buffer[0], s.c_str(), length);
+#endif
+
+	return length;
+}
+// }}}
+// {{{ void PropertyArena::GrowStrings()
+void PropertyArena::GrowStrings() {
+	std::vector<const char *> old;
+	old.swap(strings);
+	strings.resize(old.empty() ? 64 : old.size() * 2, NULL);
+
+	size_t mask = strings.size() - 1;
+	for (std::vector<const char *>::iterator i = old.begin(); i != old.end(); i++) {
+		if (*i) {
+			size_t slot = Hash(*i, GetLength(*i)) & mask;
+			while (strings[slot] != NULL) {
+				slot = (slot + 1) & mask;
+			}
+			strings[slot] = *i;
+		}
+	}
+}
+// }}}
+// {{{ wxUint32 PropertyArena::Hash(const char *bytes, size_t length)
+wxUint32 PropertyArena::Hash(const char *bytes, size_t length) {
+	wxUint32 hash = 2166136261U;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= static_cast<unsigned char>(bytes[i]);
+		hash *= 16777619U;
+	}
+	return hash;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
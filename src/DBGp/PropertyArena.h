@@ -0,0 +1,229 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_PROPERTYARENA_H
+#define DBGP_PROPERTYARENA_H
+
+#include <vector>
+
+#include <wx/string.h>
+
+#include "DBGp/Type.h"
+
+namespace DBGp {
+	/**
+	 * The storage shared by every property built from one response.
+	 * Properties, their child arrays and their strings are carved out of
+	 * a few large chunks rather than allocated one by one, and the chunks
+	 * are only freed once every property in them has gone.
+	 *
+	 * Strings are kept as UTF-8 (or the native multibyte encoding in ANSI
+	 * builds), with their length stored immediately before the first
+	 * byte, so values can contain NUL characters. An empty string is
+	 * always NULL. Strings that repeat throughout a response, such as
+	 * class names and types, can be interned so that each is only stored
+	 * once.
+	 *
+	 * Arenas are reference counted in the same way as properties, and
+	 * like properties, the counts aren't atomic.
+	 */
+	class PropertyArena {
+		public:
+			/** Constructs an empty arena with one reference. */
+			PropertyArena();
+
+			/**
+			 * Allocates memory from the arena. The memory isn't
+			 * freed until the arena is.
+			 *
+			 * @param[in] size The number of bytes required.
+			 * @return The memory, aligned for any of the types
+			 * properties contain.
+			 */
+			void *Allocate(size_t size);
+
+			/**
+			 * Returns an interned type.
+			 *
+			 * @param[in] name An interned type name.
+			 * @return The type, or NULL if AddType() hasn't been
+			 * called for the name.
+			 */
+			const Type *FindType(const char *name) const;
+
+			/**
+			 * Returns the length of a stored string.
+			 *
+			 * @param[in] s The string, which may be NULL.
+			 * @return The length in bytes.
+			 */
+			static inline size_t GetLength(const char *s) { return (s ? *reinterpret_cast<const wxUint32 *>(s - sizeof(wxUint32)) : 0); }
+
+			/**
+			 * Returns the total size of the chunks allocated.
+			 *
+			 * @return The size in bytes.
+			 */
+			inline size_t GetSize() const { return reserved; }
+
+			/**
+			 * Stores a string, returning the existing copy if the
+			 * same string has been interned already.
+			 *
+			 * @param[in] s The string.
+			 * @return The stored string.
+			 */
+			const char *Intern(const wxString &s);
+
+			/**
+			 * Interns a type under the given name.
+			 *
+			 * @param[in] name An interned type name.
+			 * @param[in] type The type.
+			 * @return The interned type.
+			 */
+			const Type *InternType(const char *name, const Type &type);
+
+			/** Adds a reference. */
+			void Ref();
+
+			/**
+			 * Stores a string without interning it.
+			 *
+			 * @param[in] s The string.
+			 * @return The stored string.
+			 */
+			const char *Store(const wxString &s);
+
+			/**
+			 * Converts a stored string back to a wxString.
+			 *
+			 * @param[in] s The string, which may be NULL.
+			 * @return The converted string.
+			 */
+			static wxString ToString(const char *s);
+
+			/**
+			 * Drops a reference, deleting the arena once the last
+			 * reference has gone.
+			 */
+			void Unref();
+
+		private:
+			/** An interned type and the name it was interned under. */
+			class TypeEntry {
+				public:
+					inline TypeEntry(const char *name, Type *type) : name(name), type(type) {}
+
+					/** The interned type name. */
+					const char *name;
+
+					/** The type. */
+					Type *type;
+			};
+
+			/** The size of the first chunk. */
+			static const size_t MIN_CHUNK = 1024;
+
+			/** The size chunks stop growing at. */
+			static const size_t MAX_CHUNK = 65536;
+
+			/** The chunks allocated, in order. */
+			std::vector<char *> chunks;
+
+			/** The next free byte in the current chunk. */
+			char *cursor;
+
+			/** The number of references. */
+			unsigned int references;
+
+			/** The number of free bytes in the current chunk. */
+			size_t remaining;
+
+			/** The total size of the chunks allocated. */
+			size_t reserved;
+
+			/** Reused when converting strings to be interned. */
+			std::vector<char> scratch;
+
+			/**
+			 * The interned strings, as an open addressed hash
+			 * table. The size is always a power of two.
+			 */
+			std::vector<const char *> strings;
+
+			/** The number of interned strings. */
+			size_t stringCount;
+
+			/** The interned types. */
+			std::vector<TypeEntry> types;
+
+			/** Destructor. Use Unref() instead. */
+			~PropertyArena();
+
+			/**
+			 * Copies a converted string into the arena.
+			 *
+			 * @param[in] bytes The string.
+			 * @param[in] length The length in bytes.
+			 * @return The stored string.
+			 */
+			const char *Copy(const char *bytes, size_t length);
+
+			/**
+			 * Converts a string to the stored encoding.
+			 *
+			 * @param[in] s The string.
+			 * @param[out] buffer The buffer to convert into, which
+			 * is resized as required.
+			 * @return The length of the converted string.
+			 */
+			static size_t Encode(const wxString &s, std::vector<char> &buffer);
+
+			/**
+			 * Doubles the size of the string hash table.
+			 */
+			void GrowStrings();
+
+			/**
+			 * Hashes a string with FNV-1a.
+			 *
+			 * @param[in] bytes The string.
+			 * @param[in] length The length in bytes.
+			 * @return The hash.
+			 */
+			static wxUint32 Hash(const char *bytes, size_t length);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
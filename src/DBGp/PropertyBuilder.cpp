@@ -0,0 +1,175 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/PropertyBuilder.h"
+#include "DBGp/Context.h"
+#include "DBGp/StackLevel.h"
+#include "DBGp/Tracer.h"
+
+#include <algorithm>
+
+using namespace DBGp;
+
+// {{{ PropertyBuilder::PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property::PropertyMap &properties, Property::PropertyVector *order)
+PropertyBuilder::PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property::PropertyMap &properties, Property::PropertyVector *order) : arena(new PropertyArena), conn(conn), context(context), depth(depth), ignoreDepth(0), level(context ? context->GetStackLevel() : NULL), order(order), properties(&properties), replace(false), target(NULL), targetDone(false) {
+}
+// }}}
+// {{{ PropertyBuilder::PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property *target, bool replace)
+PropertyBuilder::PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property *target, bool replace) : arena(new PropertyArena), conn(conn), context(context), depth(depth), ignoreDepth(0), level(context ? context->GetStackLevel() : NULL), order(NULL), properties(NULL), replace(replace), target(target), targetDone(false) {
+	wxASSERT(target != NULL);
+}
+// }}}
+// {{{ PropertyBuilder::~PropertyBuilder()
+PropertyBuilder::~PropertyBuilder() {
+	/* Children are only attached to their parents once the parents are
+	 * complete, so everything still on the stack or pending is ours to
+	 * clean up. */
+	for (std::vector<Frame>::iterator i = frames.begin(); i != frames.end(); i++) {
+		if (i->prop != target) {
+			i->prop->Unref();
+		}
+	}
+
+	for (std::vector<Property *>::iterator i = pending.begin(); i != pending.end(); i++) {
+		(*i)->Unref();
+	}
+
+	// The properties we built keep the arena alive from here on.
+	arena->Unref();
+}
+// }}}
+
+// {{{ void PropertyBuilder::OnEndElement(const wxString &name, const wxString &content) throw (Error)
+void PropertyBuilder::OnEndElement(const wxString &name, const wxString &content) throw (Error) {
+	if (ignoreDepth > 0) {
+		/* Newer engines can send some of the property fields as child
+		 * elements, so they can be encoded. */
+		if (--ignoreDepth == 0 && !frames.empty()) {
+			Frame &frame = frames.back();
+
+			if (name == wxT("name")) {
+				frame.prop->name = frame.prop->arena->Store(content);
+			}
+			else if (name == wxT("fullname")) {
+				frame.prop->fullName = frame.prop->arena->Store(content);
+			}
+			else if (name == wxT("classname")) {
+				frame.prop->className = frame.prop->arena->Intern(content);
+			}
+			else if (name == wxT("value")) {
+				frame.prop->data = frame.prop->arena->Store(content);
+				frame.value = true;
+			}
+		}
+		return;
+	}
+
+	if (frames.empty()) {
+		return;
+	}
+
+	Frame frame(frames.back());
+	frames.pop_back();
+
+	if (!frame.value) {
+		frame.prop->data = frame.prop->arena->Store(content);
+	}
+
+	size_t parsed = pending.size() - frame.first;
+	if (parsed > 0) {
+		frame.prop->AddChildren(&pending[frame.first], parsed);
+		pending.resize(frame.first);
+	}
+	frame.prop->ParseChildCount(frame.attributes, parsed);
+
+	/* Every property is indexed as it's completed, including children
+	 * paged in later, so hovers never have to walk the tree. */
+	if (level) {
+		level->IndexProperty(frame.prop);
+	}
+
+	if (!frames.empty()) {
+		pending.push_back(frame.prop);
+	}
+	else if (frame.prop == target) {
+		targetDone = true;
+	}
+	else {
+		Property::PropertyMap::iterator existing = properties->find(frame.prop->GetName());
+		if (existing != properties->end()) {
+			if (order) {
+				std::replace(order->begin(), order->end(), existing->second, frame.prop);
+			}
+			existing->second->Unref();
+		}
+		else if (order) {
+			order->push_back(frame.prop);
+		}
+		(*properties)[frame.prop->GetName()] = frame.prop;
+	}
+}
+// }}}
+// {{{ void PropertyBuilder::OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error)
+void PropertyBuilder::OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error) {
+	Property *prop;
+
+	if (ignoreDepth > 0 || name != wxT("property")) {
+		++ignoreDepth;
+		return;
+	}
+
+	DBGP_TRACE("dbgp", "Property");
+	if (!frames.empty()) {
+		prop = Property::Create(arena, conn, context, depth, frames.back().prop);
+	}
+	else if (target) {
+		// property_get only ever returns the one property.
+		if (targetDone) {
+			++ignoreDepth;
+			return;
+		}
+
+		prop = target;
+		if (replace) {
+			prop->ClearChildren();
+			prop->nextPage = 0;
+		}
+	}
+	else {
+		prop = Property::Create(arena, conn, context, depth);
+	}
+
+	prop->ParseAttributes(attributes);
+	frames.push_back(Frame(prop, attributes, pending.size()));
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,174 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_PROPERTYBUILDER_H
+#define DBGP_PROPERTYBUILDER_H
+
+#include <vector>
+
+#include "DBGp/Property.h"
+#include "DBGp/ResponseParser.h"
+
+namespace DBGp {
+	class Connection;
+	class Context;
+	class StackLevel;
+
+	/**
+	 * A ResponseParser handler that builds Property trees directly from
+	 * context_get and property_get responses as they're parsed.
+	 */
+	class PropertyBuilder : public ResponseParser::Handler {
+		public:
+			/**
+			 * Constructs a builder that adds every top level
+			 * property to a map, as for context_get.
+			 *
+			 * @param[in] conn The DBGp connection.
+			 * @param[in] context The context the properties are
+			 * in.
+			 * @param[in] depth The stack depth.
+			 * @param[out] properties The map to add properties to.
+			 * Existing properties with the same name are replaced.
+			 * @param[out] order If given, the properties are also
+			 * appended to it in the order the engine sent them.
+			 */
+			PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property::PropertyMap &properties, Property::PropertyVector *order = NULL);
+
+			/**
+			 * Constructs a builder that updates an existing
+			 * property, as for property_get.
+			 *
+			 * @param[in] conn The DBGp connection.
+			 * @param[in] context The context the property is in.
+			 * @param[in] depth The stack depth.
+			 * @param[in,out] target The property to update.
+			 * @param[in] replace True if the existing children
+			 * should be thrown away, false if the response is a
+			 * further page of children to add.
+			 */
+			PropertyBuilder(Connection *conn, Context *context, unsigned int depth, Property *target, bool replace);
+
+			/**
+			 * Destructor. Any properties left half built by an
+			 * aborted parse are released, along with the builder's
+			 * reference to the arena.
+			 */
+			virtual ~PropertyBuilder();
+
+			virtual void OnEndElement(const wxString &name, const wxString &content) throw (Error);
+			virtual void OnStartElement(const wxString &name, const ResponseParser::Attributes &attributes) throw (Error);
+
+		private:
+			/** The state kept for each open property element. */
+			class Frame {
+				public:
+					inline Frame(Property *prop, const ResponseParser::Attributes &attributes, size_t first) : attributes(attributes), first(first), prop(prop), value(false) {}
+
+					/** The element's attributes. */
+					ResponseParser::Attributes attributes;
+
+					/**
+					 * The position of the property's first
+					 * child in the pending list.
+					 */
+					size_t first;
+
+					/** The property being built. */
+					Property *prop;
+
+					/**
+					 * Whether the value came from a value
+					 * child element.
+					 */
+					bool value;
+			};
+
+			/**
+			 * The arena every property built from the response
+			 * lives in.
+			 */
+			PropertyArena *arena;
+
+			/** The DBGp connection. */
+			Connection *conn;
+
+			/** The context the properties are in. */
+			Context *context;
+
+			/** The stack depth. */
+			unsigned int depth;
+
+			/** The open property elements, innermost last. */
+			std::vector<Frame> frames;
+
+			/**
+			 * The number of elements we're ignoring currently
+			 * open.
+			 */
+			unsigned int ignoreDepth;
+
+			/**
+			 * The stack level to index the properties in by full
+			 * name, if any.
+			 */
+			StackLevel *level;
+
+			/**
+			 * The vector to add top level properties to in engine
+			 * order, if any.
+			 */
+			Property::PropertyVector *order;
+
+			/**
+			 * Completed properties waiting for their parent to
+			 * finish, so each parent's children can be attached
+			 * in a single array.
+			 */
+			std::vector<Property *> pending;
+
+			/** The map to add top level properties to, if any. */
+			Property::PropertyMap *properties;
+
+			/** Whether to replace the target's children. */
+			bool replace;
+
+			/** The property to update, if any. */
+			Property *target;
+
+			/** Whether the target has been updated. */
+			bool targetDone;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
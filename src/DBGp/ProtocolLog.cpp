@@ -0,0 +1,139 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/ProtocolLog.h"
+#include "DBGp/Log.h"
+#include "DBGp/Utility.h"
+
+#include <wx/file.h>
+#include <wx/thread.h>
+
+using namespace DBGp;
+
+/* Log state, all guarded by the mutex. The ring holds the most recent
+ * entries, with next counting every entry ever written to it. */
+static size_t next = 0;
+static size_t logPayloadLimit = ProtocolLog::DEFAULT_PAYLOAD_LIMIT;
+static ProtocolLog::EntryList ring;
+static wxMutex mutex;
+static unsigned int logSampleRate = 1;
+static unsigned long seen = 0;
+static wxUint64 started = 0;
+
+volatile bool ProtocolLog::enabled = false;
+
+// {{{ void ProtocolLog::Disable()
+void ProtocolLog::Disable() {
+	wxMutexLocker lock(mutex);
+	enabled = false;
+}
+// }}}
+// {{{ bool ProtocolLog::Dump(const wxString &file)
+bool ProtocolLog::Dump(const wxString &file) {
+	wxFile f;
+
+	if (!f.Create(file, true)) {
+		return false;
+	}
+	return f.Write(Format(), wxConvUTF8) && f.Close();
+}
+// }}}
+// {{{ void ProtocolLog::Enable(unsigned int sampleRate, size_t capacity, size_t payloadLimit)
+void ProtocolLog::Enable(unsigned int sampleRate, size_t capacity, size_t payloadLimit) {
+	wxMutexLocker lock(mutex);
+
+	EntryList(capacity > 0 ? capacity : 1).swap(ring);
+	next = 0;
+	logPayloadLimit = payloadLimit;
+	logSampleRate = (sampleRate > 0) ? sampleRate : 1;
+	seen = 0;
+	started = GetMicroseconds();
+	enabled = true;
+}
+// }}}
+// {{{ wxString ProtocolLog::Format()
+wxString ProtocolLog::Format() {
+	EntryList entries(GetEntries());
+	wxString s;
+
+	for (EntryList::const_iterator i = entries.begin(); i != entries.end(); i++) {
+		s << wxString::Format(wxT("%12lu %p %s(%lu): "),
+			static_cast<unsigned long>(i->time),
+			i->session,
+			i->direction == SENT ? wxT("TX") : wxT("RX"),
+			static_cast<unsigned long>(i->length));
+		s << LogPayload(i->payload.data(), i->payload.length()).Format(i->payload.length());
+		if (i->payload.length() < i->length) {
+			s << wxString::Format(wxT("... (%lu more bytes)"), static_cast<unsigned long>(i->length - i->payload.length()));
+		}
+		s << wxT("\n");
+	}
+	return s;
+}
+// }}}
+// {{{ ProtocolLog::EntryList ProtocolLog::GetEntries()
+ProtocolLog::EntryList ProtocolLog::GetEntries() {
+	wxMutexLocker lock(mutex);
+	EntryList entries;
+
+	if (ring.empty()) {
+		return entries;
+	}
+
+	size_t first = (next > ring.size()) ? next - ring.size() : 0;
+	entries.reserve(next - first);
+	for (size_t i = first; i < next; i++) {
+		entries.push_back(ring[i % ring.size()]);
+	}
+	return entries;
+}
+// }}}
+// {{{ void ProtocolLog::Record(const void *session, Direction direction, const char *payload, size_t length)
+void ProtocolLog::Record(const void *session, Direction direction, const char *payload, size_t length) {
+	if (!enabled) {
+		return;
+	}
+
+	wxMutexLocker lock(mutex);
+	if (!enabled || (seen++ % logSampleRate) != 0) {
+		return;
+	}
+
+	Entry &entry = ring[next++ % ring.size()];
+	entry.direction = direction;
+	entry.length = length;
+	entry.payload.assign(payload, (length > logPayloadLimit) ? logPayloadLimit : length);
+	entry.session = session;
+	entry.time = GetMicroseconds() - started;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
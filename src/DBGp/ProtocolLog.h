@@ -0,0 +1,164 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_PROTOCOLLOG_H
+#define DBGP_PROTOCOLLOG_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <wx/string.h>
+
+namespace DBGp {
+	/**
+	 * A sampled record of the most recent protocol traffic across all
+	 * sessions, which can be switched on and off at runtime, including in
+	 * release builds.
+	 *
+	 * Recording only copies the raw bytes of each sampled message, up to
+	 * a limit, into a fixed size ring buffer; nothing is converted or
+	 * formatted until the log is read. While the log is disabled, each
+	 * message costs a single flag check.
+	 *
+	 * Messages may be recorded from any thread.
+	 */
+	class ProtocolLog {
+		public:
+			/** The direction of a message. */
+			typedef enum {
+				RECEIVED,
+				SENT
+			} Direction;
+
+			/** A single recorded message. */
+			class Entry {
+				public:
+					/** Whether the message was sent or received. */
+					Direction direction;
+
+					/** The full length of the message, in bytes. */
+					size_t length;
+
+					/**
+					 * The start of the message, up to the
+					 * payload limit.
+					 */
+					std::string payload;
+
+					/** The session the message belongs to. */
+					const void *session;
+
+					/**
+					 * When the message was recorded, in
+					 * microseconds since the log was enabled.
+					 */
+					wxUint64 time;
+			};
+
+			/** A list of entries, oldest first. */
+			typedef std::vector<Entry> EntryList;
+
+			/** The default number of messages kept. */
+			static const size_t DEFAULT_CAPACITY = 256;
+
+			/** The default number of bytes kept per message. */
+			static const size_t DEFAULT_PAYLOAD_LIMIT = 4096;
+
+			/**
+			 * Stops recording. Messages already recorded are kept
+			 * until the log is next enabled.
+			 */
+			static void Disable();
+
+			/**
+			 * Writes the formatted log to a file.
+			 *
+			 * @param[in] file The file name.
+			 * @return True if the file was written.
+			 */
+			static bool Dump(const wxString &file);
+
+			/**
+			 * Starts recording, discarding any messages already
+			 * recorded.
+			 *
+			 * @param[in] sampleRate Record one message in this
+			 * many; 1 records everything.
+			 * @param[in] capacity The number of messages to keep.
+			 * @param[in] payloadLimit The number of bytes to keep
+			 * from each message.
+			 */
+			static void Enable(unsigned int sampleRate = 1, size_t capacity = DEFAULT_CAPACITY, size_t payloadLimit = DEFAULT_PAYLOAD_LIMIT);
+
+			/**
+			 * Formats the recorded messages as text, one per line.
+			 *
+			 * @return The formatted log.
+			 */
+			static wxString Format();
+
+			/**
+			 * Returns a copy of the recorded messages.
+			 *
+			 * @return The messages, oldest first.
+			 */
+			static EntryList GetEntries();
+
+			/**
+			 * Checks if messages are being recorded.
+			 *
+			 * @return True if the log is enabled.
+			 */
+			static inline bool IsEnabled() { return enabled; }
+
+			/**
+			 * Offers a message to the log, which records it if the
+			 * log is enabled and the message is sampled.
+			 *
+			 * @param[in] session The session the message belongs
+			 * to; only used to tell sessions apart.
+			 * @param[in] direction Whether the message was sent or
+			 * received.
+			 * @param[in] payload The message.
+			 * @param[in] length The length of the message.
+			 */
+			static void Record(const void *session, Direction direction, const char *payload, size_t length);
+
+		protected:
+			/** Whether messages are being recorded. */
+			static volatile bool enabled;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
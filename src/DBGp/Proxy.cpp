@@ -0,0 +1,951 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Proxy.h"
+#include "DBGp/DocumentBuilder.h"
+#include "DBGp/FrameReader.h"
+#include "DBGp/ResponseParser.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <wx/log.h>
+#include <wx/xml/xml.h>
+
+using namespace DBGp;
+
+/* The longest proxyinit or proxystop command we'll buffer. */
+static const size_t MAX_COMMAND_LENGTH = 4096;
+
+// {{{ static std::string Escape(const std::string &s)
+static std::string Escape(const std::string &s) {
+	std::string escaped;
+
+	for (std::string::const_iterator i = s.begin(); i != s.end(); i++) {
+		switch (*i) {
+			case '&':
+				escaped.append("&amp;");
+				break;
+
+			case '<':
+				escaped.append("&lt;");
+				break;
+
+			case '>':
+				escaped.append("&gt;");
+				break;
+
+			case '"':
+				escaped.append("&quot;");
+				break;
+
+			default:
+				escaped.push_back(*i);
+		}
+	}
+
+	return escaped;
+}
+// }}}
+// {{{ static std::string Frame(const std::string &payload)
+static std::string Frame(const std::string &payload) {
+	char length[32];
+	std::string frame;
+
+	std::sprintf(length, "%lu", static_cast<unsigned long>(payload.length()));
+	frame.append(length);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	return frame;
+}
+// }}}
+// {{{ static std::string ProxyResponse(const std::string &command, int code, const std::string &message)
+static std::string ProxyResponse(const std::string &command, int code, const std::string &message) {
+	char id[16];
+
+	std::sprintf(id, "%d", code);
+	return "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<" + command + " success=\"0\"><error id=\"" + id + "\"><message>" + Escape(message) + "</message></error></" + command + ">";
+}
+// }}}
+// {{{ static SocketError SystemError(const wxString &operation)
+static SocketError SystemError(const wxString &operation) {
+	return SocketError(operation + wxT(": ") + wxSysErrorMsg(errno));
+}
+// }}}
+
+// {{{ class Proxy::Channel
+namespace DBGp {
+	class Proxy::Channel {
+		public:
+			Channel(Proxy *proxy) : closed(false), proxy(proxy), slot(0) {}
+			virtual ~Channel() {}
+
+			/* Handles an event on one of the channel's endpoints. */
+			virtual void OnEvent(Endpoint *endpoint, unsigned int events) throw () = 0;
+
+			bool closed;
+			Proxy *proxy;
+			size_t slot;
+
+		protected:
+			void Close() throw () {
+				if (!closed) {
+					closed = true;
+					proxy->MarkClosed(this);
+				}
+			}
+	};
+}
+// }}}
+// {{{ class Proxy::Control
+namespace DBGp {
+	/* Reads a single command, writes the response and closes, which is
+	 * what IDEs expect of a proxy. */
+	class Proxy::Control : public Channel {
+		public:
+			Control(Proxy *proxy, int fd) : Channel(proxy), offset(0), responded(false) {
+				endpoint.channel = this;
+				endpoint.fd = fd;
+			}
+
+			~Control() {
+				close(endpoint.fd);
+			}
+
+			void OnEvent(Endpoint *ep, unsigned int events) throw () {
+				if (!responded && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+					Read();
+				}
+				if (!closed && responded) {
+					Flush();
+				}
+			}
+
+			Endpoint endpoint;
+
+		protected:
+			std::string input;
+			size_t offset;
+			std::string output;
+			bool responded;
+
+			void Flush() throw () {
+				while (offset < output.length()) {
+					ssize_t written = send(endpoint.fd, output.data() + offset, output.length() - offset, MSG_NOSIGNAL);
+
+					if (written >= 0) {
+						offset += static_cast<size_t>(written);
+					}
+					else if (errno == EINTR) {
+						continue;
+					}
+					else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+						proxy->Watch(&endpoint, EPOLLOUT);
+						return;
+					}
+					else {
+						break;
+					}
+				}
+				Close();
+			}
+
+			void Read() throw () {
+				char buffer[512];
+				bool eof = false;
+
+				for (;;) {
+					ssize_t received = recv(endpoint.fd, buffer, sizeof(buffer), 0);
+
+					if (received > 0) {
+						input.append(buffer, static_cast<size_t>(received));
+					}
+					else if (received == -1 && errno == EINTR) {
+						continue;
+					}
+					else if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+						break;
+					}
+					else if (received == 0) {
+						eof = true;
+						break;
+					}
+					else {
+						Close();
+						return;
+					}
+				}
+
+				std::string::size_type terminator = input.find('\0');
+				if (terminator == std::string::npos) {
+					// Gone before sending a whole command.
+					if (eof || input.length() > MAX_COMMAND_LENGTH) {
+						Close();
+					}
+					return;
+				}
+
+				std::string response;
+				if (proxy->HandleCommand(input.substr(0, terminator), endpoint.fd, response)) {
+					output = Frame(response);
+					responded = true;
+				}
+				else {
+					Close();
+				}
+			}
+	};
+}
+// }}}
+// {{{ class Proxy::Session
+namespace DBGp {
+	class Proxy::Session : public Channel {
+		public:
+			enum State {
+				AWAITING_INIT,
+				CONNECTING,
+				SPLICING
+			};
+
+			Session(Proxy *proxy, int fd) : Channel(proxy), counted(false), pendingOffset(0), reader(4096), serial(0), state(AWAITING_INIT) {
+				engine.channel = this;
+				engine.fd = fd;
+				ide.channel = this;
+
+				toEngine.pipe[0] = toEngine.pipe[1] = -1;
+				toIDE.pipe[0] = toIDE.pipe[1] = -1;
+
+				proxy->sessionCount++;
+			}
+
+			~Session() {
+				if (counted) {
+					/* If the IDE has stopped and registered again
+					 * since, the new registration never counted
+					 * this session. */
+					RegistrationMap::iterator i = proxy->registrations.find(ideKey);
+					if (i != proxy->registrations.end() && i->second.serial == serial && i->second.sessions > 0) {
+						i->second.sessions--;
+					}
+				}
+
+				ClosePipe(toEngine);
+				ClosePipe(toIDE);
+				if (ide.fd != -1) {
+					close(ide.fd);
+				}
+				close(engine.fd);
+
+				proxy->sessionCount--;
+			}
+
+			void OnEvent(Endpoint *endpoint, unsigned int events) throw () {
+				switch (state) {
+					case AWAITING_INIT:
+						ReadInit();
+						break;
+
+					case CONNECTING:
+						if (endpoint == &ide) {
+							Connected();
+						}
+						else {
+							// The engine has given up on us.
+							Close();
+						}
+						break;
+
+					case SPLICING:
+						if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+							if (endpoint == &engine ? !Pump(toIDE, engine, ide) : !Pump(toEngine, ide, engine)) {
+								Close();
+								return;
+							}
+						}
+						if (events & EPOLLOUT) {
+							if (endpoint == &engine ? !Drain(toEngine, engine) : !Drain(toIDE, ide)) {
+								Close();
+								return;
+							}
+						}
+						UpdateInterest();
+						break;
+				}
+			}
+
+			Endpoint engine;
+
+		protected:
+			/* One direction of the session: bytes are spliced from
+			 * the source socket into the pipe, then from the pipe
+			 * into the destination socket. */
+			struct Direction {
+				size_t buffered;
+				bool eof;
+				int pipe[2];
+
+				Direction() : buffered(0), eof(false) {}
+			};
+
+			bool counted;
+			Endpoint ide;
+			std::string ideKey;
+			std::string pending;
+			size_t pendingOffset;
+			FrameReader reader;
+			unsigned long serial;
+			State state;
+			Direction toEngine;
+			Direction toIDE;
+
+			void ClosePipe(Direction &direction) throw () {
+				for (int i = 0; i < 2; i++) {
+					if (direction.pipe[i] != -1) {
+						close(direction.pipe[i]);
+					}
+				}
+			}
+
+			/* Called once the connection to the IDE is writable:
+			 * checks the connect() result, then sends the init
+			 * packet. */
+			void Connected() throw () {
+				if (pendingOffset == 0) {
+					int error = 0;
+					socklen_t length = sizeof(error);
+
+					if (getsockopt(ide.fd, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error != 0) {
+						wxLogDebug(wxT("Unable to connect to the IDE for a proxied session."));
+						Close();
+						return;
+					}
+				}
+
+				while (pendingOffset < pending.length()) {
+					ssize_t written = send(ide.fd, pending.data() + pendingOffset, pending.length() - pendingOffset, MSG_NOSIGNAL);
+
+					if (written >= 0) {
+						pendingOffset += static_cast<size_t>(written);
+					}
+					else if (errno == EINTR) {
+						continue;
+					}
+					else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+						return;
+					}
+					else {
+						Close();
+						return;
+					}
+				}
+				std::string().swap(pending);
+
+				if (pipe2(toEngine.pipe, O_NONBLOCK | O_CLOEXEC) == -1 || pipe2(toIDE.pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+					Close();
+					return;
+				}
+
+				state = SPLICING;
+				UpdateInterest();
+			}
+
+			/* Moves everything in the pipe to the destination.
+			 * Returns false if the destination has failed; if it's
+			 * merely full, the rest stays buffered. */
+			bool Drain(Direction &direction, Endpoint &to) throw () {
+				while (direction.buffered > 0) {
+					ssize_t moved = splice(direction.pipe[0], NULL, to.fd, NULL, direction.buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+					if (moved > 0) {
+						direction.buffered -= static_cast<size_t>(moved);
+					}
+					else if (moved == -1 && errno == EINTR) {
+						continue;
+					}
+					else if (moved == -1 && errno == EAGAIN) {
+						break;
+					}
+					else {
+						return false;
+					}
+				}
+
+				// Once the source has closed and we've caught up, we're done.
+				return !(direction.eof && direction.buffered == 0);
+			}
+
+			/* Parses the init packet, finds the IDE and starts
+			 * connecting to it. */
+			void HandleInit(const char *payload, size_t length) throw (Error) {
+				wxXmlDocument doc;
+				DocumentBuilder builder(doc);
+				ResponseParser parser(&wxConvISO8859_1);
+
+				parser.Parse(payload, length, builder);
+				if (!doc.IsOk() || doc.GetRoot()->GetName() != wxT("init")) {
+					throw MalformedDocumentError(wxT("Expected an init packet."));
+				}
+				ideKey = std::string(doc.GetRoot()->GetPropVal(wxT("idekey"), wxEmptyString).mb_str(wxConvISO8859_1));
+
+				RegistrationMap::iterator i = proxy->registrations.find(ideKey);
+				if (i == proxy->registrations.end()) {
+					wxLogDebug(wxT("No IDE is registered for IDE key %s."), wxString(ideKey.c_str(), wxConvISO8859_1).c_str());
+					Close();
+					return;
+				}
+				else if (!i->second.multiple && i->second.sessions > 0) {
+					wxLogDebug(wxT("The IDE for IDE key %s is already busy."), wxString(ideKey.c_str(), wxConvISO8859_1).c_str());
+					Close();
+					return;
+				}
+
+				/* Tell the IDE where the session really came from by
+				 * adding a proxied attribute to the root element,
+				 * rather than reserialising the document. */
+				struct sockaddr_in addr;
+				socklen_t addrLength = sizeof(addr);
+				char address[INET_ADDRSTRLEN] = "";
+				std::string init(payload, length);
+				std::string::size_type root = init.find("<init");
+
+				if (getpeername(engine.fd, reinterpret_cast<struct sockaddr *>(&addr), &addrLength) == 0) {
+					inet_ntop(AF_INET, &addr.sin_addr, address, sizeof(address));
+				}
+				if (root != std::string::npos) {
+					init.insert(root + 5, std::string(" proxied=\"") + address + "\"");
+				}
+
+				// Anything sent after the init packet follows it.
+				pending = Frame(init);
+				pending.append(reader.GetBufferedData(), reader.GetBufferedLength());
+				reader.Reset();
+
+				std::memset(&addr, 0, sizeof(addr));
+				addr.sin_family = AF_INET;
+				addr.sin_addr.s_addr = i->second.address;
+				addr.sin_port = htons(i->second.port);
+
+				if ((ide.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+					Close();
+					return;
+				}
+				if (connect(ide.fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1 && errno != EINPROGRESS) {
+					Close();
+					return;
+				}
+
+				i->second.sessions++;
+				counted = true;
+				serial = i->second.serial;
+				state = CONNECTING;
+
+				/* Nothing more is read from the engine until the
+				 * IDE is connected; we only want to hear about it
+				 * hanging up. */
+				if (!proxy->Watch(&engine, EPOLLRDHUP) || !proxy->Watch(&ide, EPOLLOUT)) {
+					Close();
+				}
+			}
+
+			/* Moves a chunk of data from one socket to the other.
+			 * Returns false once the session should be closed. */
+			bool Pump(Direction &direction, Endpoint &from, Endpoint &to) throw () {
+				/* Only one read per event, so a busy session can't
+				 * starve the others. The epoll set is level
+				 * triggered, so we'll be back if there's more. */
+				if (direction.buffered == 0 && !direction.eof) {
+					ssize_t moved = splice(from.fd, NULL, direction.pipe[1], NULL, SPLICE_SIZE, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+					if (moved > 0) {
+						direction.buffered = static_cast<size_t>(moved);
+					}
+					else if (moved == 0) {
+						direction.eof = true;
+					}
+					else if (errno != EAGAIN && errno != EINTR) {
+						return false;
+					}
+				}
+
+				return Drain(direction, to);
+			}
+
+			void ReadInit() throw () {
+				char buffer[4096];
+				const char *payload;
+				size_t length;
+
+				for (;;) {
+					ssize_t received = recv(engine.fd, buffer, sizeof(buffer), 0);
+
+					if (received > 0) {
+						reader.Append(buffer, static_cast<size_t>(received));
+					}
+					else if (received == -1 && errno == EINTR) {
+						continue;
+					}
+					else if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+						break;
+					}
+					else {
+						Close();
+						return;
+					}
+				}
+
+				try {
+					if (reader.NextFrame(payload, length)) {
+						HandleInit(payload, length);
+					}
+				}
+				catch (Error e) {
+					Close();
+				}
+			}
+
+			/* Reads from a socket only while its direction has
+			 * nothing buffered, and waits for a socket to become
+			 * writable only while the other direction does. */
+			void UpdateInterest() throw () {
+				unsigned int engineEvents = 0, ideEvents = 0;
+
+				if (toIDE.buffered == 0 && !toIDE.eof) {
+					engineEvents |= EPOLLIN | EPOLLRDHUP;
+				}
+				if (toEngine.buffered > 0) {
+					engineEvents |= EPOLLOUT;
+				}
+				if (toEngine.buffered == 0 && !toEngine.eof) {
+					ideEvents |= EPOLLIN | EPOLLRDHUP;
+				}
+				if (toIDE.buffered > 0) {
+					ideEvents |= EPOLLOUT;
+				}
+
+				if (!proxy->Watch(&engine, engineEvents) || !proxy->Watch(&ide, ideEvents)) {
+					Close();
+				}
+			}
+	};
+}
+// }}}
+// {{{ class Proxy::Thread
+namespace DBGp {
+	class Proxy::Thread : public wxThread {
+		public:
+			Thread(Proxy *proxy) : wxThread(wxTHREAD_JOINABLE), proxy(proxy) {}
+
+		protected:
+			virtual ExitCode Entry() {
+				sigset_t signals;
+
+				/* splice() has no equivalent of MSG_NOSIGNAL, so
+				 * SIGPIPE is blocked on this thread instead, which
+				 * leaves writes to a closed socket failing with
+				 * EPIPE. */
+				sigemptyset(&signals);
+				sigaddset(&signals, SIGPIPE);
+				pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+				proxy->Loop();
+				return 0;
+			}
+
+		private:
+			Proxy *proxy;
+	};
+}
+// }}}
+
+// {{{ Proxy::Proxy()
+Proxy::Proxy() : enginePort(0), epollFD(-1), idePort(0), lastSerial(0), listenPaused(false), registrationCount(0), sessionCount(0), stopping(false), thread(NULL) {
+}
+// }}}
+// {{{ Proxy::~Proxy()
+Proxy::~Proxy() {
+	Stop();
+}
+// }}}
+
+// {{{ void Proxy::Start(wxUint16 enginePort, wxUint16 idePort, bool loopback) throw (SocketError)
+void Proxy::Start(wxUint16 enginePort, wxUint16 idePort, bool loopback) throw (SocketError) {
+	if (thread) {
+		return;
+	}
+
+	try {
+		if ((epollFD = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			throw SystemError(wxT("epoll_create1"));
+		}
+		if ((wake.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			throw SystemError(wxT("eventfd"));
+		}
+		if (!Watch(&wake, EPOLLIN)) {
+			throw SystemError(wxT("epoll_ctl"));
+		}
+
+		this->enginePort = Listen(engineListener, enginePort, loopback);
+		this->idePort = Listen(ideListener, idePort, loopback);
+
+		stopping = false;
+		thread = new Thread(this);
+		if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+			delete thread;
+			thread = NULL;
+			throw SocketError(wxT("Unable to start the proxy thread."));
+		}
+	}
+	catch (SocketError e) {
+		CloseDescriptors();
+		throw;
+	}
+}
+// }}}
+// {{{ void Proxy::Stop() throw ()
+void Proxy::Stop() throw () {
+	if (thread == NULL) {
+		return;
+	}
+
+	stopping = true;
+	if (eventfd_write(wake.fd, 1) == -1) {
+		wxLogDebug(wxT("Error waking the proxy: %s"), wxSysErrorMsg(errno));
+	}
+
+	thread->Wait();
+	delete thread;
+	thread = NULL;
+
+	// The thread is gone, so the channels are ours now.
+	while (!channels.empty()) {
+		RemoveChannel(channels.back());
+	}
+	closed.clear();
+
+	registrations.clear();
+	registrationCount = 0;
+
+	CloseDescriptors();
+}
+// }}}
+
+// {{{ void Proxy::Accept(Endpoint *listener) throw ()
+void Proxy::Accept(Endpoint *listener) throw () {
+	for (;;) {
+		int fd = accept4(listener->fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (fd == -1) {
+			if (errno == EMFILE || errno == ENFILE) {
+				/* The listening sockets would otherwise stay
+				 * readable and spin the loop; they're resumed
+				 * when a channel is removed. */
+				Watch(&engineListener, 0);
+				Watch(&ideListener, 0);
+				listenPaused = true;
+			}
+			else if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			return;
+		}
+
+		if (listener == &engineListener) {
+			Session *session = new Session(this, fd);
+
+			AddChannel(session);
+			if (!Watch(&session->engine, EPOLLIN | EPOLLRDHUP)) {
+				RemoveChannel(session);
+			}
+		}
+		else {
+			Control *control = new Control(this, fd);
+
+			AddChannel(control);
+			if (!Watch(&control->endpoint, EPOLLIN | EPOLLRDHUP)) {
+				RemoveChannel(control);
+			}
+		}
+	}
+}
+// }}}
+// {{{ void Proxy::AddChannel(Channel *channel) throw ()
+void Proxy::AddChannel(Channel *channel) throw () {
+	channel->slot = channels.size();
+	channels.push_back(channel);
+}
+// }}}
+// {{{ void Proxy::CloseDescriptors() throw ()
+void Proxy::CloseDescriptors() throw () {
+	Endpoint *endpoints[] = { &engineListener, &ideListener, &wake };
+
+	for (size_t i = 0; i < sizeof(endpoints) / sizeof(endpoints[0]); i++) {
+		if (endpoints[i]->fd != -1) {
+			close(endpoints[i]->fd);
+		}
+		*endpoints[i] = Endpoint();
+	}
+
+	if (epollFD != -1) {
+		close(epollFD);
+		epollFD = -1;
+	}
+
+	listenPaused = false;
+	enginePort = idePort = 0;
+}
+// }}}
+// {{{ bool Proxy::HandleCommand(const std::string &command, int fd, std::string &response) throw ()
+bool Proxy::HandleCommand(const std::string &command, int fd, std::string &response) throw () {
+	std::map<std::string, std::string> args;
+	std::vector<std::string> tokens;
+	std::string::size_type start = 0, end;
+
+	// Neither command takes arguments that need quoting.
+	while (start < command.length()) {
+		end = command.find(' ', start);
+		if (end == std::string::npos) {
+			end = command.length();
+		}
+		if (end > start) {
+			tokens.push_back(command.substr(start, end - start));
+		}
+		start = end + 1;
+	}
+
+	if (tokens.empty()) {
+		return false;
+	}
+	for (size_t i = 1; i + 1 < tokens.size(); i += 2) {
+		args[tokens[i]] = tokens[i + 1];
+	}
+
+	const std::string &name = tokens[0];
+	const std::string &ideKey = args["-k"];
+
+	if (name == "proxyinit") {
+		struct sockaddr_in peer, local;
+		socklen_t peerLength = sizeof(peer), localLength = sizeof(local);
+		unsigned long port = std::strtoul(args["-p"].c_str(), NULL, 10);
+		char address[INET_ADDRSTRLEN] = "", portString[8];
+
+		if (ideKey.empty() || port == 0 || port > 65535) {
+			response = ProxyResponse(name, 1, "proxyinit requires an IDE key and a port.");
+			return true;
+		}
+		if (getpeername(fd, reinterpret_cast<struct sockaddr *>(&peer), &peerLength) == -1 || getsockname(fd, reinterpret_cast<struct sockaddr *>(&local), &localLength) == -1) {
+			response = ProxyResponse(name, 2, "Unable to determine the IDE address.");
+			return true;
+		}
+
+		/* An IDE can register again to change its port, but can't
+		 * take over another machine's IDE key. */
+		RegistrationMap::iterator i = registrations.find(ideKey);
+		if (i != registrations.end() && i->second.address != peer.sin_addr.s_addr) {
+			response = ProxyResponse(name, 3, "The IDE key is already registered from another address.");
+			return true;
+		}
+
+		Registration &registration = registrations[ideKey];
+		if (i == registrations.end()) {
+			registration.serial = ++lastSerial;
+			registration.sessions = 0;
+		}
+		registration.address = peer.sin_addr.s_addr;
+		registration.multiple = (args["-m"] == "1");
+		registration.port = static_cast<wxUint16>(port);
+		registrationCount = registrations.size();
+
+		// Tell the IDE where engines should connect.
+		inet_ntop(AF_INET, &local.sin_addr, address, sizeof(address));
+		std::sprintf(portString, "%hu", enginePort);
+		response = "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<proxyinit success=\"1\" idekey=\"" + Escape(ideKey) + "\" address=\"" + address + "\" port=\"" + portString + "\"/>";
+		return true;
+	}
+	else if (name == "proxystop") {
+		struct sockaddr_in peer;
+		socklen_t peerLength = sizeof(peer);
+
+		RegistrationMap::iterator i = registrations.find(ideKey);
+		if (i == registrations.end()) {
+			response = ProxyResponse(name, 4, "The IDE key isn't registered.");
+			return true;
+		}
+
+		// Only the IDE that registered the key can stop it.
+		if (getpeername(fd, reinterpret_cast<struct sockaddr *>(&peer), &peerLength) == -1) {
+			response = ProxyResponse(name, 2, "Unable to determine the IDE address.");
+			return true;
+		}
+		if (i->second.address != peer.sin_addr.s_addr) {
+			response = ProxyResponse(name, 5, "The IDE key is registered from another address.");
+			return true;
+		}
+
+		registrations.erase(i);
+		registrationCount = registrations.size();
+
+		// Sessions already routed are left to finish.
+		response = "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<proxystop success=\"1\" idekey=\"" + Escape(ideKey) + "\"/>";
+		return true;
+	}
+
+	return false;
+}
+// }}}
+// {{{ wxUint16 Proxy::Listen(Endpoint &listener, wxUint16 port, bool loopback) throw (SocketError)
+wxUint16 Proxy::Listen(Endpoint &listener, wxUint16 port, bool loopback) throw (SocketError) {
+	struct sockaddr_in addr;
+	socklen_t addrLength = sizeof(addr);
+	int reuse = 1;
+
+	if ((listener.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+		throw SystemError(wxT("socket"));
+	}
+	setsockopt(listener.fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+	addr.sin_port = htons(port);
+
+	if (bind(listener.fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+		throw SystemError(wxT("bind"));
+	}
+	if (listen(listener.fd, BACKLOG) == -1) {
+		throw SystemError(wxT("listen"));
+	}
+	if (getsockname(listener.fd, reinterpret_cast<struct sockaddr *>(&addr), &addrLength) == -1) {
+		throw SystemError(wxT("getsockname"));
+	}
+	if (!Watch(&listener, EPOLLIN)) {
+		throw SystemError(wxT("epoll_ctl"));
+	}
+
+	return ntohs(addr.sin_port);
+}
+// }}}
+// {{{ void Proxy::Loop() throw ()
+void Proxy::Loop() throw () {
+	struct epoll_event events[MAX_EVENTS];
+
+	while (!stopping) {
+		int count = epoll_wait(epollFD, events, MAX_EVENTS, -1);
+
+		if (count == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+
+		for (int i = 0; i < count; i++) {
+			Endpoint *endpoint = static_cast<Endpoint *>(events[i].data.ptr);
+
+			if (endpoint == &wake) {
+				eventfd_t value;
+				eventfd_read(wake.fd, &value);
+			}
+			else if (endpoint->channel == NULL) {
+				Accept(endpoint);
+			}
+			else if (!endpoint->channel->closed) {
+				endpoint->channel->OnEvent(endpoint, events[i].events);
+			}
+		}
+
+		// As with Reactor, channels are only deleted between batches.
+		for (std::vector<Channel *>::iterator i = closed.begin(); i != closed.end(); i++) {
+			RemoveChannel(*i);
+		}
+		closed.clear();
+	}
+}
+// }}}
+// {{{ void Proxy::MarkClosed(Channel *channel) throw ()
+void Proxy::MarkClosed(Channel *channel) throw () {
+	closed.push_back(channel);
+}
+// }}}
+// {{{ void Proxy::RemoveChannel(Channel *channel) throw ()
+void Proxy::RemoveChannel(Channel *channel) throw () {
+	size_t slot = channel->slot;
+
+	wxASSERT(slot < channels.size() && channels[slot] == channel);
+
+	channels[slot] = channels.back();
+	channels[slot]->slot = slot;
+	channels.pop_back();
+
+	// Closing the sockets takes them out of the epoll set.
+	delete channel;
+
+	if (listenPaused && epollFD != -1) {
+		if (Watch(&engineListener, EPOLLIN) && Watch(&ideListener, EPOLLIN)) {
+			listenPaused = false;
+		}
+	}
+}
+// }}}
+// {{{ bool Proxy::Watch(Endpoint *endpoint, unsigned int events) throw ()
+bool Proxy::Watch(Endpoint *endpoint, unsigned int events) throw () {
+	struct epoll_event event;
+
+	if (endpoint->registered && endpoint->events == events) {
+		return true;
+	}
+
+	event.events = events;
+	event.data.ptr = endpoint;
+	if (epoll_ctl(epollFD, endpoint->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, endpoint->fd, &event) == -1) {
+		return false;
+	}
+
+	endpoint->events = events;
+	endpoint->registered = true;
+	return true;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
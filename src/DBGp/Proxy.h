@@ -0,0 +1,341 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_PROXY_H
+#define DBGP_PROXY_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+
+#include "DBGp/Error/Error.h"
+
+namespace DBGp {
+	/**
+	 * A headless DBGp proxy, as described in section 5.3 of the spec.
+	 * IDEs register an IDE key, along with the port they're listening on,
+	 * by connecting to the IDE port and sending proxyinit (and later
+	 * proxystop). Engines connect to the engine port as they would to an
+	 * IDE; the proxy reads the init packet, looks the IDE key up and
+	 * connects to the registered IDE on the engine's behalf.
+	 *
+	 * The init packet is the only thing the proxy parses. It's forwarded
+	 * with a proxied attribute giving the engine's address, and from then
+	 * on the two sockets are joined with splice(), so the rest of the
+	 * session never leaves the kernel.
+	 *
+	 * Everything runs on a single epoll instance on the proxy's own
+	 * thread. This is only available on Linux.
+	 */
+	class Proxy {
+		public:
+			/** Constructs a proxy. Nothing is bound until Start() is called. */
+			Proxy();
+
+			/** Stops the proxy and closes every session. */
+			~Proxy();
+
+			/**
+			 * Returns the port engines connect to.
+			 *
+			 * @return The port, or 0 if the proxy isn't running.
+			 */
+			inline wxUint16 GetEnginePort() const { return enginePort; }
+
+			/**
+			 * Returns the port IDEs register on.
+			 *
+			 * @return The port, or 0 if the proxy isn't running.
+			 */
+			inline wxUint16 GetIDEPort() const { return idePort; }
+
+			/**
+			 * Returns the number of registered IDE keys. This may
+			 * be called from any thread.
+			 *
+			 * @return The number of registrations.
+			 */
+			inline size_t GetRegistrationCount() const { return registrationCount; }
+
+			/**
+			 * Returns the number of engine connections, whether
+			 * or not they've been routed yet. This may be called
+			 * from any thread.
+			 *
+			 * @return The number of sessions.
+			 */
+			inline size_t GetSessionCount() const { return sessionCount; }
+
+			/**
+			 * Checks if the proxy thread is running.
+			 *
+			 * @return True if the proxy has been started.
+			 */
+			inline bool IsRunning() const { return thread != NULL; }
+
+			/**
+			 * Binds both listening sockets and starts the proxy
+			 * thread.
+			 *
+			 * @param[in] enginePort The port to accept engine
+			 * connections on, or 0 to pick a free one.
+			 * @param[in] idePort The port to accept proxyinit and
+			 * proxystop commands on, or 0 to pick a free one.
+			 * @param[in] loopback True to only accept connections
+			 * from the local machine.
+			 * @throws SocketError Thrown if either socket can't be
+			 * bound, or the thread can't be started.
+			 */
+			void Start(wxUint16 enginePort, wxUint16 idePort, bool loopback = false) throw (SocketError);
+
+			/**
+			 * Stops the proxy thread, closes every connection and
+			 * forgets every registration. Does nothing if the
+			 * proxy isn't running.
+			 */
+			void Stop() throw ();
+
+		protected:
+			/** Anything owning sockets in the epoll set. */
+			class Channel;
+
+			/** An IDE's proxyinit or proxystop connection. */
+			class Control;
+
+			/** An engine connection and, once routed, its IDE. */
+			class Session;
+
+			/** The thread that runs the event loop. */
+			class Thread;
+
+			/**
+			 * A socket in the epoll set. The epoll data points at
+			 * one of these, so sessions can tell which of their
+			 * two sockets an event is for.
+			 */
+			struct Endpoint {
+				Endpoint() : channel(NULL), events(0), fd(-1), registered(false) {}
+
+				/** The owning channel, or NULL for the proxy's own sockets. */
+				Channel *channel;
+
+				/** The events currently being waited for. */
+				unsigned int events;
+
+				/** The socket. */
+				int fd;
+
+				/** Whether the socket has been added to the epoll set. */
+				bool registered;
+			};
+
+			/** An IDE registered with proxyinit. */
+			struct Registration {
+				/** The IDE's IPv4 address, in network byte order. */
+				wxUint32 address;
+
+				/** Whether the IDE accepts more than one session at a time. */
+				bool multiple;
+
+				/** The port the IDE is listening on. */
+				wxUint16 port;
+
+				/**
+				 * Identifies this registration, so a session
+				 * routed through it isn't counted against a
+				 * later registration of the same IDE key.
+				 */
+				unsigned long serial;
+
+				/** The number of sessions currently routed to the IDE. */
+				size_t sessions;
+			};
+
+			/** Registrations, keyed by IDE key. */
+			typedef std::map<std::string, Registration> RegistrationMap;
+
+			/** The most events handled per call to epoll_wait(). */
+			static const int MAX_EVENTS = 256;
+
+			/** The listen() backlog. */
+			static const int BACKLOG = 1024;
+
+			/** The most bytes moved by a single splice(). */
+			static const size_t SPLICE_SIZE = 65536;
+
+			/**
+			 * Every open channel. As with Reactor, each channel
+			 * holds its index, and a removed channel's slot is
+			 * filled with the last one.
+			 */
+			std::vector<Channel *> channels;
+
+			/**
+			 * Channels that have closed during the current batch
+			 * of events, which are deleted once the batch is
+			 * complete.
+			 */
+			std::vector<Channel *> closed;
+
+			/** The listening socket for engines. */
+			Endpoint engineListener;
+
+			/** The port engines connect to. */
+			wxUint16 enginePort;
+
+			/** The epoll instance. */
+			int epollFD;
+
+			/** The listening socket for IDEs. */
+			Endpoint ideListener;
+
+			/** The port IDEs register on. */
+			wxUint16 idePort;
+
+			/** The serial given to the most recent registration. */
+			unsigned long lastSerial;
+
+			/**
+			 * Whether the listening sockets have stopped being
+			 * watched because we've run out of file descriptors.
+			 */
+			bool listenPaused;
+
+			/** The number of registrations. */
+			volatile size_t registrationCount;
+
+			/** The registered IDEs. */
+			RegistrationMap registrations;
+
+			/** The number of engine connections. */
+			volatile size_t sessionCount;
+
+			/** Set to ask the event loop to return. */
+			volatile bool stopping;
+
+			/** The proxy thread, if running. */
+			Thread *thread;
+
+			/** An eventfd used to wake the event loop up. */
+			Endpoint wake;
+
+			/**
+			 * Accepts every pending connection on a listening
+			 * socket.
+			 *
+			 * @param[in] listener The listening socket.
+			 */
+			void Accept(Endpoint *listener) throw ();
+
+			/**
+			 * Registers a new channel.
+			 *
+			 * @param[in] channel The channel.
+			 */
+			void AddChannel(Channel *channel) throw ();
+
+			/**
+			 * Closes every file descriptor the proxy owns.
+			 */
+			void CloseDescriptors() throw ();
+
+			/**
+			 * Runs a proxyinit or proxystop command.
+			 *
+			 * @param[in] command The command, without its NULL
+			 * terminator.
+			 * @param[in] fd The socket the command arrived on.
+			 * @param[out] response Set to the XML response.
+			 * @return False if the command isn't recognised, in
+			 * which case there's no response.
+			 */
+			bool HandleCommand(const std::string &command, int fd, std::string &response) throw ();
+
+			/**
+			 * Binds a listening socket and adds it to the epoll
+			 * set.
+			 *
+			 * @param[out] listener The endpoint to set up.
+			 * @param[in] port The port to bind to.
+			 * @param[in] loopback True to only bind to the
+			 * loopback interface.
+			 * @return The bound port.
+			 * @throws SocketError Thrown if the socket can't be
+			 * bound.
+			 */
+			wxUint16 Listen(Endpoint &listener, wxUint16 port, bool loopback) throw (SocketError);
+
+			/**
+			 * Runs the event loop until Stop() is called.
+			 */
+			void Loop() throw ();
+
+			/**
+			 * Queues a closed channel for deletion at the end of
+			 * the current batch of events.
+			 *
+			 * @param[in] channel The channel.
+			 */
+			void MarkClosed(Channel *channel) throw ();
+
+			/**
+			 * Removes a channel from the table and deletes it.
+			 *
+			 * @param[in] channel The channel.
+			 */
+			void RemoveChannel(Channel *channel) throw ();
+
+			/**
+			 * Sets the events an endpoint is waiting for, adding
+			 * it to the epoll set if needed.
+			 *
+			 * @param[in] endpoint The endpoint.
+			 * @param[in] events The epoll event flags.
+			 * @return False if epoll_ctl() failed.
+			 */
+			bool Watch(Endpoint *endpoint, unsigned int events) throw ();
+
+			friend class Control;
+			friend class Session;
+
+		private:
+			/** Proxies own sockets, so can't be copied. */
+			Proxy(const Proxy &);
+			Proxy &operator=(const Proxy &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
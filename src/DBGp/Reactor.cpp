@@ -0,0 +1,366 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Reactor.h"
+#include "DBGp/ReactorSession.h"
+#include "DBGp/Utility.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <wx/log.h>
+
+using namespace DBGp;
+
+// {{{ class Reactor::Thread
+namespace DBGp {
+	class Reactor::Thread : public wxThread {
+		public:
+			Thread(Reactor *reactor) : wxThread(wxTHREAD_JOINABLE), reactor(reactor) {}
+
+		protected:
+			virtual ExitCode Entry() {
+				reactor->Loop();
+				return 0;
+			}
+
+		private:
+			Reactor *reactor;
+	};
+}
+// }}}
+
+// {{{ static SocketError SystemError(const wxString &operation)
+static SocketError SystemError(const wxString &operation) {
+	return SocketError(operation + wxT(": ") + wxSysErrorMsg(errno));
+}
+// }}}
+
+// {{{ Reactor::Reactor(Handler *handler)
+Reactor::Reactor(Handler *handler) : dumpInterval(60), epollFD(-1), handler(handler), listenFD(-1), listenPaused(false), nextDump(0), port(0), readBuffer(READ_BUFFER_SIZE), sessionCount(0), stopping(false), thread(NULL), wakeFD(-1) {
+	wxASSERT(handler != NULL);
+}
+// }}}
+// {{{ Reactor::~Reactor()
+Reactor::~Reactor() {
+	Stop();
+}
+// }}}
+
+// {{{ void Reactor::SetStatisticsDump(const wxString &file, unsigned int interval)
+void Reactor::SetStatisticsDump(const wxString &file, unsigned int interval) {
+	dumpFile = file;
+	dumpInterval = (interval > 0 ? interval : 1);
+}
+// }}}
+// {{{ void Reactor::Start(wxUint16 port, bool loopback) throw (SocketError)
+void Reactor::Start(wxUint16 port, bool loopback) throw (SocketError) {
+	struct sockaddr_in addr;
+	socklen_t addrLength = sizeof(addr);
+	struct epoll_event event;
+	int reuse = 1;
+
+	if (thread) {
+		return;
+	}
+
+	try {
+		if ((listenFD = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) {
+			throw SystemError(wxT("socket"));
+		}
+		setsockopt(listenFD, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+		addr.sin_port = htons(port);
+
+		if (bind(listenFD, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+			throw SystemError(wxT("bind"));
+		}
+		if (listen(listenFD, BACKLOG) == -1) {
+			throw SystemError(wxT("listen"));
+		}
+		if (getsockname(listenFD, reinterpret_cast<struct sockaddr *>(&addr), &addrLength) == -1) {
+			throw SystemError(wxT("getsockname"));
+		}
+		this->port = ntohs(addr.sin_port);
+
+		if ((epollFD = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+			throw SystemError(wxT("epoll_create1"));
+		}
+		if ((wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+			throw SystemError(wxT("eventfd"));
+		}
+
+		/* The listening socket is tagged with a NULL pointer and the
+		 * wakeup descriptor with the reactor itself; everything else
+		 * is a session. */
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		if (epoll_ctl(epollFD, EPOLL_CTL_ADD, listenFD, &event) == -1) {
+			throw SystemError(wxT("epoll_ctl"));
+		}
+		event.data.ptr = this;
+		if (epoll_ctl(epollFD, EPOLL_CTL_ADD, wakeFD, &event) == -1) {
+			throw SystemError(wxT("epoll_ctl"));
+		}
+
+		nextDump = GetMicroseconds() + static_cast<wxUint64>(dumpInterval) * 1000000;
+		stopping = false;
+		thread = new Thread(this);
+		if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+			delete thread;
+			thread = NULL;
+			throw SocketError(wxT("Unable to start the reactor thread."));
+		}
+	}
+	catch (SocketError e) {
+		CloseDescriptors();
+		throw;
+	}
+}
+// }}}
+// {{{ void Reactor::Stop() throw ()
+void Reactor::Stop() throw () {
+	if (thread == NULL) {
+		return;
+	}
+
+	stopping = true;
+	if (eventfd_write(wakeFD, 1) == -1) {
+		wxLogDebug(wxT("Error waking the reactor: %s"), wxSysErrorMsg(errno));
+	}
+
+	thread->Wait();
+	delete thread;
+	thread = NULL;
+
+	// The thread is gone, so the sessions are ours now.
+	while (!sessions.empty()) {
+		RemoveSession(sessions.back());
+	}
+	closed.clear();
+
+	CloseDescriptors();
+	DumpStatistics();
+}
+// }}}
+
+// {{{ void Reactor::AcceptAll() throw ()
+void Reactor::AcceptAll() throw () {
+	for (;;) {
+		int fd = accept4(listenFD, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+		if (fd == -1) {
+			if (errno == EMFILE || errno == ENFILE) {
+				/* The listening socket would otherwise stay
+				 * readable and spin the loop; it's resumed
+				 * when a session is removed. */
+				epoll_ctl(epollFD, EPOLL_CTL_DEL, listenFD, NULL);
+				listenPaused = true;
+			}
+			else if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			return;
+		}
+
+		ReactorSession *session = new ReactorSession(this, fd);
+		struct epoll_event event;
+
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.ptr = session;
+		if (epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &event) == -1) {
+			delete session;
+			continue;
+		}
+
+		session->slot = sessions.size();
+		sessions.push_back(session);
+		sessionCount = sessions.size();
+
+		handler->OnSessionAccepted(session);
+	}
+}
+// }}}
+// {{{ void Reactor::CloseDescriptors() throw ()
+void Reactor::CloseDescriptors() throw () {
+	if (wakeFD != -1) {
+		close(wakeFD);
+		wakeFD = -1;
+	}
+	if (epollFD != -1) {
+		close(epollFD);
+		epollFD = -1;
+	}
+	if (listenFD != -1) {
+		close(listenFD);
+		listenFD = -1;
+	}
+	listenPaused = false;
+	port = 0;
+}
+// }}}
+// {{{ void Reactor::DumpStatistics() throw ()
+void Reactor::DumpStatistics() throw () {
+	if (!dumpFile.IsEmpty() && !statistics.Dump(dumpFile)) {
+		wxLogDebug(wxT("Unable to write statistics to %s."), dumpFile.c_str());
+	}
+}
+// }}}
+// {{{ void Reactor::HandleEvent(ReactorSession *session, unsigned int events) throw ()
+void Reactor::HandleEvent(ReactorSession *session, unsigned int events) throw () {
+	if (session->state == ReactorSession::CLOSED) {
+		return;
+	}
+
+	/* Read before acting on a hang up, since the engine may well have
+	 * sent something just before closing. */
+	if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+		session->OnReadable(&readBuffer[0], readBuffer.size());
+	}
+
+	if (session->state != ReactorSession::CLOSED && (events & EPOLLOUT)) {
+		session->OnWritable();
+	}
+}
+// }}}
+// {{{ void Reactor::Loop() throw ()
+void Reactor::Loop() throw () {
+	struct epoll_event events[MAX_EVENTS];
+
+	while (!stopping) {
+		int timeout = -1;
+
+		if (!dumpFile.IsEmpty()) {
+			wxUint64 now = GetMicroseconds();
+
+			if (now >= nextDump) {
+				DumpStatistics();
+				nextDump = now + static_cast<wxUint64>(dumpInterval) * 1000000;
+			}
+			timeout = static_cast<int>((nextDump - now + 999) / 1000);
+		}
+
+		int count = epoll_wait(epollFD, events, MAX_EVENTS, timeout);
+
+		if (count == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return;
+		}
+
+		for (int i = 0; i < count; i++) {
+			void *ptr = events[i].data.ptr;
+
+			if (ptr == NULL) {
+				AcceptAll();
+			}
+			else if (ptr == this) {
+				eventfd_t value;
+				eventfd_read(wakeFD, &value);
+			}
+			else {
+				HandleEvent(static_cast<ReactorSession *>(ptr), events[i].events);
+			}
+		}
+
+		/* Sessions are only removed between batches, since a
+		 * handler acting on one session can close another that still
+		 * has an event waiting further down the batch. */
+		for (std::vector<ReactorSession *>::iterator i = closed.begin(); i != closed.end(); i++) {
+			RemoveSession(*i);
+		}
+		closed.clear();
+	}
+}
+// }}}
+// {{{ void Reactor::MarkClosed(ReactorSession *session) throw ()
+void Reactor::MarkClosed(ReactorSession *session) throw () {
+	closed.push_back(session);
+}
+// }}}
+// {{{ void Reactor::RemoveSession(ReactorSession *session) throw ()
+void Reactor::RemoveSession(ReactorSession *session) throw () {
+	size_t slot = session->slot;
+
+	wxASSERT(slot < sessions.size() && sessions[slot] == session);
+
+	// Fill the hole with the last session, so removal is O(1).
+	sessions[slot] = sessions.back();
+	sessions[slot]->slot = slot;
+	sessions.pop_back();
+	sessionCount = sessions.size();
+
+	epoll_ctl(epollFD, EPOLL_CTL_DEL, session->fd, NULL);
+	statistics.Forget(session);
+	session->state = ReactorSession::CLOSED;
+	handler->OnSessionClosed(session);
+	delete session;
+
+	if (listenPaused && epollFD != -1) {
+		struct epoll_event event;
+
+		event.events = EPOLLIN;
+		event.data.ptr = NULL;
+		if (epoll_ctl(epollFD, EPOLL_CTL_ADD, listenFD, &event) == 0) {
+			listenPaused = false;
+		}
+	}
+}
+// }}}
+// {{{ void Reactor::UpdateInterest(ReactorSession *session) throw ()
+void Reactor::UpdateInterest(ReactorSession *session) throw () {
+	bool writing = (session->GetPendingOutput() > 0);
+
+	if (writing != session->writing) {
+		struct epoll_event event;
+
+		event.events = EPOLLIN | EPOLLRDHUP | (writing ? EPOLLOUT : 0);
+		event.data.ptr = session;
+		if (epoll_ctl(epollFD, EPOLL_CTL_MOD, session->fd, &event) == 0) {
+			session->writing = writing;
+		}
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,338 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_REACTOR_H
+#define DBGP_REACTOR_H
+
+#include <vector>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+#include <wx/xml/xml.h>
+
+#include "DBGp/ConnectionFilter.h"
+#include "DBGp/Error/Error.h"
+#include "DBGp/Statistics.h"
+
+namespace DBGp {
+	class ReactorSession;
+
+	/**
+	 * A headless listener for large numbers of concurrent DBGp sessions.
+	 * Unlike Server, which accepts connections through wxWidgets on the
+	 * GUI event loop and gives each one a Connection, the reactor
+	 * multiplexes every session over a single epoll instance on its own
+	 * thread, and hands parsed messages to a Handler.
+	 *
+	 * Sessions are kept in a dense table, and each one knows its own slot,
+	 * so registering and removing a session are both constant time.
+	 *
+	 * This is only available on Linux.
+	 */
+	class Reactor {
+		public:
+			/**
+			 * The interface for receiving session events. Every
+			 * callback is made on the reactor thread, and sessions
+			 * may only be used from that thread.
+			 */
+			class Handler {
+				public:
+					virtual ~Handler() {}
+
+					/**
+					 * Called when a new session has been
+					 * accepted, before anything has been
+					 * read from it.
+					 *
+					 * @param[in] session The session.
+					 */
+					virtual void OnSessionAccepted(ReactorSession *session) throw () {}
+
+					/**
+					 * Called when a session has been closed
+					 * by either end. The session is deleted
+					 * once this returns.
+					 *
+					 * @param[in] session The session.
+					 */
+					virtual void OnSessionClosed(ReactorSession *session) throw () {}
+
+					/**
+					 * Called when a session's init packet has
+					 * been accepted by the filter.
+					 *
+					 * @param[in] session The session.
+					 * @param[in] init The init packet.
+					 */
+					virtual void OnSessionInit(ReactorSession *session, wxXmlDocument &init) throw () = 0;
+
+					/**
+					 * Called for each message received after
+					 * the init packet.
+					 *
+					 * @param[in] session The session.
+					 * @param[in] message The message.
+					 */
+					virtual void OnSessionMessage(ReactorSession *session, wxXmlDocument &message) throw () {}
+			};
+
+			/**
+			 * Constructs a reactor. Nothing is bound until Start()
+			 * is called.
+			 *
+			 * @param[in] handler The handler for session events,
+			 * which must outlive the reactor.
+			 */
+			Reactor(Handler *handler);
+
+			/** Stops the reactor and closes every session. */
+			~Reactor();
+
+			/**
+			 * Returns the filter applied to init packets. This
+			 * should only be changed while the reactor is
+			 * stopped.
+			 *
+			 * @return The connection filter.
+			 */
+			inline ConnectionFilter &GetFilter() { return filter; }
+
+			/**
+			 * Returns the port being listened on, which is useful
+			 * if the reactor was started on port 0.
+			 *
+			 * @return The port, or 0 if the reactor isn't running.
+			 */
+			inline wxUint16 GetPort() const { return port; }
+
+			/**
+			 * Returns the number of open sessions. This may be
+			 * called from any thread.
+			 *
+			 * @return The number of sessions.
+			 */
+			inline size_t GetSessionCount() const { return sessionCount; }
+
+			/**
+			 * Returns the traffic and latency figures for every
+			 * session, combined.
+			 *
+			 * @return The statistics.
+			 */
+			inline Statistics &GetStatistics() { return statistics; }
+
+			/**
+			 * Checks if the reactor thread is running.
+			 *
+			 * @return True if the reactor has been started.
+			 */
+			inline bool IsRunning() const { return thread != NULL; }
+
+			/**
+			 * Has the reactor thread write its statistics to a
+			 * file periodically while it runs, and once more when
+			 * it stops. This should only be changed while the
+			 * reactor is stopped.
+			 *
+			 * @param[in] file The file to write, or an empty
+			 * string to stop dumping.
+			 * @param[in] interval The time between dumps, in
+			 * seconds.
+			 */
+			void SetStatisticsDump(const wxString &file, unsigned int interval = 60);
+
+			/**
+			 * Binds the listening socket and starts the reactor
+			 * thread.
+			 *
+			 * @param[in] port The TCP port to listen on, or 0 to
+			 * pick a free one.
+			 * @param[in] loopback True to only accept connections
+			 * from the local machine.
+			 * @throws SocketError Thrown if the socket can't be
+			 * bound, or the thread can't be started.
+			 */
+			void Start(wxUint16 port, bool loopback = false) throw (SocketError);
+
+			/**
+			 * Stops the reactor thread and closes every session,
+			 * calling the handler's OnSessionClosed() for each on
+			 * the calling thread. Does nothing if the reactor
+			 * isn't running.
+			 */
+			void Stop() throw ();
+
+		protected:
+			/** The thread that runs the event loop. */
+			class Thread;
+
+			/** The most events handled per call to epoll_wait(). */
+			static const int MAX_EVENTS = 256;
+
+			/** The size of the buffer shared by every read. */
+			static const size_t READ_BUFFER_SIZE = 65536;
+
+			/** The listen() backlog. */
+			static const int BACKLOG = 1024;
+
+			/**
+			 * Sessions that have closed during the current batch
+			 * of events, which are removed once the batch is
+			 * complete.
+			 */
+			std::vector<ReactorSession *> closed;
+
+			/** The file statistics are dumped to, if any. */
+			wxString dumpFile;
+
+			/** The time between statistics dumps, in seconds. */
+			unsigned int dumpInterval;
+
+			/** The epoll instance. */
+			int epollFD;
+
+			/** The filter applied to init packets. */
+			ConnectionFilter filter;
+
+			/** The handler for session events. */
+			Handler *handler;
+
+			/** The listening socket. */
+			int listenFD;
+
+			/**
+			 * Whether the listening socket has been taken out of
+			 * the epoll set because we've run out of file
+			 * descriptors.
+			 */
+			bool listenPaused;
+
+			/** When the statistics are next due to be dumped. */
+			wxUint64 nextDump;
+
+			/** The port being listened on. */
+			wxUint16 port;
+
+			/**
+			 * The buffer every read goes through, so sessions
+			 * only ever hold on to partial frames.
+			 */
+			std::vector<char> readBuffer;
+
+			/** The number of open sessions. */
+			volatile size_t sessionCount;
+
+			/**
+			 * Every open session. Each session holds its index in
+			 * here, and a removed session's slot is filled with
+			 * the last session.
+			 */
+			std::vector<ReactorSession *> sessions;
+
+			/** The figures for every session. */
+			Statistics statistics;
+
+			/** Set to ask the event loop to return. */
+			volatile bool stopping;
+
+			/** The reactor thread, if running. */
+			Thread *thread;
+
+			/** An eventfd used to wake the event loop up. */
+			int wakeFD;
+
+			/**
+			 * Accepts every pending connection and registers a
+			 * session for each.
+			 */
+			void AcceptAll() throw ();
+
+			/**
+			 * Closes every file descriptor the reactor owns.
+			 */
+			void CloseDescriptors() throw ();
+
+			/**
+			 * Writes the statistics to the dump file, logging
+			 * any failure.
+			 */
+			void DumpStatistics() throw ();
+
+			/**
+			 * Handles a single event on a session.
+			 *
+			 * @param[in] session The session.
+			 * @param[in] events The epoll event flags.
+			 */
+			void HandleEvent(ReactorSession *session, unsigned int events) throw ();
+
+			/**
+			 * Runs the event loop until Stop() is called.
+			 */
+			void Loop() throw ();
+
+			/**
+			 * Queues a closed session for removal at the end of
+			 * the current batch of events.
+			 *
+			 * @param[in] session The session.
+			 */
+			void MarkClosed(ReactorSession *session) throw ();
+
+			/**
+			 * Removes a session from the table and the epoll set,
+			 * tells the handler and deletes the session.
+			 *
+			 * @param[in] session The session to remove.
+			 */
+			void RemoveSession(ReactorSession *session) throw ();
+
+			/**
+			 * Updates the events a session is waiting for, after
+			 * it has queued or finished writing output.
+			 *
+			 * @param[in] session The session.
+			 */
+			void UpdateInterest(ReactorSession *session) throw ();
+
+			friend class ReactorSession;
+
+		private:
+			/** Reactors own sockets, so can't be copied. */
+			Reactor(const Reactor &);
+			Reactor &operator=(const Reactor &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,265 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/ReactorSession.h"
+#include "DBGp/Base64.h"
+#include "DBGp/DocumentBuilder.h"
+#include "DBGp/ProtocolLog.h"
+#include "DBGp/Reactor.h"
+#include "DBGp/ResponseParser.h"
+#include "DBGp/Utility.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace DBGp;
+
+// {{{ ReactorSession::ReactorSession(Reactor *reactor, int fd)
+ReactorSession::ReactorSession(Reactor *reactor, int fd) : clientData(NULL), fd(fd), frameStart(0), lastRead(0), outputOffset(0), reactor(reactor), reader(CHUNK_SIZE), slot(0), state(AWAITING_INIT), txID(0), writing(false) {
+	// As with Connection, this is what engines send init packets in.
+	conv = &wxConvISO8859_1;
+}
+// }}}
+// {{{ ReactorSession::~ReactorSession()
+ReactorSession::~ReactorSession() {
+	close(fd);
+}
+// }}}
+
+// {{{ void ReactorSession::Close() throw ()
+void ReactorSession::Close() throw () {
+	if (state == CLOSED || state == DRAINING) {
+		return;
+	}
+	else if (GetPendingOutput() == 0) {
+		Shutdown();
+		return;
+	}
+
+	state = DRAINING;
+}
+// }}}
+// {{{ TransactionID ReactorSession::SendCommand(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError)
+TransactionID ReactorSession::SendCommand(const wxString &command, MessageArguments args, const char *data, size_t dataLength) throw (SocketError) {
+	TransactionID id = txID++;
+	wxString message(command);
+
+	if (state == DRAINING || state == CLOSED) {
+		throw SocketError(wxT("The session is closing."));
+	}
+
+	message << wxT(" ") << args.Append(wxT("-i"), IntToString(id)).GetArguments();
+	if (data && dataLength > 0) {
+		message << wxT(" -- ") << Base64::Encode(data, dataLength);
+	}
+
+	wxCharBuffer buffer(message.mb_str(*conv));
+	size_t length = std::strlen(buffer.data()) + 1;
+
+	reactor->statistics.RecordSent(this, command, id, length);
+	ProtocolLog::Record(this, ProtocolLog::SENT, buffer.data(), length - 1);
+	output.append(buffer.data(), length);
+
+	/* Try to write straight away: most commands fit in the socket
+	 * buffer, and then the epoll set never needs touching. */
+	OnWritable();
+	return id;
+}
+// }}}
+
+// {{{ void ReactorSession::HandleFrame(const char *payload, size_t length) throw (MalformedDocumentError)
+void ReactorSession::HandleFrame(const char *payload, size_t length, Statistics::Timing timing) throw (MalformedDocumentError) {
+	wxXmlDocument doc;
+	DocumentBuilder builder(doc);
+	ResponseParser parser(conv);
+	wxUint64 start = GetMicroseconds();
+
+	ProtocolLog::Record(this, ProtocolLog::RECEIVED, payload, length);
+	parser.Parse(payload, length, builder);
+	if (!doc.IsOk()) {
+		throw MalformedDocumentError(wxT("Incoming XML document has no root element."));
+	}
+
+	timing.parse = GetMicroseconds() - start;
+	timing.decode = parser.GetDecodeTime();
+
+	wxXmlNode *root = doc.GetRoot();
+	unsigned long id;
+	if (root->GetName() == wxT("response") && root->GetPropVal(wxT("transaction_id"), wxEmptyString).ToULong(&id)) {
+		reactor->statistics.RecordResponse(this, root->GetPropVal(wxT("command"), wxEmptyString), id, length, timing);
+	}
+	else {
+		reactor->statistics.RecordReceived(root->GetName(), length, timing);
+	}
+
+	switch (state) {
+		case AWAITING_INIT:
+			if (root->GetName() != wxT("init")) {
+				throw MalformedDocumentError(wxT("Expected an init packet."));
+			}
+
+			appID = root->GetPropVal(wxT("appid"), wxEmptyString);
+			ideKey = root->GetPropVal(wxT("idekey"), wxEmptyString);
+
+			switch (reactor->filter.Check(appID, root->GetPropVal(wxT("fileuri"), wxEmptyString), ideKey)) {
+				case ConnectionFilter::ACCEPT:
+					state = ACTIVE;
+					reactor->handler->OnSessionInit(this, doc);
+					break;
+
+				case ConnectionFilter::DETACH:
+					// Let the script carry on without us.
+					SendCommand(wxT("detach"), MessageArguments());
+					Close();
+					break;
+
+				default:
+					Shutdown();
+			}
+			break;
+
+		case ACTIVE:
+			reactor->handler->OnSessionMessage(this, doc);
+			break;
+
+		default:
+			// Anything arriving after we've decided to close is ignored.
+			break;
+	}
+}
+// }}}
+// {{{ void ReactorSession::OnReadable(char *buffer, size_t length) throw ()
+void ReactorSession::OnReadable(char *buffer, size_t length) throw () {
+	const char *payload;
+	size_t payloadLength;
+	Statistics::Timing timing;
+	bool eof = false;
+	bool idle = (reader.GetBufferedLength() == 0);
+
+	for (;;) {
+		ssize_t received = recv(fd, buffer, length, 0);
+
+		if (received > 0) {
+			reader.Append(buffer, static_cast<size_t>(received));
+
+			/* A short read means the socket has been drained.
+			 * Anything else, including an orderly close, will
+			 * raise another event. */
+			if (static_cast<size_t>(received) == length) {
+				continue;
+			}
+		}
+		else if (received == 0) {
+			eof = true;
+		}
+		else if (errno == EINTR) {
+			continue;
+		}
+		else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			Shutdown();
+			return;
+		}
+		break;
+	}
+
+	lastRead = GetMicroseconds();
+	if (idle) {
+		frameStart = lastRead;
+	}
+
+	try {
+		while ((state == AWAITING_INIT || state == ACTIVE) && reader.NextFrame(payload, payloadLength)) {
+			timing.firstByte = frameStart;
+			timing.lastByte = lastRead;
+
+			// Anything left over arrived with this read.
+			frameStart = lastRead;
+			HandleFrame(payload, payloadLength, timing);
+		}
+	}
+	catch (Error e) {
+		// A bad frame leaves the stream unrecoverable.
+		Shutdown();
+		return;
+	}
+
+	// Nothing more will be written to an engine that has gone away.
+	if (eof) {
+		Shutdown();
+	}
+}
+// }}}
+// {{{ void ReactorSession::OnWritable() throw ()
+void ReactorSession::OnWritable() throw () {
+	while (outputOffset < output.length()) {
+		ssize_t written = send(fd, output.data() + outputOffset, output.length() - outputOffset, MSG_NOSIGNAL);
+
+		if (written >= 0) {
+			outputOffset += static_cast<size_t>(written);
+		}
+		else if (errno == EINTR) {
+			continue;
+		}
+		else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		}
+		else {
+			Shutdown();
+			return;
+		}
+	}
+
+	if (outputOffset == output.length()) {
+		output.clear();
+		outputOffset = 0;
+
+		if (state == DRAINING) {
+			Shutdown();
+			return;
+		}
+	}
+
+	reactor->UpdateInterest(this);
+}
+// }}}
+// {{{ void ReactorSession::Shutdown() throw ()
+void ReactorSession::Shutdown() throw () {
+	if (state != CLOSED) {
+		state = CLOSED;
+		reactor->MarkClosed(this);
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,245 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_REACTORSESSION_H
+#define DBGP_REACTORSESSION_H
+
+#include <string>
+
+#include <wx/strconv.h>
+#include <wx/string.h>
+
+#include "DBGp/Connection.h"
+#include "DBGp/Error/Error.h"
+#include "DBGp/FrameReader.h"
+#include "DBGp/MessageArguments.h"
+#include "DBGp/Statistics.h"
+
+namespace DBGp {
+	class Reactor;
+
+	/**
+	 * A single DBGp session multiplexed by a Reactor. Each session is a
+	 * small state machine driven by the reactor thread:
+	 *
+	 * - AWAITING_INIT: accepted, waiting for the init packet.
+	 * - ACTIVE: the init packet passed the filter; messages are handed to
+	 *   the reactor's handler.
+	 * - DRAINING: closing once any queued output has been written, such
+	 *   as the detach command sent to a filtered session.
+	 * - CLOSED: finished with, and about to be removed.
+	 *
+	 * Sessions must only be used on the reactor thread.
+	 */
+	class ReactorSession {
+		public:
+			/** The session states. */
+			typedef enum {
+				AWAITING_INIT,
+				ACTIVE,
+				DRAINING,
+				CLOSED
+			} State;
+
+			/**
+			 * Closes the session once any queued output has been
+			 * written.
+			 */
+			void Close() throw ();
+
+			/**
+			 * Returns the application ID from the init packet.
+			 *
+			 * @return The application ID.
+			 */
+			inline const wxString &GetAppID() const { return appID; }
+
+			/**
+			 * Returns the data attached with SetClientData().
+			 *
+			 * @return The client data.
+			 */
+			inline void *GetClientData() const { return clientData; }
+
+			/**
+			 * Returns the IDE key from the init packet.
+			 *
+			 * @return The IDE key.
+			 */
+			inline const wxString &GetIDEKey() const { return ideKey; }
+
+			/**
+			 * Returns the number of bytes queued to be written.
+			 *
+			 * @return The queued output length.
+			 */
+			inline size_t GetPendingOutput() const { return output.length() - outputOffset; }
+
+			/**
+			 * Returns the current state.
+			 *
+			 * @return The state.
+			 */
+			inline State GetState() const { return state; }
+
+			/**
+			 * Queues a command to be sent to the debugging engine.
+			 * Responses arrive through the handler's
+			 * OnSessionMessage().
+			 *
+			 * @param[in] command The command to send.
+			 * @param[in] args The arguments to the command.
+			 * @param[in] data The data to be encoded and sent up
+			 * with the command, if any.
+			 * @param[in] dataLength The length of the data to be
+			 * sent. Ignored if data is NULL.
+			 * @return The transaction ID of the command.
+			 * @throws SocketError Thrown if the session is closing.
+			 */
+			TransactionID SendCommand(const wxString &command, MessageArguments args, const char *data = NULL, size_t dataLength = 0) throw (SocketError);
+
+			/**
+			 * Attaches arbitrary data to the session. It isn't
+			 * owned by the session.
+			 *
+			 * @param[in] data The data.
+			 */
+			inline void SetClientData(void *data) { clientData = data; }
+
+		protected:
+			/** The minimum read size for the frame reader. */
+			static const size_t CHUNK_SIZE = 4096;
+
+			/** Only the reactor creates and destroys sessions. */
+			friend class Reactor;
+
+			/** The application ID from the init packet. */
+			wxString appID;
+
+			/** Data attached by the handler. */
+			void *clientData;
+
+			/** The conversion object for the encoding in use. */
+			wxMBConv *conv;
+
+			/** The socket. */
+			int fd;
+
+			/**
+			 * When the first byte of the next frame in the reader
+			 * was read.
+			 */
+			wxUint64 frameStart;
+
+			/** The IDE key from the init packet. */
+			wxString ideKey;
+
+			/** When data was last read into the reader. */
+			wxUint64 lastRead;
+
+			/** Output waiting to be written. */
+			std::string output;
+
+			/** How much of the output has been written. */
+			size_t outputOffset;
+
+			/** The reactor that owns the session. */
+			Reactor *reactor;
+
+			/** The frame reader for incoming data. */
+			FrameReader reader;
+
+			/** The session's index in the reactor's table. */
+			size_t slot;
+
+			/** The current state. */
+			State state;
+
+			/** The next transaction ID. */
+			TransactionID txID;
+
+			/** Whether EPOLLOUT is currently requested. */
+			bool writing;
+
+			/**
+			 * Constructs a session for an accepted socket.
+			 *
+			 * @param[in] reactor The owning reactor.
+			 * @param[in] fd The non-blocking socket.
+			 */
+			ReactorSession(Reactor *reactor, int fd);
+
+			/** Closes the socket. */
+			~ReactorSession();
+
+			/**
+			 * Handles a complete frame according to the current
+			 * state.
+			 *
+			 * @param[in] payload The frame payload.
+			 * @param[in] length The payload length.
+			 * @param[in] timing When the frame arrived.
+			 * @throws MalformedDocumentError Thrown if the payload
+			 * isn't a well formed document.
+			 */
+			void HandleFrame(const char *payload, size_t length, Statistics::Timing timing) throw (MalformedDocumentError);
+
+			/**
+			 * Reads everything available on the socket and handles
+			 * every complete frame.
+			 *
+			 * @param[in] buffer The reactor's read buffer.
+			 * @param[in] length The size of the buffer.
+			 */
+			void OnReadable(char *buffer, size_t length) throw ();
+
+			/**
+			 * Writes as much queued output as the socket will
+			 * take.
+			 */
+			void OnWritable() throw ();
+
+			/**
+			 * Moves the session to the CLOSED state and has the
+			 * reactor remove it.
+			 */
+			void Shutdown() throw ();
+
+		private:
+			/** Sessions own their socket, so can't be copied. */
+			ReactorSession(const ReactorSession &);
+			ReactorSession &operator=(const ReactorSession &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,130 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_RESPONSEHANDLER_H
+#define DBGP_RESPONSEHANDLER_H
+
+#include <wx/log.h>
+#include <wx/xml/xml.h>
+
+#include "DBGp/Error/Error.h"
+
+namespace DBGp {
+	class Connection;
+
+	/**
+	 * Interface for objects that want to be called back when the
+	 * response to an asynchronous command arrives. Handlers given to
+	 * Connection::SendCommandAsync() are owned by the connection, and
+	 * are deleted once they have been called.
+	 */
+	class ResponseHandler {
+		public:
+			virtual ~ResponseHandler() {}
+
+			/**
+			 * Called when a successful response arrives.
+			 *
+			 * @param[in] conn The connection the command was sent
+			 * on.
+			 * @param[in] doc The response document.
+			 */
+			virtual void OnResponse(Connection *conn, wxXmlDocument &doc) = 0;
+
+			/**
+			 * Called when the debugging engine returns an error
+			 * for the command. By default, the error is logged.
+			 *
+			 * @param[in] conn The connection the command was sent
+			 * on.
+			 * @param[in] error The error returned.
+			 */
+			virtual void OnError(Connection *conn, const EngineError &error) {
+				wxLogError(wxT("Error in asynchronous command: %s"), error.GetMessage().c_str());
+			}
+	};
+
+	/**
+	 * Adapts member functions on an arbitrary object into a
+	 * ResponseHandler, which saves declaring a handler class for every
+	 * asynchronous command.
+	 *
+	 * <code>
+	 * conn->SendCommandAsync(wxT("status"), MessageArguments(), new ResponseCallback<Foo>(this, &Foo::OnStatus));
+	 * </code>
+	 */
+	template <class T> class ResponseCallback : public ResponseHandler {
+		public:
+			/** Member function called with a successful response. */
+			typedef void (T::*ResponseFunction)(Connection *conn, wxXmlDocument &doc);
+
+			/** Member function called with an engine error. */
+			typedef void (T::*ErrorFunction)(Connection *conn, const EngineError &error);
+
+			/**
+			 * Constructs a new callback.
+			 *
+			 * @param[in] object The object to call.
+			 * @param[in] onResponse The function to call with a
+			 * successful response.
+			 * @param[in] onError The function to call with an
+			 * engine error. If NULL, the error will be logged.
+			 */
+			ResponseCallback(T *object, ResponseFunction onResponse, ErrorFunction onError = NULL) : object(object), onError(onError), onResponse(onResponse) {}
+
+			void OnResponse(Connection *conn, wxXmlDocument &doc) {
+				(object->*onResponse)(conn, doc);
+			}
+
+			void OnError(Connection *conn, const EngineError &error) {
+				if (onError) {
+					(object->*onError)(conn, error);
+				}
+				else {
+					ResponseHandler::OnError(conn, error);
+				}
+			}
+
+		protected:
+			/** The object to call. */
+			T *object;
+
+			/** The error function. */
+			ErrorFunction onError;
+
+			/** The response function. */
+			ResponseFunction onResponse;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,226 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/ResponseParser.h"
+#include "DBGp/Base64.h"
+#include "DBGp/Tracer.h"
+#include "DBGp/Utility.h"
+
+#include <cstring>
+
+#include <expat.h>
+
+#include <wx/log.h>
+
+using namespace DBGp;
+
+// {{{ ResponseParser::ResponseParser(wxMBConv *conv)
+ResponseParser::ResponseParser(wxMBConv *conv) : conv(conv), decodeTime(0), handler(NULL), parser(NULL) {
+	wxASSERT(conv != NULL);
+}
+// }}}
+
+// {{{ void ResponseParser::Parse(const char *payload, size_t length, Handler &handler) throw (MalformedDocumentError)
+void ResponseParser::Parse(const char *payload, size_t length, Handler &handler) throw (MalformedDocumentError) {
+	DBGP_TRACE("dbgp", "XMLParse");
+
+	/* We deliberately don't give expat an encoding: it'll use whatever
+	 * the XML declaration says, and hand everything to us as UTF-8. */
+	XML_Parser p = XML_ParserCreate(NULL);
+	if (!p) {
+		throw MalformedDocumentError(wxT("Unable to create XML parser."));
+	}
+
+	XML_SetUserData(p, this);
+	XML_SetElementHandler(p, OnStartElement, OnEndElement);
+	XML_SetCharacterDataHandler(p, OnCharacterData);
+	XML_SetCdataSectionHandler(p, OnCdataStart, OnCdataEnd);
+
+	decodeTime = 0;
+	elements.clear();
+	this->handler = &handler;
+	handlerError = wxEmptyString;
+	parser = p;
+	text.clear();
+
+	bool ok = (XML_Parse(p, payload, static_cast<int>(length), 1) != XML_STATUS_ERROR);
+	wxString message;
+
+	if (!handlerError.IsEmpty()) {
+		message = handlerError;
+	}
+	else if (!ok) {
+		message = wxString(XML_ErrorString(XML_GetErrorCode(p)), wxConvUTF8);
+		message << wxT(" at line ") << static_cast<unsigned long>(XML_GetCurrentLineNumber(p));
+	}
+
+	XML_ParserFree(p);
+	elements.clear();
+	this->handler = NULL;
+	parser = NULL;
+	text.clear();
+
+	if (!message.IsEmpty()) {
+		throw MalformedDocumentError(wxT("Incoming XML document is malformed: ") + message);
+	}
+}
+// }}}
+
+// {{{ wxString ResponseParser::GetAttribute(const Attributes &attributes, const wxString &name, const wxString &def)
+wxString ResponseParser::GetAttribute(const Attributes &attributes, const wxString &name, const wxString &def) {
+	Attributes::const_iterator i = attributes.find(name);
+	if (i == attributes.end()) {
+		return def;
+	}
+	return i->second;
+}
+// }}}
+
+// {{{ void ResponseParser::FlushText(bool keepWhitespace)
+void ResponseParser::FlushText(bool keepWhitespace) {
+	if (!text.empty() && !elements.empty()) {
+		if (keepWhitespace || text.find_first_not_of(" \t\r\n") != std::string::npos) {
+			elements.back().content.append(text);
+		}
+	}
+	text.clear();
+}
+// }}}
+// {{{ wxString ResponseParser::GetContent(const Element &element) throw (Error)
+wxString ResponseParser::GetContent(const Element &element) throw (Error) {
+	if (element.content.empty()) {
+		return wxEmptyString;
+	}
+
+	if (!element.encoded) {
+		return wxString(element.content.data(), wxConvUTF8, element.content.length());
+	}
+
+	/* Base64 only ever contains ASCII, so the UTF-8 we get from expat is
+	 * exactly what the engine sent. */
+	DBGP_TRACE("dbgp", "Base64Decode");
+	wxUint64 start = GetMicroseconds();
+	try {
+		size_t maxLength = Base64::MaxDataLength(element.content.length());
+		std::vector<char> data(maxLength + 1);
+		size_t length = Base64::Decode(element.content.data(), element.content.length(), &data[0], maxLength);
+		data[length] = '\0';
+
+		decodeTime += GetMicroseconds() - start;
+		return wxString(&data[0], *conv, length);
+	}
+	catch (Base64::DecoderError e) {
+		decodeTime += GetMicroseconds() - start;
+		wxLogError(wxT("Error in Base64 decoding: %s"), e.GetMessage().c_str());
+		return wxString(element.content.data(), wxConvUTF8, element.content.length());
+	}
+}
+// }}}
+
+// {{{ void ResponseParser::OnCdataEnd(void *data)
+void ResponseParser::OnCdataEnd(void *data) {
+	ResponseParser *self = static_cast<ResponseParser *>(data);
+
+	// CDATA sections are always kept, even if they're only whitespace.
+	self->FlushText(true);
+}
+// }}}
+// {{{ void ResponseParser::OnCdataStart(void *data)
+void ResponseParser::OnCdataStart(void *data) {
+	ResponseParser *self = static_cast<ResponseParser *>(data);
+
+	self->FlushText(false);
+}
+// }}}
+// {{{ void ResponseParser::OnCharacterData(void *data, const char *s, int len)
+void ResponseParser::OnCharacterData(void *data, const char *s, int len) {
+	static_cast<ResponseParser *>(data)->text.append(s, len);
+}
+// }}}
+// {{{ void ResponseParser::OnEndElement(void *data, const char *name)
+void ResponseParser::OnEndElement(void *data, const char *name) {
+	ResponseParser *self = static_cast<ResponseParser *>(data);
+
+	/* Expat can still report the end of an empty element after the
+	 * parser has been stopped. */
+	if (!self->handlerError.IsEmpty()) {
+		return;
+	}
+
+	self->FlushText(false);
+
+	try {
+		wxString content(self->GetContent(self->elements.back()));
+		self->elements.pop_back();
+		self->handler->OnEndElement(wxString(name, wxConvUTF8), content);
+	}
+	catch (Error e) {
+		self->handlerError = e.GetMessage();
+		XML_StopParser(static_cast<XML_Parser>(self->parser), XML_FALSE);
+	}
+	catch (...) {
+		self->handlerError = wxT("Unexpected error handling element.");
+		XML_StopParser(static_cast<XML_Parser>(self->parser), XML_FALSE);
+	}
+}
+// }}}
+// {{{ void ResponseParser::OnStartElement(void *data, const char *name, const char **atts)
+void ResponseParser::OnStartElement(void *data, const char *name, const char **atts) {
+	ResponseParser *self = static_cast<ResponseParser *>(data);
+	Attributes attributes;
+	bool encoded = false;
+
+	self->FlushText(false);
+
+	for (const char **att = atts; *att != NULL; att += 2) {
+		if (std::strcmp(att[0], "encoding") == 0 && std::strcmp(att[1], "base64") == 0) {
+			encoded = true;
+		}
+		attributes[wxString(att[0], wxConvUTF8)] = wxString(att[1], wxConvUTF8);
+	}
+
+	self->elements.push_back(Element(encoded));
+
+	try {
+		self->handler->OnStartElement(wxString(name, wxConvUTF8), attributes);
+	}
+	catch (Error e) {
+		self->handlerError = e.GetMessage();
+		XML_StopParser(static_cast<XML_Parser>(self->parser), XML_FALSE);
+	}
+	catch (...) {
+		self->handlerError = wxT("Unexpected error handling element.");
+		XML_StopParser(static_cast<XML_Parser>(self->parser), XML_FALSE);
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
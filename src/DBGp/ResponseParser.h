@@ -0,0 +1,206 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_RESPONSEPARSER_H
+#define DBGP_RESPONSEPARSER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <wx/strconv.h>
+#include <wx/string.h>
+
+#include "DBGp/Error/Error.h"
+
+namespace DBGp {
+	/**
+	 * A streaming parser for the XML messages sent by DBGp debugging
+	 * engines. Rather than building a document, the parser reports each
+	 * element to a Handler as it is encountered, so the objects that
+	 * actually need the data can be built in a single pass.
+	 *
+	 * Element content is collected and handed over when the element
+	 * closes. Content within elements carrying an encoding="base64"
+	 * attribute is decoded straight from the raw buffer and converted
+	 * using the engine's character set, so it never needs to be
+	 * re-encoded.
+	 */
+	class ResponseParser {
+		public:
+			/** The attributes of an element, keyed by name. */
+			typedef std::map<wxString, wxString> Attributes;
+
+			/**
+			 * Interface for objects receiving elements from the
+			 * parser.
+			 */
+			class Handler {
+				public:
+					virtual ~Handler() {}
+
+					/**
+					 * Called when an element is opened.
+					 *
+					 * @param[in] name The element name.
+					 * @param[in] attributes The element's
+					 * attributes.
+					 * @throws Error Thrown if the handler
+					 * can't make sense of the element, which
+					 * aborts the parse.
+					 */
+					virtual void OnStartElement(const wxString &name, const Attributes &attributes) throw (Error) = 0;
+
+					/**
+					 * Called when an element is closed.
+					 *
+					 * @param[in] name The element name.
+					 * @param[in] content The (decoded) text
+					 * content of the element, excluding any
+					 * whitespace between child elements.
+					 * @throws Error Thrown if the handler
+					 * can't make sense of the element, which
+					 * aborts the parse.
+					 */
+					virtual void OnEndElement(const wxString &name, const wxString &content) throw (Error) = 0;
+			};
+
+			/**
+			 * Constructs a new parser.
+			 *
+			 * @param[in] conv The conversion object for the
+			 * character set used within encoded content.
+			 */
+			ResponseParser(wxMBConv *conv);
+
+			/**
+			 * Returns the time spent decoding Base64 content
+			 * during the last call to Parse().
+			 *
+			 * @return The time, in microseconds.
+			 */
+			inline wxUint64 GetDecodeTime() const { return decodeTime; }
+
+			/**
+			 * Parses a complete message.
+			 *
+			 * @param[in] payload The message.
+			 * @param[in] length The length of the message.
+			 * @param[in] handler The handler to report elements to.
+			 * @throws MalformedDocumentError Thrown if the message
+			 * isn't well formed, or the handler rejected it.
+			 */
+			void Parse(const char *payload, size_t length, Handler &handler) throw (MalformedDocumentError);
+
+			/**
+			 * Convenience function to retrieve an attribute.
+			 *
+			 * @param[in] attributes The attributes to look in.
+			 * @param[in] name The attribute name.
+			 * @param[in] def The value to return if the attribute
+			 * doesn't exist.
+			 * @return The attribute value.
+			 */
+			static wxString GetAttribute(const Attributes &attributes, const wxString &name, const wxString &def = wxEmptyString);
+
+		private:
+			/** The state kept for each open element. */
+			class Element {
+				public:
+					inline Element(bool encoded) : encoded(encoded) {}
+
+					/** The content collected so far. */
+					std::string content;
+
+					/** Whether the content is Base64 encoded. */
+					bool encoded;
+			};
+
+			/** The conversion object for encoded content. */
+			wxMBConv *conv;
+
+			/** The time spent decoding in the current parse. */
+			wxUint64 decodeTime;
+
+			/** The open elements, innermost last. */
+			std::vector<Element> elements;
+
+			/** The handler for the current parse. */
+			Handler *handler;
+
+			/** The error message if the handler threw. */
+			wxString handlerError;
+
+			/**
+			 * The expat parser for the current parse. This is
+			 * kept opaque so that expat's header doesn't need to
+			 * be in the include path of everything using us.
+			 */
+			void *parser;
+
+			/**
+			 * Text that has been received since the last element
+			 * or CDATA boundary, which is only kept if it turns
+			 * out to be more than whitespace.
+			 */
+			std::string text;
+
+			/**
+			 * Moves any pending text into the content of the
+			 * current element.
+			 *
+			 * @param[in] keepWhitespace Whether to keep the text
+			 * even if it's entirely whitespace.
+			 */
+			void FlushText(bool keepWhitespace);
+
+			/**
+			 * Converts the content of an element to a string,
+			 * decoding it if needed.
+			 *
+			 * @param[in] element The element.
+			 * @return The content.
+			 * @throws Error Thrown if the content can't be
+			 * decoded.
+			 */
+			wxString GetContent(const Element &element) throw (Error);
+
+			static void OnCdataEnd(void *data);
+			static void OnCdataStart(void *data);
+			static void OnCharacterData(void *data, const char *s, int len);
+			static void OnEndElement(void *data, const char *name);
+			static void OnStartElement(void *data, const char *name, const char **atts);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
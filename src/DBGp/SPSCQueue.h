@@ -0,0 +1,167 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_SPSCQUEUE_H
+#define DBGP_SPSCQUEUE_H
+
+#include <cstddef>
+#include <vector>
+
+#if defined(_MSC_VER)
+/* This header is included widely, so go through wxWidgets' wrapper, which
+ * stops <windows.h> defining min, max and the like. */
+#include <wx/msw/wrapwin.h>
+
+/* A full hardware fence, as __sync_synchronize() is: a compiler barrier
+ * alone doesn't stop the CPU reordering a store and a later load. */
+#define DBGP_MEMORY_BARRIER() MemoryBarrier()
+#elif defined(__GNUC__)
+#define DBGP_MEMORY_BARRIER() __sync_synchronize()
+#else
+#error "No memory barrier is available for this compiler."
+#endif
+
+namespace DBGp {
+	/**
+	 * A bounded, lock-free queue for handing items from exactly one
+	 * producer thread to exactly one consumer thread. Each index is only
+	 * ever written by one side, so the only synchronisation needed is a
+	 * memory barrier between writing a slot and publishing it.
+	 *
+	 * Neither side ever blocks: callers that need to wait for space or
+	 * items have to arrange that themselves.
+	 */
+	template <typename T> class SPSCQueue {
+		public:
+			/**
+			 * Constructs an empty queue.
+			 *
+			 * @param[in] capacity The maximum number of items
+			 * that can be queued at once.
+			 */
+			SPSCQueue(size_t capacity) : head(0), slots(capacity + 1), tail(0) {}
+
+			/**
+			 * Returns the maximum number of items that can be
+			 * queued at once.
+			 *
+			 * @return The capacity of the queue.
+			 */
+			inline size_t GetCapacity() const { return slots.size() - 1; }
+
+			/**
+			 * Checks if the queue is empty. This is only reliable
+			 * when called from the consumer.
+			 *
+			 * @return True if there is nothing to pop.
+			 */
+			inline bool IsEmpty() const { return head == tail; }
+
+			/**
+			 * Removes the item at the front of the queue. This
+			 * must only be called from the consumer thread.
+			 *
+			 * @param[out] item Set to the item removed.
+			 * @return True if an item was removed, false if the
+			 * queue was empty.
+			 */
+			bool Pop(T &item) {
+				size_t current = head;
+
+				if (current == tail) {
+					return false;
+				}
+				DBGP_MEMORY_BARRIER();
+
+				item = slots[current];
+				slots[current] = T();
+
+				DBGP_MEMORY_BARRIER();
+				head = Next(current);
+				return true;
+			}
+
+			/**
+			 * Adds an item to the back of the queue. This must
+			 * only be called from the producer thread.
+			 *
+			 * @param[in] item The item to add.
+			 * @return True if the item was added, false if the
+			 * queue was full.
+			 */
+			bool Push(const T &item) {
+				size_t current = tail;
+				size_t next = Next(current);
+
+				if (next == head) {
+					return false;
+				}
+				DBGP_MEMORY_BARRIER();
+
+				slots[current] = item;
+
+				DBGP_MEMORY_BARRIER();
+				tail = next;
+				return true;
+			}
+
+		private:
+			/** The next slot to pop, owned by the consumer. */
+			volatile size_t head;
+
+			/**
+			 * The storage for queued items, with one slot always
+			 * kept empty to tell a full queue from an empty one.
+			 */
+			std::vector<T> slots;
+
+			/** The next slot to push, owned by the producer. */
+			volatile size_t tail;
+
+			/**
+			 * Returns the slot after the one given.
+			 *
+			 * @param[in] slot The current slot.
+			 * @return The next slot.
+			 */
+			inline size_t Next(size_t slot) const { return (slot + 1 == slots.size()) ? 0 : slot + 1; }
+
+			/** Copying a queue makes no sense. */
+			SPSCQueue(const SPSCQueue &);
+
+			/** Nor does assigning one. */
+			SPSCQueue &operator=(const SPSCQueue &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -31,53 +31,104 @@
 
 #include "DBGp/Server.h"
 
-#include <algorithm>
+#ifdef __UNIX__
+#include <cerrno>
+#include <cstring>
 
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <wx/filename.h>
 #include <wx/log.h>
+#include <wx/utils.h>
 
 using namespace DBGp;
 
+/* Used internally to remove connections dropped by the filter. */
+static const wxEventType wxEVT_DBGP_DROP_CONNECTION = wxNewEventType();
+
 BEGIN_EVENT_TABLE(Server, wxEvtHandler)
 	EVT_SOCKET(1, Server::OnServerEvent)
 END_EVENT_TABLE()
 
-// {{{ Server::Server(wxUint16 port, wxEvtHandler *parent)
-Server::Server(wxUint16 port, wxEvtHandler *parent) : wxEvtHandler(), parent(parent), port(port) {
-	wxIPV4address addr;
+#ifdef __UNIX__
+// {{{ static int ConnectError(const char *path)
+/* Tries to connect to a Unix domain socket, returning 0 if something is
+ * listening on it, or the errno value connect() failed with. */
+static int ConnectError(const char *path) {
+	struct sockaddr_un addr;
+	int error = 0;
+	int fd;
+
+	if (std::strlen(path) >= sizeof(addr.sun_path)) {
+		return ENAMETOOLONG;
+	}
+	if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+		return errno;
+	}
 
-	addr.AnyAddress();
-	addr.Service(port);
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, path);
 
-	server = new wxSocketServer(addr, wxSOCKET_REUSEADDR);
-	if (!server) {
-		wxLogFatalError(wxT("Unable to create server object."));
+	if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+		error = errno;
 	}
-	else if (!server->IsOk()) {
-		wxLogError(wxT("Error instantiating server object."));
+	close(fd);
+
+	return error;
+}
+// }}}
+#endif
+
+// {{{ Server::Server(wxUint16 port, wxEvtHandler *parent)
+Server::Server(wxUint16 port, wxEvtHandler *parent) : wxEvtHandler(), parent(parent), recorded(0), server(NULL), threaded(false), transport(port) {
+	Connect(wxID_ANY, wxEVT_DBGP_DROP_CONNECTION, wxCommandEventHandler(Server::OnDropConnection));
+	if (parent) {
+		SetNextHandler(parent);
 	}
-	server->SetEventHandler(*this, 1);
-	server->SetNotify(wxSOCKET_CONNECTION_FLAG);
-	server->Notify(true);
 
+	Listen();
+}
+// }}}
+// {{{ Server::Server(const Transport &transport, wxEvtHandler *parent)
+Server::Server(const Transport &transport, wxEvtHandler *parent) : wxEvtHandler(), parent(parent), recorded(0), server(NULL), threaded(false), transport(transport) {
+	Connect(wxID_ANY, wxEVT_DBGP_DROP_CONNECTION, wxCommandEventHandler(Server::OnDropConnection));
 	if (parent) {
 		SetNextHandler(parent);
 	}
+
+	Listen();
 }
 // }}}
 // {{{ Server::~Server()
 Server::~Server() {
-	server->Notify(false);
+	if (server) {
+		server->Notify(false);
+	}
 
-	for (ConnectionList::iterator i = connections.begin(); i != connections.end(); i++)
+	for (ConnectionSet::iterator i = connections.begin(); i != connections.end(); i++)
 		delete *i;
 
-	server->Destroy();
+	if (server) {
+		server->Destroy();
+
+#ifdef __UNIX__
+		// Unix domain sockets outlive their listener otherwise.
+		if (transport.GetFamily() == Transport::UNIX) {
+			unlink(transport.GetPath().mb_str(wxConvFile));
+		}
+#endif
+	}
 }
 // }}}
 
 // {{{ void Server::RemoveConnection(Connection *conn)
 void Server::RemoveConnection(Connection *conn) {
-	std::remove(connections.begin(), connections.end(), conn);
+	connections.erase(conn);
 	delete conn;
 }
 // }}}
@@ -87,6 +138,71 @@ Connection *Server::CreateConnectionObject(wxSocketBase *socket, Server *server)
 	return new Connection(socket, server);
 }
 // }}}
+// {{{ void Server::DropConnection(Connection *conn)
+void Server::DropConnection(Connection *conn) {
+	wxCommandEvent e(wxEVT_DBGP_DROP_CONNECTION);
+	e.SetClientData(conn);
+	AddPendingEvent(e);
+}
+// }}}
+// {{{ void Server::Listen()
+void Server::Listen() {
+	wxSockAddress *addr;
+
+	try {
+		addr = transport.CreateAddress();
+	}
+	catch (SocketError e) {
+		wxLogError(wxT("Unable to listen on %s: %s"), transport.GetURI().c_str(), e.GetMessage().c_str());
+		return;
+	}
+
+#ifdef __UNIX__
+	/* A socket left behind by a previous run would make the bind fail.
+	 * Only remove it once a connection is refused, though: another
+	 * instance may still be listening on it, and anything that isn't a
+	 * socket is left alone. */
+	struct stat info;
+	wxCharBuffer path(transport.GetPath().mb_str(wxConvFile));
+	if (transport.GetFamily() == Transport::UNIX && lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+		int error = ConnectError(path);
+
+		if (error == ECONNREFUSED) {
+			unlink(path);
+		}
+		else if (error == 0) {
+			wxLogError(wxT("Unable to listen on %s: another process is already listening there."), transport.GetURI().c_str());
+			delete addr;
+			return;
+		}
+	}
+#endif
+
+	server = new wxSocketServer(*addr, wxSOCKET_REUSEADDR);
+	delete addr;
+
+	if (!server) {
+		wxLogFatalError(wxT("Unable to create server object."));
+	}
+	else if (!server->IsOk()) {
+		wxLogError(wxT("Error instantiating server object."));
+	}
+
+	server->SetEventHandler(*this, 1);
+	server->SetNotify(wxSOCKET_CONNECTION_FLAG);
+	server->Notify(true);
+}
+// }}}
+// {{{ void Server::OnDropConnection(wxCommandEvent &event)
+void Server::OnDropConnection(wxCommandEvent &event) {
+	Connection *conn = static_cast<Connection *>(event.GetClientData());
+
+	// Connections created outside the server aren't ours to delete.
+	if (connections.find(conn) != connections.end()) {
+		RemoveConnection(conn);
+	}
+}
+// }}}
 // {{{ void Server::OnServerEvent(wxSocketEvent &event)
 void Server::OnServerEvent(wxSocketEvent &event) {
 	wxSocketClient *socket;
@@ -103,11 +219,29 @@ void Server::OnServerEvent(wxSocketEvent &event) {
 	}
 
 	if (server->AcceptWith(*socket, false)) {
-		wxIPV4address addr;
-		socket->GetPeer(addr);
-		wxLogDebug(wxT("Got connection from %s:%hu."), addr.Hostname().c_str(), addr.Service());
+		if (transport.GetFamily() == Transport::TCP) {
+			wxIPV4address addr;
+			socket->GetPeer(addr);
+			wxLogDebug(wxT("Got connection from %s:%hu."), addr.Hostname().c_str(), addr.Service());
+		}
+		else {
+			wxLogDebug(wxT("Got connection on %s."), transport.GetURI().c_str());
+		}
+		transport.Configure(socket);
+
 		Connection *conn = CreateConnectionObject(socket, this);
-		connections.push_back(conn);
+		connections.insert(conn);
+
+		// This has to start before the thread can read the init packet.
+		if (!recordDirectory.empty()) {
+			wxString name(wxString::Format(wxT("dubnium-%lu-%lu.dbgprec"), wxGetProcessId(), ++recorded));
+			conn->StartRecording(wxFileName(recordDirectory, name).GetFullPath());
+		}
+
+		// Falls back to reading on the main thread if this fails.
+		if (threaded) {
+			conn->StartIOThread();
+		}
 	}
 	else {
 		wxLogWarning(wxT("Got server socket event but no connection is in the accept queue."));
@@ -32,15 +32,20 @@
 #ifndef DBGP_SERVER_H
 #define DBGP_SERVER_H
 
-#include <list>
-
 #include <wx/event.h>
+#include <wx/hashset.h>
 #include <wx/socket.h>
 #include <wx/thread.h>
 
 #include "DBGp/Connection.h"
+#include "DBGp/ConnectionFilter.h"
+#include "DBGp/EngineProfileCache.h"
+#include "DBGp/Transport.h"
 
 namespace DBGp {
+	/** A set of connections, with constant time insertion and removal. */
+	WX_DECLARE_HASH_SET(Connection *, wxPointerHash, wxPointerEqual, ConnectionSet);
+
 	/**
 	 * The server that accepts new DBGp connections and spawns Connection
 	 * objects to handle them.
@@ -54,17 +59,66 @@ namespace DBGp {
 
 		public:
 			/**
-			 * Constructs a new listening server.
+			 * Constructs a new server listening on a TCP port on
+			 * every interface.
 			 *
 			 * @param[in] port The TCP port to listen on.
 			 * @param[in] parent The parent event handler, if any.
-			 * @todo Allow binding to a particular interface.
 			 */
 			Server(wxUint16 port, wxEvtHandler *parent = NULL);
 
+			/**
+			 * Constructs a new listening server.
+			 *
+			 * @param[in] transport Where to listen, and how to set
+			 * up accepted sockets.
+			 * @param[in] parent The parent event handler, if any.
+			 */
+			Server(const Transport &transport, wxEvtHandler *parent = NULL);
+
 			/** Shuts down the server. */
 			virtual ~Server();
 
+			/**
+			 * Returns the filter applied to new connections. Any
+			 * changes take effect from the next init packet.
+			 *
+			 * @return The connection filter.
+			 */
+			inline ConnectionFilter &GetFilter() { return filter; }
+
+			/**
+			 * Returns the profiles of the engines that have
+			 * connected to the server so far.
+			 *
+			 * @return The profile cache.
+			 */
+			inline EngineProfileCache &GetProfileCache() { return profiles; }
+
+			/**
+			 * Returns the directory new connections are recorded
+			 * to.
+			 *
+			 * @return The directory, or an empty string if
+			 * connections aren't recorded.
+			 */
+			inline const wxString &GetRecordDirectory() const { return recordDirectory; }
+
+			/**
+			 * Returns the transport the server is listening on.
+			 *
+			 * @return The transport.
+			 */
+			inline const Transport &GetTransport() const { return transport; }
+
+			/**
+			 * Checks if new connections read from the debugging
+			 * engine on their own I/O thread.
+			 *
+			 * @return True if new connections are threaded.
+			 */
+			inline bool IsThreaded() const { return threaded; }
+
 			/**
 			 * Removes a connection from the active list. This also
 			 * destroys the connection; the connection should not
@@ -74,6 +128,26 @@ namespace DBGp {
 			 */
 			void RemoveConnection(Connection *conn);
 
+			/**
+			 * Sets the directory new connections are recorded to,
+			 * each in its own file, from before the init packet
+			 * is read. Existing connections are unaffected.
+			 *
+			 * @param[in] directory The directory, or an empty
+			 * string to stop recording new connections.
+			 */
+			inline void SetRecordDirectory(const wxString &directory) { recordDirectory = directory; }
+
+			/**
+			 * Sets whether new connections read from the debugging
+			 * engine on their own I/O thread. Existing connections
+			 * are unaffected.
+			 *
+			 * @param[in] threaded True to start an I/O thread for
+			 * each new connection.
+			 */
+			inline void SetThreaded(bool threaded) { this->threaded = threaded; }
+
 		protected:
 			/**
 			 * Creates a new connection object. This can be
@@ -90,21 +164,57 @@ namespace DBGp {
 			virtual Connection *CreateConnectionObject(wxSocketBase *socket, Server *server);
 
 		private:
-			/** Typedef for the internal connection map. */
-			typedef std::list<Connection *> ConnectionList;
+			/** The active connections. */
+			ConnectionSet connections;
 
-			/** The internal list of active connections. */
-			ConnectionList connections;
+			/** The filter applied to new connections. */
+			ConnectionFilter filter;
 
 			/** The parent event handler. */
 			wxEvtHandler *parent;
 
-			/** The TCP port to listen on. */
-			wxUint16 port;
+			/** Engine profiles, shared between connections. */
+			EngineProfileCache profiles;
+
+			/** The number of connections recorded so far. */
+			unsigned long recorded;
+
+			/** Where new connections are recorded, if anywhere. */
+			wxString recordDirectory;
 
 			/** The socket server listening for DBGp connections. */
 			wxSocketServer *server;
 
+			/** Whether new connections get their own I/O thread. */
+			bool threaded;
+
+			/** Where to listen, and how to set up accepted sockets. */
+			Transport transport;
+
+			/**
+			 * Arranges for a connection that was dropped by the
+			 * filter to be removed once control returns to the
+			 * event loop, since the connection is still on the
+			 * stack when it decides to drop itself.
+			 *
+			 * @param[in] conn The connection to remove.
+			 */
+			void DropConnection(Connection *conn);
+
+			/**
+			 * Creates the listening socket. Errors are logged, and
+			 * leave the server without a socket.
+			 */
+			void Listen();
+
+			/**
+			 * Removes a dropped connection.
+			 *
+			 * @param[in] event The event posted by
+			 * DropConnection().
+			 */
+			void OnDropConnection(wxCommandEvent &event);
+
 			/**
 			 * Called when connections are made to the listening
 			 * socket.
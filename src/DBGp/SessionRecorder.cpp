@@ -0,0 +1,116 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/SessionRecorder.h"
+#include "DBGp/Utility.h"
+
+using namespace DBGp;
+
+const char SessionRecorder::MAGIC[8] = { 'D', 'B', 'G', 'P', 'R', 'E', 'C', '1' };
+
+// {{{ static void PutLittleEndian(unsigned char *buffer, wxUint64 value, size_t bytes)
+static void PutLittleEndian(unsigned char *buffer, wxUint64 value, size_t bytes) {
+	for (size_t i = 0; i < bytes; i++) {
+		buffer[i] = static_cast<unsigned char>(value & 0xff);
+		value >>= 8;
+	}
+}
+// }}}
+
+// {{{ SessionRecorder::SessionRecorder()
+SessionRecorder::SessionRecorder() : open(false), started(0) {
+}
+// }}}
+// {{{ SessionRecorder::~SessionRecorder()
+SessionRecorder::~SessionRecorder() {
+	Close();
+}
+// }}}
+
+// {{{ void SessionRecorder::Close()
+void SessionRecorder::Close() {
+	wxMutexLocker lock(mutex);
+
+	if (open) {
+		open = false;
+		file.Close();
+	}
+}
+// }}}
+// {{{ bool SessionRecorder::Open(const wxString &file)
+bool SessionRecorder::Open(const wxString &file) {
+	wxMutexLocker lock(mutex);
+
+	if (open) {
+		open = false;
+		this->file.Close();
+	}
+
+	if (!this->file.Open(file, wxT("wb"))) {
+		return false;
+	}
+	if (this->file.Write(MAGIC, sizeof(MAGIC)) != sizeof(MAGIC)) {
+		this->file.Close();
+		return false;
+	}
+
+	started = GetMicroseconds();
+	open = true;
+	return true;
+}
+// }}}
+// {{{ void SessionRecorder::Record(Direction direction, const char *payload, size_t length)
+void SessionRecorder::Record(Direction direction, const char *payload, size_t length) {
+	unsigned char header[RECORD_HEADER_LENGTH] = { 0 };
+
+	if (!open) {
+		return;
+	}
+
+	wxMutexLocker lock(mutex);
+	if (!open) {
+		return;
+	}
+
+	header[0] = static_cast<unsigned char>(direction);
+	PutLittleEndian(header + 4, length, 4);
+	PutLittleEndian(header + 8, GetMicroseconds() - started, 8);
+
+	/* A failed write would leave the rest of the file unreadable, so
+	 * stop recording rather than carry on. */
+	if (file.Write(header, sizeof(header)) != sizeof(header) || file.Write(payload, length) != length) {
+		open = false;
+		file.Close();
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
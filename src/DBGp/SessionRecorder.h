@@ -0,0 +1,138 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_SESSIONRECORDER_H
+#define DBGP_SESSIONRECORDER_H
+
+#include <cstddef>
+
+#include <wx/ffile.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+namespace DBGp {
+	/**
+	 * Records the raw traffic of a session, with timestamps, so that it
+	 * can later be replayed against the IDE by SessionReplay.
+	 *
+	 * Recordings start with the eight byte magic number "DBGPREC1",
+	 * followed by one record per message. Each record has a sixteen byte
+	 * header, with all fields little endian:
+	 *
+	 * - the direction: 0 for a message from the engine, 1 for a command
+	 *   sent to it;
+	 * - three bytes of padding, which are always zero;
+	 * - the length of the payload in bytes, as 32 bits; and
+	 * - when the message was recorded, in microseconds since the
+	 *   recording started, as 64 bits.
+	 *
+	 * The payload follows the header: for engine messages, the XML
+	 * without the DBGp length prefix, and for commands, the command line
+	 * without its terminating NULL.
+	 *
+	 * Messages may be recorded from any thread.
+	 */
+	class SessionRecorder {
+		public:
+			/** The direction of a recorded message. */
+			typedef enum {
+				RECEIVED = 0,
+				SENT = 1
+			} Direction;
+
+			/** The magic number at the start of every recording. */
+			static const char MAGIC[8];
+
+			/** The length of each record header. */
+			static const size_t RECORD_HEADER_LENGTH = 16;
+
+			/** Constructs a recorder that isn't recording. */
+			SessionRecorder();
+
+			/** Finishes any recording in progress. */
+			~SessionRecorder();
+
+			/**
+			 * Finishes the recording, if one is in progress.
+			 */
+			void Close();
+
+			/**
+			 * Checks if a recording is in progress.
+			 *
+			 * @return True if messages are being recorded.
+			 */
+			inline bool IsOpen() const { return open; }
+
+			/**
+			 * Starts recording to a file, finishing any recording
+			 * already in progress. The file is overwritten.
+			 *
+			 * @param[in] file The file to record to.
+			 * @return True if the file could be created.
+			 */
+			bool Open(const wxString &file);
+
+			/**
+			 * Records a message, if a recording is in progress.
+			 *
+			 * @param[in] direction Whether the message came from
+			 * the engine or was sent to it.
+			 * @param[in] payload The message.
+			 * @param[in] length The length of the message.
+			 */
+			void Record(Direction direction, const char *payload, size_t length);
+
+		protected:
+			/** The file being recorded to. */
+			wxFFile file;
+
+			/** Serialises access to the file. */
+			wxMutex mutex;
+
+			/** Whether a recording is in progress. */
+			volatile bool open;
+
+			/** When the recording started. */
+			wxUint64 started;
+
+		private:
+			/** Recorders can't be copied. */
+			SessionRecorder(const SessionRecorder &);
+
+			/** Nor assigned. */
+			SessionRecorder &operator=(const SessionRecorder &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
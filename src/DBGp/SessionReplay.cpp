@@ -0,0 +1,303 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/SessionReplay.h"
+#include "DBGp/Utility.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <wx/log.h>
+
+using namespace DBGp;
+
+/* How much of the IDE's output is read at once. */
+static const size_t READ_CHUNK = 4096;
+
+// {{{ static wxUint64 GetLittleEndian(const unsigned char *buffer, size_t bytes)
+static wxUint64 GetLittleEndian(const unsigned char *buffer, size_t bytes) {
+	wxUint64 value = 0;
+
+	for (size_t i = bytes; i > 0; i--) {
+		value = (value << 8) | buffer[i - 1];
+	}
+	return value;
+}
+// }}}
+// {{{ static std::string GetTransactionID(const std::string &command)
+/* Returns the value of a command's -i argument, or an empty string. */
+static std::string GetTransactionID(const std::string &command) {
+	size_t start = command.find(" -i ");
+
+	if (start == std::string::npos) {
+		return std::string();
+	}
+
+	start += 4;
+	return command.substr(start, command.find(' ', start) - start);
+}
+// }}}
+// {{{ static bool ReadCommand(int fd, std::string &buffer, std::string &command) throw (SocketError)
+/* Reads the next NULL terminated command from the IDE, keeping anything
+ * read past it in the buffer. Returns false if the IDE hung up. */
+static bool ReadCommand(int fd, std::string &buffer, std::string &command) throw (SocketError) {
+	size_t end;
+
+	while ((end = buffer.find('\0')) == std::string::npos) {
+		char chunk[READ_CHUNK];
+		ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+
+		if (got == 0) {
+			return false;
+		}
+		else if (got < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw SocketError(wxT("recv: ") + wxString(wxSysErrorMsg(errno)));
+		}
+		buffer.append(chunk, static_cast<size_t>(got));
+	}
+
+	command.assign(buffer, 0, end);
+	buffer.erase(0, end + 1);
+	return true;
+}
+// }}}
+// {{{ static std::string RewriteTransactionID(const char *payload, size_t length, const std::map<std::string, std::string> &ids)
+/* Swaps the recorded transaction ID in a response for the one the IDE used
+ * for the matching command. */
+static std::string RewriteTransactionID(const char *payload, size_t length, const std::map<std::string, std::string> &ids) {
+	static const std::string attribute("transaction_id=\"");
+	std::string message(payload, length);
+	size_t start = message.find(attribute);
+
+	if (start != std::string::npos) {
+		start += attribute.length();
+
+		size_t end = message.find('"', start);
+		if (end != std::string::npos) {
+			std::map<std::string, std::string>::const_iterator i = ids.find(message.substr(start, end - start));
+			if (i != ids.end()) {
+				message.replace(start, end - start, i->second);
+			}
+		}
+	}
+
+	return message;
+}
+// }}}
+// {{{ static bool SendFrame(int fd, const std::string &payload) throw (SocketError)
+/* Writes a message to the IDE with its DBGp framing. Returns false if the
+ * IDE hung up. */
+static bool SendFrame(int fd, const std::string &payload) throw (SocketError) {
+	char length[32];
+	std::string frame;
+
+	std::sprintf(length, "%lu", static_cast<unsigned long>(payload.length()));
+	frame.reserve(payload.length() + 34);
+	frame.append(length);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	for (size_t sent = 0; sent < frame.length(); ) {
+		ssize_t written = send(fd, frame.data() + sent, frame.length() - sent, MSG_NOSIGNAL);
+
+		if (written >= 0) {
+			sent += static_cast<size_t>(written);
+		}
+		else if (errno == EPIPE || errno == ECONNRESET) {
+			return false;
+		}
+		else if (errno != EINTR) {
+			throw SocketError(wxT("send: ") + wxString(wxSysErrorMsg(errno)));
+		}
+	}
+	return true;
+}
+// }}}
+
+// {{{ SessionReplay::SessionReplay()
+SessionReplay::SessionReplay() : data(NULL), length(0) {
+}
+// }}}
+// {{{ SessionReplay::~SessionReplay()
+SessionReplay::~SessionReplay() {
+	Unload();
+}
+// }}}
+
+// {{{ void SessionReplay::Load(const wxString &file) throw (Error)
+void SessionReplay::Load(const wxString &file) throw (Error) {
+	struct stat info;
+	int fd;
+
+	Unload();
+
+	if ((fd = open(file.mb_str(wxConvFile), O_RDONLY)) == -1) {
+		throw Error(wxT("Unable to open ") + file + wxT(": ") + wxSysErrorMsg(errno));
+	}
+	if (fstat(fd, &info) == -1) {
+		close(fd);
+		throw Error(wxT("Unable to read ") + file + wxT(": ") + wxSysErrorMsg(errno));
+	}
+	if (static_cast<size_t>(info.st_size) < sizeof(SessionRecorder::MAGIC)) {
+		close(fd);
+		throw Error(file + wxT(" isn't a session recording."));
+	}
+
+	length = static_cast<size_t>(info.st_size);
+	data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (data == MAP_FAILED) {
+		data = NULL;
+		throw Error(wxT("Unable to map ") + file + wxT(": ") + wxSysErrorMsg(errno));
+	}
+
+	const char *bytes = static_cast<const char *>(data);
+	if (std::memcmp(bytes, SessionRecorder::MAGIC, sizeof(SessionRecorder::MAGIC)) != 0) {
+		Unload();
+		throw Error(file + wxT(" isn't a session recording."));
+	}
+
+	// Recordings are only ever read in order, once.
+	madvise(data, length, MADV_SEQUENTIAL);
+
+	size_t offset = sizeof(SessionRecorder::MAGIC);
+	while (length - offset >= SessionRecorder::RECORD_HEADER_LENGTH) {
+		const unsigned char *header = reinterpret_cast<const unsigned char *>(bytes + offset);
+		Record record;
+
+		record.direction = (header[0] == SessionRecorder::SENT) ? SessionRecorder::SENT : SessionRecorder::RECEIVED;
+		record.length = static_cast<size_t>(GetLittleEndian(header + 4, 4));
+		record.time = GetLittleEndian(header + 8, 8);
+		offset += SessionRecorder::RECORD_HEADER_LENGTH;
+
+		if (record.length > length - offset) {
+			break;
+		}
+
+		record.payload = bytes + offset;
+		offset += record.length;
+		records.push_back(record);
+	}
+}
+// }}}
+// {{{ size_t SessionReplay::Replay(int fd, double speed) throw (SocketError)
+size_t SessionReplay::Replay(int fd, double speed) throw (SocketError) {
+	std::map<std::string, std::string> ids;
+	std::string buffer, command;
+	wxUint64 lastLive = GetMicroseconds(), lastRecorded = 0;
+	size_t replayed = 0;
+
+	if (!records.empty()) {
+		lastRecorded = records.front().time;
+	}
+
+	for (RecordList::const_iterator i = records.begin(); i != records.end(); i++, replayed++) {
+		if (i->direction == SessionRecorder::SENT) {
+			if (!ReadCommand(fd, buffer, command)) {
+				break;
+			}
+
+			std::string recorded(GetTransactionID(std::string(i->payload, i->length)));
+			if (!recorded.empty()) {
+				ids[recorded] = GetTransactionID(command);
+			}
+		}
+		else {
+			if (speed > 0 && i->time > lastRecorded) {
+				wxUint64 due = lastLive + static_cast<wxUint64>((i->time - lastRecorded) / speed);
+				wxUint64 now = GetMicroseconds();
+
+				if (due > now) {
+					struct timespec delay;
+
+					delay.tv_sec = static_cast<time_t>((due - now) / 1000000);
+					delay.tv_nsec = static_cast<long>((due - now) % 1000000) * 1000;
+					while (nanosleep(&delay, &delay) == -1 && errno == EINTR);
+				}
+			}
+
+			if (!SendFrame(fd, RewriteTransactionID(i->payload, i->length, ids))) {
+				break;
+			}
+		}
+
+		lastLive = GetMicroseconds();
+		lastRecorded = i->time;
+	}
+
+	return replayed;
+}
+// }}}
+// {{{ size_t SessionReplay::Replay(const Transport &transport, double speed) throw (SocketError)
+size_t SessionReplay::Replay(const Transport &transport, double speed) throw (SocketError) {
+	int fd = transport.Connect();
+	size_t replayed;
+
+	try {
+		replayed = Replay(fd, speed);
+	}
+	catch (...) {
+		close(fd);
+		throw;
+	}
+
+	close(fd);
+	return replayed;
+}
+// }}}
+
+// {{{ void SessionReplay::Unload()
+void SessionReplay::Unload() {
+	if (data) {
+		munmap(data, length);
+		data = NULL;
+	}
+	length = 0;
+	records.clear();
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
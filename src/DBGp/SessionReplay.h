@@ -0,0 +1,158 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_SESSIONREPLAY_H
+#define DBGP_SESSIONREPLAY_H
+
+#include <cstddef>
+#include <vector>
+
+#include <wx/string.h>
+
+#include "DBGp/Error/Error.h"
+#include "DBGp/SessionRecorder.h"
+#include "DBGp/Transport.h"
+
+namespace DBGp {
+	/**
+	 * Plays a session recorded by SessionRecorder back to an IDE, taking
+	 * the part of the engine.
+	 *
+	 * Messages the engine sent are written to the IDE as they were
+	 * recorded, after the same delay as in the original session divided
+	 * by the speed factor: the time between a command and its response
+	 * is the engine's think time, so slow sessions stay slow. Each
+	 * recorded command is matched up with the next command read from the
+	 * IDE, whatever it is, and transaction IDs in the responses are
+	 * rewritten to match the IDE's.
+	 *
+	 * The recording is mapped into memory rather than read, so large
+	 * recordings cost nothing to load.
+	 */
+	class SessionReplay {
+		public:
+			/** A single recorded message. */
+			class Record {
+				public:
+					/** The direction of the message. */
+					SessionRecorder::Direction direction;
+
+					/** The length of the payload. */
+					size_t length;
+
+					/** The payload, within the mapped file. */
+					const char *payload;
+
+					/**
+					 * When the message was recorded, in
+					 * microseconds since the recording
+					 * started.
+					 */
+					wxUint64 time;
+			};
+
+			/** The records of a recording, in order. */
+			typedef std::vector<Record> RecordList;
+
+			/** Constructs an empty replay. */
+			SessionReplay();
+
+			/** Unmaps the recording. */
+			~SessionReplay();
+
+			/**
+			 * Returns the records loaded.
+			 *
+			 * @return The records.
+			 */
+			inline const RecordList &GetRecords() const { return records; }
+
+			/**
+			 * Maps a recording into memory, replacing any already
+			 * loaded. A truncated final record, as left by a
+			 * process that didn't finish its recording, is
+			 * ignored.
+			 *
+			 * @param[in] file The recording.
+			 * @throws Error Thrown if the file can't be mapped or
+			 * isn't a recording.
+			 */
+			void Load(const wxString &file) throw (Error);
+
+			/**
+			 * Replays the recording over a connected socket.
+			 *
+			 * @param[in] fd The socket connected to the IDE. It
+			 * isn't closed.
+			 * @param[in] speed How much faster than real time to
+			 * replay; 0 replays as fast as possible.
+			 * @return The number of records replayed, which is
+			 * short of the total if the IDE hung up early.
+			 * @throws SocketError Thrown if the socket fails.
+			 */
+			size_t Replay(int fd, double speed = 1.0) throw (SocketError);
+
+			/**
+			 * Connects to an IDE and replays the recording.
+			 *
+			 * @param[in] transport The IDE's address.
+			 * @param[in] speed How much faster than real time to
+			 * replay; 0 replays as fast as possible.
+			 * @return The number of records replayed.
+			 * @throws SocketError Thrown if the connection fails.
+			 */
+			size_t Replay(const Transport &transport, double speed = 1.0) throw (SocketError);
+
+		protected:
+			/** The mapped recording, or NULL. */
+			void *data;
+
+			/** The length of the mapping. */
+			size_t length;
+
+			/** The records within the mapping. */
+			RecordList records;
+
+			/** Unmaps the recording, if one is loaded. */
+			void Unload();
+
+		private:
+			/** Replays can't be copied. */
+			SessionReplay(const SessionReplay &);
+
+			/** Nor assigned. */
+			SessionReplay &operator=(const SessionReplay &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
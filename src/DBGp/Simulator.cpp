@@ -0,0 +1,944 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Simulator.h"
+#include "DBGp/Base64.h"
+#include "DBGp/Utility.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <wx/log.h>
+#include <wx/thread.h>
+#include <wx/tokenzr.h>
+
+using namespace DBGp;
+
+/* The arguments of a command, keyed by option. */
+typedef std::map<std::string, std::string> ArgumentMap;
+
+/* The file the simulated script claims to be running. */
+static const char *SCRIPT = "file:///dbgp-sim/script.php";
+
+/* The feature values used until the IDE negotiates its own, as Xdebug
+ * does. */
+static const unsigned long DEFAULT_MAX_CHILDREN = 32;
+static const unsigned long DEFAULT_MAX_DEPTH = 1;
+
+/* The number of source lines returned when the IDE doesn't ask for a
+ * range. */
+static const unsigned long SOURCE_LINES = 100;
+
+/* How much of the IDE's output is read at once. */
+static const size_t READ_CHUNK = 4096;
+
+/* The DBGp error codes used. */
+static const int ERROR_INVALID_OPTIONS = 3;
+static const int ERROR_UNIMPLEMENTED = 4;
+static const int ERROR_NOT_AVAILABLE = 5;
+static const int ERROR_NO_SUCH_BREAKPOINT = 205;
+static const int ERROR_NO_SUCH_PROPERTY = 300;
+static const int ERROR_INVALID_DEPTH = 301;
+static const int ERROR_INVALID_CONTEXT = 302;
+
+// {{{ static std::string Escape(const std::string &s)
+static std::string Escape(const std::string &s) {
+	std::string escaped;
+
+	for (std::string::const_iterator i = s.begin(); i != s.end(); i++) {
+		switch (*i) {
+			case '&':
+				escaped.append("&amp;");
+				break;
+
+			case '<':
+				escaped.append("&lt;");
+				break;
+
+			case '>':
+				escaped.append("&gt;");
+				break;
+
+			case '"':
+				escaped.append("&quot;");
+				break;
+
+			default:
+				escaped.push_back(*i);
+		}
+	}
+
+	return escaped;
+}
+// }}}
+// {{{ static std::string GetArgument(const ArgumentMap &args, const std::string &option, const std::string &fallback = std::string())
+static std::string GetArgument(const ArgumentMap &args, const std::string &option, const std::string &fallback = std::string()) {
+	ArgumentMap::const_iterator i = args.find(option);
+
+	return (i == args.end()) ? fallback : i->second;
+}
+// }}}
+// {{{ static bool GetNumericArgument(const ArgumentMap &args, const std::string &option, unsigned long &value)
+/* Leaves the value alone if the option wasn't given, and returns false if it
+ * isn't a number. */
+static bool GetNumericArgument(const ArgumentMap &args, const std::string &option, unsigned long &value) {
+	ArgumentMap::const_iterator i = args.find(option);
+	char *end;
+
+	if (i == args.end()) {
+		return true;
+	}
+
+	unsigned long parsed = std::strtoul(i->second.c_str(), &end, 10);
+	if (i->second.empty() || *end != '\0') {
+		return false;
+	}
+
+	value = parsed;
+	return true;
+}
+// }}}
+// {{{ static void ParseCommand(const std::string &line, std::string &name, ArgumentMap &args, std::string &data)
+/* Splits a command into its name, options and any data after "--". Values
+ * may be quoted, as MessageArguments does. */
+static void ParseCommand(const std::string &line, std::string &name, ArgumentMap &args, std::string &data) {
+	std::string option;
+	size_t i = 0;
+
+	while (i < line.length()) {
+		std::string token;
+
+		while (i < line.length() && line[i] == ' ') {
+			i++;
+		}
+		if (i >= line.length()) {
+			break;
+		}
+
+		if (line[i] == '"') {
+			size_t end = line.find('"', i + 1);
+
+			if (end == std::string::npos) {
+				end = line.length();
+			}
+			token = line.substr(i + 1, end - i - 1);
+			i = end + 1;
+		}
+		else {
+			size_t end = line.find(' ', i);
+
+			if (end == std::string::npos) {
+				end = line.length();
+			}
+			token = line.substr(i, end - i);
+			i = end;
+
+			if (token == "--") {
+				data = (i < line.length()) ? line.substr(i + 1) : std::string();
+				break;
+			}
+		}
+
+		if (name.empty()) {
+			name = token;
+		}
+		else if (option.empty() && token.length() > 1 && token[0] == '-') {
+			option = token;
+			args[option] = std::string();
+		}
+		else if (!option.empty()) {
+			args[option] = token;
+			option.clear();
+		}
+	}
+}
+// }}}
+// {{{ static std::string ToString(unsigned long value)
+static std::string ToString(unsigned long value) {
+	char buffer[32];
+
+	std::sprintf(buffer, "%lu", value);
+	return buffer;
+}
+// }}}
+
+// {{{ class Simulator::Session
+namespace DBGp {
+	class Simulator::Session {
+		public:
+			Session(const Workload &workload, int fd);
+
+			/* Sends the init packet and answers commands until
+			 * the session ends. */
+			Totals Serve() throw (SocketError);
+
+		private:
+			/* A breakpoint set by the IDE. */
+			class BreakpointState {
+				public:
+					std::string filename;
+					std::string function;
+					unsigned int hits;
+					std::string id;
+					unsigned long lineno;
+					std::string state;
+					std::string type;
+			};
+
+			/* The kinds of variable generated. */
+			typedef enum {
+				STRING,
+				INT,
+				ARRAY,
+				OBJECT
+			} PropertyType;
+
+			typedef std::vector<BreakpointState> BreakpointList;
+
+			std::string buffer;
+			BreakpointList breakpoints;
+			unsigned int breaksLeft;
+			std::string encoded;
+			int fd;
+			wxUint64 lastSent;
+			unsigned long line;
+			unsigned long maxChildren;
+			unsigned long maxDepth;
+			unsigned long nextBreakpoint;
+			std::string reason;
+			unsigned int runs;
+			std::string status;
+			bool stdoutEnabled;
+			Totals totals;
+			const Workload &workload;
+
+			std::string Breakpoint(const BreakpointState &breakpoint) const;
+			std::string Continue(const std::string &command, const std::string &id) throw (SocketError);
+			std::string Error(const std::string &command, const std::string &id, int code, const std::string &message) const;
+			BreakpointList::iterator FindBreakpoint(const std::string &id);
+			bool FindProperty(const std::string &fullName, unsigned long context, unsigned int &level, unsigned int &index) const;
+			PropertyType GetPropertyType(unsigned long context, unsigned int level, unsigned int index) const;
+			std::string Handle(const std::string &command, bool &finished) throw (SocketError);
+			std::string Property(unsigned long context, unsigned int level, unsigned int index, const std::string &name, const std::string &fullName, unsigned long depth, unsigned long page) const;
+			bool ReadCommand(std::string &command) throw (SocketError);
+			std::string Response(const std::string &command, const std::string &id, const std::string &attributes, const std::string &body = std::string()) const;
+			void Send(const std::string &payload) throw (SocketError);
+	};
+}
+// }}}
+// {{{ class Simulator::Thread
+namespace DBGp {
+	class Simulator::Thread : public wxThread {
+		public:
+			Thread(Simulator *simulator, int fd) : wxThread(wxTHREAD_JOINABLE), fd(fd), simulator(simulator) {}
+
+			inline const Totals &GetTotals() const { return totals; }
+
+		protected:
+			virtual ExitCode Entry() {
+				try {
+					totals = simulator->Serve(fd);
+				}
+				catch (SocketError e) {
+					totals.failed = 1;
+					totals.sessions = 1;
+				}
+				return 0;
+			}
+
+		private:
+			int fd;
+			Simulator *simulator;
+			Totals totals;
+	};
+}
+// }}}
+
+// {{{ Simulator::Workload::Workload()
+Simulator::Workload::Workload() : breaks(100), contexts(2), depth(10), fanOut(4), ideKey(wxT("dbgp-sim")), nesting(2), properties(20), stdoutPackets(0), stringLength(64) {
+	hits.push_back(1);
+}
+// }}}
+
+// {{{ Simulator::Workload Simulator::Workload::FromString(const wxString &spec) throw (Error)
+Simulator::Workload Simulator::Workload::FromString(const wxString &spec) throw (Error) {
+	Workload workload;
+	wxStringTokenizer pairs(spec, wxT(","), wxTOKEN_STRTOK);
+
+	while (pairs.HasMoreTokens()) {
+		wxString pair(pairs.GetNextToken());
+		wxString key(pair.BeforeFirst(wxT('=')).Lower());
+		wxString value(pair.AfterFirst(wxT('=')));
+		unsigned long number = 0;
+
+		if (key == wxT("idekey")) {
+			workload.ideKey = value;
+			continue;
+		}
+		else if (key == wxT("hits")) {
+			wxStringTokenizer hits(value, wxT(":"), wxTOKEN_STRTOK);
+
+			workload.hits.clear();
+			while (hits.HasMoreTokens()) {
+				if (!hits.GetNextToken().ToULong(&number)) {
+					throw Error(wxT("Invalid hit pattern: ") + value);
+				}
+				workload.hits.push_back(static_cast<unsigned int>(number));
+			}
+			continue;
+		}
+
+		if (!value.ToULong(&number)) {
+			throw Error(wxT("Invalid value for ") + key + wxT(": ") + value);
+		}
+
+		if (key == wxT("breaks")) {
+			workload.breaks = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("contexts") && number > 0) {
+			workload.contexts = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("depth") && number > 0) {
+			workload.depth = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("fanout")) {
+			workload.fanOut = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("nesting")) {
+			workload.nesting = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("properties")) {
+			workload.properties = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("stdout")) {
+			workload.stdoutPackets = static_cast<unsigned int>(number);
+		}
+		else if (key == wxT("strings")) {
+			workload.stringLength = static_cast<size_t>(number);
+		}
+		else if (key == wxT("contexts") || key == wxT("depth")) {
+			throw Error(wxT("There must be at least one ") + key.Left(key.length() - 1) + wxT("."));
+		}
+		else {
+			throw Error(wxT("Unknown workload key: ") + key);
+		}
+	}
+
+	return workload;
+}
+// }}}
+
+// {{{ Simulator::Totals::Totals()
+Simulator::Totals::Totals() : bytesReceived(0), bytesSent(0), commands(0), elapsed(0), failed(0), sessions(0) {
+}
+// }}}
+
+// {{{ void Simulator::Totals::Merge(const Totals &other)
+void Simulator::Totals::Merge(const Totals &other) {
+	bytesReceived += other.bytesReceived;
+	bytesSent += other.bytesSent;
+	commands += other.commands;
+	if (other.elapsed > elapsed) {
+		elapsed = other.elapsed;
+	}
+	failed += other.failed;
+	sessions += other.sessions;
+	turnaround.Merge(other.turnaround);
+}
+// }}}
+
+// {{{ Simulator::Session::Session(const Workload &workload, int fd)
+Simulator::Session::Session(const Workload &workload, int fd) : breaksLeft(workload.breaks), fd(fd), lastSent(0), line(1), maxChildren(DEFAULT_MAX_CHILDREN), maxDepth(DEFAULT_MAX_DEPTH), nextBreakpoint(1), reason("ok"), runs(0), status("starting"), stdoutEnabled(false), workload(workload) {
+	std::string raw;
+
+	// Every string is the same, so it's only encoded once.
+	raw.reserve(workload.stringLength);
+	for (size_t i = 0; i < workload.stringLength; i++) {
+		raw.push_back(static_cast<char>('a' + i % 26));
+	}
+	encoded = std::string(Base64::Encode(raw.data(), raw.length()).mb_str(wxConvISO8859_1));
+}
+// }}}
+
+// {{{ Simulator::Totals Simulator::Session::Serve() throw (SocketError)
+Simulator::Totals Simulator::Session::Serve() throw (SocketError) {
+	wxUint64 start = GetMicroseconds();
+	std::string command;
+	bool finished = false;
+
+	totals.sessions = 1;
+	Send("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<init xmlns=\"urn:debugger_protocol_v1\" fileuri=\"" + std::string(SCRIPT) + "\" language=\"PHP\" protocol_version=\"1.0\" appid=\"" + ToString(static_cast<unsigned long>(getpid())) + "\" idekey=\"" + Escape(std::string(workload.ideKey.mb_str(wxConvUTF8))) + "\"><engine version=\"1.0\"><![CDATA[dbgp-sim]]></engine></init>");
+
+	while (!finished && ReadCommand(command)) {
+		std::string response(Handle(command, finished));
+
+		totals.commands++;
+		Send(response);
+	}
+
+	totals.elapsed = GetMicroseconds() - start;
+	return totals;
+}
+// }}}
+
+// {{{ std::string Simulator::Session::Breakpoint(const BreakpointState &breakpoint) const
+std::string Simulator::Session::Breakpoint(const BreakpointState &breakpoint) const {
+	std::string xml("<breakpoint id=\"" + breakpoint.id + "\" type=\"" + Escape(breakpoint.type) + "\" state=\"" + breakpoint.state + "\"");
+
+	if (!breakpoint.filename.empty()) {
+		xml += " filename=\"" + Escape(breakpoint.filename) + "\" lineno=\"" + ToString(breakpoint.lineno) + "\"";
+	}
+	if (!breakpoint.function.empty()) {
+		xml += " function=\"" + Escape(breakpoint.function) + "\"";
+	}
+	return xml + " hit_count=\"" + ToString(breakpoint.hits) + "\"/>";
+}
+// }}}
+// {{{ std::string Simulator::Session::Continue(const std::string &command, const std::string &id) throw (SocketError)
+std::string Simulator::Session::Continue(const std::string &command, const std::string &id) throw (SocketError) {
+	if (status == "stopping" || status == "stopped") {
+		return Error(command, id, ERROR_NOT_AVAILABLE, "The script has finished.");
+	}
+
+	line++;
+	if (command == "run" && !workload.hits.empty()) {
+		unsigned int hit = workload.hits[runs++ % workload.hits.size()];
+
+		if (hit > 0 && hit <= breakpoints.size() && breakpoints[hit - 1].state == "enabled") {
+			BreakpointState &breakpoint = breakpoints[hit - 1];
+
+			breakpoint.hits++;
+			if (breakpoint.type == "line") {
+				line = breakpoint.lineno;
+			}
+		}
+	}
+
+	if (stdoutEnabled) {
+		std::string packet("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<stream xmlns=\"urn:debugger_protocol_v1\" type=\"stdout\" encoding=\"base64\"><![CDATA[" + encoded + "]]></stream>");
+
+		for (unsigned int i = 0; i < workload.stdoutPackets; i++) {
+			Send(packet);
+		}
+	}
+
+	if (breaksLeft == 0) {
+		status = "stopping";
+	}
+	else {
+		breaksLeft--;
+		status = "break";
+	}
+	return Response(command, id, " status=\"" + status + "\" reason=\"" + reason + "\"");
+}
+// }}}
+// {{{ std::string Simulator::Session::Error(const std::string &command, const std::string &id, int code, const std::string &message) const
+std::string Simulator::Session::Error(const std::string &command, const std::string &id, int code, const std::string &message) const {
+	return Response(command, id, std::string(), "<error code=\"" + ToString(code) + "\"><message><![CDATA[" + message + "]]></message></error>");
+}
+// }}}
+// {{{ Simulator::Session::BreakpointList::iterator Simulator::Session::FindBreakpoint(const std::string &id)
+Simulator::Session::BreakpointList::iterator Simulator::Session::FindBreakpoint(const std::string &id) {
+	BreakpointList::iterator i;
+
+	for (i = breakpoints.begin(); i != breakpoints.end(); i++) {
+		if (i->id == id) {
+			break;
+		}
+	}
+	return i;
+}
+// }}}
+// {{{ bool Simulator::Session::FindProperty(const std::string &fullName, unsigned long context, unsigned int &level, unsigned int &index) const
+/* Walks a full name such as $var3[1]->prop2 down the generated graph. */
+bool Simulator::Session::FindProperty(const std::string &fullName, unsigned long context, unsigned int &level, unsigned int &index) const {
+	const char *s = fullName.c_str();
+	char *end;
+
+	if (fullName.compare(0, 4, "$var") != 0) {
+		return false;
+	}
+
+	index = static_cast<unsigned int>(std::strtoul(s + 4, &end, 10));
+	if (end == s + 4 || index >= workload.properties) {
+		return false;
+	}
+
+	for (level = 0; *end != '\0'; level++) {
+		PropertyType type = GetPropertyType(context, level, index);
+		const char *start;
+
+		if (type == ARRAY && *end == '[') {
+			start = end + 1;
+		}
+		else if (type == OBJECT && std::strncmp(end, "->prop", 6) == 0) {
+			start = end + 6;
+		}
+		else {
+			return false;
+		}
+
+		index = static_cast<unsigned int>(std::strtoul(start, &end, 10));
+		if (end == start || index >= workload.fanOut) {
+			return false;
+		}
+		if (type == ARRAY && *end++ != ']') {
+			return false;
+		}
+	}
+
+	return true;
+}
+// }}}
+// {{{ Simulator::Session::PropertyType Simulator::Session::GetPropertyType(unsigned long context, unsigned int level, unsigned int index) const
+Simulator::Session::PropertyType Simulator::Session::GetPropertyType(unsigned long context, unsigned int level, unsigned int index) const {
+	// Contexts differ so that switching between them isn't a no-op.
+	unsigned long mix = index + context;
+
+	if (level >= workload.nesting || workload.fanOut == 0) {
+		return (mix % 2) ? INT : STRING;
+	}
+	return static_cast<PropertyType>(mix % 4);
+}
+// }}}
+// {{{ std::string Simulator::Session::Handle(const std::string &command, bool &finished) throw (SocketError)
+std::string Simulator::Session::Handle(const std::string &command, bool &finished) throw (SocketError) {
+	std::string name, data;
+	ArgumentMap args;
+
+	ParseCommand(command, name, args, data);
+	std::string id(GetArgument(args, "-i"));
+
+	if (name == "run" || name == "step_into" || name == "step_over" || name == "step_out") {
+		return Continue(name, id);
+	}
+	else if (name == "status" || name == "break") {
+		return Response(name, id, " status=\"" + status + "\" reason=\"" + reason + "\"");
+	}
+	else if (name == "stop" || name == "detach") {
+		finished = true;
+		status = (name == "stop") ? "stopped" : "stopping";
+		return Response(name, id, " status=\"" + status + "\" reason=\"" + reason + "\"");
+	}
+	else if (name == "feature_get") {
+		static const char *commands[] = { "break", "breakpoint_get", "breakpoint_list", "breakpoint_remove", "breakpoint_set", "breakpoint_update", "context_get", "context_names", "detach", "feature_get", "feature_set", "property_get", "property_value", "run", "source", "stack_depth", "stack_get", "status", "stderr", "stdout", "step_into", "step_out", "step_over", "stop", "typemap_get" };
+		std::string feature(GetArgument(args, "-n")), value;
+		bool supported = true;
+
+		if (feature == "language_name") {
+			value = "PHP";
+		}
+		else if (feature == "encoding") {
+			value = "iso-8859-1";
+		}
+		else if (feature == "protocol_version" || feature == "data_encoding") {
+			value = (feature == "data_encoding") ? "base64" : "1";
+		}
+		else if (feature == "breakpoint_types") {
+			value = "line call return exception conditional watch";
+		}
+		else if (feature == "max_children") {
+			value = ToString(maxChildren);
+		}
+		else if (feature == "max_depth") {
+			value = ToString(maxDepth);
+		}
+		else if (feature == "language_supports_threads" || feature == "supports_async" || feature == "multiple_sessions" || feature == "max_data") {
+			value = "0";
+		}
+		else {
+			supported = false;
+			for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+				if (feature == commands[i]) {
+					supported = true;
+					break;
+				}
+			}
+			value = supported ? "1" : "0";
+		}
+
+		return Response(name, id, " feature_name=\"" + Escape(feature) + "\" supported=\"" + (supported ? "1" : "0") + "\"", "<![CDATA[" + value + "]]>");
+	}
+	else if (name == "feature_set") {
+		std::string feature(GetArgument(args, "-n"));
+		unsigned long value = 0;
+		bool success = true;
+
+		if (feature == "max_children" || feature == "max_depth") {
+			success = GetNumericArgument(args, "-v", value) && args.count("-v") > 0;
+			if (success) {
+				(feature == "max_children" ? maxChildren : maxDepth) = value;
+			}
+		}
+		else if (feature != "encoding" && feature != "max_data" && feature != "show_hidden") {
+			success = false;
+		}
+
+		return Response(name, id, " feature_name=\"" + Escape(feature) + "\" success=\"" + (success ? "1" : "0") + "\"");
+	}
+	else if (name == "stdout" || name == "stderr") {
+		if (name == "stdout") {
+			stdoutEnabled = (GetArgument(args, "-c", "0") != "0");
+		}
+		return Response(name, id, " success=\"1\"");
+	}
+	else if (name == "typemap_get") {
+		return Response(name, id, " xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\"",
+			"<map name=\"bool\" type=\"bool\" xsi:type=\"xsd:boolean\"/>"
+			"<map name=\"int\" type=\"int\" xsi:type=\"xsd:decimal\"/>"
+			"<map name=\"float\" type=\"float\" xsi:type=\"xsd:double\"/>"
+			"<map name=\"string\" type=\"string\" xsi:type=\"xsd:string\"/>"
+			"<map name=\"null\" type=\"null\"/>"
+			"<map name=\"array\" type=\"hash\"/>"
+			"<map name=\"object\" type=\"object\"/>"
+			"<map name=\"resource\" type=\"resource\"/>");
+	}
+	else if (name == "breakpoint_set") {
+		BreakpointState breakpoint;
+
+		breakpoint.hits = 0;
+		breakpoint.id = ToString(nextBreakpoint++);
+		breakpoint.lineno = 0;
+		breakpoint.state = GetArgument(args, "-s", "enabled");
+		breakpoint.type = GetArgument(args, "-t", "line");
+		breakpoint.function = GetArgument(args, "-m");
+		if (breakpoint.type == "line") {
+			breakpoint.filename = GetArgument(args, "-f", SCRIPT);
+			if (!GetNumericArgument(args, "-n", breakpoint.lineno)) {
+				return Error(name, id, ERROR_INVALID_OPTIONS, "Invalid line number.");
+			}
+		}
+
+		breakpoints.push_back(breakpoint);
+		return Response(name, id, " state=\"" + breakpoint.state + "\" id=\"" + breakpoint.id + "\"");
+	}
+	else if (name == "breakpoint_get" || name == "breakpoint_update" || name == "breakpoint_remove") {
+		BreakpointList::iterator breakpoint(FindBreakpoint(GetArgument(args, "-d")));
+
+		if (breakpoint == breakpoints.end()) {
+			return Error(name, id, ERROR_NO_SUCH_BREAKPOINT, "No such breakpoint.");
+		}
+
+		std::string xml(Breakpoint(*breakpoint));
+		if (name == "breakpoint_update") {
+			breakpoint->state = GetArgument(args, "-s", breakpoint->state);
+			if (!GetNumericArgument(args, "-n", breakpoint->lineno)) {
+				return Error(name, id, ERROR_INVALID_OPTIONS, "Invalid line number.");
+			}
+			return Response(name, id, std::string());
+		}
+		else if (name == "breakpoint_remove") {
+			breakpoints.erase(breakpoint);
+		}
+		return Response(name, id, std::string(), xml);
+	}
+	else if (name == "breakpoint_list") {
+		std::string body;
+
+		for (BreakpointList::const_iterator i = breakpoints.begin(); i != breakpoints.end(); i++) {
+			body += Breakpoint(*i);
+		}
+		return Response(name, id, std::string(), body);
+	}
+	else if (name == "stack_depth") {
+		return Response(name, id, " depth=\"" + ToString(workload.depth) + "\"");
+	}
+	else if (name == "stack_get") {
+		unsigned long first = 0, last = workload.depth - 1;
+		std::string body;
+
+		if (args.count("-d") > 0) {
+			if (!GetNumericArgument(args, "-d", first) || first >= workload.depth) {
+				return Error(name, id, ERROR_INVALID_DEPTH, "Stack depth invalid.");
+			}
+			last = first;
+		}
+
+		for (unsigned long level = first; level <= last; level++) {
+			std::string filename(level == 0 ? std::string(SCRIPT) : "file:///dbgp-sim/include" + ToString(level) + ".php");
+			std::string lineno(ToString(level == 0 ? line : level * 10 + 1));
+			std::string where(level == workload.depth - 1 ? "{main}" : "function" + ToString(workload.depth - level - 1));
+
+			body += "<stack level=\"" + ToString(level) + "\" type=\"file\" filename=\"" + filename + "\" lineno=\"" + lineno + "\" where=\"" + where + "\" cmdbegin=\"" + lineno + ":0\" cmdend=\"" + lineno + ":0\"/>";
+		}
+		return Response(name, id, std::string(), body);
+	}
+	else if (name == "context_names") {
+		std::string body;
+
+		for (unsigned long context = 0; context < workload.contexts; context++) {
+			std::string contextName(context == 0 ? "Locals" : context == 1 ? "Superglobals" : "Context " + ToString(context));
+
+			body += "<context name=\"" + contextName + "\" id=\"" + ToString(context) + "\"/>";
+		}
+		return Response(name, id, std::string(), body);
+	}
+	else if (name == "context_get" || name == "property_get" || name == "property_value") {
+		unsigned long context = 0, depth = 0, page = 0;
+
+		if (!GetNumericArgument(args, "-d", depth) || depth >= workload.depth) {
+			return Error(name, id, ERROR_INVALID_DEPTH, "Stack depth invalid.");
+		}
+		if (!GetNumericArgument(args, "-c", context) || context >= workload.contexts) {
+			return Error(name, id, ERROR_INVALID_CONTEXT, "Context invalid.");
+		}
+
+		if (name == "context_get") {
+			std::string body;
+
+			for (unsigned int i = 0; i < workload.properties; i++) {
+				std::string var("$var" + ToString(i));
+
+				body += Property(context, 0, i, var, var, maxDepth, 0);
+			}
+			return Response(name, id, " context=\"" + ToString(context) + "\"", body);
+		}
+
+		std::string fullName(GetArgument(args, "-n"));
+		unsigned int level, index;
+		if (!FindProperty(fullName, context, level, index)) {
+			return Error(name, id, ERROR_NO_SUCH_PROPERTY, "Property doesn't exist.");
+		}
+
+		PropertyType type = GetPropertyType(context, level, index);
+		if (name == "property_value") {
+			if (type == STRING) {
+				return Response(name, id, " size=\"" + ToString(workload.stringLength) + "\" encoding=\"base64\"", "<![CDATA[" + encoded + "]]>");
+			}
+			return Response(name, id, " size=\"0\"", type == INT ? "<![CDATA[" + ToString(index * 7 + level) + "]]>" : std::string());
+		}
+
+		if (!GetNumericArgument(args, "-p", page)) {
+			return Error(name, id, ERROR_INVALID_OPTIONS, "Invalid page.");
+		}
+
+		size_t separator = fullName.find_last_of("[>");
+		std::string shortName(separator == std::string::npos ? fullName : fullName.substr(separator + 1));
+		if (!shortName.empty() && shortName[shortName.length() - 1] == ']') {
+			shortName.erase(shortName.length() - 1);
+		}
+		return Response(name, id, " context=\"" + ToString(context) + "\"", Property(context, level, index, shortName, fullName, maxDepth, page));
+	}
+	else if (name == "source") {
+		unsigned long begin = 1, end = 0;
+		std::string source;
+
+		if (!GetNumericArgument(args, "-b", begin) || !GetNumericArgument(args, "-e", end)) {
+			return Error(name, id, ERROR_INVALID_OPTIONS, "Invalid line range.");
+		}
+		if (begin == 0) {
+			begin = 1;
+		}
+		if (end < begin) {
+			end = begin + SOURCE_LINES - 1;
+		}
+
+		for (unsigned long i = begin; i <= end; i++) {
+			source += (i == 1) ? "<?php\n" : "$var" + ToString(i % (workload.properties + 1)) + " = " + ToString(i) + ";\n";
+		}
+		return Response(name, id, " success=\"1\" encoding=\"base64\"", "<![CDATA[" + std::string(Base64::Encode(source.data(), source.length()).mb_str(wxConvISO8859_1)) + "]]>");
+	}
+
+	return Error(name, id, ERROR_UNIMPLEMENTED, "Unimplemented command.");
+}
+// }}}
+// {{{ std::string Simulator::Session::Property(unsigned long context, unsigned int level, unsigned int index, const std::string &name, const std::string &fullName, unsigned long depth, unsigned long page) const
+std::string Simulator::Session::Property(unsigned long context, unsigned int level, unsigned int index, const std::string &name, const std::string &fullName, unsigned long depth, unsigned long page) const {
+	std::string xml("<property name=\"" + Escape(name) + "\" fullname=\"" + Escape(fullName) + "\"");
+
+	switch (GetPropertyType(context, level, index)) {
+		case STRING:
+			return xml + " type=\"string\" constant=\"0\" children=\"0\" size=\"" + ToString(workload.stringLength) + "\" encoding=\"base64\"><![CDATA[" + encoded + "]]></property>";
+
+		case INT:
+			return xml + " type=\"int\" constant=\"0\" children=\"0\"><![CDATA[" + ToString(index * 7 + level) + "]]></property>";
+
+		case ARRAY:
+			xml += " type=\"array\"";
+			break;
+
+		case OBJECT:
+			xml += " type=\"object\" classname=\"SimObject\"";
+			break;
+	}
+
+	xml += " constant=\"0\" children=\"1\" numchildren=\"" + ToString(workload.fanOut) + "\" page=\"" + ToString(page) + "\" pagesize=\"" + ToString(maxChildren) + "\"";
+	if (depth == 0) {
+		return xml + "/>";
+	}
+
+	xml += ">";
+	bool object = (GetPropertyType(context, level, index) == OBJECT);
+	for (unsigned long i = page * maxChildren; i < workload.fanOut && i < (page + 1) * maxChildren; i++) {
+		std::string childName(object ? "prop" + ToString(i) : ToString(i));
+		std::string childFullName(fullName + (object ? "->" + childName : "[" + childName + "]"));
+
+		xml += Property(context, level + 1, static_cast<unsigned int>(i), childName, childFullName, depth - 1, 0);
+	}
+	return xml + "</property>";
+}
+// }}}
+// {{{ bool Simulator::Session::ReadCommand(std::string &command) throw (SocketError)
+/* Reads the next NULL terminated command, keeping anything read past it in
+ * the buffer. Returns false if the IDE hung up. */
+bool Simulator::Session::ReadCommand(std::string &command) throw (SocketError) {
+	size_t end;
+
+	while ((end = buffer.find('\0')) == std::string::npos) {
+		char chunk[READ_CHUNK];
+		ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+
+		if (received > 0) {
+			buffer.append(chunk, received);
+			totals.bytesReceived += received;
+		}
+		else if (received == 0 || errno == ECONNRESET) {
+			return false;
+		}
+		else if (errno != EINTR) {
+			throw SocketError(wxT("recv: ") + wxString(wxSysErrorMsg(errno)));
+		}
+	}
+
+	// Only the first command after a response shows the IDE's think time.
+	if (lastSent != 0) {
+		totals.turnaround.Record(GetMicroseconds() - lastSent);
+		lastSent = 0;
+	}
+
+	command.assign(buffer, 0, end);
+	buffer.erase(0, end + 1);
+	return true;
+}
+// }}}
+// {{{ std::string Simulator::Session::Response(const std::string &command, const std::string &id, const std::string &attributes, const std::string &body) const
+std::string Simulator::Session::Response(const std::string &command, const std::string &id, const std::string &attributes, const std::string &body) const {
+	std::string xml("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"" + Escape(command) + "\" transaction_id=\"" + Escape(id) + "\"" + attributes);
+
+	if (body.empty()) {
+		return xml + "/>";
+	}
+	return xml + ">" + body + "</response>";
+}
+// }}}
+// {{{ void Simulator::Session::Send(const std::string &payload) throw (SocketError)
+void Simulator::Session::Send(const std::string &payload) throw (SocketError) {
+	std::string frame(ToString(payload.length()));
+
+	frame.reserve(frame.length() + payload.length() + 2);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	for (size_t sent = 0; sent < frame.length(); ) {
+		ssize_t written = send(fd, frame.data() + sent, frame.length() - sent, MSG_NOSIGNAL);
+
+		if (written >= 0) {
+			sent += static_cast<size_t>(written);
+		}
+		else if (errno != EINTR) {
+			throw SocketError(wxT("send: ") + wxString(wxSysErrorMsg(errno)));
+		}
+	}
+
+	totals.bytesSent += frame.length();
+	lastSent = GetMicroseconds();
+}
+// }}}
+
+// {{{ Simulator::Simulator(const Workload &workload)
+Simulator::Simulator(const Workload &workload) : workload(workload) {
+}
+// }}}
+
+// {{{ Simulator::Totals Simulator::Run(const Transport &transport, unsigned int sessions) throw (SocketError)
+Simulator::Totals Simulator::Run(const Transport &transport, unsigned int sessions) throw (SocketError) {
+	std::vector<int> fds;
+	std::vector<Thread *> threads;
+	Totals totals;
+
+	// Connect everything first, so the sessions really are concurrent.
+	try {
+		for (unsigned int i = 0; i < sessions; i++) {
+			fds.push_back(transport.Connect());
+		}
+	}
+	catch (SocketError e) {
+		for (std::vector<int>::const_iterator i = fds.begin(); i != fds.end(); i++) {
+			close(*i);
+		}
+		throw;
+	}
+
+	wxUint64 start = GetMicroseconds();
+	for (std::vector<int>::const_iterator i = fds.begin(); i != fds.end(); i++) {
+		Thread *thread = new Thread(this, *i);
+
+		if (thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+			wxLogError(wxT("Unable to start a session thread."));
+			delete thread;
+
+			totals.failed++;
+			totals.sessions++;
+			continue;
+		}
+		threads.push_back(thread);
+	}
+
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i]->Wait();
+		totals.Merge(threads[i]->GetTotals());
+		delete threads[i];
+	}
+	for (std::vector<int>::const_iterator i = fds.begin(); i != fds.end(); i++) {
+		close(*i);
+	}
+
+	totals.elapsed = GetMicroseconds() - start;
+	return totals;
+}
+// }}}
+// {{{ Simulator::Totals Simulator::Serve(int fd) throw (SocketError)
+Simulator::Totals Simulator::Serve(int fd) throw (SocketError) {
+	Session session(workload, fd);
+
+	return session.Serve();
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
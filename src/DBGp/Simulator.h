@@ -0,0 +1,246 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_SIMULATOR_H
+#define DBGP_SIMULATOR_H
+
+#include <vector>
+
+#include <wx/string.h>
+
+#include "DBGp/Error/Error.h"
+#include "DBGp/Histogram.h"
+#include "DBGp/Transport.h"
+
+namespace DBGp {
+	/**
+	 * Takes the part of a debugging engine running a synthetic script,
+	 * so that IDEs built on this library can be loaded and measured
+	 * without PHP and Xdebug.
+	 *
+	 * The script's shape is set by a Workload. It breaks a fixed number
+	 * of times before it finishes: each step command breaks on the next
+	 * line, and each run command breaks at the breakpoint given by the
+	 * next entry of the hit pattern, counting a hit on it. Every frame
+	 * has the same contexts, and every context the same variables: a
+	 * mix of strings, integers, arrays and objects, with the arrays and
+	 * objects nested to a fixed depth. Everything is generated from
+	 * the workload alone, so runs are reproducible.
+	 *
+	 * Enough of the protocol is implemented for the connection start up,
+	 * breakpoints, stepping, stack and property inspection, stream
+	 * redirection and source retrieval. Other commands get an
+	 * "unimplemented command" error.
+	 */
+	class Simulator {
+		public:
+			/** The shape of the simulated script. */
+			class Workload {
+				public:
+					/** Constructs the default workload. */
+					Workload();
+
+					/**
+					 * Parses a workload from a comma separated
+					 * list of key=value pairs, starting from the
+					 * defaults. The keys are breaks, contexts,
+					 * depth, fanout, hits (a colon separated
+					 * list), idekey, nesting, properties, stdout
+					 * and strings, matching the members below.
+					 *
+					 * @param[in] spec The workload.
+					 * @return The workload.
+					 * @throws Error Thrown if a key is unknown or
+					 * a value is invalid.
+					 */
+					static Workload FromString(const wxString &spec) throw (Error);
+
+					/**
+					 * The number of times the script breaks
+					 * before it finishes.
+					 */
+					unsigned int breaks;
+
+					/** The number of contexts in each frame. */
+					unsigned int contexts;
+
+					/** The depth of the stack. */
+					unsigned int depth;
+
+					/**
+					 * The number of children of each array and
+					 * object.
+					 */
+					unsigned int fanOut;
+
+					/**
+					 * The breakpoints hit by successive run
+					 * commands, by the order in which they were
+					 * set, starting from 1. The pattern repeats;
+					 * 0 stands for a break that isn't a
+					 * breakpoint, as does a breakpoint that
+					 * hasn't been set or is disabled.
+					 */
+					std::vector<unsigned int> hits;
+
+					/** The IDE key sent in the init packet. */
+					wxString ideKey;
+
+					/**
+					 * How many levels of arrays and objects are
+					 * nested below each variable.
+					 */
+					unsigned int nesting;
+
+					/** The number of variables in each context. */
+					unsigned int properties;
+
+					/**
+					 * The number of stdout packets the script
+					 * writes between breaks, if stdout is being
+					 * copied or redirected.
+					 */
+					unsigned int stdoutPackets;
+
+					/**
+					 * The length of each string variable and
+					 * stdout packet, in bytes.
+					 */
+					size_t stringLength;
+			};
+
+			/** What the simulator did, summed over its sessions. */
+			class Totals {
+				public:
+					/** Constructs empty totals. */
+					Totals();
+
+					/**
+					 * Adds another set of totals to this one.
+					 *
+					 * @param[in] other The totals to add.
+					 */
+					void Merge(const Totals &other);
+
+					/**
+					 * The number of bytes of commands read from
+					 * the IDE.
+					 */
+					wxUint64 bytesReceived;
+
+					/**
+					 * The number of bytes of messages written to
+					 * the IDE, including framing.
+					 */
+					wxUint64 bytesSent;
+
+					/** The number of commands answered. */
+					wxUint64 commands;
+
+					/**
+					 * The time spent serving sessions, in
+					 * microseconds. For concurrent sessions, this
+					 * is the wall clock time of the slowest.
+					 */
+					wxUint64 elapsed;
+
+					/**
+					 * The number of sessions that ended in a
+					 * socket error.
+					 */
+					unsigned int failed;
+
+					/** The number of sessions served. */
+					unsigned int sessions;
+
+					/**
+					 * The time from each message being written
+					 * to the next command arriving, in
+					 * microseconds: how long the IDE took to act
+					 * on it.
+					 */
+					Histogram turnaround;
+			};
+
+			/**
+			 * Constructs a simulator.
+			 *
+			 * @param[in] workload The shape of the script.
+			 */
+			Simulator(const Workload &workload = Workload());
+
+			/**
+			 * Returns the workload.
+			 *
+			 * @return The workload.
+			 */
+			inline const Workload &GetWorkload() const { return workload; }
+
+			/**
+			 * Connects a number of sessions to an IDE at once and
+			 * serves them each on their own thread until they
+			 * finish.
+			 *
+			 * @param[in] transport The IDE's address.
+			 * @param[in] sessions The number of sessions.
+			 * @return The totals over every session.
+			 * @throws SocketError Thrown if a session can't be
+			 * connected, in which case none are served.
+			 */
+			Totals Run(const Transport &transport, unsigned int sessions) throw (SocketError);
+
+			/**
+			 * Serves a single session over a connected socket,
+			 * starting with the init packet, until the IDE stops
+			 * or detaches from the script or hangs up.
+			 *
+			 * @param[in] fd The socket connected to the IDE. It
+			 * isn't closed.
+			 * @return The totals for the session.
+			 * @throws SocketError Thrown if the socket fails.
+			 */
+			Totals Serve(int fd) throw (SocketError);
+
+		protected:
+			/** A single session's script and socket. */
+			class Session;
+
+			/** The thread that serves a session for Run(). */
+			class Thread;
+
+			/** The shape of the script. */
+			Workload workload;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -37,25 +37,36 @@
 
 #include <wx/log.h>
 #include <wx/string.h>
+#include <wx/xml/xml.h>
 
 using namespace DBGp;
 
 // {{{ Stack::Stack(Connection *conn) throw (EngineError, MalformedDocumentError, SocketError)
 Stack::Stack(Connection *conn) throw (EngineError, MalformedDocumentError, SocketError) : conn(conn) {
-	unsigned int depth;
-	wxXmlDocument doc(conn->SendCommandWait(wxT("stack_depth"), MessageArguments()));
-	
-	depth = StringToInt(doc.GetRoot()->GetPropVal(wxT("depth"), wxT("0")));
-	for (unsigned int i = 0; i < depth; i++) {
-		try {
-			levels.push_back(new StackLevel(conn, i));
-		}
-		catch (NotFoundError e) {
-			wxLogWarning(wxT("Expected stack depth %u not found."), i);
+	/* A single stack_get without a depth returns every frame at once;
+	 * the contexts within each frame are only requested when they're
+	 * actually needed. */
+	wxXmlDocument doc(conn->SendCommandWait(wxT("stack_get"), MessageArguments()));
+
+	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
+		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("stack")) {
+			unsigned int level = StringToInt(node->GetPropVal(wxT("level"), wxT("0")));
+
+			if (level != levels.size()) {
+				wxLogWarning(wxT("Expected stack level %u, but got level %u."), static_cast<unsigned int>(levels.size()), level);
+			}
+			levels.push_back(new StackLevel(conn, node));
 		}
 	}
 }
 // }}}
+// {{{ Stack::Stack(const Stack &stack)
+Stack::Stack(const Stack &stack) : conn(stack.conn) {
+	for (StackLevelDeque::const_iterator i = stack.levels.begin(); i != stack.levels.end(); i++) {
+		levels.push_back(new StackLevel(**i));
+	}
+}
+// }}}
 // {{{ Stack::~Stack()
 Stack::~Stack() {
 	for (StackLevelDeque::iterator i = levels.begin(); i != levels.end(); i++) {
@@ -43,6 +43,7 @@ namespace DBGp {
 	class Stack {
 		public:
 			Stack(Connection *conn) throw (EngineError, MalformedDocumentError, SocketError);
+			Stack(const Stack &stack);
 			~Stack();
 			
 			inline unsigned int GetDepth() const { return levels.size(); }
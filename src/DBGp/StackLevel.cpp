@@ -31,31 +31,133 @@
 
 #include "DBGp/StackLevel.h"
 #include "DBGp/Connection.h"
+#include "DBGp/PropertyBuilder.h"
 #include "DBGp/Utility.h"
 
+#include <map>
+#include <utility>
+
 using namespace DBGp;
 
 // {{{ StackLevel::StackLevel(Connection *conn, unsigned int level) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError)
-StackLevel::StackLevel(Connection *conn, unsigned int level) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError) : conn(conn), level(level) {
+StackLevel::StackLevel(Connection *conn, unsigned int level) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError) : conn(conn), contextsRetrieved(false), level(level) {
 	GetStack();
-	GetEngineContexts();
+}
+// }}}
+// {{{ StackLevel::StackLevel(Connection *conn, wxXmlNode *stack) throw (MalformedDocumentError)
+StackLevel::StackLevel(Connection *conn, wxXmlNode *stack) throw (MalformedDocumentError) : conn(conn), contextsRetrieved(false) {
+	ParseStackElement(stack);
 }
 // }}}
 // {{{ StackLevel::StackLevel(const StackLevel &level)
-StackLevel::StackLevel(const StackLevel &level) : cmdBegin(level.cmdBegin), cmdEnd(level.cmdEnd), conn(level.conn), fileName(level.fileName), level(level.level), lineNo(level.lineNo), type(level.type), where(level.where) {
+StackLevel::StackLevel(const StackLevel &level) : cmdBegin(level.cmdBegin), cmdEnd(level.cmdEnd), conn(level.conn), contextsRetrieved(level.contextsRetrieved), fileName(level.fileName), level(level.level), lineNo(level.lineNo), type(level.type), where(level.where) {
+	/* The properties are shared with the original level, and only know
+	 * about the level they were built for, so the copy starts with an
+	 * empty index and only indexes what it retrieves itself. */
 	for (ContextMap::const_iterator i = level.contexts.begin(); i != level.contexts.end(); i++) {
-		contexts[i->first] = new Context(*(i->second));
+		Context *context = new Context(*(i->second));
+		context->level = this;
+		contexts[i->first] = context;
 	}
 }
 // }}}
 // {{{ StackLevel::~StackLevel()
 StackLevel::~StackLevel() {
+	// There's no point in the properties unindexing themselves now.
+	names.clear();
+
 	for (ContextMap::iterator i = contexts.begin(); i != contexts.end(); i++) {
 		delete i->second;
 	}
 }
 // }}}
 
+// {{{ Property *StackLevel::FindProperty(const wxString &fullName) const
+Property *StackLevel::FindProperty(const wxString &fullName) const {
+	PropertyHash::const_iterator i = names.find(fullName);
+	return (i != names.end() ? i->second : NULL);
+}
+// }}}
+// {{{ const StackLevel::ContextMap &StackLevel::GetContexts() const throw (EngineError, SocketError)
+const StackLevel::ContextMap &StackLevel::GetContexts() const throw (EngineError, SocketError) {
+	if (!contextsRetrieved) {
+		GetEngineContexts();
+	}
+	return contexts;
+}
+// }}}
+// {{{ void StackLevel::RetrieveProperties() const throw (EngineError, MalformedDocumentError, SocketError)
+void StackLevel::RetrieveProperties() const throw (EngineError, MalformedDocumentError, SocketError) {
+	typedef std::map<TransactionID, std::pair<Context *, PropertyBuilder *> > PendingMap;
+	PendingMap pending;
+
+	GetContexts();
+
+	/* Send every context_get before waiting on any of them, so the
+	 * whole frame costs one round trip instead of one per context. The
+	 * properties are built straight from each response as it arrives. */
+	try {
+		for (ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
+			Context *context = i->second;
+
+			if (!context->HasProperties()) {
+				MessageArguments args(2, wxT("-d"), IntToString(level).c_str(), wxT("-c"), context->GetID().c_str());
+				PropertyBuilder *builder = new PropertyBuilder(conn, context, level, context->properties, &context->order);
+				TransactionID id;
+
+				try {
+					id = conn->SendCommandAsync(wxT("context_get"), args, NULL, NULL, 0, builder);
+				}
+				catch (...) {
+					delete builder;
+					throw;
+				}
+				pending[id] = std::make_pair(context, builder);
+			}
+		}
+	}
+	catch (...) {
+		for (PendingMap::iterator i = pending.begin(); i != pending.end(); i++) {
+			conn->ForgetStream(i->first);
+			delete i->second.second;
+		}
+		throw;
+	}
+
+	PendingMap::iterator i = pending.begin();
+	try {
+		for (; i != pending.end(); i++) {
+			conn->WaitForResponse(i->first);
+			i->second.first->propertiesRetrieved = true;
+		}
+	}
+	catch (...) {
+		// Collect the remaining responses so they don't linger.
+		for (i++; i != pending.end(); i++) {
+			try {
+				conn->WaitForResponse(i->first);
+			}
+			catch (...) {}
+		}
+
+		for (i = pending.begin(); i != pending.end(); i++) {
+			delete i->second.second;
+		}
+
+		try {
+			throw;
+		}
+		catch (NotFoundError e) {
+			throw MalformedDocumentError(e.GetMessage());
+		}
+	}
+
+	for (i = pending.begin(); i != pending.end(); i++) {
+		delete i->second.second;
+	}
+}
+// }}}
+
 // {{{ StackLevel::Type StackLevel::StringToType(const wxString &s)
 StackLevel::Type StackLevel::StringToType(const wxString &s) {
 	if (s == wxT("file")) {
@@ -73,18 +175,22 @@ wxString StackLevel::TypeToString(StackLevel::Type type) {
 }
 // }}}
 
-// {{{ void StackLevel::GetEngineContexts() throw (EngineError, SocketError)
-void StackLevel::GetEngineContexts() throw (EngineError, SocketError) {
+// {{{ void StackLevel::GetEngineContexts() const throw (EngineError, SocketError)
+void StackLevel::GetEngineContexts() const throw (EngineError, SocketError) {
 	wxXmlDocument doc(conn->SendCommandWait(wxT("context_names"), MessageArguments().Append(wxT("-d"), IntToString(level))));
 
+	for (ContextMap::iterator i = contexts.begin(); i != contexts.end(); i++) {
+		delete i->second;
+	}
 	contexts.clear();
 
 	for (wxXmlNode *node = doc.GetRoot()->GetChildren(); node != NULL; node = node->GetNext()) {
 		if (node->GetType() == wxXML_ELEMENT_NODE && node->GetName() == wxT("context")) {
 			wxString id(node->GetPropVal(wxT("id"), wxEmptyString));
-			contexts[id] = new Context(conn, this, id, node->GetPropVal(wxT("name"), wxEmptyString));
+			contexts[id] = new Context(conn, const_cast<StackLevel *>(this), id, node->GetPropVal(wxT("name"), wxEmptyString));
 		}
 	}
+	contextsRetrieved = true;
 }
 // }}}
 // {{{ void StackLevel::GetStack() throw (EngineError, MalformedDocumentError, NotFoundError, SocketError)
@@ -116,6 +222,43 @@ void StackLevel::GetStack() throw (EngineError, MalformedDocumentError, NotFound
 		throw MalformedDocumentError(wxT("Invalid stack_get response."));
 	}
 
+	ParseStackElement(stack);
+}
+// }}}
+// {{{ void StackLevel::IndexProperty(Property *prop) const
+void StackLevel::IndexProperty(Property *prop) const {
+	wxString fullName(prop->GetFullName());
+
+	if (fullName.IsEmpty()) {
+		return;
+	}
+
+	/* Where two contexts have a property with the same full name, the
+	 * first context wins, so locals shadow globals as they do when the
+	 * script runs. */
+	PropertyHash::iterator i = names.find(fullName);
+	if (i != names.end() && i->second != prop) {
+		const Context *existing = i->second->GetContext();
+		const Context *context = prop->GetContext();
+
+		if (existing && context && existing != context && existing->GetID() < context->GetID()) {
+			return;
+		}
+	}
+
+	names[fullName] = prop;
+	prop->indexed = true;
+}
+// }}}
+// {{{ void StackLevel::ParseStackElement(wxXmlNode *stack) throw (MalformedDocumentError)
+void StackLevel::ParseStackElement(wxXmlNode *stack) throw (MalformedDocumentError) {
+	wxString levelAttr;
+
+	if (!stack->GetPropVal(wxT("level"), &levelAttr)) {
+		throw MalformedDocumentError(wxT("Stack element is missing its level."));
+	}
+
+	level = StringToInt(levelAttr);
 	type = StringToType(stack->GetPropVal(wxT("type"), wxT("file")));
 	fileName = stack->GetPropVal(wxT("filename"), wxEmptyString);
 	lineNo = StringToInt(stack->GetPropVal(wxT("lineno"), wxT("0")));
@@ -124,5 +267,20 @@ void StackLevel::GetStack() throw (EngineError, MalformedDocumentError, NotFound
 	cmdEnd = Location(stack->GetPropVal(wxT("cmdend"), wxEmptyString));
 }
 // }}}
+// {{{ void StackLevel::UnindexProperty(Property *prop) const
+void StackLevel::UnindexProperty(Property *prop) const {
+	prop->indexed = false;
+
+	if (names.empty()) {
+		return;
+	}
+
+	// A newer property may have taken the name over already.
+	PropertyHash::iterator i = names.find(prop->GetFullName());
+	if (i != names.end() && i->second == prop) {
+		names.erase(i);
+	}
+}
+// }}}
 
 // vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -35,6 +35,7 @@
 #include <map>
 
 #include <wx/string.h>
+#include <wx/xml/xml.h>
 
 #include "DBGp/Context.h"
 #include "DBGp/Error/Error.h"
@@ -45,6 +46,11 @@ namespace DBGp {
 	class Connection;
 
 	class StackLevel {
+		/* Properties add themselves to the index as they're built,
+		 * and remove themselves when they go away. */
+		friend class Property;
+		friend class PropertyBuilder;
+
 		public:
 			typedef enum {
 				FILE,
@@ -54,17 +60,28 @@ namespace DBGp {
 			typedef std::map<wxString, Context *> ContextMap;
 
 			StackLevel(Connection *conn, unsigned int level) throw (EngineError, MalformedDocumentError, NotFoundError, SocketError);
+			StackLevel(Connection *conn, wxXmlNode *stack) throw (MalformedDocumentError);
 			StackLevel(const StackLevel &level);
 			virtual ~StackLevel();
+
+			/* FindProperty() resolves a full name, such as
+			 * $this->foo['bar'], against every property retrieved so
+			 * far in any of the frame's contexts, including children
+			 * paged in later, without walking the trees or going back
+			 * to the engine. It returns NULL for anything that hasn't
+			 * been retrieved. */
+			Property *FindProperty(const wxString &fullName) const;
 			
 			inline Location GetCmdBegin() const { return cmdBegin; }
 			inline Location GetCmdEnd() const { return cmdEnd; }
-			inline const ContextMap &GetContexts() const { return contexts; }
+			const ContextMap &GetContexts() const throw (EngineError, SocketError);
 			inline wxString GetFileName() const { return fileName; }
 			inline unsigned int GetLevel() const { return level; }
 			inline unsigned int GetLineNo() const { return lineNo; }
 			inline Type GetType() const { return type; }
 			inline wxString GetWhere() const { return where; }
+			inline bool HasContexts() const { return contextsRetrieved; }
+			void RetrieveProperties() const throw (EngineError, MalformedDocumentError, SocketError);
 
 			static Type StringToType(const wxString &s);
 			static wxString TypeToString(Type type);
@@ -73,15 +90,20 @@ namespace DBGp {
 			Location cmdBegin;
 			Location cmdEnd;
 			Connection *conn;
-			ContextMap contexts;
+			mutable ContextMap contexts;
+			mutable bool contextsRetrieved;
 			wxString fileName;
 			unsigned int level;
 			unsigned int lineNo;
+			mutable PropertyHash names;
 			Type type;
 			wxString where;
 
-			void GetEngineContexts() throw (EngineError, SocketError);
+			void GetEngineContexts() const throw (EngineError, SocketError);
 			void GetStack() throw (EngineError, MalformedDocumentError, NotFoundError, SocketError);
+			void IndexProperty(Property *prop) const;
+			void ParseStackElement(wxXmlNode *stack) throw (MalformedDocumentError);
+			void UnindexProperty(Property *prop) const;
 	};
 }
 
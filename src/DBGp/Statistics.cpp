@@ -0,0 +1,201 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Statistics.h"
+#include "DBGp/Utility.h"
+
+#include <climits>
+
+#include <wx/file.h>
+
+using namespace DBGp;
+
+// {{{ static wxString FormatCount(wxUint64 value)
+static wxString FormatCount(wxUint64 value) {
+	return wxString::Format(wxT("%") wxLongLongFmtSpec wxT("u"), value);
+}
+// }}}
+// {{{ static wxString FormatLine(const wxString &name, const Statistics::Command &command)
+static wxString FormatLine(const wxString &name, const Statistics::Command &command) {
+	return wxString::Format(wxT("%-20s %8s %8s %12s %12s %24s %24s %24s %24s\n"),
+		name.c_str(),
+		FormatCount(command.sent).c_str(),
+		FormatCount(command.received).c_str(),
+		FormatCount(command.bytesSent).c_str(),
+		FormatCount(command.bytesReceived).c_str(),
+		Statistics::Summarise(command.firstByte).c_str(),
+		Statistics::Summarise(command.response).c_str(),
+		Statistics::Summarise(command.parse).c_str(),
+		Statistics::Summarise(command.decode).c_str());
+}
+// }}}
+
+// {{{ Statistics::Command::Command()
+Statistics::Command::Command() : bytesReceived(0), bytesSent(0), received(0), sent(0) {
+}
+// }}}
+// {{{ void Statistics::Command::Merge(const Command &other)
+void Statistics::Command::Merge(const Command &other) {
+	bytesReceived += other.bytesReceived;
+	bytesSent += other.bytesSent;
+	decode.Merge(other.decode);
+	firstByte.Merge(other.firstByte);
+	parse.Merge(other.parse);
+	received += other.received;
+	response.Merge(other.response);
+	sent += other.sent;
+}
+// }}}
+
+// {{{ Statistics::Statistics()
+Statistics::Statistics() {
+}
+// }}}
+
+// {{{ bool Statistics::Dump(const wxString &file) const
+bool Statistics::Dump(const wxString &file) const {
+	wxFile f;
+
+	if (!f.Create(file, true)) {
+		return false;
+	}
+	return f.Write(Format(), wxConvUTF8) && f.Close();
+}
+// }}}
+// {{{ void Statistics::Forget(const void *session)
+void Statistics::Forget(const void *session) {
+	wxMutexLocker lock(mutex);
+	pending.erase(pending.lower_bound(PendingKey(session, 0)), pending.upper_bound(PendingKey(session, ULONG_MAX)));
+}
+// }}}
+// {{{ wxString Statistics::Format() const
+wxString Statistics::Format() const {
+	CommandMap snapshot(GetCommands());
+	Command totals;
+	wxString s;
+
+	s << wxString::Format(wxT("%-20s %8s %8s %12s %12s %24s %24s %24s %24s\n"),
+		wxT("command"), wxT("sent"), wxT("received"), wxT("bytes out"), wxT("bytes in"),
+		wxT("first byte us p50/p99/max"), wxT("response us p50/p99/max"),
+		wxT("parse us p50/p99/max"), wxT("decode us p50/p99/max"));
+
+	for (CommandMap::const_iterator i = snapshot.begin(); i != snapshot.end(); i++) {
+		s << FormatLine(i->first, i->second);
+		totals.Merge(i->second);
+	}
+
+	s << FormatLine(wxT("(total)"), totals);
+	return s;
+}
+// }}}
+// {{{ Statistics::CommandMap Statistics::GetCommands() const
+Statistics::CommandMap Statistics::GetCommands() const {
+	wxMutexLocker lock(mutex);
+	return commands;
+}
+// }}}
+// {{{ Statistics::Command Statistics::GetTotals() const
+Statistics::Command Statistics::GetTotals() const {
+	wxMutexLocker lock(mutex);
+	Command totals;
+
+	for (CommandMap::const_iterator i = commands.begin(); i != commands.end(); i++) {
+		totals.Merge(i->second);
+	}
+	return totals;
+}
+// }}}
+// {{{ void Statistics::RecordReceived(const wxString &name, size_t bytes, const Timing &timing)
+void Statistics::RecordReceived(const wxString &name, size_t bytes, const Timing &timing) {
+	wxMutexLocker lock(mutex);
+	Record(commands[name], bytes, timing);
+}
+// }}}
+// {{{ void Statistics::RecordResponse(const void *session, const wxString &command, unsigned long id, size_t bytes, const Timing &timing)
+void Statistics::RecordResponse(const void *session, const wxString &command, unsigned long id, size_t bytes, const Timing &timing) {
+	wxMutexLocker lock(mutex);
+	Command &figures = commands[command];
+	PendingMap::iterator i = pending.find(PendingKey(session, id));
+
+	Record(figures, bytes, timing);
+
+	if (i != pending.end()) {
+		wxUint64 sent = i->second;
+
+		pending.erase(i);
+
+		// Responses read without timing information only get counted.
+		if (timing.firstByte > 0) {
+			figures.firstByte.Record(timing.firstByte > sent ? timing.firstByte - sent : 0);
+		}
+		if (timing.lastByte > 0) {
+			figures.response.Record(timing.lastByte > sent ? timing.lastByte - sent : 0);
+		}
+	}
+}
+// }}}
+// {{{ void Statistics::RecordSent(const void *session, const wxString &command, unsigned long id, size_t bytes)
+void Statistics::RecordSent(const void *session, const wxString &command, unsigned long id, size_t bytes) {
+	wxUint64 now = GetMicroseconds();
+	wxMutexLocker lock(mutex);
+	Command &figures = commands[command];
+
+	figures.bytesSent += bytes;
+	figures.sent++;
+	pending[PendingKey(session, id)] = now;
+}
+// }}}
+// {{{ void Statistics::Reset()
+void Statistics::Reset() {
+	wxMutexLocker lock(mutex);
+	commands.clear();
+	pending.clear();
+}
+// }}}
+// {{{ wxString Statistics::Summarise(const Histogram &histogram)
+wxString Statistics::Summarise(const Histogram &histogram) {
+	if (histogram.GetCount() == 0) {
+		return wxT("-");
+	}
+	return FormatCount(histogram.GetPercentile(50.0)) + wxT("/") + FormatCount(histogram.GetPercentile(99.0)) + wxT("/") + FormatCount(histogram.GetMax());
+}
+// }}}
+
+// {{{ void Statistics::Record(Command &command, size_t bytes, const Timing &timing)
+void Statistics::Record(Command &command, size_t bytes, const Timing &timing) {
+	command.bytesReceived += bytes;
+	command.decode.Record(timing.decode);
+	command.parse.Record(timing.parse);
+	command.received++;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,266 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_STATISTICS_H
+#define DBGP_STATISTICS_H
+
+#include <map>
+#include <utility>
+
+#include <wx/string.h>
+#include <wx/thread.h>
+
+#include "DBGp/Histogram.h"
+
+namespace DBGp {
+	/**
+	 * Per-command traffic and latency figures for a session, or any
+	 * number of sessions. For each command name, this keeps the number
+	 * of commands sent and messages received, the bytes each way, and
+	 * histograms of:
+	 *
+	 * - the time from a command being sent to the first byte of its
+	 *   response arriving;
+	 * - the time from a command being sent to the last byte of its
+	 *   response arriving;
+	 * - the time taken to parse each message, including any Base64
+	 *   decoding; and
+	 * - the time spent decoding Base64 content alone.
+	 *
+	 * Messages that aren't responses, such as init packets and stream
+	 * output, are counted under their element name.
+	 *
+	 * One statistics object can be shared by any number of sessions:
+	 * commands and responses are matched up by the session they came
+	 * from as well as their transaction ID.
+	 *
+	 * All times are in microseconds. Statistics objects may be updated
+	 * and read from any thread.
+	 */
+	class Statistics {
+		public:
+			/** The figures kept for a single command. */
+			class Command {
+				public:
+					/** Constructs an empty set of figures. */
+					Command();
+
+					/**
+					 * Adds the figures for another command to
+					 * these.
+					 *
+					 * @param[in] other The figures to add.
+					 */
+					void Merge(const Command &other);
+
+					/** The bytes received in messages. */
+					wxUint64 bytesReceived;
+
+					/** The bytes sent in commands. */
+					wxUint64 bytesSent;
+
+					/** Base64 decoding time per message. */
+					Histogram decode;
+
+					/** Time to the first byte of responses. */
+					Histogram firstByte;
+
+					/** Parse time per message. */
+					Histogram parse;
+
+					/** The number of messages received. */
+					wxUint64 received;
+
+					/** Time to the last byte of responses. */
+					Histogram response;
+
+					/** The number of commands sent. */
+					wxUint64 sent;
+			};
+
+			/** Figures for each command, keyed by name. */
+			typedef std::map<wxString, Command> CommandMap;
+
+			/** The times recorded for a single message. */
+			class Timing {
+				public:
+					/** Constructs an empty timing. */
+					inline Timing() : decode(0), firstByte(0), lastByte(0), parse(0) {}
+
+					/** The time spent decoding Base64. */
+					wxUint64 decode;
+
+					/**
+					 * When the first byte of the message was
+					 * read, as returned by GetMicroseconds(),
+					 * or 0 if unknown.
+					 */
+					wxUint64 firstByte;
+
+					/**
+					 * When the last byte of the message was
+					 * read, or 0 if unknown.
+					 */
+					wxUint64 lastByte;
+
+					/** The time spent parsing the message. */
+					wxUint64 parse;
+			};
+
+			/** Constructs an empty statistics object. */
+			Statistics();
+
+			/**
+			 * Writes the output of Format() to a file, replacing
+			 * anything already in it.
+			 *
+			 * @param[in] file The file name.
+			 * @return True if the file was written.
+			 */
+			bool Dump(const wxString &file) const;
+
+			/**
+			 * Forgets the commands a session has sent that haven't
+			 * been answered. This should be called when a session
+			 * sharing the statistics closes.
+			 *
+			 * @param[in] session The session.
+			 */
+			void Forget(const void *session);
+
+			/**
+			 * Formats the statistics as a plain text table, one
+			 * line per command, followed by the totals.
+			 *
+			 * @return The table.
+			 */
+			wxString Format() const;
+
+			/**
+			 * Returns a snapshot of the figures for each command.
+			 *
+			 * @return The figures.
+			 */
+			CommandMap GetCommands() const;
+
+			/**
+			 * Returns the figures for every command combined.
+			 *
+			 * @return The totals.
+			 */
+			Command GetTotals() const;
+
+			/**
+			 * Records a message that isn't a response to a
+			 * command.
+			 *
+			 * @param[in] name The name of the message.
+			 * @param[in] bytes The length of the message.
+			 * @param[in] timing When the message arrived and how
+			 * long it took to handle.
+			 */
+			void RecordReceived(const wxString &name, size_t bytes, const Timing &timing);
+
+			/**
+			 * Records a response to a command. If the command was
+			 * recorded with RecordSent(), the response latency is
+			 * recorded as well.
+			 *
+			 * @param[in] session The session the response arrived
+			 * on.
+			 * @param[in] command The command responded to.
+			 * @param[in] id The transaction ID of the response.
+			 * @param[in] bytes The length of the response.
+			 * @param[in] timing When the response arrived and how
+			 * long it took to handle.
+			 */
+			void RecordResponse(const void *session, const wxString &command, unsigned long id, size_t bytes, const Timing &timing);
+
+			/**
+			 * Records a command that's about to be sent. This
+			 * should be called before the command is written, so
+			 * that the response can't beat it here.
+			 *
+			 * @param[in] session The session sending the command.
+			 * @param[in] command The command name.
+			 * @param[in] id The transaction ID of the command.
+			 * @param[in] bytes The length of the command.
+			 */
+			void RecordSent(const void *session, const wxString &command, unsigned long id, size_t bytes);
+
+			/** Discards everything recorded so far. */
+			void Reset();
+
+			/**
+			 * Summarises a histogram as its median, 99th
+			 * percentile and maximum, separated by slashes.
+			 *
+			 * @param[in] histogram The histogram.
+			 * @return The summary, or "-" if the histogram is
+			 * empty.
+			 */
+			static wxString Summarise(const Histogram &histogram);
+
+		protected:
+			/** Identifies a command by session and transaction. */
+			typedef std::pair<const void *, unsigned long> PendingKey;
+
+			/** Send times of unanswered commands. */
+			typedef std::map<PendingKey, wxUint64> PendingMap;
+
+			/** The figures for each command. */
+			CommandMap commands;
+
+			/** The mutex protecting everything else. */
+			mutable wxMutex mutex;
+
+			/** When each unanswered command was sent. */
+			PendingMap pending;
+
+			/**
+			 * Records a received message. The mutex must be held.
+			 *
+			 * @param[in] command The figures to add to.
+			 * @param[in] bytes The length of the message.
+			 * @param[in] timing The message timing.
+			 */
+			static void Record(Command &command, size_t bytes, const Timing &timing);
+
+		private:
+			/** Statistics hold a mutex, so can't be copied. */
+			Statistics(const Statistics &);
+			Statistics &operator=(const Statistics &);
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,250 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Tracer.h"
+#include "DBGp/SPSCQueue.h"
+
+#include <vector>
+
+#ifdef __UNIX__
+#include <pthread.h>
+#endif
+
+#include <wx/file.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+#if defined(_MSC_VER)
+#define DBGP_THREAD_LOCAL __declspec(thread)
+#else
+#define DBGP_THREAD_LOCAL __thread
+#endif
+
+using namespace DBGp;
+
+/* A single recorded span. */
+struct TraceEvent {
+	const char *category;
+	const char *name;
+	wxUint64 start;
+	wxUint64 duration;
+};
+
+/* The events recorded by one thread. Only the owning thread writes events
+ * or advances the head; everything else happens under the tracer mutex. */
+struct TraceBuffer {
+	std::vector<TraceEvent> events;
+	volatile unsigned long generation;
+	volatile size_t head;
+	bool main;
+	bool orphaned;
+	unsigned long tid;
+};
+
+typedef std::vector<TraceBuffer *> TraceBufferList;
+
+/* Tracer state. The generation is bumped by each call to Start(), which
+ * tells threads to reset their buffers before recording anything new. */
+static TraceBufferList buffers;
+static size_t traceCapacity = Tracer::DEFAULT_CAPACITY;
+static wxString traceFile;
+static volatile unsigned long generation = 0;
+static wxMutex mutex;
+static unsigned long nextTID = 1;
+
+static DBGP_THREAD_LOCAL TraceBuffer *current = NULL;
+
+#ifdef __UNIX__
+/* Thread exit isn't otherwise visible with __thread, so a key with a
+ * destructor is used to find buffers that can be freed after the next
+ * trace is written. */
+static pthread_key_t exitKey;
+static pthread_once_t exitKeyOnce = PTHREAD_ONCE_INIT;
+
+// {{{ static void OnThreadExit(void *data)
+static void OnThreadExit(void *data) {
+	wxMutexLocker lock(mutex);
+	static_cast<TraceBuffer *>(data)->orphaned = true;
+}
+// }}}
+// {{{ static void CreateExitKey()
+static void CreateExitKey() {
+	pthread_key_create(&exitKey, OnThreadExit);
+}
+// }}}
+#endif
+
+volatile bool Tracer::enabled = false;
+
+// {{{ static TraceBuffer *Attach()
+/* Returns the calling thread's buffer for the current generation, creating
+ * or resetting it as needed. */
+static TraceBuffer *Attach() {
+	wxMutexLocker lock(mutex);
+	TraceBuffer *buffer = current;
+
+	if (!Tracer::IsEnabled()) {
+		return NULL;
+	}
+
+	if (!buffer) {
+		buffer = new TraceBuffer;
+		buffer->main = wxThread::IsMain();
+		buffer->orphaned = false;
+		buffer->tid = nextTID++;
+		buffers.push_back(buffer);
+		current = buffer;
+
+#ifdef __UNIX__
+		pthread_once(&exitKeyOnce, CreateExitKey);
+		pthread_setspecific(exitKey, buffer);
+#endif
+	}
+
+	if (buffer->events.size() != traceCapacity) {
+		std::vector<TraceEvent>(traceCapacity).swap(buffer->events);
+	}
+	buffer->head = 0;
+	buffer->generation = generation;
+
+	return buffer;
+}
+// }}}
+// {{{ static wxString FormatNumber(wxUint64 value)
+static wxString FormatNumber(wxUint64 value) {
+	return wxString::Format(wxT("%") wxLongLongFmtSpec wxT("u"), value);
+}
+// }}}
+
+// {{{ void Tracer::Record(const char *category, const char *name, wxUint64 start, wxUint64 end)
+void Tracer::Record(const char *category, const char *name, wxUint64 start, wxUint64 end) {
+	TraceBuffer *buffer = current;
+
+	if (!enabled) {
+		return;
+	}
+
+	if (!buffer || buffer->generation != generation) {
+		if ((buffer = Attach()) == NULL) {
+			return;
+		}
+	}
+
+	size_t head = buffer->head;
+	TraceEvent &event = buffer->events[head % buffer->events.size()];
+
+	event.category = category;
+	event.name = name;
+	event.start = start;
+	event.duration = (end > start) ? end - start : 0;
+
+	// The reader mustn't see the new head before the event itself.
+	DBGP_MEMORY_BARRIER();
+	buffer->head = head + 1;
+}
+// }}}
+// {{{ void Tracer::Start(const wxString &file, size_t capacity)
+void Tracer::Start(const wxString &file, size_t capacity) {
+	wxMutexLocker lock(mutex);
+
+	traceFile = file;
+	traceCapacity = (capacity > 0) ? capacity : 1;
+	generation++;
+
+	DBGP_MEMORY_BARRIER();
+	enabled = true;
+}
+// }}}
+// {{{ bool Tracer::Stop()
+bool Tracer::Stop() {
+	wxMutexLocker lock(mutex);
+	wxString pid(FormatNumber(wxGetProcessId()));
+	wxString json(wxT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+	bool first = true;
+
+	if (!enabled) {
+		return false;
+	}
+	enabled = false;
+	DBGP_MEMORY_BARRIER();
+
+	for (TraceBufferList::iterator i = buffers.begin(); i != buffers.end(); i++) {
+		TraceBuffer *buffer = *i;
+		wxString tid(FormatNumber(buffer->tid));
+
+		if (buffer->generation != generation) {
+			continue;
+		}
+
+		/* A thread that had already passed the enabled check may
+		 * still be writing slot head % size, which holds the oldest
+		 * event once the buffer has filled, so only events that can't
+		 * have been touched since the head was read are kept. */
+		size_t head = buffer->head;
+		size_t size = buffer->events.size();
+		size_t begin = (head >= size) ? head - size + 1 : 0;
+		DBGP_MEMORY_BARRIER();
+
+		json << (first ? wxT("") : wxT(",")) << wxT("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":") << pid << wxT(",\"tid\":") << tid << wxT(",\"args\":{\"name\":\"") << (buffer->main ? wxString(wxT("main")) : wxT("thread ") + tid) << wxT("\"}}");
+		first = false;
+
+		for (size_t j = begin; j < head; j++) {
+			const TraceEvent &event = buffer->events[j % size];
+
+			json << wxT(",{\"name\":\"") << wxString(event.name, wxConvUTF8)
+				<< wxT("\",\"cat\":\"") << wxString(event.category, wxConvUTF8)
+				<< wxT("\",\"ph\":\"X\",\"ts\":") << FormatNumber(event.start)
+				<< wxT(",\"dur\":") << FormatNumber(event.duration)
+				<< wxT(",\"pid\":") << pid << wxT(",\"tid\":") << tid << wxT("}");
+		}
+	}
+	json << wxT("]}\n");
+
+	// Buffers belonging to threads that have since exited can go now.
+	for (TraceBufferList::iterator i = buffers.begin(); i != buffers.end(); ) {
+		if ((*i)->orphaned) {
+			delete *i;
+			i = buffers.erase(i);
+		}
+		else {
+			i++;
+		}
+	}
+
+	wxFile f;
+	if (!f.Create(traceFile, true)) {
+		return false;
+	}
+	return f.Write(json, wxConvUTF8) && f.Close();
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
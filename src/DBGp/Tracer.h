@@ -0,0 +1,167 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_TRACER_H
+#define DBGP_TRACER_H
+
+#include <cstddef>
+
+#include <wx/string.h>
+
+#include "DBGp/Utility.h"
+
+namespace DBGp {
+	/**
+	 * An opt-in tracer that records how long each stage of handling a
+	 * message takes, and writes the result out in the Chrome Trace Event
+	 * format, which can be loaded directly into Perfetto or
+	 * chrome://tracing.
+	 *
+	 * Each thread records into its own fixed size ring buffer, so
+	 * recording an event takes no locks: only the thread that owns a
+	 * buffer ever writes to it, and it publishes each event with a
+	 * memory barrier. When a buffer fills, the oldest events are
+	 * overwritten.
+	 *
+	 * Spans are normally recorded with the DBGP_TRACE macro, which only
+	 * does anything if the library was built with DBGP_TRACING defined
+	 * (TRACE=1 on the SCons command line). Without that, tracing compiles
+	 * away entirely; with it, each span costs a single flag check until
+	 * Start() is called.
+	 */
+	class Tracer {
+		public:
+			/** The default number of events kept per thread. */
+			static const size_t DEFAULT_CAPACITY = 65536;
+
+			/**
+			 * Checks if the tracer is currently recording.
+			 *
+			 * @return True if events are being recorded.
+			 */
+			static inline bool IsEnabled() { return enabled; }
+
+			/**
+			 * Records a complete span. The name and category must be
+			 * string literals (or otherwise outlive the trace), and
+			 * must not need escaping in JSON.
+			 *
+			 * @param[in] category The category of the span.
+			 * @param[in] name The name of the span.
+			 * @param[in] start When the span began, as returned by
+			 * GetMicroseconds().
+			 * @param[in] end When the span ended.
+			 */
+			static void Record(const char *category, const char *name, wxUint64 start, wxUint64 end);
+
+			/**
+			 * Starts recording, discarding any events recorded by
+			 * an earlier trace.
+			 *
+			 * @param[in] file The file the trace will be written to
+			 * when Stop() is called.
+			 * @param[in] capacity The number of events to keep for
+			 * each thread.
+			 */
+			static void Start(const wxString &file, size_t capacity = DEFAULT_CAPACITY);
+
+			/**
+			 * Stops recording and writes the trace to the file given
+			 * to Start(). Threads that are still recording when this
+			 * is called may have their last event or two omitted.
+			 *
+			 * @return True if the trace was written.
+			 */
+			static bool Stop();
+
+		protected:
+			/** Whether events are currently being recorded. */
+			static volatile bool enabled;
+	};
+
+	/**
+	 * Records a span covering the lifetime of the object. Use the
+	 * DBGP_TRACE macro rather than instantiating this directly.
+	 */
+	class TraceScope {
+		public:
+			/**
+			 * Begins a span, provided the tracer is recording.
+			 *
+			 * @param[in] category The category of the span.
+			 * @param[in] name The name of the span.
+			 */
+			inline TraceScope(const char *category, const char *name) : category(category), name(name), start(Tracer::IsEnabled() ? GetMicroseconds() : 0) {}
+
+			/** Ends the span. */
+			inline ~TraceScope() {
+				if (start) {
+					Tracer::Record(category, name, start, GetMicroseconds());
+				}
+			}
+
+		protected:
+			/** The category of the span. */
+			const char *category;
+
+			/** The name of the span. */
+			const char *name;
+
+			/** When the span began, or 0 if it isn't recorded. */
+			wxUint64 start;
+
+		private:
+			/** Spans can't be copied. */
+			TraceScope(const TraceScope &);
+
+			/** Nor assigned. */
+			TraceScope &operator=(const TraceScope &);
+	};
+}
+
+#define DBGP_TRACE_JOIN2(a, b) a##b
+#define DBGP_TRACE_JOIN(a, b) DBGP_TRACE_JOIN2(a, b)
+
+#ifdef DBGP_TRACING
+/**
+ * Records a span from this point to the end of the enclosing scope.
+ *
+ * @param[in] category The category of the span: a string literal.
+ * @param[in] name The name of the span: a string literal.
+ */
+#define DBGP_TRACE(category, name) DBGp::TraceScope DBGP_TRACE_JOIN(dbgpTraceScope, __LINE__)(category, name)
+#else
+#define DBGP_TRACE(category, name)
+#endif
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,252 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Transport.h"
+
+#ifdef __WXMSW__
+#include <winsock.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <wx/log.h>
+
+using namespace DBGp;
+
+// {{{ Transport::Transport(wxUint16 port)
+Transport::Transport(wxUint16 port) : family(TCP), noDelay(true), port(port), quickAck(true), receiveBufferSize(0), sendBufferSize(0) {
+}
+// }}}
+
+// {{{ Transport Transport::FromURI(const wxString &uri) throw (Error)
+Transport Transport::FromURI(const wxString &uri) throw (Error) {
+	Transport transport;
+	wxString rest;
+	unsigned long port;
+
+	if (uri.StartsWith(wxT("unix://"), &rest)) {
+		if (rest.IsEmpty()) {
+			throw Error(wxT("A Unix domain socket URI needs a path."));
+		}
+		transport.SetPath(rest);
+		return transport;
+	}
+	else if (!uri.StartsWith(wxT("tcp://"), &rest)) {
+		if (uri.Find(wxT("://")) != wxNOT_FOUND) {
+			throw Error(wxT("Unsupported transport: ") + uri);
+		}
+		rest = uri;
+	}
+
+	// IPv6 isn't supported, so the port follows the last colon.
+	wxString portString(rest.AfterLast(wxT(':')));
+	if (!portString.ToULong(&port) || port > 65535) {
+		throw Error(wxT("Invalid port in transport URI: ") + uri);
+	}
+
+	if (portString.Len() < rest.Len()) {
+		transport.SetHost(rest.BeforeLast(wxT(':')));
+	}
+	transport.SetPort(static_cast<wxUint16>(port));
+	return transport;
+}
+// }}}
+
+// {{{ void Transport::Configure(wxSocketBase *socket) const
+void Transport::Configure(wxSocketBase *socket) const {
+	int value = 1;
+
+	if (family == TCP && noDelay && !socket->SetOption(IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value))) {
+		wxLogDebug(wxT("Unable to set TCP_NODELAY."));
+	}
+	RestoreQuickAck(socket);
+
+	if (receiveBufferSize > 0 && !socket->SetOption(SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize))) {
+		wxLogDebug(wxT("Unable to set the receive buffer size to %d."), receiveBufferSize);
+	}
+
+	if (sendBufferSize > 0 && !socket->SetOption(SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize))) {
+		wxLogDebug(wxT("Unable to set the send buffer size to %d."), sendBufferSize);
+	}
+}
+// }}}
+#ifndef __WXMSW__
+// {{{ void Transport::Configure(int fd) const
+void Transport::Configure(int fd) const {
+	int value = 1;
+
+	if (family == TCP && noDelay && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value)) == -1) {
+		wxLogDebug(wxT("Unable to set TCP_NODELAY."));
+	}
+	RestoreQuickAck(fd);
+
+	if (receiveBufferSize > 0 && setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBufferSize, sizeof(receiveBufferSize)) == -1) {
+		wxLogDebug(wxT("Unable to set the receive buffer size to %d."), receiveBufferSize);
+	}
+
+	if (sendBufferSize > 0 && setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) == -1) {
+		wxLogDebug(wxT("Unable to set the send buffer size to %d."), sendBufferSize);
+	}
+}
+// }}}
+// {{{ int Transport::Connect() const throw (SocketError)
+int Transport::Connect() const throw (SocketError) {
+	int fd;
+
+	if (family == UNIX) {
+		struct sockaddr_un addr;
+		wxCharBuffer file(path.mb_str(wxConvFile));
+
+		if (std::strlen(file.data()) >= sizeof(addr.sun_path)) {
+			throw SocketError(wxT("The socket path ") + path + wxT(" is too long."));
+		}
+
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		std::strcpy(addr.sun_path, file.data());
+
+		if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+			throw SocketError(wxT("socket: ") + wxString(wxSysErrorMsg(errno)));
+		}
+		if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == -1) {
+			wxString error(wxSysErrorMsg(errno));
+			close(fd);
+			throw SocketError(wxT("Unable to connect to ") + GetURI() + wxT(": ") + error);
+		}
+	}
+	else {
+		struct addrinfo hints, *result;
+		char service[8];
+
+		std::memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_INET;
+		hints.ai_socktype = SOCK_STREAM;
+		std::sprintf(service, "%hu", port);
+
+		if (getaddrinfo(host.IsEmpty() ? "127.0.0.1" : static_cast<const char *>(host.mb_str()), service, &hints, &result) != 0) {
+			throw SocketError(wxT("Unable to resolve ") + host + wxT("."));
+		}
+
+		if ((fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol)) == -1) {
+			freeaddrinfo(result);
+			throw SocketError(wxT("socket: ") + wxString(wxSysErrorMsg(errno)));
+		}
+		if (connect(fd, result->ai_addr, result->ai_addrlen) == -1) {
+			wxString error(wxSysErrorMsg(errno));
+			freeaddrinfo(result);
+			close(fd);
+			throw SocketError(wxT("Unable to connect to ") + GetURI() + wxT(": ") + error);
+		}
+		freeaddrinfo(result);
+	}
+
+	Configure(fd);
+	return fd;
+}
+// }}}
+#endif
+// {{{ wxSockAddress *Transport::CreateAddress() const throw (SocketError)
+wxSockAddress *Transport::CreateAddress() const throw (SocketError) {
+	if (family == UNIX) {
+#ifdef __UNIX__
+		wxUNIXaddress *addr = new wxUNIXaddress;
+
+		addr->Filename(path);
+		return addr;
+#else
+		throw SocketError(wxT("Unix domain sockets aren't supported on this platform."));
+#endif
+	}
+
+	wxIPV4address *addr = new wxIPV4address;
+
+	if (host.IsEmpty()) {
+		addr->AnyAddress();
+	}
+	else if (!addr->Hostname(host)) {
+		delete addr;
+		throw SocketError(wxT("Unable to resolve the interface ") + host + wxT("."));
+	}
+	addr->Service(port);
+
+	return addr;
+}
+// }}}
+// {{{ wxString Transport::GetURI() const
+wxString Transport::GetURI() const {
+	wxString uri;
+
+	if (family == UNIX) {
+		uri << wxT("unix://") << path;
+	}
+	else {
+		uri << wxT("tcp://") << host << wxT(':') << static_cast<unsigned int>(port);
+	}
+
+	return uri;
+}
+// }}}
+
+// {{{ void Transport::RestoreQuickAck(wxSocketBase *socket) const
+void Transport::RestoreQuickAck(wxSocketBase *socket) const {
+#ifdef TCP_QUICKACK
+	int value = 1;
+
+	if (family == TCP && quickAck) {
+		socket->SetOption(IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+	}
+#endif
+}
+// }}}
+#ifndef __WXMSW__
+// {{{ void Transport::RestoreQuickAck(int fd) const
+void Transport::RestoreQuickAck(int fd) const {
+#ifdef TCP_QUICKACK
+	int value = 1;
+
+	if (family == TCP && quickAck) {
+		setsockopt(fd, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+	}
+#endif
+}
+// }}}
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
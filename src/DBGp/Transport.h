@@ -0,0 +1,300 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DBGP_TRANSPORT_H
+#define DBGP_TRANSPORT_H
+
+#include <wx/socket.h>
+#include <wx/string.h>
+
+#include "DBGp/Error/Error.h"
+
+namespace DBGp {
+	/**
+	 * Describes where a server listens and how the sockets it accepts
+	 * are set up. This covers TCP listeners, optionally bound to a single
+	 * interface, and Unix domain socket listeners, which Xdebug 3 can
+	 * connect to when its client host is given as a unix:// URI.
+	 *
+	 * By default TCP_NODELAY is set on accepted TCP sockets. DBGp is a
+	 * strict request/response protocol made up of small messages, so
+	 * leaving Nagle's algorithm on only serves to hold messages back
+	 * until the peer's delayed ACK arrives.
+	 *
+	 * The same stall happens in the other direction when an engine writes
+	 * the length of a frame and its payload separately: the payload sits
+	 * in the engine's Nagle buffer until we ACK the length, which we'd
+	 * normally delay. Where TCP_QUICKACK is available, it's set on
+	 * accepted sockets and, since the kernel drops back to delayed ACKs
+	 * whenever it decides the connection is interactive, restored after
+	 * every read.
+	 */
+	class Transport {
+		public:
+			/** The kind of socket to listen on. */
+			typedef enum {
+				TCP,
+				UNIX
+			} Family;
+
+			/**
+			 * Constructs a TCP transport listening on every
+			 * interface.
+			 *
+			 * @param[in] port The port to listen on.
+			 */
+			Transport(wxUint16 port = 9000);
+
+			/**
+			 * Parses a transport from a URI of the form
+			 * tcp://interface:port, tcp://:port (or just a port
+			 * number) for every interface, or unix:///path.
+			 *
+			 * @param[in] uri The URI.
+			 * @return The transport.
+			 * @throws Error Thrown if the URI can't be parsed.
+			 */
+			static Transport FromURI(const wxString &uri) throw (Error);
+
+			/**
+			 * Applies the socket options to an accepted socket.
+			 *
+			 * @param[in] socket The socket.
+			 */
+			void Configure(wxSocketBase *socket) const;
+
+#ifndef __WXMSW__
+			/**
+			 * Applies the socket options to an accepted socket
+			 * that isn't managed by wxWidgets.
+			 *
+			 * @param[in] fd The socket.
+			 */
+			void Configure(int fd) const;
+
+			/**
+			 * Connects to the transport's address, as an engine
+			 * would. TCP transports without a host connect to the
+			 * loopback interface.
+			 *
+			 * @return The connected, blocking socket, which the
+			 * caller must close.
+			 * @throws SocketError Thrown if the address can't be
+			 * resolved or the connection fails.
+			 */
+			int Connect() const throw (SocketError);
+#endif
+
+			/**
+			 * Creates the address to listen on.
+			 *
+			 * @return The address, which the caller must delete.
+			 * @throws SocketError Thrown if the interface can't be
+			 * resolved, or Unix domain sockets aren't supported
+			 * on this platform.
+			 */
+			wxSockAddress *CreateAddress() const throw (SocketError);
+
+			/**
+			 * Returns the socket family.
+			 *
+			 * @return The family.
+			 */
+			inline Family GetFamily() const { return family; }
+
+			/**
+			 * Returns the interface a TCP transport is bound to.
+			 *
+			 * @return The interface's address or host name, or an
+			 * empty string for every interface.
+			 */
+			inline const wxString &GetHost() const { return host; }
+
+			/**
+			 * Returns whether TCP_NODELAY is set on accepted TCP
+			 * sockets.
+			 *
+			 * @return True if Nagle's algorithm is disabled.
+			 */
+			inline bool GetNoDelay() const { return noDelay; }
+
+			/**
+			 * Returns whether TCP_QUICKACK is kept set on accepted
+			 * TCP sockets.
+			 *
+			 * @return True if ACKs are sent immediately.
+			 */
+			inline bool GetQuickAck() const { return quickAck; }
+
+			/**
+			 * Returns the path of a Unix domain socket transport.
+			 *
+			 * @return The path.
+			 */
+			inline const wxString &GetPath() const { return path; }
+
+			/**
+			 * Returns the port of a TCP transport.
+			 *
+			 * @return The port.
+			 */
+			inline wxUint16 GetPort() const { return port; }
+
+			/**
+			 * Returns the receive buffer size set on accepted
+			 * sockets.
+			 *
+			 * @return The size in bytes, or 0 to leave the
+			 * system default alone.
+			 */
+			inline int GetReceiveBufferSize() const { return receiveBufferSize; }
+
+			/**
+			 * Returns the send buffer size set on accepted
+			 * sockets.
+			 *
+			 * @return The size in bytes, or 0 to leave the
+			 * system default alone.
+			 */
+			inline int GetSendBufferSize() const { return sendBufferSize; }
+
+			/**
+			 * Returns the transport as a URI that FromURI() will
+			 * accept.
+			 *
+			 * @return The URI.
+			 */
+			wxString GetURI() const;
+
+			/**
+			 * Sets TCP_QUICKACK again after a read, if the
+			 * transport uses it.
+			 *
+			 * @param[in] socket The socket that was read from.
+			 */
+			void RestoreQuickAck(wxSocketBase *socket) const;
+
+#ifndef __WXMSW__
+			/**
+			 * Sets TCP_QUICKACK again after a read on a socket
+			 * that isn't managed by wxWidgets, if the transport
+			 * uses it.
+			 *
+			 * @param[in] fd The socket that was read from.
+			 */
+			void RestoreQuickAck(int fd) const;
+#endif
+
+			/**
+			 * Binds a TCP transport to a single interface.
+			 *
+			 * @param[in] host The interface's address or host
+			 * name, or an empty string for every interface.
+			 */
+			inline void SetHost(const wxString &host) { this->host = host; }
+
+			/**
+			 * Sets whether TCP_NODELAY is set on accepted TCP
+			 * sockets.
+			 *
+			 * @param[in] noDelay True to disable Nagle's algorithm.
+			 */
+			inline void SetNoDelay(bool noDelay) { this->noDelay = noDelay; }
+
+			/**
+			 * Sets whether TCP_QUICKACK is kept set on accepted TCP
+			 * sockets. This has no effect on platforms without
+			 * TCP_QUICKACK.
+			 *
+			 * @param[in] quickAck True to send ACKs immediately.
+			 */
+			inline void SetQuickAck(bool quickAck) { this->quickAck = quickAck; }
+
+			/**
+			 * Makes this a Unix domain socket transport.
+			 *
+			 * @param[in] path The path of the socket.
+			 */
+			inline void SetPath(const wxString &path) { family = UNIX; this->path = path; }
+
+			/**
+			 * Makes this a TCP transport.
+			 *
+			 * @param[in] port The port to listen on.
+			 */
+			inline void SetPort(wxUint16 port) { family = TCP; this->port = port; }
+
+			/**
+			 * Sets the receive buffer size for accepted sockets.
+			 *
+			 * @param[in] size The size in bytes, or 0 to leave the
+			 * system default alone.
+			 */
+			inline void SetReceiveBufferSize(int size) { receiveBufferSize = size; }
+
+			/**
+			 * Sets the send buffer size for accepted sockets.
+			 *
+			 * @param[in] size The size in bytes, or 0 to leave the
+			 * system default alone.
+			 */
+			inline void SetSendBufferSize(int size) { sendBufferSize = size; }
+
+		protected:
+			/** The socket family. */
+			Family family;
+
+			/** The interface to bind a TCP listener to. */
+			wxString host;
+
+			/** Whether to set TCP_NODELAY. */
+			bool noDelay;
+
+			/** The path of a Unix domain socket. */
+			wxString path;
+
+			/** The TCP port. */
+			wxUint16 port;
+
+			/** Whether to keep TCP_QUICKACK set. */
+			bool quickAck;
+
+			/** The receive buffer size, or 0 for the default. */
+			int receiveBufferSize;
+
+			/** The send buffer size, or 0 for the default. */
+			int sendBufferSize;
+	};
+}
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
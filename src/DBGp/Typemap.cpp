@@ -40,17 +40,29 @@ Typemap::Typemap(const Typemap &typemap) : types(typemap.types) {
 
 // {{{ Type Typemap::GetType(const wxString &name) const throw (NotFoundError)
 Type Typemap::GetType(const wxString &name) const throw (NotFoundError) {
+	Type type;
+	if (!TryGetType(name, type)) {
+		throw NotFoundError(wxT("Requested type '") + name + wxT("' not found."));
+	}
+	return type;
+}
+// }}}
+// {{{ bool Typemap::TryGetType(const wxString &name, Type &type) const
+bool Typemap::TryGetType(const wxString &name, Type &type) const {
 	TypeMap::const_iterator i = types.find(name);
 	if (i == types.end()) {
-		throw NotFoundError(wxT("Requested type '") + name + wxT("' not found."));
+		return false;
 	}
-	return i->second;
+
+	type = i->second;
+	return true;
 }
 // }}}
 
 // {{{ void Typemap::AddType(Type type)
 void Typemap::AddType(Type type) {
-	types.insert(std::pair<wxString, Type>(type.GetName(), type));
+	// As with std::map, the first type added under a name wins.
+	types.insert(TypeMap::value_type(type.GetName(), type));
 }
 // }}}
 
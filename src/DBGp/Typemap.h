@@ -32,17 +32,18 @@
 #ifndef DBGP_TYPEMAP_H
 #define DBGP_TYPEMAP_H
 
-#include <map>
-
+#include <wx/hashmap.h>
 #include <wx/string.h>
 
 #include "DBGp/Error/Error.h"
 #include "DBGp/Type.h"
 
 namespace DBGp {
+	WX_DECLARE_STRING_HASH_MAP(Type, TypeHash);
+
 	class Typemap {
 		public:
-			typedef std::map<wxString, Type> TypeMap;
+			typedef TypeHash TypeMap;
 
 			inline Typemap() {}
 			Typemap(const Typemap &typemap);
@@ -50,6 +51,11 @@ namespace DBGp {
 			Type GetType(const wxString &name) const throw (NotFoundError);
 			inline const TypeMap &GetTypes() const { return types; }
 
+			/* Looks the type up without throwing, leaving type alone
+			 * if it isn't found, since unmapped types are common
+			 * enough that an exception for each one adds up. */
+			bool TryGetType(const wxString &name, Type &type) const;
+
 			void AddType(Type type);
 
 		private:
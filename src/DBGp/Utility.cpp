@@ -31,6 +31,38 @@
 
 #include "DBGp/Utility.h"
 
+#if defined(__WXMSW__)
+#include <wx/msw/wrapwin.h>
+#else
+#include <sys/time.h>
+#include <time.h>
+#endif
+
+/* Returns a monotonic time in microseconds, for measuring intervals. Where
+ * there's no monotonic clock, we fall back to the time of day. */
+wxUint64 DBGp::GetMicroseconds() {
+#if defined(__WXMSW__)
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+	return static_cast<wxUint64>(counter.QuadPart / frequency.QuadPart) * 1000000 + static_cast<wxUint64>(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<wxUint64>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return static_cast<wxUint64>(tv.tv_sec) * 1000000 + tv.tv_usec;
+#endif
+}
+
 wxString DBGp::IntToString(long l) {
 	wxString s;
 	s << l;
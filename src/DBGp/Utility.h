@@ -35,6 +35,7 @@
 #include <wx/string.h>
 
 namespace DBGp {
+	wxUint64 GetMicroseconds();
 	wxString IntToString(long l);
 	int StringToInt(const wxString &s);
 	long StringToLong(const wxString &s);
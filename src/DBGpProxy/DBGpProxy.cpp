@@ -0,0 +1,100 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Proxy.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <wx/init.h>
+
+// {{{ static bool ParsePort(const char *s, wxUint16 &port)
+static bool ParsePort(const char *s, wxUint16 &port) {
+	char *end;
+	unsigned long value = std::strtoul(s, &end, 10);
+
+	if (*s == '\0' || *end != '\0' || value > 65535) {
+		return false;
+	}
+
+	port = static_cast<wxUint16>(value);
+	return true;
+}
+// }}}
+
+// {{{ int main(int argc, char **argv)
+int main(int argc, char **argv) {
+	// These match the defaults used by other DBGp proxies.
+	wxUint16 enginePort = 9000, idePort = 9001;
+	sigset_t signals;
+	int received;
+
+	if (argc > 3 || (argc > 1 && !ParsePort(argv[1], enginePort)) || (argc > 2 && !ParsePort(argv[2], idePort))) {
+		std::fprintf(stderr, "Usage: %s [engine port [IDE port]]\n", argv[0]);
+		return 1;
+	}
+
+	wxInitializer init;
+	if (!init.IsOk()) {
+		std::fprintf(stderr, "Unable to initialise wxWidgets.\n");
+		return 1;
+	}
+
+	/* Block the signals we wait for before the proxy thread is started,
+	 * so it inherits the mask and they're all delivered to sigwait(). */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	DBGp::Proxy proxy;
+	try {
+		proxy.Start(enginePort, idePort);
+	}
+	catch (DBGp::SocketError e) {
+		std::fprintf(stderr, "Unable to start the proxy: %s\n", static_cast<const char *>(e.GetMessage().mb_str()));
+		return 1;
+	}
+
+	std::printf("Accepting engines on port %hu and IDE registrations on port %hu.\n", proxy.GetEnginePort(), proxy.GetIDEPort());
+	std::fflush(stdout);
+
+	sigwait(&signals, &received);
+	proxy.Stop();
+
+	return 0;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
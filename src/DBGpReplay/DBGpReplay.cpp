@@ -0,0 +1,89 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/SessionReplay.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <wx/init.h>
+
+// {{{ int main(int argc, char **argv)
+int main(int argc, char **argv) {
+	wxString uri(wxT("tcp://127.0.0.1:9000"));
+	double speed = 1.0;
+
+	if (argc < 2 || argc > 4) {
+		std::fprintf(stderr, "Usage: %s recording [IDE URI [speed]]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 2) {
+		uri = wxString(argv[2], wxConvLibc);
+	}
+	if (argc > 3) {
+		char *end;
+
+		speed = std::strtod(argv[3], &end);
+		if (*argv[3] == '\0' || *end != '\0' || speed < 0.0) {
+			std::fprintf(stderr, "Invalid speed: %s\n", argv[3]);
+			return 1;
+		}
+	}
+
+	wxInitializer init;
+	if (!init.IsOk()) {
+		std::fprintf(stderr, "Unable to initialise wxWidgets.\n");
+		return 1;
+	}
+
+	DBGp::SessionReplay replay;
+	try {
+		replay.Load(wxString(argv[1], wxConvFile));
+	}
+	catch (DBGp::Error e) {
+		std::fprintf(stderr, "Unable to load %s: %s\n", argv[1], static_cast<const char *>(e.GetMessage().mb_str()));
+		return 1;
+	}
+
+	try {
+		size_t replayed = replay.Replay(DBGp::Transport::FromURI(uri), speed);
+
+		std::printf("Replayed %lu of %lu records.\n", (unsigned long) replayed, (unsigned long) replay.GetRecords().size());
+		return replayed == replay.GetRecords().size() ? 0 : 2;
+	}
+	catch (DBGp::Error e) {
+		std::fprintf(stderr, "Unable to replay %s: %s\n", argv[1], static_cast<const char *>(e.GetMessage().mb_str()));
+		return 1;
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
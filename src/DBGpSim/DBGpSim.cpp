@@ -0,0 +1,92 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "DBGp/Simulator.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <wx/init.h>
+
+// {{{ int main(int argc, char **argv)
+int main(int argc, char **argv) {
+	wxString uri(wxT("tcp://127.0.0.1:9000"));
+	unsigned long sessions = 1;
+	DBGp::Simulator::Workload workload;
+
+	if (argc > 4) {
+		std::fprintf(stderr, "Usage: %s [IDE URI [sessions [workload]]]\n", argv[0]);
+		return 1;
+	}
+	if (argc > 1) {
+		uri = wxString(argv[1], wxConvLibc);
+	}
+	if (argc > 2) {
+		char *end;
+
+		sessions = std::strtoul(argv[2], &end, 10);
+		if (*argv[2] == '\0' || *end != '\0' || sessions == 0) {
+			std::fprintf(stderr, "Invalid session count: %s\n", argv[2]);
+			return 1;
+		}
+	}
+
+	wxInitializer init;
+	if (!init.IsOk()) {
+		std::fprintf(stderr, "Unable to initialise wxWidgets.\n");
+		return 1;
+	}
+
+	try {
+		if (argc > 3) {
+			workload = DBGp::Simulator::Workload::FromString(wxString(argv[3], wxConvLibc));
+		}
+
+		DBGp::Simulator simulator(workload);
+		DBGp::Simulator::Totals totals(simulator.Run(DBGp::Transport::FromURI(uri), static_cast<unsigned int>(sessions)));
+		double seconds = totals.elapsed / 1000000.0;
+
+		std::printf("Sessions: %u (%u failed)\n", totals.sessions, totals.failed);
+		std::printf("Commands: %lu in %.3f s (%.1f/s)\n", (unsigned long) totals.commands, seconds, seconds > 0 ? totals.commands / seconds : 0.0);
+		std::printf("Received: %lu bytes\n", (unsigned long) totals.bytesReceived);
+		std::printf("Sent: %lu bytes (%.1f MB/s)\n", (unsigned long) totals.bytesSent, seconds > 0 ? totals.bytesSent / seconds / 1048576.0 : 0.0);
+		std::printf("IDE turnaround: mean %.0f us, p50 %lu us, p99 %lu us, max %lu us\n", totals.turnaround.GetMean(), (unsigned long) totals.turnaround.GetPercentile(50), (unsigned long) totals.turnaround.GetPercentile(99), (unsigned long) totals.turnaround.GetMax());
+
+		return totals.failed > 0 ? 2 : 0;
+	}
+	catch (DBGp::Error e) {
+		std::fprintf(stderr, "Unable to run the simulator: %s\n", static_cast<const char *>(e.GetMessage().mb_str()));
+		return 1;
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
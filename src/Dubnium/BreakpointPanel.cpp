@@ -148,10 +148,23 @@ DBGp::Connection::BreakpointList BreakpointPanel::GetFileBreakpoints(const wxStr
 	return list;
 }
 // }}}
+// {{{ void BreakpointPanel::RefreshBreakpoints()
+void BreakpointPanel::RefreshBreakpoints() {
+	try {
+		// One breakpoint_list, however many breakpoints there are.
+		if (!parent->GetConnection()->RefreshBreakpoints().empty()) {
+			Update();
+		}
+	}
+	catch (DBGp::Error e) {
+		wxLogDebug(wxT("Error refreshing breakpoints: %s"), e.GetMessage().c_str());
+	}
+}
+// }}}
 // {{{ void BreakpointPanel::Update()
 void BreakpointPanel::Update() {
 	breakpoints = parent->GetConnection()->GetBreakpoints();
-	std::remove_if(breakpoints.begin(), breakpoints.end(), IsNotDisplayed);
+	breakpoints.remove_if(IsNotDisplayed);
 
 	grid->Freeze();
 
@@ -197,6 +210,10 @@ void BreakpointPanel::Update() {
 				cond = wxT("???");
 		}
 		grid->SetCellValue(row, 2, cond);
+		wxString hits;
+		hits << (*i)->GetLastHitCount();
+		grid->SetCellValue(row, 3, hits);
+		grid->SetCellAlignment(row, 3, wxALIGN_RIGHT, wxALIGN_CENTRE);
 		grid->SetRowLabelValue(row, (*i)->GetID());
 	}
 	grid->AutoSizeColumns();
@@ -218,7 +235,6 @@ void BreakpointPanel::OnAddCall(wxCommandEvent &event) {
 
 		DBGp::Breakpoint *bp = parent->GetConnection()->CreateBreakpoint();
 		bp->SetCallType(function);
-		bp->Set();
 	}
 
 	Update();
@@ -230,7 +246,6 @@ void BreakpointPanel::OnAddException(wxCommandEvent &event) {
 	if (exception != wxEmptyString) {
 		DBGp::Breakpoint *bp = parent->GetConnection()->CreateBreakpoint();
 		bp->SetExceptionType(exception);
-		bp->Set();
 	}
 	Update();
 }
@@ -248,7 +263,6 @@ void BreakpointPanel::OnAddReturn(wxCommandEvent &event) {
 
 		DBGp::Breakpoint *bp = parent->GetConnection()->CreateBreakpoint();
 		bp->SetReturnType(function);
-		bp->Set();
 	}
 
 	Update();
@@ -260,7 +274,6 @@ void BreakpointPanel::OnAddWatch(wxCommandEvent &event) {
 	if (watch != wxEmptyString) {
 		DBGp::Breakpoint *bp = parent->GetConnection()->CreateBreakpoint();
 		bp->SetWatchType(watch);
-		bp->Set();
 	}
 	Update();
 }
@@ -336,11 +349,12 @@ void BreakpointPanel::OnSelectCell(wxGridEvent &event) {
 void BreakpointPanel::ResetGrid() {
 	grid->Freeze();
 
-	grid->CreateGrid(1, 3);
+	grid->CreateGrid(1, 4);
 
 	grid->SetColLabelValue(0, _("Sticky"));
 	grid->SetColLabelValue(1, _("Type"));
 	grid->SetColLabelValue(2, _("Condition"));
+	grid->SetColLabelValue(3, _("Hits"));
 
 #ifndef DUBNIUM_DEBUG
 	grid->SetRowLabelSize(0);
@@ -47,6 +47,7 @@ class BreakpointPanel : public ToolbarPanel {
 
 		DBGp::Breakpoint *GetFileBreakpoint(const wxString &file, int line);
 		DBGp::Connection::BreakpointList GetFileBreakpoints(const wxString &file);
+		void RefreshBreakpoints();
 		void Update();
 
 	protected:
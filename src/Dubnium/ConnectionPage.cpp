@@ -39,6 +39,8 @@
 #include <wx/sizer.h>
 #include <wx/toolbar.h>
 
+#include "DBGp/BreakpointBatch.h"
+
 // {{{ Event table
 BEGIN_EVENT_TABLE(ConnectionPage, wxPanel)
 	EVT_DBGP_STATUSCHANGE(wxID_ANY, ConnectionPage::OnStatusChange)
@@ -55,7 +57,7 @@ END_EVENT_TABLE()
 // }}}
 
 // {{{ ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const wxString &fileURI, const wxString &language)
-ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const wxString &fileURI, const wxString &language) : wxPanel(parent, ID_CONNECTIONPAGE), conn(conn), language(language), level(level), script(fileURI), unavailable(true) {
+ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const wxString &fileURI, const wxString &language) : wxPanel(parent, ID_CONNECTIONPAGE), callStack(NULL), conn(conn), language(language), level(NULL), script(fileURI), unavailable(true) {
 	config = wxConfigBase::Get();
 
 	conn->SetEventHandler(this);
@@ -67,6 +69,7 @@ ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const w
 	properties = new PropertiesPanel(this);
 	source = new SourcePanel(this);
 	stack = new StackPanel(this);
+	statistics = new StatisticsPanel(this);
 
 	SetSource(fileURI);
 
@@ -77,6 +80,7 @@ ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const w
 	mgr->AddPane(toolbar, wxAuiPaneInfo().ToolbarPane().Top().Position(0).Floatable(false));
 	mgr->AddPane(output, wxAuiPaneInfo(defaultPane).Bottom().Position(0).Caption(_("Output")).MinSize(wxSize(1, 150)));
 	mgr->AddPane(breakpoint, wxAuiPaneInfo(defaultPane).Bottom().Position(2).Caption(_("Breakpoints")).MinSize(wxSize(1, 150)));
+	mgr->AddPane(statistics, wxAuiPaneInfo(defaultPane).Bottom().Position(3).Caption(_("Session Statistics")).MinSize(wxSize(1, 150)).Hide());
 	mgr->AddPane(stack, wxAuiPaneInfo(defaultPane).Right().Position(0).Caption(_("Call Stack")).MinSize(wxSize(200, 1)));
 	mgr->AddPane(properties, wxAuiPaneInfo(defaultPane).Right().Position(1).Caption(_("Properties")).MinSize(wxSize(200, 1)));
 	mgr->AddPane(source, wxAuiPaneInfo().CentrePane().Caption(_("Source")).CaptionVisible(true));
@@ -92,12 +96,19 @@ ConnectionPage::ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const w
 	RestoreStickyBreakpoints();
 }
 // }}}
+// {{{ ConnectionPage::~ConnectionPage()
+ConnectionPage::~ConnectionPage() {
+	stack->SetStack(NULL);
+	delete callStack;
+}
+// }}}
 
 // {{{ void ConnectionPage::BreakpointAdd(int line, bool temporary)
 void ConnectionPage::BreakpointAdd(int line, bool temporary) {
 	if (!unavailable) {
+		DBGp::BreakpointBatch batch(conn);
 		DBGp::Connection::BreakpointList disabledBreakpoints;
-		DBGp::Breakpoint *bp = conn->CreateBreakpoint();
+		DBGp::Breakpoint *bp = batch.CreateBreakpoint();
 
 		bp->SetLineType(lastFile, line);
 
@@ -113,6 +124,7 @@ void ConnectionPage::BreakpointAdd(int line, bool temporary) {
 				for (DBGp::Connection::BreakpointList::iterator i = breakpoints.begin(); i != breakpoints.end(); i++) {
 					DBGp::Breakpoint *point = *i;
 					if (point && point != bp && point->GetID() != wxEmptyString && point->IsEnabled()) {
+						batch.Add(point);
 						point->Disable();
 						disabledBreakpoints.push_back(point);
 					}
@@ -122,15 +134,17 @@ void ConnectionPage::BreakpointAdd(int line, bool temporary) {
 				bp->SetTemporary(true);
 			}
 		}
-		bp->Set();
+		batch.Send();
 
 		if (temporary) {
 			conn->Run();
 
 			if (language == wxT("PHP")) {
 				for (DBGp::Connection::BreakpointList::iterator i = disabledBreakpoints.begin(); i != disabledBreakpoints.end(); i++) {
+					batch.Add(*i);
 					(*i)->Enable();
 				}
+				batch.Send();
 				conn->RemoveBreakpoint(bp);
 			}
 		}
@@ -159,12 +173,14 @@ void ConnectionPage::BreakpointRemove(int line) {
 // }}}
 // {{{ DBGp::Property *ConnectionPage::GetProperty(const wxString &name)
 DBGp::Property *ConnectionPage::GetProperty(const wxString &name) {
-	return properties->GetProperty(name);
+	// The current frame indexes every property it has by full name.
+	return (level ? level->FindProperty(name) : NULL);
 }
 // }}}
 // {{{ wxString ConnectionPage::GetPropertyValue(const wxString &name) const
 wxString ConnectionPage::GetPropertyValue(const wxString &name) const {
-	return properties->GetPropertyValue(name);
+	DBGp::Property *prop = (level ? level->FindProperty(name) : NULL);
+	return (prop ? prop->GetData() : wxEmptyString);
 }
 // }}}
 // {{{ void ConnectionPage::SavePerspective()
@@ -232,13 +248,14 @@ void ConnectionPage::OnRun(wxCommandEvent &event) {
 // }}}
 // {{{ void ConnectionPage::OnRunToCursor(wxCommandEvent &event)
 void ConnectionPage::OnRunToCursor(wxCommandEvent &event) {
+	DBGp::BreakpointBatch batch(conn);
 	DBGp::Breakpoint *bp;
 	int line = source->tc->LineFromPosition(source->tc->GetCurrentPos()) + 1;
 
-	bp = conn->CreateBreakpoint();
+	bp = batch.CreateBreakpoint();
 	bp->SetLineType(lastFile, line);
 	bp->SetTemporary(true);
-	bp->Set();
+	batch.Send();
 
 	UpdateToolBar(false, true, false, false, false);
 	conn->Run();
@@ -249,6 +266,7 @@ void ConnectionPage::OnStatusChange(DBGp::StatusChangeEvent &event) {
 	if (event.GetStatus() == DBGp::Connection::BREAK) {
 		UpdateToolBar(true, false, true, true, true);
 		UpdateStack();
+		breakpoint->RefreshBreakpoints();
 	}
 	else if (event.GetStatus() == DBGp::Connection::RUNNING) {
 		UpdateToolBar(false, true, false, false, false);
@@ -258,6 +276,9 @@ void ConnectionPage::OnStatusChange(DBGp::StatusChangeEvent &event) {
 		breakpoint->Enable(false);
 		stack->SetStack(NULL);
 		properties->SetStackLevel(NULL);
+		delete callStack;
+		callStack = NULL;
+		level = NULL;
 		source->Unavailable(_("No source is available as execution has finished."));
 		unavailable = true;
 
@@ -300,12 +321,14 @@ void ConnectionPage::OnStepOver(wxCommandEvent &event) {
 // {{{ void ConnectionPage::RestoreStickyBreakpoints()
 void ConnectionPage::RestoreStickyBreakpoints() {
 	std::vector<StickyBreakpoint> breakpoints(wxGetApp().GetStickyBreakpoints(script));
+	DBGp::BreakpointBatch batch(conn);
 
 	wxLogDebug(wxT("Restoring sticky breakpoints for script %s..."), script.c_str());
 
+	/* The setters below only define each breakpoint; they're all sent
+	 * together when the batch is. */
 	for (std::vector<StickyBreakpoint>::iterator i = breakpoints.begin(); i != breakpoints.end(); i++) {
-		DBGp::Breakpoint *bp = conn->CreateBreakpoint();
-
+		DBGp::Breakpoint *bp = batch.CreateBreakpoint();
 
 		switch (i->GetType()) {
 			case DBGp::Breakpoint::CALL:
@@ -325,10 +348,16 @@ void ConnectionPage::RestoreStickyBreakpoints() {
 
 			default:
 				wxLogError(wxT("Sticky breakpoint of unknown type."));
+				conn->RemoveBreakpoint(bp);
 				break;
 		}
+	}
 
-		bp->Set();
+	try {
+		batch.Send();
+	}
+	catch (DBGp::SocketError e) {
+		wxLogError(wxT("Socket error restoring sticky breakpoints."));
 	}
 
 	breakpoint->Update();
@@ -359,9 +388,15 @@ void ConnectionPage::SetSource(const wxString &file, int line) {
 // }}}
 // {{{ void ConnectionPage::UpdateStack()
 void ConnectionPage::UpdateStack() {
-	DBGp::Stack stack(conn->StackGet());
-	this->stack->SetStack(&stack);
-	SetStackLevel(stack.GetLevel(0));
+	/* The stack panel only holds pointers into the current stack, so the
+	 * old one has to stay alive until the panel has been repopulated. */
+	DBGp::Stack *newStack = new DBGp::Stack(conn);
+
+	stack->SetStack(newStack);
+	delete callStack;
+	callStack = newStack;
+
+	SetStackLevel(callStack->GetLevel(0));
 }
 // }}}
 // {{{ void ConnectionPage::UpdateToolBar(bool run, bool brk, bool stepInto, bool stepOver, bool stepOut)
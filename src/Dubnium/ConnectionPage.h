@@ -38,6 +38,7 @@
 
 #include "DBGp/Connection.h"
 #include "DBGp/Event.h"
+#include "DBGp/Stack.h"
 #include "DBGp/StackLevel.h"
 
 #include "BreakpointPanel.h"
@@ -47,10 +48,12 @@
 #include "SourcePanel.h"
 #include "SourceTextCtrlHandler.h"
 #include "StackPanel.h"
+#include "StatisticsPanel.h"
 
 class ConnectionPage : public wxPanel, public SourceTextCtrlHandler {
 	public:
 		ConnectionPage(wxWindow *parent, DBGp::Connection *conn, const wxString &fileURI, const wxString &language);
+		virtual ~ConnectionPage();
 
 		virtual void BreakpointAdd(int line, bool temporary = false);
 		void BreakpointRemove(const wxString &file, int line);
@@ -66,6 +69,7 @@ class ConnectionPage : public wxPanel, public SourceTextCtrlHandler {
 	protected:
 		BreakpointPanel *breakpoint;
 		bool breakSupported;
+		DBGp::Stack *callStack;
 		wxConfigBase *config;
 		DBGp::Connection *conn;
 		wxString language;
@@ -77,6 +81,7 @@ class ConnectionPage : public wxPanel, public SourceTextCtrlHandler {
 		wxString script;
 		SourcePanel *source;
 		StackPanel *stack;
+		StatisticsPanel *statistics;
 		wxToolBar *toolbar;
 		bool unavailable;
 
@@ -42,7 +42,20 @@
 #include <wx/log.h>
 #include <wx/msgdlg.h>
 #include <wx/sysopt.h>
+#include <wx/utils.h>
 
+#include "DBGp/Tracer.h"
+
+// {{{ int Dubnium::OnExit()
+int Dubnium::OnExit() {
+#ifdef DBGP_TRACING
+	if (DBGp::Tracer::IsEnabled() && !DBGp::Tracer::Stop()) {
+		wxLogError(_("Unable to write the trace file."));
+	}
+#endif
+	return wxApp::OnExit();
+}
+// }}}
 // {{{ bool Dubnium::OnInit()
 bool Dubnium::OnInit() {
 	// Set up our toolbar image handling.
@@ -60,6 +73,15 @@ bool Dubnium::OnInit() {
 	SetVendorName(APPNAME);
 	SetAppName(APPNAME);
 
+#ifdef DBGP_TRACING
+	/* Tracing builds only record anything if asked to, since the trace is
+	 * written out when we exit. */
+	wxString traceFile;
+	if (wxGetEnv(wxT("DUBNIUM_TRACE"), &traceFile) && !traceFile.empty()) {
+		DBGp::Tracer::Start(traceFile);
+	}
+#endif
+
 	MainFrame *frame = new MainFrame;
 	frame->Show(true);
 	SetTopWindow(frame);
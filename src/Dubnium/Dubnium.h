@@ -39,6 +39,7 @@
 
 class Dubnium : public wxApp {
 	public:
+		virtual int OnExit();
 		virtual bool OnInit();
 
 		void AddStickyBreakpoint(const wxString &script, const DBGp::Breakpoint *bp);
@@ -59,6 +59,8 @@ enum {
 	ID_FUNCTIONBREAKPOINTDIALOG_FUNCTION,
 	ID_FUNCTIONBREAKPOINTDIALOG_TYPE,
 	ID_MAINFRAME,
+	ID_MAINFRAME_PROTOCOLLOG,
+	ID_MAINFRAME_PROTOCOLLOG_SAVE,
 	ID_MAINFRAME_SERVER,
 	ID_OUTPUTPANEL_SHOW_ALL,
 	ID_OUTPUTPANEL_SHOW_STDERR,
@@ -66,14 +68,23 @@ enum {
 	ID_OUTPUTPANEL_SAVE,
 	ID_PREFDIALOG_FONT,
 	ID_PREFDIALOG_IDEKEY,
+	ID_PREFDIALOG_INTERFACE,
+	ID_PREFDIALOG_NODELAY,
 	ID_PREFDIALOG_PORT,
-	ID_PROPERTIESPANEL_TREE,
+	ID_PREFDIALOG_THREADED,
+	ID_PREFDIALOG_UNIXSOCKET,
+	ID_PROPERTIESPANEL_LIST,
+	ID_PROPERTYLISTCTRL_EXAMINE_VALUE,
 	ID_SOURCEPANEL,
 	ID_SOURCEPANEL_RTC,
 	ID_SOURCETEXTCTRL_EXAMINE_VALUE,
 	ID_SOURCETEXTCTRL_RUN_TO_HERE,
 	ID_SOURCETEXTCTRL_TOGGLE_BREAKPOINT,
 	ID_STACKPANEL_LIST,
+	ID_STATISTICSPANEL_LIST,
+	ID_STATISTICSPANEL_REFRESH,
+	ID_STATISTICSPANEL_RESET,
+	ID_STATISTICSPANEL_TIMER,
 	ID_DUBNIUM_HIGHEST
 };
 
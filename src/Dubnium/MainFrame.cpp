@@ -38,11 +38,14 @@
 #include "WelcomePage.h"
 
 #include <wx/aboutdlg.h>
+#include <wx/filedlg.h>
 #include <wx/filename.h>
+#include <wx/msgdlg.h>
 #include <wx/sizer.h>
 #include <wx/uri.h>
 
 #include "DBGp/Connection.h"
+#include "DBGp/ProtocolLog.h"
 
 // {{{ Event table
 BEGIN_EVENT_TABLE(MainFrame, wxFrame)
@@ -51,6 +54,8 @@ BEGIN_EVENT_TABLE(MainFrame, wxFrame)
 	EVT_MENU(wxID_ABOUT, MainFrame::OnAbout)
 	EVT_MENU(wxID_EXIT, MainFrame::OnQuit)
 	EVT_MENU(wxID_PREFERENCES, MainFrame::OnPreferences)
+	EVT_MENU(ID_MAINFRAME_PROTOCOLLOG, MainFrame::OnProtocolLog)
+	EVT_MENU(ID_MAINFRAME_PROTOCOLLOG_SAVE, MainFrame::OnProtocolLogSave)
 END_EVENT_TABLE()
 // }}}
 
@@ -58,7 +63,8 @@ END_EVENT_TABLE()
 MainFrame::MainFrame() : wxFrame(NULL, ID_MAINFRAME, _("Dubnium")) {
 	config = wxConfigBase::Get();
 
-	server = new DBGp::Server(static_cast<wxUint16>(config->Read(wxT("Network/Port"), 9000)), this);
+	server = new DBGp::Server(LoadTransport(), this);
+	LoadServerOptions();
 
 	wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
 
@@ -100,6 +106,9 @@ wxMenuBar *MainFrame::CreateMenuBar() {
 #endif
 
 	wxMenu *toolMenu = new wxMenu;
+	toolMenu->AppendCheckItem(ID_MAINFRAME_PROTOCOLLOG, _("Sample Protocol &Traffic"), _("Keep a sample of recent protocol messages"));
+	toolMenu->Append(ID_MAINFRAME_PROTOCOLLOG_SAVE, _("Save Protocol &Sample..."), _("Save the sampled protocol messages to a file"));
+	toolMenu->AppendSeparator();
 	toolMenu->Append(wxID_PREFERENCES);
 	menuBar->Append(toolMenu, _("&Tools"));
 
@@ -114,6 +123,31 @@ wxMenuBar *MainFrame::CreateMenuBar() {
 	return menuBar;
 }
 // }}}
+// {{{ void MainFrame::LoadServerOptions()
+void MainFrame::LoadServerOptions() {
+	DBGp::ConnectionFilter &filter = server->GetFilter();
+	wxString expectedKey(config->Read(wxT("Network/IDEKey"), wxEmptyString));
+	bool threaded = false;
+
+	/* Sessions for other IDE keys are detached as soon as their init
+	 * packet arrives, which lets their scripts carry on running without
+	 * us negotiating anything with them first. */
+	filter.Clear();
+	if (expectedKey.Len() == 0) {
+		filter.SetDefaultAction(DBGp::ConnectionFilter::ACCEPT);
+	}
+	else {
+		filter.SetDefaultAction(DBGp::ConnectionFilter::DETACH);
+		filter.AddRule(DBGp::ConnectionFilter::IDEKEY, expectedKey, DBGp::ConnectionFilter::ACCEPT);
+	}
+
+	config->Read(wxT("Network/Threaded"), &threaded);
+	server->SetThreaded(threaded);
+
+	// Like the protocol sample rate, this is only set in the configuration file.
+	server->SetRecordDirectory(config->Read(wxT("Debug/RecordDirectory"), wxEmptyString));
+}
+// }}}
 // {{{ void MainFrame::LoadSize()
 void MainFrame::LoadSize() {
 	bool max = false;
@@ -130,6 +164,30 @@ void MainFrame::LoadSize() {
 	}
 }
 // }}}
+// {{{ DBGp::Transport MainFrame::LoadTransport()
+DBGp::Transport MainFrame::LoadTransport() {
+	DBGp::Transport transport(static_cast<wxUint16>(config->Read(wxT("Network/Port"), 9000)));
+	wxString socketPath(config->Read(wxT("Network/UnixSocket"), wxEmptyString));
+	bool noDelay = true, quickAck = true;
+
+	// A Unix domain socket replaces the TCP listener entirely.
+	if (!socketPath.IsEmpty()) {
+		transport.SetPath(socketPath);
+	}
+	transport.SetHost(config->Read(wxT("Network/Interface"), wxEmptyString));
+
+	config->Read(wxT("Network/NoDelay"), &noDelay, true);
+	transport.SetNoDelay(noDelay);
+
+	// These are only set in the configuration file.
+	config->Read(wxT("Network/QuickAck"), &quickAck, true);
+	transport.SetQuickAck(quickAck);
+	transport.SetReceiveBufferSize(static_cast<int>(config->Read(wxT("Network/ReceiveBufferSize"), 0L)));
+	transport.SetSendBufferSize(static_cast<int>(config->Read(wxT("Network/SendBufferSize"), 0L)));
+
+	return transport;
+}
+// }}}
 // {{{ void MainFrame::OnAbout(wxCommandEvent &event)
 void MainFrame::OnAbout(wxCommandEvent &event) {
 	wxAboutDialogInfo info;
@@ -156,20 +214,12 @@ void MainFrame::OnClose(wxCloseEvent &event) {
 // }}}
 // {{{ void MainFrame::OnConnection(DBGp::ConnectionEvent &event)
 void MainFrame::OnConnection(DBGp::ConnectionEvent &event) {
-	wxString expectedKey(config->Read(wxT("Network/IDEKey"), wxEmptyString));
-	if (expectedKey.Len() == 0 || expectedKey == event.GetIDEKey()) {
-		wxFileName name(wxURI::Unescape(wxURI(event.GetFileURI()).GetPath()));
-		notebook->AddPage(new ConnectionPage(notebook, event.GetConnection(), event.GetFileURI(), event.GetLanguage()), name.GetFullName(), true);
+	// Connections with the wrong IDE key never get this far.
+	wxFileName name(wxURI::Unescape(wxURI(event.GetFileURI()).GetPath()));
+	notebook->AddPage(new ConnectionPage(notebook, event.GetConnection(), event.GetFileURI(), event.GetLanguage()), name.GetFullName(), true);
 
-		if (!IsActive()) {
-			RequestUserAttention(wxUSER_ATTENTION_INFO);
-		}
-	}
-	else {
-		// TODO: Ponder how we want to notify the user of this. Indeed,
-		// ponder if we want to notify the user of this.
-		wxLogDebug(wxT("Connection refused due to IDE key mismatch: expected %s; got %s."), expectedKey.c_str(), event.GetIDEKey().c_str());
-		event.GetConnection()->Close();
+	if (!IsActive()) {
+		RequestUserAttention(wxUSER_ATTENTION_INFO);
 	}
 }
 // }}}
@@ -177,6 +227,29 @@ void MainFrame::OnConnection(DBGp::ConnectionEvent &event) {
 void MainFrame::OnPreferences(wxCommandEvent &event) {
 	PrefDialog dialog(this, -1, _("Preferences"));
 	dialog.ShowModal();
+	LoadServerOptions();
+}
+// }}}
+// {{{ void MainFrame::OnProtocolLog(wxCommandEvent &event)
+void MainFrame::OnProtocolLog(wxCommandEvent &event) {
+	if (event.IsChecked()) {
+		// This is only set in the configuration file.
+		long sampleRate = config->Read(wxT("Debug/ProtocolSampleRate"), 1L);
+		DBGp::ProtocolLog::Enable(static_cast<unsigned int>(sampleRate > 0 ? sampleRate : 1));
+	}
+	else {
+		DBGp::ProtocolLog::Disable();
+	}
+}
+// }}}
+// {{{ void MainFrame::OnProtocolLogSave(wxCommandEvent &event)
+void MainFrame::OnProtocolLogSave(wxCommandEvent &event) {
+	wxFileDialog fd(this, _("Save Protocol Sample"), wxEmptyString, wxEmptyString, wxT("*.*"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (fd.ShowModal() == wxID_OK) {
+		if (!DBGp::ProtocolLog::Dump(fd.GetPath())) {
+			wxMessageBox(_("The protocol sample could not be saved."), _("Error"), wxICON_ERROR | wxOK);
+		}
+	}
 }
 // }}}
 // {{{ void MainFrame::OnQuit(wxCommandEvent &event)
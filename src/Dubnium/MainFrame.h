@@ -51,11 +51,15 @@ class MainFrame : public wxFrame {
 		DBGp::Server *server;
 
 		wxMenuBar *CreateMenuBar();
+		void LoadServerOptions();
 		void LoadSize();
+		DBGp::Transport LoadTransport();
 		void OnAbout(wxCommandEvent &event);
 		void OnClose(wxCloseEvent &event);
 		void OnConnection(DBGp::ConnectionEvent &event);
 		void OnPreferences(wxCommandEvent &event);
+		void OnProtocolLog(wxCommandEvent &event);
+		void OnProtocolLogSave(wxCommandEvent &event);
 		void OnQuit(wxCommandEvent &event);
 
 		DECLARE_EVENT_TABLE()
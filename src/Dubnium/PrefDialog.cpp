@@ -34,6 +34,7 @@
 #include "SourceTextCtrl.h"
 
 #include <wx/button.h>
+#include <wx/checkbox.h>
 #include <wx/fontdlg.h>
 #include <wx/gbsizer.h>
 #include <wx/panel.h>
@@ -45,14 +46,20 @@ BEGIN_EVENT_TABLE(PrefDialog, wxDialog)
 	EVT_BUTTON(wxID_CLOSE, PrefDialog::OnClose)
 	EVT_BUTTON(ID_PREFDIALOG_FONT, PrefDialog::OnFont)
 	EVT_TEXT(ID_PREFDIALOG_IDEKEY, PrefDialog::OnIDEKey)
+	EVT_TEXT(ID_PREFDIALOG_INTERFACE, PrefDialog::OnInterface)
+	EVT_CHECKBOX(ID_PREFDIALOG_NODELAY, PrefDialog::OnNoDelay)
 	EVT_SPINCTRL(ID_PREFDIALOG_PORT, PrefDialog::OnPort)
+	EVT_CHECKBOX(ID_PREFDIALOG_THREADED, PrefDialog::OnThreaded)
+	EVT_TEXT(ID_PREFDIALOG_UNIXSOCKET, PrefDialog::OnUnixSocket)
 END_EVENT_TABLE()
 // }}}
 
 // {{{ PrefDialog::PrefDialog(MainFrame *parent, wxWindowID id, const wxString &title, const wxPoint &pos, const wxSize &size, long style, const wxString &name)
 PrefDialog::PrefDialog(MainFrame *parent, wxWindowID id, const wxString &title, const wxPoint &pos, const wxSize &size, long style, const wxString &name) : wxDialog(dynamic_cast<wxWindow *>(parent), id, title, pos, size, style, name), config(wxConfigBase::Get()), parent(parent) {
 	wxGridBagSizer *sizer = new wxGridBagSizer(3, 3);
-	wxTextCtrl *ideKey = NULL;
+	wxTextCtrl *ideKey = NULL, *unixSocket = NULL;
+	wxCheckBox *noDelay = NULL, *threaded = NULL;
+	bool noDelayValue = true, threadedValue = false;
 
 	sizer->Add(new wxStaticText(this, -1, _("Font used for source code:")), wxGBPosition(0, 0), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxLEFT);
 	sizer->Add(fontButton = new wxButton(this, ID_PREFDIALOG_FONT, _("Change Source Code Font")), wxGBPosition(0, 1), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxEXPAND);
@@ -65,9 +72,26 @@ PrefDialog::PrefDialog(MainFrame *parent, wxWindowID id, const wxString &title,
 	sizer->Add(new wxStaticText(this, -1, _("Port to listen on:")), wxGBPosition(2, 0), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxLEFT);
 	sizer->Add(new wxSpinCtrl(this, ID_PREFDIALOG_PORT, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 0, 65535, config->Read(wxT("Network/Port"), 9000)), wxGBPosition(2, 1), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxEXPAND);
 
-	sizer->Add(new wxStaticText(this, -1, _("Note: Port changes require a restart to take effect.")), wxGBPosition(3, 0), wxGBSpan(1, 2), wxLEFT);
+	sizer->Add(new wxStaticText(this, -1, _("Interface to listen on:")), wxGBPosition(3, 0), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxLEFT);
+	sizer->Add(new wxTextCtrl(this, ID_PREFDIALOG_INTERFACE, config->Read(wxT("Network/Interface"), wxEmptyString)), wxGBPosition(3, 1), wxDefaultSpan, wxEXPAND);
 
-	sizer->Add(new wxButton(this, wxID_CLOSE), wxGBPosition(4, 1), wxDefaultSpan, wxEXPAND | wxRIGHT);
+	sizer->Add(new wxStaticText(this, -1, _("Unix socket to listen on:")), wxGBPosition(4, 0), wxDefaultSpan, wxALIGN_CENTRE_VERTICAL | wxLEFT);
+	sizer->Add(unixSocket = new wxTextCtrl(this, ID_PREFDIALOG_UNIXSOCKET, config->Read(wxT("Network/UnixSocket"), wxEmptyString)), wxGBPosition(4, 1), wxDefaultSpan, wxEXPAND);
+	unixSocket->SetToolTip(_("Replaces the port and interface when set. Leave blank to listen on TCP."));
+
+	config->Read(wxT("Network/NoDelay"), &noDelayValue, true);
+	sizer->Add(noDelay = new wxCheckBox(this, ID_PREFDIALOG_NODELAY, _("Send commands immediately (TCP_NODELAY)")), wxGBPosition(5, 0), wxGBSpan(1, 2), wxLEFT);
+	noDelay->SetValue(noDelayValue);
+	noDelay->SetToolTip(_("Avoids delays of up to a few hundred milliseconds per command on some systems."));
+
+	config->Read(wxT("Network/Threaded"), &threadedValue);
+	sizer->Add(threaded = new wxCheckBox(this, ID_PREFDIALOG_THREADED, _("Read from debugging engines on a separate thread")), wxGBPosition(6, 0), wxGBSpan(1, 2), wxLEFT);
+	threaded->SetValue(threadedValue);
+	threaded->SetToolTip(_("Keeps the interface responsive while large responses arrive. Applies to new connections."));
+
+	sizer->Add(new wxStaticText(this, -1, _("Note: Port, interface, socket and TCP_NODELAY changes require a restart to take effect.")), wxGBPosition(7, 0), wxGBSpan(1, 2), wxLEFT);
+
+	sizer->Add(new wxButton(this, wxID_CLOSE), wxGBPosition(8, 1), wxDefaultSpan, wxEXPAND | wxRIGHT);
 
 	SetAutoLayout(true);
 	SetSizer(sizer);
@@ -98,11 +122,33 @@ void PrefDialog::OnIDEKey(wxCommandEvent &event) {
 	config->Write(wxT("Network/IDEKey"), ideKey->GetValue());
 }
 // }}}
+// {{{ void PrefDialog::OnInterface(wxCommandEvent &event)
+void PrefDialog::OnInterface(wxCommandEvent &event) {
+	wxTextCtrl *iface = dynamic_cast<wxTextCtrl *>(event.GetEventObject());
+	config->Write(wxT("Network/Interface"), iface->GetValue());
+}
+// }}}
+// {{{ void PrefDialog::OnNoDelay(wxCommandEvent &event)
+void PrefDialog::OnNoDelay(wxCommandEvent &event) {
+	config->Write(wxT("Network/NoDelay"), event.IsChecked());
+}
+// }}}
 // {{{ void PrefDialog::OnPort(wxSpinEvent &event)
 void PrefDialog::OnPort(wxSpinEvent &event) {
 	config->Write(wxT("Network/Port"), event.GetPosition());
 }
 // }}}
+// {{{ void PrefDialog::OnThreaded(wxCommandEvent &event)
+void PrefDialog::OnThreaded(wxCommandEvent &event) {
+	config->Write(wxT("Network/Threaded"), event.IsChecked());
+}
+// }}}
+// {{{ void PrefDialog::OnUnixSocket(wxCommandEvent &event)
+void PrefDialog::OnUnixSocket(wxCommandEvent &event) {
+	wxTextCtrl *unixSocket = dynamic_cast<wxTextCtrl *>(event.GetEventObject());
+	config->Write(wxT("Network/UnixSocket"), unixSocket->GetValue());
+}
+// }}}
 // {{{ void PrefDialog::UpdateFontButton()
 void PrefDialog::UpdateFontButton() {
 	wxFont font(SourceTextCtrl::DefaultFont());
@@ -51,7 +51,11 @@ class PrefDialog : public wxDialog {
 		void OnClose(wxCommandEvent &event);
 		void OnFont(wxCommandEvent &event);
 		void OnIDEKey(wxCommandEvent &event);
+		void OnInterface(wxCommandEvent &event);
+		void OnNoDelay(wxCommandEvent &event);
 		void OnPort(wxSpinEvent &event);
+		void OnThreaded(wxCommandEvent &event);
+		void OnUnixSocket(wxCommandEvent &event);
 		void UpdateFontButton();
 
 		DECLARE_EVENT_TABLE()
@@ -31,98 +31,19 @@
 
 #include "PropertiesPanel.h"
 
-#include "PropertyDialog.h"
-#include "PropertyTreeItem.h"
-
-#include <wx/log.h>
-
-// {{{ Event table
-BEGIN_EVENT_TABLE(PropertiesPanel, wxPanel)
-	EVT_TREE_ITEM_ACTIVATED(ID_PROPERTIESPANEL_TREE, PropertiesPanel::OnItemActivated)
-END_EVENT_TABLE()
-// }}}
+#include "DBGp/Tracer.h"
 
 // {{{ PropertiesPanel::PropertiesPanel(ConnectionPage *parent, wxWindowID id)
 PropertiesPanel::PropertiesPanel(ConnectionPage *parent, wxWindowID id) : ToolbarPanel(parent, id) {
-	tree = new wxTreeCtrl(this, ID_PROPERTIESPANEL_TREE, wxDefaultPosition, wxDefaultSize, wxTR_HAS_BUTTONS | wxTR_DEFAULT_STYLE | wxTR_HIDE_ROOT);
-	sizer->Add(tree, 1, wxEXPAND | wxALL);
+	list = new PropertyListCtrl(this, ID_PROPERTIESPANEL_LIST);
+	sizer->Add(list, 1, wxEXPAND | wxALL);
 }
 // }}}
 
-// {{{ DBGp::Property *PropertiesPanel::GetProperty(const wxString &name)
-DBGp::Property *PropertiesPanel::GetProperty(const wxString &name) {
-	if (properties.count(name) > 0) {
-		return properties.find(name)->second;
-	}
-	return NULL;
-}
-// }}}
-// {{{ wxString PropertiesPanel::GetPropertyValue(const wxString &name) const
-wxString PropertiesPanel::GetPropertyValue(const wxString &name) const {
-	if (properties.count(name) > 0) {
-		return properties.find(name)->second->GetData();
-	}
-	return wxEmptyString;
-}
-// }}}
 // {{{ void PropertiesPanel::SetStackLevel(DBGp::StackLevel *level)
 void PropertiesPanel::SetStackLevel(const DBGp::StackLevel *level) {
-	tree->Freeze();
-
-	properties.clear();
-	tree->DeleteAllItems();
-	wxTreeItemId root(tree->AddRoot(_("Root")));
-
-	if (level) {
-		const DBGp::StackLevel::ContextMap &contexts = level->GetContexts();
-
-		for (DBGp::StackLevel::ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
-			const DBGp::Property::PropertyMap &properties = i->second->GetProperties();
-
-			// TODO: I18n.
-			wxTreeItemId context(tree->AppendItem(root, i->second->GetName()));
-
-			for (DBGp::Property::PropertyMap::const_iterator i = properties.begin(); i != properties.end(); i++) {
-				AddProperty(context, i->second);
-			}
-		}
-	}
-
-	tree->Thaw();
-}
-// }}}
-
-// {{{ void PropertiesPanel::AddProperty(const wxTreeItemId &parent, const DBGp::Property *prop)
-void PropertiesPanel::AddProperty(const wxTreeItemId &parent, const DBGp::Property *prop) {
-	if (prop->HasChildren()) {
-		wxTreeItemId id(tree->AppendItem(parent, prop->GetName(), -1, -1, new PropertyTreeItem(prop)));
-		const DBGp::Property::PropertyMap &children(prop->GetChildren());
-		for (DBGp::Property::PropertyMap::const_iterator i = children.begin(); i != children.end(); i++) {
-			AddProperty(id, i->second);
-		}
-		properties[prop->GetFullName()] = new DBGp::Property(*prop);
-	}
-	else {
-		wxString label(prop->GetName());
-
-		label << wxT(" : ") << prop->GetData();
-		tree->AppendItem(parent, label, -1, -1, new PropertyTreeItem(prop));
-		wxLogDebug(wxT("Adding property: %s = %s"), prop->GetFullName().c_str(), prop->GetData().c_str());
-		properties[prop->GetFullName()] = new DBGp::Property(*prop);
-	}
-}
-// }}}
-// {{{ void PropertiesPanel::OnItemActivated(wxTreeEvent &event)
-void PropertiesPanel::OnItemActivated(wxTreeEvent &event) {
-	PropertyTreeItem *item = dynamic_cast<PropertyTreeItem *>(tree->GetItemData(event.GetItem()));
-
-	/* The cast can fail, as the root element and context elements don't
-	 * have PropertyTreeItem instances associated with them. That's not an
-	 * error; we'll just return without doing anything. */
-	if (item) {
-		PropertyDialog pd(this, wxID_ANY, item->GetProperty());
-		pd.ShowModal();
-	}
+	DBGP_TRACE("ui", "PropertiesPanel::SetStackLevel");
+	list->SetStackLevel(level);
 }
 // }}}
 
@@ -32,30 +32,20 @@
 #ifndef DUBNIUM_PROPERTIESPANEL_H
 #define DUBNIUM_PROPERTIESPANEL_H
 
-#include <wx/treectrl.h>
-
-#include "DBGp/Property.h"
 #include "DBGp/StackLevel.h"
 
 #include "ID.h"
+#include "PropertyListCtrl.h"
 #include "ToolbarPanel.h"
 
 class PropertiesPanel : public ToolbarPanel {
 	public:
 		PropertiesPanel(ConnectionPage *parent, wxWindowID id = wxID_ANY);
 
-		DBGp::Property *GetProperty(const wxString &name);
-		wxString GetPropertyValue(const wxString &name) const;
 		void SetStackLevel(const DBGp::StackLevel *level);
 
 	protected:
-		DBGp::Property::PropertyMap properties;
-		wxTreeCtrl *tree;
-
-		void AddProperty(const wxTreeItemId &parent, const DBGp::Property *prop);
-		void OnItemActivated(wxTreeEvent &event);
-
-		DECLARE_EVENT_TABLE()
+		PropertyListCtrl *list;
 };
 
 #endif
@@ -89,8 +89,8 @@ void PropertyDialog::AddProperty(const DBGp::Property *prop, unsigned long inden
 	grid->SetCellValue(row, 1, prop->GetType().GetName());
 	grid->SetCellValue(row, 2, prop->GetData());
 	
-	for (DBGp::Property::PropertyMap::const_iterator i = prop->GetChildren().begin(); i != prop->GetChildren().end(); i++) {
-		AddProperty(i->second, indent + 1);
+	for (size_t i = 0; i < prop->GetChildCount(); i++) {
+		AddProperty(prop->GetChildAt(i), indent + 1);
 	}
 }
 // }}}
@@ -0,0 +1,393 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "PropertyListCtrl.h"
+
+#include "ID.h"
+#include "PropertyDialog.h"
+
+#include <wx/dcmemory.h>
+#include <wx/imaglist.h>
+#include <wx/intl.h>
+#include <wx/log.h>
+#include <wx/menu.h>
+#include <wx/renderer.h>
+#include <wx/settings.h>
+
+#include "DBGp/Tracer.h"
+
+// {{{ Event table
+BEGIN_EVENT_TABLE(PropertyListCtrl, wxListCtrl)
+	EVT_LIST_ITEM_ACTIVATED(wxID_ANY, PropertyListCtrl::OnItemActivated)
+	EVT_LIST_ITEM_RIGHT_CLICK(wxID_ANY, PropertyListCtrl::OnItemRightClick)
+	EVT_LIST_KEY_DOWN(wxID_ANY, PropertyListCtrl::OnKeyDown)
+	EVT_MENU(ID_PROPERTYLISTCTRL_EXAMINE_VALUE, PropertyListCtrl::OnExamineValue)
+END_EVENT_TABLE()
+// }}}
+
+/* The images in the control's image list. Rows that can't be expanded get
+ * a blank image, so the names line up with those that can. */
+enum {
+	IMAGE_BLANK,
+	IMAGE_COLLAPSED,
+	IMAGE_EXPANDED
+};
+
+// The size of the images, and of the expander drawn in the middle of each.
+static const int IMAGE_SIZE = 16;
+static const int EXPANDER_SIZE = 9;
+
+// {{{ static wxImageList *CreateExpanderImages(wxWindow *win)
+static wxImageList *CreateExpanderImages(wxWindow *win) {
+	wxColour background(wxSystemSettings::GetColour(wxSYS_COLOUR_WINDOW));
+	wxImageList *images = new wxImageList(IMAGE_SIZE, IMAGE_SIZE, true);
+	const int offset = (IMAGE_SIZE - EXPANDER_SIZE) / 2;
+
+	for (int image = IMAGE_BLANK; image <= IMAGE_EXPANDED; image++) {
+		wxBitmap bitmap(IMAGE_SIZE, IMAGE_SIZE);
+		wxMemoryDC dc;
+
+		dc.SelectObject(bitmap);
+		dc.SetBackground(wxBrush(background));
+		dc.Clear();
+
+		if (image != IMAGE_BLANK) {
+			wxRendererNative::Get().DrawTreeItemButton(win, dc, wxRect(offset, offset, EXPANDER_SIZE, EXPANDER_SIZE), (image == IMAGE_EXPANDED ? wxCONTROL_EXPANDED : 0));
+		}
+
+		dc.SelectObject(wxNullBitmap);
+		images->Add(bitmap, background);
+	}
+
+	return images;
+}
+// }}}
+// {{{ static wxString RowIndent(unsigned int indent)
+static wxString RowIndent(unsigned int indent) {
+	/* The control draws every image at the left edge of the row, so
+	 * nesting can only be shown by indenting the names. */
+	return wxString(wxT(' '), indent * 4);
+}
+// }}}
+
+// {{{ PropertyListCtrl::PropertyListCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size)
+PropertyListCtrl::PropertyListCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size) : wxListCtrl(parent, id, pos, size, wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL), level(NULL), menuProperty(NULL) {
+	InsertColumn(0, _("Name"), wxLIST_FORMAT_LEFT, 200);
+	InsertColumn(1, _("Value"), wxLIST_FORMAT_LEFT, 300);
+
+	// wx 2.8 has no virtual tree control, so the expanders are images.
+	AssignImageList(CreateExpanderImages(this), wxIMAGE_LIST_SMALL);
+}
+// }}}
+// {{{ PropertyListCtrl::~PropertyListCtrl()
+PropertyListCtrl::~PropertyListCtrl() {
+	if (menuProperty) {
+		menuProperty->Unref();
+	}
+}
+// }}}
+
+// {{{ void PropertyListCtrl::SetStackLevel(const DBGp::StackLevel *level)
+void PropertyListCtrl::SetStackLevel(const DBGp::StackLevel *level) {
+	/* The rows point into the previous frame's properties, which may
+	 * already have gone, so they have to be dropped before anything
+	 * else happens. */
+	this->level = NULL;
+	rows.clear();
+	SetItemCount(0);
+
+	if (level) {
+		/* Fetch every context in one go rather than one at a time. The
+		 * frame indexes the properties for hovers as they arrive, so
+		 * this is needed even if every context is collapsed. */
+		level->RetrieveProperties();
+	}
+
+	this->level = level;
+	Rebuild();
+}
+// }}}
+
+// {{{ void PropertyListCtrl::AppendProperty(DBGp::Property *prop, unsigned int indent)
+void PropertyListCtrl::AppendProperty(DBGp::Property *prop, unsigned int indent) {
+	bool expanded = (prop->HasChildren() && expandedProperties.find(prop->GetFullName()) != expandedProperties.end());
+
+	/* A property that was expanded before a step comes back without its
+	 * children. Note it so they can be fetched along with the others,
+	 * and show it once they've arrived. */
+	if (expanded && prop->GetChildCount() == 0 && prop->HasMoreChildren()) {
+		unloaded.push_back(prop);
+	}
+
+	rows.push_back(Row(Row::PROPERTY, indent, NULL, prop, expanded));
+
+	if (expanded) {
+		for (size_t i = 0; i < prop->GetChildCount(); i++) {
+			AppendProperty(prop->GetChildAt(i), indent + 1);
+		}
+
+		if (prop->HasMoreChildren()) {
+			rows.push_back(Row(Row::MORE, indent + 1, NULL, prop, false));
+		}
+	}
+}
+// }}}
+// {{{ void PropertyListCtrl::BuildRows()
+void PropertyListCtrl::BuildRows() {
+	rows.clear();
+	unloaded.clear();
+
+	if (level) {
+		const DBGp::StackLevel::ContextMap &contexts = level->GetContexts();
+
+		for (DBGp::StackLevel::ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
+			const DBGp::Context *context = i->second;
+			bool expanded = (expandedContexts.find(context->GetID()) != expandedContexts.end());
+
+			rows.push_back(Row(Row::CONTEXT, 0, context, NULL, expanded));
+
+			if (expanded) {
+				/* Properties are shown in the order the engine
+				 * sent them, as their children are. */
+				const DBGp::Property::PropertyVector &properties = context->GetPropertiesInOrder();
+
+				for (DBGp::Property::PropertyVector::const_iterator j = properties.begin(); j != properties.end(); j++) {
+					AppendProperty(*j, 1);
+				}
+			}
+		}
+	}
+}
+// }}}
+// {{{ void PropertyListCtrl::Collapse(long item)
+void PropertyListCtrl::Collapse(long item) {
+	if (item < 0 || item >= static_cast<long>(rows.size()) || !rows[item].expanded) {
+		return;
+	}
+
+	const Row &row = rows[item];
+	if (row.type == Row::CONTEXT) {
+		expandedContexts.erase(row.context->GetID());
+	}
+	else {
+		expandedProperties.erase(row.prop->GetFullName());
+	}
+
+	Rebuild();
+}
+// }}}
+// {{{ void PropertyListCtrl::Expand(long item)
+void PropertyListCtrl::Expand(long item) {
+	if (item < 0 || item >= static_cast<long>(rows.size()) || rows[item].expanded) {
+		return;
+	}
+
+	const Row &row = rows[item];
+	if (row.type == Row::CONTEXT) {
+		expandedContexts.insert(row.context->GetID());
+	}
+	else if (row.type == Row::PROPERTY && row.prop->HasChildren()) {
+		if (row.prop->GetChildCount() == 0 && !LoadChildren(row.prop)) {
+			return;
+		}
+		expandedProperties.insert(row.prop->GetFullName());
+	}
+	else {
+		return;
+	}
+
+	Rebuild();
+}
+// }}}
+// {{{ bool PropertyListCtrl::LoadChildren(DBGp::Property *prop)
+bool PropertyListCtrl::LoadChildren(DBGp::Property *prop) {
+	try {
+		prop->RetrieveChildren();
+	}
+	catch (DBGp::Error e) {
+		wxLogError(wxT("Error retrieving children of %s: %s"), prop->GetFullName().c_str(), e.GetMessage().c_str());
+		return false;
+	}
+
+	return true;
+}
+// }}}
+// {{{ void PropertyListCtrl::OnExamineValue(wxCommandEvent &event)
+void PropertyListCtrl::OnExamineValue(wxCommandEvent &event) {
+	if (menuProperty) {
+		PropertyDialog pd(this, wxID_ANY, menuProperty);
+		pd.ShowModal();
+	}
+}
+// }}}
+// {{{ int PropertyListCtrl::OnGetItemImage(long item) const
+int PropertyListCtrl::OnGetItemImage(long item) const {
+	if (item < 0 || item >= static_cast<long>(rows.size())) {
+		return -1;
+	}
+
+	const Row &row = rows[item];
+	if (row.type == Row::CONTEXT || (row.type == Row::PROPERTY && row.prop->HasChildren())) {
+		return (row.expanded ? IMAGE_EXPANDED : IMAGE_COLLAPSED);
+	}
+
+	return IMAGE_BLANK;
+}
+// }}}
+// {{{ wxString PropertyListCtrl::OnGetItemText(long item, long column) const
+wxString PropertyListCtrl::OnGetItemText(long item, long column) const {
+	if (item < 0 || item >= static_cast<long>(rows.size())) {
+		return wxEmptyString;
+	}
+
+	const Row &row = rows[item];
+	if (row.type == Row::CONTEXT) {
+		// TODO: I18n.
+		return (column == 0 ? RowIndent(row.indent) + row.context->GetName() : wxString());
+	}
+	else if (row.type == Row::MORE) {
+		return (column == 0 ? RowIndent(row.indent) + _("More...") : wxString());
+	}
+	else if (column == 0) {
+		return RowIndent(row.indent) + row.prop->GetName();
+	}
+
+	return (row.prop->HasChildren() ? wxString() : row.prop->GetData());
+}
+// }}}
+// {{{ void PropertyListCtrl::OnItemActivated(wxListEvent &event)
+void PropertyListCtrl::OnItemActivated(wxListEvent &event) {
+	long item = event.GetIndex();
+
+	if (item < 0 || item >= static_cast<long>(rows.size())) {
+		return;
+	}
+
+	const Row &row = rows[item];
+	if (row.type == Row::MORE) {
+		// The placeholder makes way for the next page of children.
+		LoadChildren(row.prop);
+		Rebuild();
+	}
+	else if (row.type == Row::CONTEXT || row.prop->HasChildren()) {
+		if (row.expanded) {
+			Collapse(item);
+		}
+		else {
+			Expand(item);
+		}
+	}
+	else {
+		PropertyDialog pd(this, wxID_ANY, row.prop);
+		pd.ShowModal();
+	}
+}
+// }}}
+// {{{ void PropertyListCtrl::OnItemRightClick(wxListEvent &event)
+void PropertyListCtrl::OnItemRightClick(wxListEvent &event) {
+	long item = event.GetIndex();
+
+	if (item >= 0 && item < static_cast<long>(rows.size()) && rows[item].type == Row::PROPERTY) {
+		wxMenu menu;
+
+		/* Hold on to the property itself rather than the row, which
+		 * could be rebuilt before the menu command arrives. */
+		if (menuProperty) {
+			menuProperty->Unref();
+		}
+		menuProperty = rows[item].prop;
+		menuProperty->Ref();
+
+		menu.Append(ID_PROPERTYLISTCTRL_EXAMINE_VALUE, _("E&xamine Value"));
+		PopupMenu(&menu);
+	}
+}
+// }}}
+// {{{ void PropertyListCtrl::OnKeyDown(wxListEvent &event)
+void PropertyListCtrl::OnKeyDown(wxListEvent &event) {
+	switch (event.GetKeyCode()) {
+		case WXK_RIGHT:
+		case WXK_ADD:
+		case WXK_NUMPAD_ADD:
+		case '+':
+			Expand(event.GetIndex());
+			break;
+
+		case WXK_LEFT:
+		case WXK_SUBTRACT:
+		case WXK_NUMPAD_SUBTRACT:
+		case '-':
+			Collapse(event.GetIndex());
+			break;
+
+		default:
+			event.Skip();
+	}
+}
+// }}}
+// {{{ void PropertyListCtrl::Rebuild()
+void PropertyListCtrl::Rebuild() {
+	DBGP_TRACE("ui", "PropertyListCtrl::Rebuild");
+	BuildRows();
+
+	/* Each pass may uncover expanded properties further down whose
+	 * children have yet to be fetched, so keep going until there are no
+	 * more. Failures are dropped from the expansion state, so this ends
+	 * whatever the engine does. */
+	while (!unloaded.empty()) {
+		RetrieveUnloaded();
+		BuildRows();
+	}
+
+	/* Only the rows themselves are rebuilt: the control asks for the
+	 * text of whichever rows are on screen as it paints them. */
+	SetItemCount(rows.size());
+	Refresh();
+}
+// }}}
+// {{{ void PropertyListCtrl::RetrieveUnloaded()
+void PropertyListCtrl::RetrieveUnloaded() {
+	try {
+		DBGp::Property::RetrieveChildren(unloaded);
+	}
+	catch (DBGp::Error e) {
+		wxLogError(wxT("Error retrieving expanded properties: %s"), e.GetMessage().c_str());
+
+		for (DBGp::Property::PropertyVector::const_iterator i = unloaded.begin(); i != unloaded.end(); i++) {
+			if ((*i)->GetChildCount() == 0) {
+				expandedProperties.erase((*i)->GetFullName());
+			}
+		}
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,123 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DUBNIUM_PROPERTYLISTCTRL_H
+#define DUBNIUM_PROPERTYLISTCTRL_H
+
+#include <vector>
+
+#include <wx/hashset.h>
+#include <wx/listctrl.h>
+
+#include "DBGp/Context.h"
+#include "DBGp/Property.h"
+#include "DBGp/StackLevel.h"
+
+WX_DECLARE_HASH_SET(wxString, wxStringHash, wxStringEqual, ExpansionSet);
+
+/**
+ * A virtual list control that shows the properties of a stack frame as a
+ * tree. Rows only exist for contexts and for properties whose parents are
+ * expanded, children are only fetched when the user expands a property,
+ * and the native control only asks for the text of the rows on screen, so
+ * a refresh costs the same however large the contexts are. Expansion state
+ * is kept by full name, so contexts and properties stay expanded from one
+ * step to the next; the children of expanded properties are fetched again
+ * together after each step.
+ */
+class PropertyListCtrl : public wxListCtrl {
+	public:
+		PropertyListCtrl(wxWindow *parent, wxWindowID id, const wxPoint &pos = wxDefaultPosition, const wxSize &size = wxDefaultSize);
+		virtual ~PropertyListCtrl();
+
+		void SetStackLevel(const DBGp::StackLevel *level);
+
+	protected:
+		/** A row currently shown in the list. */
+		class Row {
+			public:
+				typedef enum {
+					CONTEXT,
+					PROPERTY,
+					MORE
+				} Type;
+
+				inline Row(Type type, unsigned int indent, const DBGp::Context *context, DBGp::Property *prop, bool expanded) : context(context), expanded(expanded), indent(indent), prop(prop), type(type) {}
+
+				/** The context, for context rows. */
+				const DBGp::Context *context;
+
+				/** Whether the row's children are shown. */
+				bool expanded;
+
+				/** The nesting depth of the row. */
+				unsigned int indent;
+
+				/**
+				 * The property, or for "more" rows, the
+				 * property whose next page of children they
+				 * fetch.
+				 */
+				DBGp::Property *prop;
+
+				/** The kind of row. */
+				Type type;
+		};
+
+		typedef std::vector<Row> RowVector;
+
+		ExpansionSet expandedContexts;
+		ExpansionSet expandedProperties;
+		const DBGp::StackLevel *level;
+		DBGp::Property *menuProperty;
+		RowVector rows;
+		DBGp::Property::PropertyVector unloaded;
+
+		void AppendProperty(DBGp::Property *prop, unsigned int indent);
+		void BuildRows();
+		void Collapse(long item);
+		void Expand(long item);
+		bool LoadChildren(DBGp::Property *prop);
+		void OnExamineValue(wxCommandEvent &event);
+		virtual int OnGetItemImage(long item) const;
+		virtual wxString OnGetItemText(long item, long column) const;
+		void OnItemActivated(wxListEvent &event);
+		void OnItemRightClick(wxListEvent &event);
+		void OnKeyDown(wxListEvent &event);
+		void Rebuild();
+		void RetrieveUnloaded();
+
+		DECLARE_EVENT_TABLE()
+};
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -80,13 +80,13 @@ PropertyTipWindow::PropertyTipWindow(wxWindow *parent, const DBGp::Property *pro
 	if (prop->HasChildren()) {
 		/* We'll do a shallow dump, since detailed information is
 		 * available through the properties panel and context menu. */
-		const DBGp::Property::PropertyMap children = prop->GetChildren();
+		size_t children = prop->GetChildCount();
 		int numShown = 0;
 
 		sizer->Add(20, 10, wxGBPosition(1, 0));
 		
-		for (DBGp::Property::PropertyMap::const_iterator i = children.begin(); i != children.end(); i++) {
-			DBGp::Property *child = i->second;
+		for (size_t i = 0; i < children; i++) {
+			DBGp::Property *child = prop->GetChildAt(i);
 
 			sizer->Add(new wxStaticText(this, -1, child->GetName() + wxT(" (") + child->GetType().GetName() << wxT(")")), wxGBPosition(++numShown, 1));
 
@@ -101,7 +101,7 @@ PropertyTipWindow::PropertyTipWindow(wxWindow *parent, const DBGp::Property *pro
 			if (numShown >= MAXIMUM_CHILD_ELEMENTS) {
 				wxString rem;
 
-				rem.Printf(_("<remaining %d element(s) omitted>"), children.size() - MAXIMUM_CHILD_ELEMENTS);
+				rem.Printf(_("<remaining %d element(s) omitted>"), (int) (children - MAXIMUM_CHILD_ELEMENTS));
 				sizer->Add(new wxStaticText(this, -1, rem), wxGBPosition(++numShown, 0), wxGBSpan(1, 3));
 
 				break;
@@ -163,11 +163,11 @@ wxString PropertyAsString(const DBGp::Property *prop) {
 	text << prop->GetFullName() << wxT(" (") << prop->GetType().GetName() << wxT(") : ");
 
 	if (prop->HasChildren()) {
-		const DBGp::Property::PropertyMap children = prop->GetChildren();
+		size_t children = prop->GetChildCount();
 		int numShown = 0;
 
-		for (DBGp::Property::PropertyMap::const_iterator i = children.begin(); i != children.end(); i++) {
-			const DBGp::Property *child = i->second;
+		for (size_t i = 0; i < children; i++) {
+			const DBGp::Property *child = prop->GetChildAt(i);
 
 			text << wxT("\n\t") << child->GetName() << wxT(" (") << child->GetType().GetName() << wxT(") : ");
 			if (child->HasChildren()) {
@@ -180,7 +180,7 @@ wxString PropertyAsString(const DBGp::Property *prop) {
 			if (++numShown >= MAXIMUM_CHILD_ELEMENTS) {
 				wxString rem;
 
-				rem.Printf(_("<remaining %d element(s) omitted>"), children.size() - MAXIMUM_CHILD_ELEMENTS);
+				rem.Printf(_("<remaining %d element(s) omitted>"), (int) (children - MAXIMUM_CHILD_ELEMENTS));
 				text << wxT("\n") << rem;
 
 				break;
@@ -42,6 +42,8 @@
 
 #include "ID.h"
 
+#include "DBGp/Tracer.h"
+
 using namespace Languages;
 
 // {{{ Event table
@@ -137,10 +139,22 @@ void SourceTextCtrl::SetBreakpointStyle(int line, bool isSet) {
 // }}}
 // {{{ void SourceTextCtrl::SetLexerLanguage(const wxString &language)
 void SourceTextCtrl::SetLexerLanguage(const wxString &language) {
+	DBGP_TRACE("ui", "SourceTextCtrl::SetLexerLanguage");
+
 	StyleClearAll();
 	wxStyledTextCtrl::SetLexerLanguage(language.Lower());
 	SetLexerOptions(GetLexer());
 	SetStyleOptions(GetLexer());
+
+#ifdef DBGP_TRACING
+	/* Scintilla would otherwise lex the visible lines on the next paint,
+	 * outside any trace scope. Lexing them here, synchronously, is only
+	 * worth it when the time is being traced. */
+	{
+		DBGP_TRACE("ui", "Lex");
+		Colourise(0, GetLineEndPosition(GetFirstVisibleLine() + LinesOnScreen()));
+	}
+#endif
 }
 // }}}
 // {{{ void SourceTextCtrl::SetLine(int line)
@@ -158,6 +172,7 @@ void SourceTextCtrl::SetLine(int line) {
 // }}}
 // {{{ void SourceTextCtrl::SetSource(const wxString &source, int line)
 void SourceTextCtrl::SetSource(const wxString &source, int line) {
+	DBGP_TRACE("ui", "SourceTextCtrl::SetSource");
 	breakpoints.clear();
 	Freeze();
 	SetReadOnly(false);
@@ -32,13 +32,11 @@
 #include "StackLevelClientData.h"
 
 // {{{ StackLevelClientData::StackLevelClientData(DBGp::StackLevel *level)
-StackLevelClientData::StackLevelClientData(DBGp::StackLevel *level) : wxClientData() {
-	this->level = new DBGp::StackLevel(*level);
+StackLevelClientData::StackLevelClientData(DBGp::StackLevel *level) : wxClientData(), level(level) {
 }
 // }}}
 // {{{ StackLevelClientData::~StackLevelClientData()
 StackLevelClientData::~StackLevelClientData() {
-	delete level;
 }
 // }}}
 
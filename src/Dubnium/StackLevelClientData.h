@@ -44,6 +44,8 @@ class StackLevelClientData : public wxClientData {
 		DBGp::StackLevel *GetStackLevel();
 
 	protected:
+		/* Owned by the DBGp::Stack the stack panel was populated
+		 * from, which the connection page keeps alive. */
 		DBGp::StackLevel *level;
 };
 
@@ -33,6 +33,8 @@
 #include "ConnectionPage.h"
 #include "StackLevelClientData.h"
 
+#include "DBGp/Tracer.h"
+
 // {{{ Event table
 BEGIN_EVENT_TABLE(StackPanel, wxPanel)
 	EVT_LISTBOX(ID_STACKPANEL_LIST, StackPanel::OnListBox)
@@ -64,6 +66,7 @@ void StackPanel::OnDwell(const wxPoint &pos) {
 // }}}
 // {{{ void StackPanel::SetStack(DBGp::Stack *stack)
 void StackPanel::SetStack(DBGp::Stack *stack) {
+	DBGP_TRACE("ui", "StackPanel::SetStack");
 	list->Freeze();
 
 	list->Clear();
@@ -0,0 +1,148 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "StatisticsPanel.h"
+#include "ConnectionPage.h"
+
+#include <wx/filedlg.h>
+#include <wx/msgdlg.h>
+
+// {{{ Event table
+BEGIN_EVENT_TABLE(StatisticsPanel, wxPanel)
+	EVT_TIMER(ID_STATISTICSPANEL_TIMER, StatisticsPanel::OnTimer)
+	EVT_TOOL(ID_STATISTICSPANEL_REFRESH, StatisticsPanel::OnRefresh)
+	EVT_TOOL(ID_STATISTICSPANEL_RESET, StatisticsPanel::OnReset)
+	EVT_TOOL(wxID_SAVE, StatisticsPanel::OnSave)
+END_EVENT_TABLE()
+// }}}
+
+// {{{ static wxString FormatCount(wxUint64 value)
+static wxString FormatCount(wxUint64 value) {
+	return wxString::Format(wxT("%") wxLongLongFmtSpec wxT("u"), value);
+}
+// }}}
+
+// {{{ StatisticsPanel::StatisticsPanel(ConnectionPage *parent, wxWindowID id)
+StatisticsPanel::StatisticsPanel(ConnectionPage *parent, wxWindowID id) : ToolbarPanel(parent, id) {
+	AddTool(ID_STATISTICSPANEL_REFRESH, _("Refresh"), wxART_REDO, _("Refresh the statistics"));
+	AddTool(ID_STATISTICSPANEL_RESET, _("Reset"), wxART_DELETE, _("Discard the statistics collected so far"));
+	toolbar->AddSeparator();
+	AddTool(wxID_SAVE, _("Save"), wxART_FILE_SAVE, _("Save the statistics to a file"));
+	toolbar->Realize();
+
+	list = new wxListCtrl(this, ID_STATISTICSPANEL_LIST, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_SINGLE_SEL);
+	list->InsertColumn(0, _("Command"));
+	list->InsertColumn(1, _("Sent"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(2, _("Received"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(3, _("Bytes Out"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(4, _("Bytes In"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(5, _("First Byte (us)"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(6, _("Response (us)"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(7, _("Parse (us)"), wxLIST_FORMAT_RIGHT);
+	list->InsertColumn(8, _("Decode (us)"), wxLIST_FORMAT_RIGHT);
+	list->SetToolTip(_("Times are shown as the median, 99th percentile and maximum."));
+	sizer->Add(list, 1, wxEXPAND | wxALL);
+
+	timer = new wxTimer(this, ID_STATISTICSPANEL_TIMER);
+	timer->Start(REFRESH_INTERVAL);
+}
+// }}}
+// {{{ StatisticsPanel::~StatisticsPanel()
+StatisticsPanel::~StatisticsPanel() {
+	timer->Stop();
+	delete timer;
+}
+// }}}
+
+// {{{ void StatisticsPanel::Update()
+void StatisticsPanel::Update() {
+	DBGp::Statistics &statistics = parent->GetConnection()->GetStatistics();
+	DBGp::Statistics::CommandMap commands(statistics.GetCommands());
+
+	list->Freeze();
+	list->DeleteAllItems();
+
+	for (DBGp::Statistics::CommandMap::const_iterator i = commands.begin(); i != commands.end(); i++) {
+		AddRow(i->first, i->second);
+	}
+	if (!commands.empty()) {
+		AddRow(_("(total)"), statistics.GetTotals());
+	}
+
+	list->Thaw();
+}
+// }}}
+
+// {{{ void StatisticsPanel::AddRow(const wxString &name, const DBGp::Statistics::Command &command)
+void StatisticsPanel::AddRow(const wxString &name, const DBGp::Statistics::Command &command) {
+	long item = list->InsertItem(list->GetItemCount(), name);
+
+	list->SetItem(item, 1, FormatCount(command.sent));
+	list->SetItem(item, 2, FormatCount(command.received));
+	list->SetItem(item, 3, FormatCount(command.bytesSent));
+	list->SetItem(item, 4, FormatCount(command.bytesReceived));
+	list->SetItem(item, 5, DBGp::Statistics::Summarise(command.firstByte));
+	list->SetItem(item, 6, DBGp::Statistics::Summarise(command.response));
+	list->SetItem(item, 7, DBGp::Statistics::Summarise(command.parse));
+	list->SetItem(item, 8, DBGp::Statistics::Summarise(command.decode));
+}
+// }}}
+// {{{ void StatisticsPanel::OnRefresh(wxCommandEvent &event)
+void StatisticsPanel::OnRefresh(wxCommandEvent &event) {
+	Update();
+}
+// }}}
+// {{{ void StatisticsPanel::OnReset(wxCommandEvent &event)
+void StatisticsPanel::OnReset(wxCommandEvent &event) {
+	parent->GetConnection()->GetStatistics().Reset();
+	Update();
+}
+// }}}
+// {{{ void StatisticsPanel::OnSave(wxCommandEvent &event)
+void StatisticsPanel::OnSave(wxCommandEvent &event) {
+	wxFileDialog fd(this, _("Save Statistics"), wxEmptyString, wxEmptyString, wxT("*.*"), wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (fd.ShowModal() == wxID_OK) {
+		if (!parent->GetConnection()->GetStatistics().Dump(fd.GetPath())) {
+			wxMessageBox(_("The statistics could not be saved."), _("Error"), wxICON_ERROR | wxOK);
+		}
+	}
+}
+// }}}
+// {{{ void StatisticsPanel::OnTimer(wxTimerEvent &event)
+void StatisticsPanel::OnTimer(wxTimerEvent &event) {
+	// There's no point rebuilding the list while the pane is hidden.
+	if (IsShown()) {
+		Update();
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
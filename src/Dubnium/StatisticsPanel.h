@@ -0,0 +1,76 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef DUBNIUM_STATISTICSPANEL_H
+#define DUBNIUM_STATISTICSPANEL_H
+
+#include <wx/listctrl.h>
+#include <wx/timer.h>
+
+#include "DBGp/Connection.h"
+#include "DBGp/Statistics.h"
+
+#include "ID.h"
+#include "ToolbarPanel.h"
+
+class ConnectionPage;
+
+/**
+ * Shows the per-command traffic and latency figures the connection has
+ * collected. The figures are refreshed periodically while the pane is
+ * visible.
+ */
+class StatisticsPanel : public ToolbarPanel {
+	public:
+		StatisticsPanel(ConnectionPage *parent, wxWindowID id = wxID_ANY);
+		virtual ~StatisticsPanel();
+
+		void Update();
+
+	protected:
+		/** How often the figures are refreshed, in milliseconds. */
+		static const int REFRESH_INTERVAL = 1000;
+
+		wxListCtrl *list;
+		wxTimer *timer;
+
+		void AddRow(const wxString &name, const DBGp::Statistics::Command &command);
+		void OnRefresh(wxCommandEvent &event);
+		void OnReset(wxCommandEvent &event);
+		void OnSave(wxCommandEvent &event);
+		void OnTimer(wxTimerEvent &event);
+
+		DECLARE_EVENT_TABLE()
+};
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,115 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Async.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Async);
+
+// {{{ void Async::setUp()
+void Async::setUp() {
+	DBGpFixture::setUp();
+	conn->ProcessNextResponse();
+	errors = 0;
+	responses = 0;
+}
+// }}}
+
+// {{{ void Async::testCallback()
+void Async::testCallback() {
+	AddResponse(wxT("xml/feature/get-success.xml"));
+	AddResponse(wxT("xml/feature/get-error.xml"));
+	AddResponse(wxT("xml/source/success.xml"));
+
+	DBGp::MessageArguments args(1, wxT("-n"), wxT("test"));
+	conn->SendCommandAsync(wxT("feature_get"), args, new DBGp::ResponseCallback<Async>(this, &Async::OnResponse, &Async::OnError));
+	conn->SendCommandAsync(wxT("feature_get"), args, new DBGp::ResponseCallback<Async>(this, &Async::OnResponse, &Async::OnError));
+
+	/* The earlier responses should be handed to their callbacks while the
+	 * synchronous command waits for its own. */
+	wxString source(conn->Source());
+	CPPUNIT_ASSERT(source == wxT("<?php phpinfo(); ?>"));
+	CPPUNIT_ASSERT(responses == 1);
+	CPPUNIT_ASSERT(errors == 1);
+}
+// }}}
+// {{{ void Async::testError()
+void Async::testError() {
+	AddResponse(wxT("xml/feature/get-error.xml"));
+
+	DBGp::TransactionID id = conn->SendCommandAsync(wxT("feature_get"), DBGp::MessageArguments(1, wxT("-n"), wxT("test")));
+	conn->WaitForResponse(id);
+}
+// }}}
+// {{{ void Async::testNotPending()
+void Async::testNotPending() {
+	conn->WaitForResponse(12345);
+}
+// }}}
+// {{{ void Async::testPipelined()
+void Async::testPipelined() {
+	AddResponse(wxT("xml/source/success.xml"));
+	AddResponse(wxT("xml/feature/set-success.xml"));
+	AddResponse(wxT("xml/feature/get-success.xml"));
+
+	DBGp::TransactionID source = conn->SendCommandAsync(wxT("source"), DBGp::MessageArguments());
+	DBGp::TransactionID set = conn->SendCommandAsync(wxT("feature_set"), DBGp::MessageArguments(2, wxT("-n"), wxT("test"), wxT("-v"), wxT("1")));
+	DBGp::TransactionID get = conn->SendCommandAsync(wxT("feature_get"), DBGp::MessageArguments(1, wxT("-n"), wxT("test")));
+
+	// Collect the responses in a different order to that they were sent.
+	wxXmlDocument getDoc(conn->WaitForResponse(get));
+	CPPUNIT_ASSERT(getDoc.GetRoot()->GetPropVal(wxT("command"), wxEmptyString) == wxT("feature_get"));
+	CPPUNIT_ASSERT(getDoc.GetRoot()->GetNodeContent() == wxT("Unit testing FTW"));
+
+	wxXmlDocument sourceDoc(conn->WaitForResponse(source));
+	CPPUNIT_ASSERT(sourceDoc.GetRoot()->GetPropVal(wxT("command"), wxEmptyString) == wxT("source"));
+	CPPUNIT_ASSERT(sourceDoc.GetRoot()->GetNodeContent() == wxT("<?php phpinfo(); ?>"));
+
+	wxXmlDocument setDoc(conn->WaitForResponse(set));
+	CPPUNIT_ASSERT(setDoc.GetRoot()->GetPropVal(wxT("success"), wxEmptyString) == wxT("1"));
+}
+// }}}
+
+// {{{ void Async::OnError(DBGp::Connection *conn, const DBGp::EngineError &error)
+void Async::OnError(DBGp::Connection *conn, const DBGp::EngineError &error) {
+	CPPUNIT_ASSERT(conn == this->conn);
+	CPPUNIT_ASSERT(error.GetCode() == 998);
+	++errors;
+}
+// }}}
+// {{{ void Async::OnResponse(DBGp::Connection *conn, wxXmlDocument &doc)
+void Async::OnResponse(DBGp::Connection *conn, wxXmlDocument &doc) {
+	CPPUNIT_ASSERT(conn == this->conn);
+	CPPUNIT_ASSERT(doc.GetRoot()->GetNodeContent() == wxT("Unit testing FTW"));
+	++responses;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,270 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Base64.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Base64Test);
+
+/* The implementation as it was before the raw buffer and SIMD code went in,
+ * kept here so that the output of the new code can be checked against it. */
+namespace Legacy {
+	static char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	// {{{ static char AlphabetPosition(char c)
+	static char AlphabetPosition(char c) {
+		char *pos = std::strchr(alphabet, c);
+		CPPUNIT_ASSERT(pos != NULL);
+		return pos - alphabet;
+	}
+	// }}}
+	// {{{ static void Decode(const wxString &base64, char *data)
+	static void Decode(const wxString &base64, char *data) {
+		char *c = data;
+
+		for (size_t i = 0; i < base64.Length(); i += 4) {
+			wxUint32 buffer;
+			wxString slice(base64.Mid(i, 4));
+
+			buffer = AlphabetPosition(slice[0]) * 67108864 + AlphabetPosition(slice[1]) * 1048576;
+			*c = static_cast<char>(buffer >> 24);
+			++c;
+			if (slice[2] != wxT('=')) {
+				buffer += AlphabetPosition(slice[2]) * 16384;
+				*c = static_cast<char>(buffer >> 16);
+				++c;
+				if (slice[3] != wxT('=')) {
+					buffer += AlphabetPosition(slice[3]) * 256;
+					*c = static_cast<char>(buffer >> 8);
+					++c;
+				}
+			}
+		}
+	}
+	// }}}
+	// {{{ static wxString Encode(const char *s, size_t length)
+	static wxString Encode(const char *s, size_t length) {
+		const char *ptr = s;
+		wxString enc;
+
+		for (; length >= 3 && ptr <= (s + length - 3); ptr += 3) {
+			wxUint32 bufVal = ptr[0] * 16777216 + ptr[1] * 65536 + ptr[2] * 256;
+			for (size_t i = 0; i < 4; ++i) {
+				unsigned char c = bufVal >> 26;
+				bufVal = bufVal << 6;
+				enc += alphabet[c];
+			}
+		}
+
+		if (ptr < (s + length)) {
+			char rem = (s + length) - ptr;
+			wxUint32 bufVal = ptr[0] * 16777216;
+			if (rem == 2) {
+				bufVal += ptr[1] * 65536;
+			}
+			for (char i = 0; i <= rem; i++) {
+				unsigned char c = bufVal >> 26;
+				bufVal = bufVal << 6;
+				enc += alphabet[c];
+			}
+			enc << (rem == 1 ? wxT("==") : wxT("="));
+		}
+
+		return enc;
+	}
+	// }}}
+}
+
+// {{{ static std::string RandomData(size_t length, int range)
+static std::string RandomData(size_t length, int range) {
+	std::string data(length, '\0');
+	for (size_t i = 0; i < length; i++) {
+		data[i] = static_cast<char>(std::rand() % range);
+	}
+	return data;
+}
+// }}}
+// {{{ static std::vector<Base64::Implementation> SupportedImplementations()
+static std::vector<Base64::Implementation> SupportedImplementations() {
+	std::vector<Base64::Implementation> implementations;
+	Base64::Implementation all[] = { Base64::SCALAR, Base64::SSE2, Base64::AVX2 };
+
+	for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+		if (Base64::IsSupported(all[i])) {
+			implementations.push_back(all[i]);
+		}
+	}
+	return implementations;
+}
+// }}}
+
+// {{{ void Base64Test::setUp()
+void Base64Test::setUp() {
+	original = Base64::GetImplementation();
+	std::srand(42);
+}
+// }}}
+// {{{ void Base64Test::tearDown()
+void Base64Test::tearDown() {
+	Base64::SetImplementation(original);
+}
+// }}}
+
+// {{{ void Base64Test::testDecodeMatchesLegacy()
+void Base64Test::testDecodeMatchesLegacy() {
+	std::vector<Base64::Implementation> implementations(SupportedImplementations());
+
+	for (size_t length = 0; length < 200; length++) {
+		// The old encoder mangled bytes above 0x7f, so stick to ASCII.
+		std::string data(RandomData(length, 128));
+		wxString encoded(Legacy::Encode(data.data(), length));
+		std::vector<char> expected(length + 1);
+		Legacy::Decode(encoded, &expected[0]);
+
+		for (size_t i = 0; i < implementations.size(); i++) {
+			Base64::SetImplementation(implementations[i]);
+
+			std::vector<char> decoded(length + 1);
+			Base64::Decode(encoded, &decoded[0], length + 1);
+			CPPUNIT_ASSERT(std::memcmp(&decoded[0], &expected[0], length) == 0);
+			CPPUNIT_ASSERT(decoded[length] == '\0');
+
+			std::string raw(encoded.mb_str(wxConvUTF8));
+			CPPUNIT_ASSERT(Base64::Decode(raw.data(), raw.length(), &decoded[0], length) == length);
+			CPPUNIT_ASSERT(std::memcmp(&decoded[0], &expected[0], length) == 0);
+		}
+	}
+}
+// }}}
+// {{{ void Base64Test::testEncodeMatchesLegacy()
+void Base64Test::testEncodeMatchesLegacy() {
+	std::vector<Base64::Implementation> implementations(SupportedImplementations());
+
+	for (size_t length = 0; length < 200; length++) {
+		std::string data(RandomData(length, 128));
+		wxString expected(Legacy::Encode(data.data(), length));
+
+		for (size_t i = 0; i < implementations.size(); i++) {
+			Base64::SetImplementation(implementations[i]);
+			CPPUNIT_ASSERT(Base64::Encode(data.data(), length) == expected);
+			CPPUNIT_ASSERT(Base64::EncodedLength(length) == expected.Length());
+		}
+	}
+}
+// }}}
+// {{{ void Base64Test::testHighBytes()
+void Base64Test::testHighBytes() {
+	char decoded[4];
+
+	CPPUNIT_ASSERT(Base64::Encode("\xff\xfe\xfd", 3) == wxT("//79"));
+	CPPUNIT_ASSERT(Base64::Encode("\x80", 1) == wxT("gA=="));
+	CPPUNIT_ASSERT(Base64::Encode("\xc3\xa9", 2) == wxT("w6k="));
+
+	CPPUNIT_ASSERT(Base64::Decode("//79", 4, decoded, sizeof(decoded)) == 3);
+	CPPUNIT_ASSERT(std::memcmp(decoded, "\xff\xfe\xfd", 3) == 0);
+}
+// }}}
+// {{{ void Base64Test::testImplementations()
+void Base64Test::testImplementations() {
+	std::vector<Base64::Implementation> implementations(SupportedImplementations());
+
+	CPPUNIT_ASSERT(implementations[0] == Base64::SCALAR);
+	CPPUNIT_ASSERT(Base64::IsSupported(Base64::GetImplementation()));
+
+	// Long enough to exercise the vector paths and their tails.
+	for (size_t length = 0; length < 400; length += 7) {
+		std::string data(RandomData(length, 256));
+
+		Base64::SetImplementation(Base64::SCALAR);
+		std::vector<char> expected(Base64::EncodedLength(length) + 1);
+		size_t expectedLength = Base64::Encode(data.data(), length, &expected[0], expected.size());
+		CPPUNIT_ASSERT(expectedLength == Base64::EncodedLength(length));
+
+		for (size_t i = 1; i < implementations.size(); i++) {
+			Base64::SetImplementation(implementations[i]);
+
+			std::vector<char> encoded(expected.size());
+			CPPUNIT_ASSERT(Base64::Encode(data.data(), length, &encoded[0], encoded.size()) == expectedLength);
+			CPPUNIT_ASSERT(std::memcmp(&encoded[0], &expected[0], expectedLength) == 0);
+
+			std::vector<char> decoded(length + 1);
+			CPPUNIT_ASSERT(Base64::Decode(&encoded[0], expectedLength, &decoded[0], length) == length);
+			CPPUNIT_ASSERT(std::string(&decoded[0], length) == data);
+		}
+	}
+}
+// }}}
+// {{{ void Base64Test::testInsufficientBuffer()
+void Base64Test::testInsufficientBuffer() {
+	char decoded[2];
+	Base64::Decode("QUJD", 4, decoded, sizeof(decoded));
+}
+// }}}
+// {{{ void Base64Test::testInvalidCharacter()
+void Base64Test::testInvalidCharacter() {
+	/* Put the bad character a long way in, so that the vector code has
+	 * to notice it and hand over. */
+	std::string encoded(200, 'Q');
+	encoded[150] = '*';
+
+	char decoded[200];
+	Base64::Decode(encoded.data(), encoded.length(), decoded, sizeof(decoded));
+}
+// }}}
+// {{{ void Base64Test::testWhitespace()
+void Base64Test::testWhitespace() {
+	std::vector<Base64::Implementation> implementations(SupportedImplementations());
+	std::string data(RandomData(300, 256));
+	wxString encoded(Base64::Encode(data.data(), data.length()));
+
+	// Wrap the encoded data the way MIME would.
+	std::string wrapped;
+	std::string raw(encoded.mb_str(wxConvUTF8));
+	for (size_t i = 0; i < raw.length(); i += 76) {
+		wrapped.append(raw, i, 76);
+		wrapped.append("\r\n");
+	}
+
+	for (size_t i = 0; i < implementations.size(); i++) {
+		Base64::SetImplementation(implementations[i]);
+
+		std::vector<char> decoded(Base64::MaxDataLength(wrapped.length()));
+		size_t length = Base64::Decode(wrapped.data(), wrapped.length(), &decoded[0], decoded.size());
+		CPPUNIT_ASSERT(std::string(&decoded[0], length) == data);
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
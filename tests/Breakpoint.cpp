@@ -31,6 +31,8 @@
 
 #include "Breakpoint.h"
 
+#include "DBGp/BreakpointBatch.h"
+
 #include <algorithm>
 
 CPPUNIT_TEST_SUITE_REGISTRATION(Breakpoint);
@@ -49,6 +51,59 @@ void Breakpoint::tearDown() {
 }
 // }}}
 
+// {{{ void Breakpoint::testBatch()
+void Breakpoint::testBatch() {
+	AddResponse(wxT("xml/breakpoint/set.xml"));
+	AddResponse(wxT("xml/breakpoint/set-2.xml"));
+	AddResponse(wxT("xml/breakpoint/remove.xml"));
+	AddResponse(wxT("xml/breakpoint/remove.xml"));
+
+	size_t sent = conn->GetCommands().size();
+	DBGp::BreakpointBatch batch(conn);
+	DBGp::Breakpoint *call = batch.CreateBreakpoint();
+	DBGp::Breakpoint *exception = batch.CreateBreakpoint();
+
+	// Nothing should be sent until the batch is.
+	call->SetCallType(wxT("func"));
+	call->SetHitCondition(DBGp::Breakpoint::HIT_GE, 42);
+	exception->SetExceptionType(wxT("TestException"));
+	CPPUNIT_ASSERT(conn->GetCommands().size() == sent);
+	CPPUNIT_ASSERT(call->GetID() == wxEmptyString);
+
+	CPPUNIT_ASSERT(batch.Send() == 2);
+	CPPUNIT_ASSERT(batch.IsEmpty());
+	CPPUNIT_ASSERT(conn->GetCommands().size() == sent + 2);
+	CPPUNIT_ASSERT(call->GetID() == wxT("BP1"));
+	CPPUNIT_ASSERT(call->GetHitValue() == 42);
+	CPPUNIT_ASSERT(exception->GetID() == wxT("BP2"));
+
+	conn->RemoveBreakpoint(call);
+	conn->RemoveBreakpoint(exception);
+}
+// }}}
+// {{{ void Breakpoint::testBatchError()
+void Breakpoint::testBatchError() {
+	AddResponse(wxT("xml/breakpoint/set.xml"));
+	AddResponse(wxT("xml/breakpoint/set-error.xml"));
+	AddResponse(wxT("xml/breakpoint/remove.xml"));
+
+	const DBGp::Connection::BreakpointList &breakpoints = conn->GetBreakpoints();
+	DBGp::BreakpointBatch batch(conn);
+	DBGp::Breakpoint *call = batch.CreateBreakpoint();
+	DBGp::Breakpoint *rejected = batch.CreateBreakpoint();
+
+	call->SetCallType(wxT("func"));
+	rejected->SetReturnType(wxT("func"));
+
+	// The rejected breakpoint should be removed from the connection.
+	CPPUNIT_ASSERT(batch.Send() == 1);
+	CPPUNIT_ASSERT(call->GetID() == wxT("BP1"));
+	CPPUNIT_ASSERT(std::find(breakpoints.begin(), breakpoints.end(), call) != breakpoints.end());
+	CPPUNIT_ASSERT(std::find(breakpoints.begin(), breakpoints.end(), rejected) == breakpoints.end());
+
+	conn->RemoveBreakpoint(call);
+}
+// }}}
 // {{{ void Breakpoint::testCall()
 void Breakpoint::testCall() {
 	AddResponse(wxT("xml/breakpoint/set.xml"));
@@ -175,6 +230,32 @@ void Breakpoint::testLine() {
 	run();
 }
 // }}}
+// {{{ void Breakpoint::testRefresh()
+void Breakpoint::testRefresh() {
+	AddResponse(wxT("xml/breakpoint/set.xml"));
+	AddResponse(wxT("xml/breakpoint/set-2.xml"));
+	AddResponse(wxT("xml/breakpoint/list.xml"));
+	AddResponse(wxT("xml/breakpoint/remove.xml"));
+
+	DBGp::Breakpoint *hit = conn->CreateBreakpoint();
+	DBGp::Breakpoint *gone = conn->CreateBreakpoint();
+	hit->SetCallType(wxT("func"));
+	gone->SetLineType(wxT("dbgp://"), 42);
+	CPPUNIT_ASSERT(hit->GetLastHitCount() == 0);
+
+	DBGp::Connection::BreakpointList changed(conn->RefreshBreakpoints());
+	CPPUNIT_ASSERT(changed.size() == 2);
+	CPPUNIT_ASSERT(std::find(changed.begin(), changed.end(), hit) != changed.end());
+	CPPUNIT_ASSERT(std::find(changed.begin(), changed.end(), gone) != changed.end());
+	CPPUNIT_ASSERT(hit->GetLastHitCount() == 3);
+	CPPUNIT_ASSERT(hit->GetID() == wxT("BP1"));
+	CPPUNIT_ASSERT(gone->GetID() == wxEmptyString);
+	CPPUNIT_ASSERT(conn->GetBreakpoint(wxT("BP9")) == NULL);
+
+	conn->RemoveBreakpoint(hit);
+	conn->RemoveBreakpoint(gone);
+}
+// }}}
 // {{{ void Breakpoint::testReturn()
 void Breakpoint::testReturn() {
 	AddResponse(wxT("xml/breakpoint/set.xml"));
@@ -36,6 +36,8 @@
 
 class Breakpoint : public DBGpFixture {
 	CPPUNIT_TEST_SUITE(Breakpoint);
+	CPPUNIT_TEST(testBatch);
+	CPPUNIT_TEST(testBatchError);
 	CPPUNIT_TEST(testCall);
 	CPPUNIT_TEST(testConditional);
 	CPPUNIT_TEST(testCreateRemove);
@@ -43,6 +45,7 @@ class Breakpoint : public DBGpFixture {
 	CPPUNIT_TEST_EXCEPTION(testGetError, DBGp::EngineError);
 	CPPUNIT_TEST(testHitCondition);
 	CPPUNIT_TEST(testLine);
+	CPPUNIT_TEST(testRefresh);
 	CPPUNIT_TEST(testReturn);
 	CPPUNIT_TEST_EXCEPTION(testSetError, DBGp::EngineError);
 	CPPUNIT_TEST(testTemporary);
@@ -54,6 +57,8 @@ class Breakpoint : public DBGpFixture {
 		virtual void setUp();
 		virtual void tearDown();
 
+		void testBatch();
+		void testBatchError();
 		void testCall();
 		void testConditional();
 		void testCreateRemove();
@@ -61,6 +66,7 @@ class Breakpoint : public DBGpFixture {
 		void testGetError();
 		void testHitCondition();
 		void testLine();
+		void testRefresh();
 		void testReturn();
 		void testSetError();
 		void testTemporary();
@@ -0,0 +1,215 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "FrameReader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FrameReader);
+
+// {{{ class StringSource
+/* A frame source that hands out a fixed string a few bytes at a time, much
+ * like a socket would if the data was arriving slowly. */
+class StringSource : public DBGp::FrameReader::Source {
+	public:
+		StringSource(const std::string &data, size_t segment) : data(data), position(0), reads(0), segment(segment) {}
+
+		size_t Read(char *buffer, size_t length) throw (DBGp::SocketError) {
+			size_t available = data.length() - position;
+
+			if (available == 0) {
+				throw DBGp::SocketError(wxT("End of data."));
+			}
+
+			if (available > segment) {
+				available = segment;
+			}
+			if (available > length) {
+				available = length;
+			}
+
+			std::memcpy(buffer, data.data() + position, available);
+			position += available;
+			++reads;
+
+			return available;
+		}
+
+		inline int GetReads() const { return reads; }
+
+	private:
+		std::string data;
+		size_t position;
+		int reads;
+		size_t segment;
+};
+// }}}
+
+// {{{ static std::string Frame(const std::string &payload)
+static std::string Frame(const std::string &payload) {
+	std::string frame;
+	char length[32];
+
+	std::sprintf(length, "%lu", static_cast<unsigned long>(payload.length()));
+	frame.append(length);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	return frame;
+}
+// }}}
+
+// {{{ void FrameReader::testFill()
+void FrameReader::testFill() {
+	std::string data(Frame("<response command=\"run\"/>") + Frame("<stream type=\"stdout\"/>"));
+	StringSource source(data, 7);
+	DBGp::FrameReader reader(16);
+	const char *payload;
+	size_t length;
+
+	while (!reader.NextFrame(payload, length)) {
+		reader.Fill(source);
+	}
+	CPPUNIT_ASSERT(std::string(payload, length) == "<response command=\"run\"/>");
+
+	while (!reader.NextFrame(payload, length)) {
+		reader.Fill(source);
+	}
+	CPPUNIT_ASSERT(std::string(payload, length) == "<stream type=\"stdout\"/>");
+	CPPUNIT_ASSERT(source.GetReads() == static_cast<int>((data.length() + 6) / 7));
+}
+// }}}
+// {{{ void FrameReader::testLargeFrame()
+void FrameReader::testLargeFrame() {
+	std::string payload(200000, 'x');
+	StringSource source(Frame(payload), payload.length() + 16);
+	DBGp::FrameReader reader(16);
+	const char *frame;
+	size_t length;
+
+	/* Once the header has been seen, the reader should ask for the rest of
+	 * the frame in one go, rather than in chunk sized pieces. */
+	while (!reader.NextFrame(frame, length)) {
+		reader.Fill(source);
+	}
+	CPPUNIT_ASSERT(length == payload.length());
+	CPPUNIT_ASSERT(std::string(frame, length) == payload);
+	CPPUNIT_ASSERT(source.GetReads() == 2);
+}
+// }}}
+// {{{ void FrameReader::testMalformedLength()
+void FrameReader::testMalformedLength() {
+	DBGp::FrameReader reader;
+
+	reader.Append("12a\0", 4);
+	reader.HasFrame();
+}
+// }}}
+// {{{ void FrameReader::testMissingTerminator()
+void FrameReader::testMissingTerminator() {
+	DBGp::FrameReader reader;
+	const char *payload;
+	size_t length;
+
+	reader.Append("4\0<a/>x", 7);
+	reader.NextFrame(payload, length);
+}
+// }}}
+// {{{ void FrameReader::testMultipleFrames()
+void FrameReader::testMultipleFrames() {
+	std::string data(Frame("<a/>") + Frame("<b/>") + Frame("<c/>"));
+	DBGp::FrameReader reader;
+	const char *payload;
+	size_t length;
+
+	reader.Append(data.data(), data.length());
+
+	CPPUNIT_ASSERT(reader.NextFrame(payload, length));
+	CPPUNIT_ASSERT(std::string(payload, length) == "<a/>");
+	CPPUNIT_ASSERT(reader.NextFrame(payload, length));
+	CPPUNIT_ASSERT(std::string(payload, length) == "<b/>");
+	CPPUNIT_ASSERT(reader.NextFrame(payload, length));
+	CPPUNIT_ASSERT(std::string(payload, length) == "<c/>");
+	CPPUNIT_ASSERT(!reader.NextFrame(payload, length));
+	CPPUNIT_ASSERT(reader.GetBufferedLength() == 0);
+}
+// }}}
+// {{{ void FrameReader::testPartialFrame()
+void FrameReader::testPartialFrame() {
+	std::string data(Frame("<response/>") + Frame("<init/>"));
+
+	/* Split the data at every possible point, and make sure the frames
+	 * come out intact either way. */
+	for (size_t split = 0; split <= data.length(); split++) {
+		DBGp::FrameReader reader(4);
+		const char *payload;
+		size_t length;
+
+		reader.Append(data.data(), split);
+		int frames = 0;
+		while (reader.NextFrame(payload, length)) {
+			++frames;
+		}
+
+		reader.Append(data.data() + split, data.length() - split);
+		while (reader.NextFrame(payload, length)) {
+			CPPUNIT_ASSERT(payload[length] == '\0');
+			++frames;
+		}
+
+		CPPUNIT_ASSERT(frames == 2);
+		CPPUNIT_ASSERT(std::string(payload, length) == "<init/>");
+	}
+}
+// }}}
+// {{{ void FrameReader::testSingleFrame()
+void FrameReader::testSingleFrame() {
+	std::string data(Frame("<init appid=\"1\"/>"));
+	DBGp::FrameReader reader;
+	const char *payload;
+	size_t length;
+
+	CPPUNIT_ASSERT(!reader.HasFrame());
+	reader.Append(data.data(), data.length() - 1);
+	CPPUNIT_ASSERT(!reader.HasFrame());
+	reader.Append(data.data() + data.length() - 1, 1);
+	CPPUNIT_ASSERT(reader.HasFrame());
+
+	CPPUNIT_ASSERT(reader.NextFrame(payload, length));
+	CPPUNIT_ASSERT(length == 17);
+	CPPUNIT_ASSERT(std::strcmp(payload, "<init appid=\"1\"/>") == 0);
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,197 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "IOThread.h"
+
+#include <unistd.h>
+
+#include <wx/socket.h>
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+#include "DBGp/Stack.h"
+#include "DBGp/Transport.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(IOThread);
+
+/* How long to wait for the connection to catch up, in milliseconds. */
+static const int TIMEOUT = 5000;
+
+// {{{ class EngineThread
+/* Serves the simulated script over the engine's end of the socket until the
+ * IDE hangs up. */
+class EngineThread : public wxThread {
+	public:
+		EngineThread(const DBGp::Simulator::Workload &workload, int fd) : wxThread(wxTHREAD_JOINABLE), fd(fd), simulator(workload) {}
+
+	protected:
+		int fd;
+		DBGp::Simulator simulator;
+
+		virtual ExitCode Entry() {
+			try {
+				simulator.Serve(fd);
+			}
+			catch (DBGp::SocketError e) {
+			}
+			close(fd);
+			return 0;
+		}
+};
+// }}}
+
+// {{{ void IOThread::setUp()
+void IOThread::setUp() {
+	init = new wxInitializer;
+	conn = NULL;
+	connection = NULL;
+	engine = NULL;
+	lastEvent = NULL;
+	stdoutEvents = 0;
+	server = new Test::Server(this);
+
+	workload.contexts = 2;
+	workload.nesting = 1;
+	workload.properties = 5;
+	workload.stdoutPackets = 3;
+
+	wxIPV4address addr;
+	addr.LocalHost();
+	addr.Service(0);
+
+	wxSocketServer listener(addr);
+	CPPUNIT_ASSERT(listener.IsOk());
+	CPPUNIT_ASSERT(listener.GetLocal(addr));
+
+	// The backlog lets the engine connect before anything is accepted.
+	int fd = DBGp::Transport(addr.Service()).Connect();
+	wxSocketClient *socket = new wxSocketClient;
+	CPPUNIT_ASSERT(listener.AcceptWith(*socket, true));
+
+	engine = new EngineThread(workload, fd);
+	CPPUNIT_ASSERT(engine->Create() == wxTHREAD_NO_ERROR);
+	CPPUNIT_ASSERT(engine->Run() == wxTHREAD_NO_ERROR);
+
+	connection = new DBGp::Connection(socket, server);
+	CPPUNIT_ASSERT(connection->StartIOThread());
+
+	/* The init packet is dispatched from the pending frames event, and
+	 * the handshake waits for its responses synchronously while further
+	 * frames keep arriving on the I/O thread. */
+	CPPUNIT_ASSERT(WaitForEvent(wxEVT_DBGP_CONNECTION));
+}
+// }}}
+// {{{ void IOThread::tearDown()
+void IOThread::tearDown() {
+	// Hanging up ends the simulated session.
+	delete connection;
+	if (engine) {
+		engine->Wait();
+		delete engine;
+	}
+
+	DBGpFixture::tearDown();
+	delete init;
+}
+// }}}
+
+// {{{ void IOThread::OnStdoutEvent(DBGp::StdoutEvent &event)
+void IOThread::OnStdoutEvent(DBGp::StdoutEvent &event) {
+	stdoutEvents++;
+	DBGpFixture::OnStdoutEvent(event);
+}
+// }}}
+
+// {{{ void IOThread::testIdleEvents()
+void IOThread::testIdleEvents() {
+	/* Nothing waits for the response to run: it and the stdout packets
+	 * before it are dispatched as they arrive. */
+	connection->Run();
+	CPPUNIT_ASSERT(WaitForEvent(wxEVT_DBGP_STATUSCHANGE));
+	CPPUNIT_ASSERT(connection->GetStatus() == DBGp::Connection::BREAK);
+	CPPUNIT_ASSERT_EQUAL((size_t) workload.stdoutPackets, stdoutEvents);
+
+	// Idle dispatch carries on once a synchronous wait is over.
+	CPPUNIT_ASSERT(connection->Status() == DBGp::Connection::BREAK);
+	connection->StepInto();
+	CPPUNIT_ASSERT(WaitForEvent(wxEVT_DBGP_STATUSCHANGE));
+	CPPUNIT_ASSERT_EQUAL((size_t) workload.stdoutPackets * 2, stdoutEvents);
+}
+// }}}
+// {{{ void IOThread::testStreamedContext()
+void IOThread::testStreamedContext() {
+	connection->Run();
+	CPPUNIT_ASSERT(WaitForEvent(wxEVT_DBGP_STATUSCHANGE));
+
+	/* Every context is requested at once, and each response is built
+	 * into properties on the I/O thread as it's parsed. */
+	DBGp::Stack stack(connection->StackGet());
+	DBGp::StackLevel *level = stack.GetLevel(0);
+	CPPUNIT_ASSERT(level != NULL);
+
+	const DBGp::StackLevel::ContextMap &contexts(level->GetContexts());
+	CPPUNIT_ASSERT_EQUAL((size_t) workload.contexts, contexts.size());
+	for (DBGp::StackLevel::ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
+		CPPUNIT_ASSERT_EQUAL((size_t) workload.properties, i->second->GetProperties().size());
+	}
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$var0")) != NULL);
+}
+// }}}
+// {{{ void IOThread::testWait()
+void IOThread::testWait() {
+	CPPUNIT_ASSERT(connection->IsThreaded());
+
+	// The handshake's answers came back through the queue.
+	CPPUNIT_ASSERT(connection->CommandSupported(wxT("break")));
+	CPPUNIT_ASSERT(connection->GetMaxChildren() == DBGp::Connection::DEFAULT_MAX_CHILDREN);
+
+	CPPUNIT_ASSERT(connection->Status() == DBGp::Connection::STARTING);
+	CPPUNIT_ASSERT(connection->FeatureSet(wxT("max_depth"), wxT("2")));
+}
+// }}}
+
+// {{{ bool IOThread::WaitForEvent(wxEventType type)
+bool IOThread::WaitForEvent(wxEventType type) {
+	delete lastEvent;
+	lastEvent = NULL;
+
+	for (int waited = 0; waited < TIMEOUT; waited += 10) {
+		connection->ProcessPendingEvents();
+		if (lastEvent && lastEvent->GetEventType() == type) {
+			return true;
+		}
+		wxMilliSleep(10);
+	}
+	return false;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,81 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef TEST_IOTHREAD_H
+#define TEST_IOTHREAD_H
+
+#include <wx/init.h>
+
+#include "DBGp/Connection.h"
+#include "DBGp/Simulator.h"
+
+#include "DBGpFixture.h"
+
+class EngineThread;
+
+/* Runs a real connection in threaded mode against the simulator, over a
+ * loopback socket, rather than feeding canned responses to
+ * Test::Connection. */
+class IOThread : public DBGpFixture {
+	CPPUNIT_TEST_SUITE(IOThread);
+	CPPUNIT_TEST(testIdleEvents);
+	CPPUNIT_TEST(testStreamedContext);
+	CPPUNIT_TEST(testWait);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp();
+		void tearDown();
+
+		virtual void OnStdoutEvent(DBGp::StdoutEvent &event);
+
+		void testIdleEvents();
+		void testStreamedContext();
+		void testWait();
+
+	protected:
+		DBGp::Connection *connection;
+		EngineThread *engine;
+		wxInitializer *init;
+		size_t stdoutEvents;
+		DBGp::Simulator::Workload workload;
+
+		/**
+		 * Dispatches the events the I/O thread posts to the
+		 * connection, as the event loop would, until a new event of
+		 * the given type has reached the fixture.
+		 */
+		bool WaitForEvent(wxEventType type);
+};
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
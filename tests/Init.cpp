@@ -33,6 +33,42 @@
 
 CPPUNIT_TEST_SUITE_REGISTRATION(Init);
 
+// {{{ void Init::testFilterAccept()
+void Init::testFilterAccept() {
+	server->GetFilter().SetDefaultAction(DBGp::ConnectionFilter::REJECT);
+	server->GetFilter().AddRule(DBGp::ConnectionFilter::IDEKEY, wxT("Test*"), DBGp::ConnectionFilter::ACCEPT);
+
+	conn->ProcessNextResponse();
+	CPPUNIT_ASSERT(lastEvent != NULL);
+	CPPUNIT_ASSERT(lastEvent->GetEventType() == wxEVT_DBGP_CONNECTION);
+	CPPUNIT_ASSERT(!conn->GetCommands().empty());
+}
+// }}}
+// {{{ void Init::testFilterDetach()
+void Init::testFilterDetach() {
+	server->GetFilter().SetDefaultAction(DBGp::ConnectionFilter::DETACH);
+	server->GetFilter().AddRule(DBGp::ConnectionFilter::IDEKEY, wxT("Someone Else"), DBGp::ConnectionFilter::ACCEPT);
+
+	conn->ProcessNextResponse();
+	CPPUNIT_ASSERT(lastEvent == NULL);
+	CPPUNIT_ASSERT(conn->GetStatus() == DBGp::Connection::STOPPED);
+
+	// The detach should be the only thing sent.
+	CPPUNIT_ASSERT(conn->GetCommands().size() == 1);
+	CPPUNIT_ASSERT(conn->GetCommands().front() == wxT("detach"));
+}
+// }}}
+// {{{ void Init::testFilterReject()
+void Init::testFilterReject() {
+	server->GetFilter().AddRule(DBGp::ConnectionFilter::APPID, wxT("Other*"), DBGp::ConnectionFilter::ACCEPT);
+	server->GetFilter().AddRule(DBGp::ConnectionFilter::FILEURI, wxT("dbgp:*"), DBGp::ConnectionFilter::REJECT);
+
+	conn->ProcessNextResponse();
+	CPPUNIT_ASSERT(lastEvent == NULL);
+	CPPUNIT_ASSERT(conn->GetStatus() == DBGp::Connection::STOPPED);
+	CPPUNIT_ASSERT(conn->GetCommands().empty());
+}
+// }}}
 // {{{ void Init::testInit()
 void Init::testInit() {
 	conn->ProcessNextResponse();
@@ -49,4 +85,33 @@ void Init::testInit() {
 }
 // }}}
 
+// {{{ void Init::testProfileCache()
+void Init::testProfileCache() {
+	conn->ProcessNextResponse();
+	CPPUNIT_ASSERT(server->GetProfileCache().GetCount() == 1);
+
+	/* A second connection from the same engine should only be sent the
+	 * per session settings. */
+	Test::Connection *second = new Test::Connection(new wxSocketClient, server);
+	const wxChar *files[] = { wxT("001"), wxT("002"), wxT("007"), wxT("008"), wxT("009"), wxT("010") };
+	for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+		wxXmlDocument doc(wxString(wxT("xml/init/")) + files[i] + wxT(".xml"));
+		CPPUNIT_ASSERT(doc.IsOk());
+		second->AddResponse(doc);
+	}
+	second->ProcessNextResponse();
+
+	const std::list<wxString> &commands = second->GetCommands();
+	CPPUNIT_ASSERT(commands.size() == 5);
+	for (std::list<wxString>::const_iterator i = commands.begin(); i != commands.end(); i++) {
+		CPPUNIT_ASSERT(*i != wxT("feature_get"));
+		CPPUNIT_ASSERT(*i != wxT("typemap_get"));
+	}
+	CPPUNIT_ASSERT(second->CommandSupported(wxT("break")) == conn->CommandSupported(wxT("break")));
+	CPPUNIT_ASSERT(second->TypemapGet().GetTypes().size() == conn->TypemapGet().GetTypes().size());
+
+	delete second;
+}
+// }}}
+
 // vim:set fdm=marker ts=8 sw=8 noet cin:
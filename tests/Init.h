@@ -36,11 +36,19 @@
 
 class Init : public DBGpFixture {
 	CPPUNIT_TEST_SUITE(Init);
+	CPPUNIT_TEST(testFilterAccept);
+	CPPUNIT_TEST(testFilterDetach);
+	CPPUNIT_TEST(testFilterReject);
 	CPPUNIT_TEST(testInit);
+	CPPUNIT_TEST(testProfileCache);
 	CPPUNIT_TEST_SUITE_END();
 
 	public:
+		void testFilterAccept();
+		void testFilterDetach();
+		void testFilterReject();
 		void testInit();
+		void testProfileCache();
 };
 
 #endif
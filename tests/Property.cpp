@@ -38,6 +38,8 @@ CPPUNIT_TEST_SUITE_REGISTRATION(Property);
 // {{{ void Property::setUp()
 void Property::setUp() {
 	Stack::setUp();
+	AddResponse(wxT("xml/stack/context.xml"));
+	AddResponse(wxT("xml/stack/context-get-0.xml"));
 	DBGp::StackLevel::ContextMap::const_iterator i = stack->GetLevel(0)->GetContexts().find(wxT("0"));
 	context = new DBGp::Context(*(i->second));
 }
@@ -67,12 +69,48 @@ void Property::testArray() {
 	CPPUNIT_ASSERT(zero->GetType().GetCommonType() == DBGp::Type::INT);
 }
 // }}}
+// {{{ void Property::testChildAt()
+void Property::testChildAt() {
+	DBGp::Property *obj = context->GetProperty(wxT("obj"));
+	CPPUNIT_ASSERT(obj != NULL);
+	CPPUNIT_ASSERT(obj->GetChildCount() == 2);
+
+	// Children come back in the order the engine sent them.
+	CPPUNIT_ASSERT(obj->GetChildAt(0) == obj->GetChild(wxT("constant")));
+	CPPUNIT_ASSERT(obj->GetChildAt(1) == obj->GetChild(wxT("nul")));
+	CPPUNIT_ASSERT(obj->GetChildAt(1)->GetData() == wxT("NULL"));
+	CPPUNIT_ASSERT(obj->GetChildAt(1)->GetParent() == obj);
+	CPPUNIT_ASSERT(obj->GetChildAt(1)->GetType().GetCommonType() == DBGp::Type::NULLTYPE);
+}
+// }}}
+// {{{ void Property::testContextFindProperty()
+void Property::testContextFindProperty() {
+	// Nothing is found before the properties have been retrieved.
+	CPPUNIT_ASSERT(context->FindProperty(wxT("str")) == NULL);
+
+	context->GetProperties();
+	DBGp::Property *prop = context->FindProperty(wxT("str"));
+	CPPUNIT_ASSERT(prop != NULL);
+	CPPUNIT_ASSERT(prop == context->GetProperty(wxT("str")));
+	CPPUNIT_ASSERT(context->FindProperty(wxT("missing")) == NULL);
+}
+// }}}
 // {{{ void Property::testContextGetProperties()
 void Property::testContextGetProperties() {
 	const DBGp::Property::PropertyMap &properties(context->GetProperties());
 	CPPUNIT_ASSERT(properties.size() == 3);
 }
 // }}}
+// {{{ void Property::testContextGetPropertiesInOrder()
+void Property::testContextGetPropertiesInOrder() {
+	const DBGp::Property::PropertyVector &properties(context->GetPropertiesInOrder());
+	CPPUNIT_ASSERT(properties.size() == 3);
+	CPPUNIT_ASSERT(properties[0]->GetName() == wxT("str"));
+	CPPUNIT_ASSERT(properties[1]->GetName() == wxT("arr"));
+	CPPUNIT_ASSERT(properties[2]->GetName() == wxT("obj"));
+	CPPUNIT_ASSERT(properties[1] == context->GetProperty(wxT("arr")));
+}
+// }}}
 // {{{ void Property::testContextGetProperty()
 void Property::testContextGetProperty() {
 	DBGp::Property *prop = context->GetProperty(wxT("str"));
@@ -86,6 +124,96 @@ void Property::testContextGetPropertyNotFound() {
 	context->GetProperty(wxT("notFound"));
 }
 // }}}
+// {{{ void Property::testContextShared()
+void Property::testContextShared() {
+	DBGp::Property *arr = context->GetProperty(wxT("arr"));
+	DBGp::Context copy(*context);
+
+	CPPUNIT_ASSERT(copy.GetProperties().size() == 3);
+	CPPUNIT_ASSERT(copy.GetProperty(wxT("arr")) == arr);
+	CPPUNIT_ASSERT(arr->IsShared() == true);
+}
+// }}}
+// {{{ void Property::testCopyShared()
+void Property::testCopyShared() {
+	DBGp::Property *obj = context->GetProperty(wxT("obj"));
+	DBGp::Property *constant = obj->GetChild(wxT("constant"));
+	CPPUNIT_ASSERT(constant->IsShared() == false);
+
+	{
+		DBGp::Property copy(*obj);
+		CPPUNIT_ASSERT(copy.GetFullName() == wxT("obj"));
+		CPPUNIT_ASSERT(copy.GetChildren().size() == 2);
+		CPPUNIT_ASSERT(copy.GetChild(wxT("constant")) == constant);
+		CPPUNIT_ASSERT(constant->IsShared() == true);
+	}
+
+	CPPUNIT_ASSERT(constant->IsShared() == false);
+	CPPUNIT_ASSERT(constant->GetParent() == obj);
+}
+// }}}
+// {{{ void Property::testCopyUpdated()
+void Property::testCopyUpdated() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::Context paged(conn, stack->GetLevel(0), wxT("0"), wxT("Local"));
+	DBGp::Property *big = paged.GetProperty(wxT("big"));
+	DBGp::Property copy(*big);
+
+	// Replacing the original's children mustn't touch the copy's.
+	AddResponse(wxT("xml/property/get-page-1.xml"));
+	big->Update();
+	CPPUNIT_ASSERT(big->GetChildCount() == 1);
+	CPPUNIT_ASSERT(big->GetChildAt(0)->GetName() == wxT("2"));
+	CPPUNIT_ASSERT(copy.GetChildCount() == 2);
+	CPPUNIT_ASSERT(copy.GetChildAt(0)->GetName() == wxT("0"));
+	CPPUNIT_ASSERT(copy.GetChildAt(1)->GetData() == wxT("b"));
+}
+// }}}
+// {{{ void Property::testFindChild()
+void Property::testFindChild() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::Context paged(conn, stack->GetLevel(0), wxT("0"), wxT("Local"));
+	DBGp::Property *big = paged.GetProperty(wxT("big"));
+	CPPUNIT_ASSERT(big != NULL);
+	CPPUNIT_ASSERT(big->FindChild(wxT("1"))->GetData() == wxT("b"));
+
+	// Unlike GetChild(), this mustn't go back to the engine for more.
+	CPPUNIT_ASSERT(big->FindChild(wxT("2")) == NULL);
+	CPPUNIT_ASSERT(big->GetChildCount() == 2);
+	CPPUNIT_ASSERT(big->HasMoreChildren() == true);
+}
+// }}}
+// {{{ void Property::testFindPagedChild()
+void Property::testFindPagedChild() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::StackLevel *level = stack->GetLevel(0);
+	DBGp::Context *paged = new DBGp::Context(conn, level, wxT("0"), wxT("Local"));
+	DBGp::Property *big = paged->GetProperty(wxT("big"));
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$big[1]")) == big->GetChildAt(1));
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$big[2]")) == NULL);
+
+	// Children paged in later are added to the frame's index too.
+	AddResponse(wxT("xml/property/get-page-1.xml"));
+	big->RetrieveChildren();
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$big[2]")) != NULL);
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$big[2]"))->GetData() == wxT("c"));
+
+	// Properties leave the index along with their context.
+	delete paged;
+	CPPUNIT_ASSERT(level->FindProperty(wxT("big")) == NULL);
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$big[2]")) == NULL);
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$arr[0]")) == context->GetProperty(wxT("arr"))->GetChild(wxT("0")));
+}
+// }}}
 // {{{ void Property::testGetChildNotFound()
 void Property::testGetChildNotFound() {
 	DBGp::Property *arr = context->GetProperty(wxT("arr"));
@@ -93,6 +221,29 @@ void Property::testGetChildNotFound() {
 	arr->GetChild(wxT("2"));
 }
 // }}}
+// {{{ void Property::testLazyChildren()
+void Property::testLazyChildren() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::Context paged(conn, stack->GetLevel(0), wxT("0"), wxT("Local"));
+	DBGp::Property *nested = paged.GetProperty(wxT("nested"));
+	CPPUNIT_ASSERT(nested != NULL);
+	CPPUNIT_ASSERT(nested->HasChildren() == true);
+	CPPUNIT_ASSERT(nested->HasMoreChildren() == true);
+	CPPUNIT_ASSERT(nested->GetChildren().size() == 0);
+
+	AddResponse(wxT("xml/property/get-nested.xml"));
+	DBGp::Property *inner = nested->GetChild(wxT("inner"));
+	CPPUNIT_ASSERT(inner != NULL);
+	CPPUNIT_ASSERT(inner->GetClassName() == wxT("Inner"));
+	CPPUNIT_ASSERT(inner->GetParent() == nested);
+	CPPUNIT_ASSERT(inner->GetNumChildren() == 4);
+	CPPUNIT_ASSERT(inner->HasMoreChildren() == true);
+	CPPUNIT_ASSERT(nested->HasMoreChildren() == false);
+}
+// }}}
 // {{{ void Property::testObject()
 void Property::testObject() {
 	DBGp::Property *obj = context->GetProperty(wxT("obj"));
@@ -113,6 +264,76 @@ void Property::testObject() {
 	CPPUNIT_ASSERT(constant->IsConstant() == true);
 }
 // }}}
+// {{{ void Property::testPagedChildren()
+void Property::testPagedChildren() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::Context paged(conn, stack->GetLevel(0), wxT("0"), wxT("Local"));
+	DBGp::Property *big = paged.GetProperty(wxT("big"));
+	CPPUNIT_ASSERT(big != NULL);
+	CPPUNIT_ASSERT(big->GetNumChildren() == 3);
+	CPPUNIT_ASSERT(big->GetChildren().size() == 2);
+	CPPUNIT_ASSERT(big->HasMoreChildren() == true);
+
+	AddResponse(wxT("xml/property/get-page-1.xml"));
+	big->RetrieveChildren();
+	CPPUNIT_ASSERT(big->GetChildren().size() == 3);
+	CPPUNIT_ASSERT(big->GetChildCount() == 3);
+	CPPUNIT_ASSERT(big->GetChildAt(2)->GetName() == wxT("2"));
+	CPPUNIT_ASSERT(big->HasMoreChildren() == false);
+	CPPUNIT_ASSERT(big->GetChild(wxT("0"))->GetData() == wxT("a"));
+	CPPUNIT_ASSERT(big->GetChild(wxT("2"))->GetData() == wxT("c"));
+}
+// }}}
+// {{{ void Property::testRetrieveChildrenBatch()
+void Property::testRetrieveChildrenBatch() {
+	// Use up the context_get queued by setUp() first.
+	context->GetProperties();
+
+	AddResponse(wxT("xml/property/context-get-paged.xml"));
+	DBGp::Context paged(conn, stack->GetLevel(0), wxT("0"), wxT("Local"));
+	DBGp::Property *big = paged.GetProperty(wxT("big"));
+	DBGp::Property *nested = paged.GetProperty(wxT("nested"));
+	CPPUNIT_ASSERT(big->HasMoreChildren() == true);
+	CPPUNIT_ASSERT(nested->HasMoreChildren() == true);
+
+	// Properties with nothing left to fetch are skipped.
+	DBGp::Property::PropertyVector props;
+	props.push_back(big);
+	props.push_back(context->GetProperty(wxT("arr")));
+	props.push_back(nested);
+
+	AddResponse(wxT("xml/property/get-page-1.xml"));
+	AddResponse(wxT("xml/property/get-nested.xml"));
+	DBGp::Property::RetrieveChildren(props);
+
+	CPPUNIT_ASSERT(big->GetChildCount() == 3);
+	CPPUNIT_ASSERT(big->GetChildAt(2)->GetData() == wxT("c"));
+	CPPUNIT_ASSERT(big->HasMoreChildren() == false);
+	CPPUNIT_ASSERT(nested->FindChild(wxT("inner")) != NULL);
+	CPPUNIT_ASSERT(nested->HasMoreChildren() == false);
+}
+// }}}
+// {{{ void Property::testSharedOutlivesContext()
+void Property::testSharedOutlivesContext() {
+	DBGp::Property *zero = context->GetProperty(wxT("arr"))->GetChild(wxT("0"));
+	DBGp::Context *copy = new DBGp::Context(*context);
+
+	zero->Ref();
+	delete copy;
+	delete context;
+	context = NULL;
+
+	CPPUNIT_ASSERT(zero->GetData() == wxT("42"));
+	CPPUNIT_ASSERT(zero->GetFullName() == wxT("$arr[0]"));
+	CPPUNIT_ASSERT(zero->GetContext() == NULL);
+	CPPUNIT_ASSERT(zero->GetParent() == NULL);
+	CPPUNIT_ASSERT(zero->IsShared() == false);
+	zero->Unref();
+}
+// }}}
 // {{{ void Property::testUpdate()
 void Property::testUpdate() {
 	AddResponse(wxT("xml/property/get-str.xml"));
@@ -37,11 +37,23 @@
 class Property : public Stack {
 	CPPUNIT_TEST_SUITE(Property);
 	CPPUNIT_TEST(testArray);
+	CPPUNIT_TEST(testChildAt);
+	CPPUNIT_TEST(testContextFindProperty);
 	CPPUNIT_TEST(testContextGetProperties);
+	CPPUNIT_TEST(testContextGetPropertiesInOrder);
 	CPPUNIT_TEST(testContextGetProperty);
+	CPPUNIT_TEST(testContextShared);
 	CPPUNIT_TEST_EXCEPTION(testContextGetPropertyNotFound, DBGp::NotFoundError);
+	CPPUNIT_TEST(testCopyShared);
+	CPPUNIT_TEST(testCopyUpdated);
+	CPPUNIT_TEST(testFindChild);
+	CPPUNIT_TEST(testFindPagedChild);
 	CPPUNIT_TEST_EXCEPTION(testGetChildNotFound, DBGp::NotFoundError);
+	CPPUNIT_TEST(testLazyChildren);
 	CPPUNIT_TEST(testObject);
+	CPPUNIT_TEST(testPagedChildren);
+	CPPUNIT_TEST(testRetrieveChildrenBatch);
+	CPPUNIT_TEST(testSharedOutlivesContext);
 	CPPUNIT_TEST(testUpdate);
 	CPPUNIT_TEST_SUITE_END();
 
@@ -50,11 +62,23 @@ class Property : public Stack {
 		virtual void tearDown();
 
 		void testArray();
+		void testChildAt();
+		void testContextFindProperty();
 		void testContextGetProperties();
+		void testContextGetPropertiesInOrder();
 		void testContextGetProperty();
 		void testContextGetPropertyNotFound();
+		void testContextShared();
+		void testCopyShared();
+		void testCopyUpdated();
+		void testFindChild();
+		void testFindPagedChild();
 		void testGetChildNotFound();
+		void testLazyChildren();
 		void testObject();
+		void testPagedChildren();
+		void testRetrieveChildrenBatch();
+		void testSharedOutlivesContext();
 		void testString();
 		void testUpdate();
 
@@ -0,0 +1,151 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "ProtocolLog.h"
+
+#include <cstring>
+#include <string>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ProtocolLog);
+
+// {{{ void ProtocolLog::tearDown()
+void ProtocolLog::tearDown() {
+	DBGp::ProtocolLog::Disable();
+	DBGpFixture::tearDown();
+}
+// }}}
+
+// {{{ void ProtocolLog::testConnection()
+void ProtocolLog::testConnection() {
+	DBGp::ProtocolLog::Enable();
+	conn->ProcessNextResponse();
+
+	// Negotiation may have absorbed more responses after the init packet.
+	DBGp::ProtocolLog::EntryList entries(DBGp::ProtocolLog::GetEntries());
+	CPPUNIT_ASSERT(!entries.empty());
+	CPPUNIT_ASSERT(entries[0].direction == DBGp::ProtocolLog::RECEIVED);
+	CPPUNIT_ASSERT(entries[0].session == conn);
+	CPPUNIT_ASSERT(entries[0].payload.find("<init") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(entries[0].payload.length(), entries[0].length);
+	CPPUNIT_ASSERT(DBGp::ProtocolLog::Format().Find(wxT("RX(")) != wxNOT_FOUND);
+}
+// }}}
+// {{{ void ProtocolLog::testDisabled()
+void ProtocolLog::testDisabled() {
+	int session;
+
+	CPPUNIT_ASSERT(!DBGp::ProtocolLog::IsEnabled());
+	DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::SENT, "status -i 1", 11);
+
+	DBGp::ProtocolLog::Enable();
+	DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::SENT, "run -i 2", 8);
+	DBGp::ProtocolLog::Disable();
+	DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::SENT, "step_into -i 3", 14);
+
+	// What was recorded stays around after the log is disabled.
+	DBGp::ProtocolLog::EntryList entries(DBGp::ProtocolLog::GetEntries());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, entries.size());
+	CPPUNIT_ASSERT(entries[0].payload == "run -i 2");
+	CPPUNIT_ASSERT(entries[0].direction == DBGp::ProtocolLog::SENT);
+	CPPUNIT_ASSERT(entries[0].session == &session);
+}
+// }}}
+// {{{ void ProtocolLog::testLogPayload()
+void ProtocolLog::testLogPayload() {
+	const char *payload = "<response command=\"status\"/>";
+	size_t length = std::strlen(payload);
+
+	CPPUNIT_ASSERT(DBGp::LogPayload(payload, length).Format() == wxT("<response command=\"status\"/>"));
+	CPPUNIT_ASSERT(DBGp::LogPayload(payload, length).Format(9) == wxT("<response... (19 more bytes)"));
+	CPPUNIT_ASSERT(DBGp::LogPayload(payload, 0).Format().empty());
+
+	// Invalid UTF-8 falls back to Latin-1 rather than vanishing.
+	CPPUNIT_ASSERT(DBGp::LogPayload("caf\xe9", 4).Format() == wxString(wxT("caf")) + wxChar(0xe9));
+}
+// }}}
+// {{{ void ProtocolLog::testSampling()
+void ProtocolLog::testSampling() {
+	int session;
+	char payload[2] = { 0, 0 };
+
+	DBGp::ProtocolLog::Enable(3);
+	for (char c = 'a'; c < 'k'; c++) {
+		payload[0] = c;
+		DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::RECEIVED, payload, 1);
+	}
+
+	DBGp::ProtocolLog::EntryList entries(DBGp::ProtocolLog::GetEntries());
+	CPPUNIT_ASSERT_EQUAL((size_t) 4, entries.size());
+	CPPUNIT_ASSERT(entries[0].payload == "a");
+	CPPUNIT_ASSERT(entries[1].payload == "d");
+	CPPUNIT_ASSERT(entries[2].payload == "g");
+	CPPUNIT_ASSERT(entries[3].payload == "j");
+}
+// }}}
+// {{{ void ProtocolLog::testTruncation()
+void ProtocolLog::testTruncation() {
+	int session;
+	std::string payload(100, 'x');
+
+	DBGp::ProtocolLog::Enable(1, 4, 10);
+	DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::RECEIVED, payload.data(), payload.length());
+
+	DBGp::ProtocolLog::EntryList entries(DBGp::ProtocolLog::GetEntries());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, entries.size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 100, entries[0].length);
+	CPPUNIT_ASSERT(entries[0].payload == std::string(10, 'x'));
+	CPPUNIT_ASSERT(DBGp::ProtocolLog::Format().Find(wxT("xxxxxxxxxx... (90 more bytes)")) != wxNOT_FOUND);
+}
+// }}}
+// {{{ void ProtocolLog::testWrap()
+void ProtocolLog::testWrap() {
+	int session;
+	char payload[2] = { 0, 0 };
+
+	DBGp::ProtocolLog::Enable(1, 3);
+	for (char c = 'a'; c < 'h'; c++) {
+		payload[0] = c;
+		DBGp::ProtocolLog::Record(&session, DBGp::ProtocolLog::SENT, payload, 1);
+	}
+
+	DBGp::ProtocolLog::EntryList entries(DBGp::ProtocolLog::GetEntries());
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, entries.size());
+	CPPUNIT_ASSERT(entries[0].payload == "e");
+	CPPUNIT_ASSERT(entries[1].payload == "f");
+	CPPUNIT_ASSERT(entries[2].payload == "g");
+
+	// Enabling again starts afresh.
+	DBGp::ProtocolLog::Enable();
+	CPPUNIT_ASSERT(DBGp::ProtocolLog::GetEntries().empty());
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
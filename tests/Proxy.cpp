@@ -0,0 +1,365 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Proxy.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <wx/utils.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Proxy);
+
+/* How long to wait for the proxy thread to catch up, in milliseconds. */
+static const int TIMEOUT = 5000;
+
+// {{{ static void SetTimeout(int fd)
+/* Never let a broken proxy hang the test run. */
+static void SetTimeout(int fd) {
+	struct timeval timeout = { TIMEOUT / 1000, 0 };
+
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+// }}}
+// {{{ static int Accept(int listener)
+static int Accept(int listener) {
+	int fd = accept(listener, NULL, NULL);
+
+	CPPUNIT_ASSERT(fd != -1);
+	SetTimeout(fd);
+	return fd;
+}
+// }}}
+// {{{ static int Connect(wxUint16 port, const char *source = NULL)
+/* If a source address is given, the connection comes from there; anything in
+ * 127.0.0.0/8 will do on Linux. */
+static int Connect(wxUint16 port, const char *source = NULL) {
+	struct sockaddr_in addr;
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	CPPUNIT_ASSERT(fd != -1);
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	if (source) {
+		CPPUNIT_ASSERT(inet_pton(AF_INET, source, &addr.sin_addr) == 1);
+		CPPUNIT_ASSERT(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+	}
+
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+
+	CPPUNIT_ASSERT(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+
+	SetTimeout(fd);
+	return fd;
+}
+// }}}
+// {{{ static std::string Init(const std::string &ideKey)
+static std::string Init(const std::string &ideKey) {
+	return "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<init xmlns=\"urn:debugger_protocol_v1\" appid=\"1\" idekey=\"" + ideKey + "\" language=\"PHP\" protocol_version=\"1.0\" fileuri=\"file:///tmp/test.php\"/>";
+}
+// }}}
+// {{{ static int Listen(wxUint16 &port)
+/* Stands in for an IDE waiting for the proxy to connect. */
+static int Listen(wxUint16 &port) {
+	struct sockaddr_in addr;
+	socklen_t addrLength = sizeof(addr);
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	CPPUNIT_ASSERT(fd != -1);
+	CPPUNIT_ASSERT(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+	CPPUNIT_ASSERT(listen(fd, 8) == 0);
+	CPPUNIT_ASSERT(getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &addrLength) == 0);
+
+	// On Linux, the receive timeout also applies to accept().
+	SetTimeout(fd);
+	port = ntohs(addr.sin_port);
+	return fd;
+}
+// }}}
+// {{{ static std::string ReadCommand(int fd)
+/* Reads a single NULL terminated command, or returns an empty string if the
+ * connection is closed first. */
+static std::string ReadCommand(int fd) {
+	std::string command;
+	char c;
+
+	while (recv(fd, &c, 1, 0) == 1) {
+		if (c == '\0') {
+			return command;
+		}
+		command.push_back(c);
+	}
+	return std::string();
+}
+// }}}
+// {{{ static std::string ReadFrame(int fd)
+/* Reads a single frame's payload, or returns an empty string if the
+ * connection is closed first. */
+static std::string ReadFrame(int fd) {
+	std::string length(ReadCommand(fd));
+	std::string payload(ReadCommand(fd));
+
+	if (length.empty() || std::strtoul(length.c_str(), NULL, 10) != payload.length()) {
+		return std::string();
+	}
+	return payload;
+}
+// }}}
+// {{{ static void SendFrame(int fd, const std::string &payload)
+static void SendFrame(int fd, const std::string &payload) {
+	char length[32];
+	std::string frame;
+
+	std::sprintf(length, "%lu", static_cast<unsigned long>(payload.length()));
+	frame.append(length);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	CPPUNIT_ASSERT(send(fd, frame.data(), frame.length(), 0) == static_cast<ssize_t>(frame.length()));
+}
+// }}}
+
+// {{{ void Proxy::setUp()
+void Proxy::setUp() {
+	init = new wxInitializer;
+	proxy = new DBGp::Proxy;
+	proxy->Start(0, 0, true);
+}
+// }}}
+// {{{ void Proxy::tearDown()
+void Proxy::tearDown() {
+	delete proxy;
+	delete init;
+}
+// }}}
+
+// {{{ std::string Proxy::Command(const std::string &command, const char *source)
+std::string Proxy::Command(const std::string &command, const char *source) {
+	int fd = Connect(proxy->GetIDEPort(), source);
+
+	CPPUNIT_ASSERT(send(fd, command.c_str(), command.length() + 1, 0) == static_cast<ssize_t>(command.length() + 1));
+	std::string response(ReadFrame(fd));
+
+	// The proxy hangs up once it has responded.
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(fd));
+	close(fd);
+
+	return response;
+}
+// }}}
+// {{{ bool Proxy::WaitForSessions(size_t sessions)
+bool Proxy::WaitForSessions(size_t sessions) {
+	for (int waited = 0; waited < TIMEOUT; waited += 10) {
+		if (proxy->GetSessionCount() == sessions) {
+			return true;
+		}
+		wxMilliSleep(10);
+	}
+	return false;
+}
+// }}}
+
+// {{{ void Proxy::testBusy()
+void Proxy::testBusy() {
+	wxUint16 port;
+	int listener = Listen(port);
+	char command[64];
+
+	// Without -m 1, an IDE only gets one session at a time.
+	std::sprintf(command, "proxyinit -p %hu -k single -m 0", port);
+	CPPUNIT_ASSERT(Command(command).find("success=\"1\"") != std::string::npos);
+
+	int first = Connect(proxy->GetEnginePort());
+	SendFrame(first, Init("single"));
+	int ide = Accept(listener);
+	CPPUNIT_ASSERT(ReadFrame(ide).find("idekey=\"single\"") != std::string::npos);
+
+	int second = Connect(proxy->GetEnginePort());
+	SendFrame(second, Init("single"));
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(second));
+	close(second);
+
+	close(first);
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(ide));
+	close(ide);
+	close(listener);
+
+	CPPUNIT_ASSERT(WaitForSessions(0));
+}
+// }}}
+// {{{ void Proxy::testProxyInit()
+void Proxy::testProxyInit() {
+	char port[8];
+	std::string response;
+
+	std::sprintf(port, "%hu", proxy->GetEnginePort());
+
+	response = Command("proxyinit -p 9000 -k alice -m 1");
+	CPPUNIT_ASSERT(response.find("<proxyinit success=\"1\" idekey=\"alice\" address=\"127.0.0.1\" port=\"" + std::string(port) + "\"/>") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), proxy->GetRegistrationCount());
+
+	// Registering again from the same address just updates the port.
+	response = Command("proxyinit -p 9001 -k alice -m 1");
+	CPPUNIT_ASSERT(response.find("success=\"1\"") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), proxy->GetRegistrationCount());
+
+	response = Command("proxyinit -k bob");
+	CPPUNIT_ASSERT(response.find("<proxyinit success=\"0\"><error id=\"1\">") != std::string::npos);
+
+	response = Command("proxystop -k alice");
+	CPPUNIT_ASSERT(response.find("<proxystop success=\"1\" idekey=\"alice\"/>") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), proxy->GetRegistrationCount());
+
+	response = Command("proxystop -k alice");
+	CPPUNIT_ASSERT(response.find("<proxystop success=\"0\"><error id=\"4\">") != std::string::npos);
+
+	// Anything else is simply hung up on.
+	CPPUNIT_ASSERT_EQUAL(std::string(), Command("status -i 1"));
+}
+// }}}
+// {{{ void Proxy::testProxyStop()
+void Proxy::testProxyStop() {
+	CPPUNIT_ASSERT(Command("proxyinit -p 9000 -k alice -m 1").find("success=\"1\"") != std::string::npos);
+
+	// Another machine can't unregister someone else's IDE key.
+	CPPUNIT_ASSERT(Command("proxystop -k alice", "127.0.0.2").find("<proxystop success=\"0\"><error id=\"5\">") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(size_t(1), proxy->GetRegistrationCount());
+
+	CPPUNIT_ASSERT(Command("proxystop -k alice").find("<proxystop success=\"1\" idekey=\"alice\"/>") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL(size_t(0), proxy->GetRegistrationCount());
+}
+// }}}
+// {{{ void Proxy::testReregistered()
+void Proxy::testReregistered() {
+	wxUint16 port;
+	int listener = Listen(port);
+	char command[64];
+
+	std::sprintf(command, "proxyinit -p %hu -k single -m 0", port);
+	CPPUNIT_ASSERT(Command(command).find("success=\"1\"") != std::string::npos);
+
+	int first = Connect(proxy->GetEnginePort());
+	SendFrame(first, Init("single"));
+	int firstIDE = Accept(listener);
+	CPPUNIT_ASSERT(ReadFrame(firstIDE).find("idekey=\"single\"") != std::string::npos);
+
+	// The IDE stops and registers again while the first session is open.
+	CPPUNIT_ASSERT(Command("proxystop -k single").find("success=\"1\"") != std::string::npos);
+	CPPUNIT_ASSERT(Command(command).find("success=\"1\"") != std::string::npos);
+
+	int second = Connect(proxy->GetEnginePort());
+	SendFrame(second, Init("single"));
+	int secondIDE = Accept(listener);
+	CPPUNIT_ASSERT(ReadFrame(secondIDE).find("idekey=\"single\"") != std::string::npos);
+
+	/* Closing the first session mustn't free up the new registration,
+	 * which is still busy with the second. */
+	close(first);
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(firstIDE));
+	close(firstIDE);
+	CPPUNIT_ASSERT(WaitForSessions(1));
+
+	int third = Connect(proxy->GetEnginePort());
+	SendFrame(third, Init("single"));
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(third));
+	close(third);
+
+	close(second);
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(secondIDE));
+	close(secondIDE);
+	close(listener);
+
+	CPPUNIT_ASSERT(WaitForSessions(0));
+}
+// }}}
+// {{{ void Proxy::testRouting()
+void Proxy::testRouting() {
+	wxUint16 port;
+	int listener = Listen(port);
+	char command[64];
+	std::string response("<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"status\" transaction_id=\"1\" status=\"starting\" reason=\"ok\"/>");
+
+	std::sprintf(command, "proxyinit -p %hu -k alice -m 1", port);
+	CPPUNIT_ASSERT(Command(command).find("success=\"1\"") != std::string::npos);
+
+	int engine = Connect(proxy->GetEnginePort());
+	SendFrame(engine, Init("alice"));
+
+	// The init packet is forwarded with the engine's address added.
+	int ide = Accept(listener);
+	std::string init(ReadFrame(ide));
+	CPPUNIT_ASSERT(init.find("<init proxied=\"127.0.0.1\" xmlns=\"urn:debugger_protocol_v1\"") != std::string::npos);
+	CPPUNIT_ASSERT(init.find("idekey=\"alice\"") != std::string::npos);
+
+	// From then on, bytes go through untouched in both directions.
+	CPPUNIT_ASSERT(send(ide, "status -i 1", 12, 0) == 12);
+	CPPUNIT_ASSERT_EQUAL(std::string("status -i 1"), ReadCommand(engine));
+	SendFrame(engine, response);
+	CPPUNIT_ASSERT_EQUAL(response, ReadFrame(ide));
+
+	// Either end hanging up closes the other.
+	close(engine);
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(ide));
+	close(ide);
+	close(listener);
+
+	CPPUNIT_ASSERT(WaitForSessions(0));
+}
+// }}}
+// {{{ void Proxy::testUnregistered()
+void Proxy::testUnregistered() {
+	int engine = Connect(proxy->GetEnginePort());
+
+	SendFrame(engine, Init("nobody"));
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(engine));
+	close(engine);
+
+	CPPUNIT_ASSERT(WaitForSessions(0));
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,267 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Reactor.h"
+#include "DBGp/ReactorSession.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <wx/thread.h>
+#include <wx/utils.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Reactor);
+
+/* How long to wait for the reactor thread to catch up, in milliseconds. */
+static const int TIMEOUT = 5000;
+
+// {{{ class RecordingHandler
+/* Records what the reactor reports. The reactor thread writes and the test
+ * thread reads, so everything goes through the mutex. */
+class RecordingHandler : public DBGp::Reactor::Handler {
+	public:
+		RecordingHandler() : accepted(0), closed(0), sendStatus(false) {}
+
+		void OnSessionAccepted(DBGp::ReactorSession *session) throw () {
+			wxMutexLocker lock(mutex);
+			accepted++;
+		}
+
+		void OnSessionClosed(DBGp::ReactorSession *session) throw () {
+			wxMutexLocker lock(mutex);
+			closed++;
+		}
+
+		void OnSessionInit(DBGp::ReactorSession *session, wxXmlDocument &init) throw () {
+			wxMutexLocker lock(mutex);
+			ideKeys.push_back(std::string(session->GetIDEKey().mb_str()));
+
+			if (sendStatus) {
+				try {
+					session->SendCommand(wxT("status"), DBGp::MessageArguments());
+				}
+				catch (DBGp::SocketError e) {}
+			}
+		}
+
+		void OnSessionMessage(DBGp::ReactorSession *session, wxXmlDocument &message) throw () {
+			wxMutexLocker lock(mutex);
+			commands.push_back(std::string(message.GetRoot()->GetPropVal(wxT("command"), wxEmptyString).mb_str()));
+		}
+
+		int GetAccepted() { wxMutexLocker lock(mutex); return accepted; }
+		int GetClosed() { wxMutexLocker lock(mutex); return closed; }
+		std::vector<std::string> GetCommands() { wxMutexLocker lock(mutex); return commands; }
+		std::vector<std::string> GetIDEKeys() { wxMutexLocker lock(mutex); return ideKeys; }
+		void SetSendStatus(bool send) { wxMutexLocker lock(mutex); sendStatus = send; }
+
+	private:
+		int accepted;
+		int closed;
+		std::vector<std::string> commands;
+		std::vector<std::string> ideKeys;
+		wxMutex mutex;
+		bool sendStatus;
+};
+// }}}
+
+// {{{ static int Connect(wxUint16 port)
+static int Connect(wxUint16 port) {
+	struct sockaddr_in addr;
+	struct timeval timeout = { TIMEOUT / 1000, 0 };
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+
+	CPPUNIT_ASSERT(fd != -1);
+	CPPUNIT_ASSERT(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+
+	// Never let a broken reactor hang the test run.
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	return fd;
+}
+// }}}
+// {{{ static std::string ReadCommand(int fd)
+/* Reads a single NULL terminated command, or returns an empty string if the
+ * connection is closed first. */
+static std::string ReadCommand(int fd) {
+	std::string command;
+	char c;
+
+	while (recv(fd, &c, 1, 0) == 1) {
+		if (c == '\0') {
+			return command;
+		}
+		command.push_back(c);
+	}
+	return std::string();
+}
+// }}}
+// {{{ static void SendFrame(int fd, const std::string &payload)
+static void SendFrame(int fd, const std::string &payload) {
+	char length[32];
+	std::string frame;
+
+	std::sprintf(length, "%lu", static_cast<unsigned long>(payload.length()));
+	frame.append(length);
+	frame.push_back('\0');
+	frame.append(payload);
+	frame.push_back('\0');
+
+	CPPUNIT_ASSERT(send(fd, frame.data(), frame.length(), 0) == static_cast<ssize_t>(frame.length()));
+}
+// }}}
+// {{{ static std::string Init(const std::string &ideKey)
+static std::string Init(const std::string &ideKey) {
+	return "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<init xmlns=\"urn:debugger_protocol_v1\" appid=\"1\" idekey=\"" + ideKey + "\" language=\"PHP\" protocol_version=\"1.0\" fileuri=\"file:///tmp/test.php\"/>";
+}
+// }}}
+// {{{ template <class T> static bool WaitFor(T *object, int (T::*getter)(), int value)
+template <class T> static bool WaitFor(T *object, int (T::*getter)(), int value) {
+	for (int waited = 0; waited < TIMEOUT; waited += 10) {
+		if ((object->*getter)() == value) {
+			return true;
+		}
+		wxMilliSleep(10);
+	}
+	return false;
+}
+// }}}
+
+// {{{ void Reactor::setUp()
+void Reactor::setUp() {
+	init = new wxInitializer;
+	handler = new RecordingHandler;
+	reactor = new DBGp::Reactor(handler);
+	reactor->Start(0, true);
+}
+// }}}
+// {{{ void Reactor::tearDown()
+void Reactor::tearDown() {
+	delete reactor;
+	delete handler;
+	delete init;
+}
+// }}}
+
+// {{{ void Reactor::testCommand()
+void Reactor::testCommand() {
+	handler->SetSendStatus(true);
+
+	int fd = Connect(reactor->GetPort());
+	SendFrame(fd, Init("cmd"));
+	CPPUNIT_ASSERT_EQUAL(std::string("status -i 0"), ReadCommand(fd));
+
+	SendFrame(fd, "<?xml version=\"1.0\" encoding=\"iso-8859-1\"?>\n<response xmlns=\"urn:debugger_protocol_v1\" command=\"status\" transaction_id=\"0\" status=\"starting\" reason=\"ok\"/>");
+	for (int waited = 0; waited < TIMEOUT && handler->GetCommands().empty(); waited += 10) {
+		wxMilliSleep(10);
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(1), handler->GetCommands().size());
+	CPPUNIT_ASSERT_EQUAL(std::string("status"), handler->GetCommands()[0]);
+
+	close(fd);
+	CPPUNIT_ASSERT(WaitFor(handler, &RecordingHandler::GetClosed, 1));
+}
+// }}}
+// {{{ void Reactor::testDetach()
+void Reactor::testDetach() {
+	reactor->Stop();
+	reactor->GetFilter().SetDefaultAction(DBGp::ConnectionFilter::DETACH);
+	reactor->Start(0, true);
+
+	int fd = Connect(reactor->GetPort());
+	SendFrame(fd, Init("other"));
+
+	// The engine is told to detach, then the session is closed.
+	CPPUNIT_ASSERT_EQUAL(std::string("detach -i 0"), ReadCommand(fd));
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(fd));
+	close(fd);
+
+	CPPUNIT_ASSERT(WaitFor(handler, &RecordingHandler::GetClosed, 1));
+	CPPUNIT_ASSERT(handler->GetIDEKeys().empty());
+	CPPUNIT_ASSERT_EQUAL(size_t(0), reactor->GetSessionCount());
+}
+// }}}
+// {{{ void Reactor::testInit()
+void Reactor::testInit() {
+	static const int SESSIONS = 3;
+	int fds[SESSIONS];
+
+	for (int i = 0; i < SESSIONS; i++) {
+		char ideKey[16];
+
+		std::sprintf(ideKey, "key%d", i);
+		fds[i] = Connect(reactor->GetPort());
+		SendFrame(fds[i], Init(ideKey));
+	}
+
+	CPPUNIT_ASSERT(WaitFor(handler, &RecordingHandler::GetAccepted, SESSIONS));
+	for (int waited = 0; waited < TIMEOUT && handler->GetIDEKeys().size() < static_cast<size_t>(SESSIONS); waited += 10) {
+		wxMilliSleep(10);
+	}
+	CPPUNIT_ASSERT_EQUAL(size_t(SESSIONS), handler->GetIDEKeys().size());
+	CPPUNIT_ASSERT_EQUAL(size_t(SESSIONS), reactor->GetSessionCount());
+
+	// Close them out of order, so removal has to fill holes in the table.
+	close(fds[1]);
+	close(fds[0]);
+	close(fds[2]);
+
+	CPPUNIT_ASSERT(WaitFor(handler, &RecordingHandler::GetClosed, SESSIONS));
+	CPPUNIT_ASSERT_EQUAL(size_t(0), reactor->GetSessionCount());
+}
+// }}}
+// {{{ void Reactor::testMalformed()
+void Reactor::testMalformed() {
+	int fd = Connect(reactor->GetPort());
+
+	// A bad frame header can't be recovered from.
+	CPPUNIT_ASSERT(send(fd, "x12\0", 4, 0) == 4);
+	CPPUNIT_ASSERT_EQUAL(std::string(), ReadCommand(fd));
+	close(fd);
+
+	CPPUNIT_ASSERT(WaitFor(handler, &RecordingHandler::GetClosed, 1));
+	CPPUNIT_ASSERT(handler->GetIDEKeys().empty());
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,173 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "ResponseParser.h"
+
+#include "DBGp/DocumentBuilder.h"
+
+#include <cstring>
+#include <vector>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ResponseParser);
+
+// {{{ class RecordingHandler
+/* A handler that records each event it receives as a string, so the order
+ * and content of events can be checked. */
+class RecordingHandler : public DBGp::ResponseParser::Handler {
+	public:
+		void OnEndElement(const wxString &name, const wxString &content) throw (DBGp::Error) {
+			events.push_back(wxT("end ") + name + wxT(" ") + content);
+		}
+
+		void OnStartElement(const wxString &name, const DBGp::ResponseParser::Attributes &attributes) throw (DBGp::Error) {
+			last = attributes;
+			events.push_back(wxT("start ") + name);
+		}
+
+		std::vector<wxString> events;
+		DBGp::ResponseParser::Attributes last;
+};
+// }}}
+// {{{ class RejectingHandler
+class RejectingHandler : public DBGp::ResponseParser::Handler {
+	public:
+		void OnEndElement(const wxString &name, const wxString &content) throw (DBGp::Error) {
+		}
+
+		void OnStartElement(const wxString &name, const DBGp::ResponseParser::Attributes &attributes) throw (DBGp::Error) {
+			if (name == wxT("property")) {
+				throw DBGp::Error(wxT("Unexpected property."));
+			}
+		}
+};
+// }}}
+// {{{ class StreamingBuilder
+/* A document builder that diverts everything below the root element. */
+class StreamingBuilder : public DBGp::DocumentBuilder {
+	public:
+		StreamingBuilder(wxXmlDocument &doc, DBGp::ResponseParser::Handler *stream) : DBGp::DocumentBuilder(doc), stream(stream) {}
+
+	protected:
+		DBGp::ResponseParser::Handler *GetStreamHandler(const wxXmlNode *root) throw () {
+			return stream;
+		}
+
+	private:
+		DBGp::ResponseParser::Handler *stream;
+};
+// }}}
+
+// {{{ static void Parse(const char *xml, DBGp::ResponseParser::Handler &handler)
+static void Parse(const char *xml, DBGp::ResponseParser::Handler &handler) {
+	DBGp::ResponseParser parser(&wxConvUTF8);
+	parser.Parse(xml, std::strlen(xml), handler);
+}
+// }}}
+
+// {{{ void ResponseParser::testAttributes()
+void ResponseParser::testAttributes() {
+	RecordingHandler handler;
+	Parse("<response command=\"run\" status=\"break\" reason=\"ok\"/>", handler);
+
+	CPPUNIT_ASSERT(handler.events.size() == 2);
+	CPPUNIT_ASSERT(handler.last.size() == 3);
+	CPPUNIT_ASSERT(DBGp::ResponseParser::GetAttribute(handler.last, wxT("status")) == wxT("break"));
+	CPPUNIT_ASSERT(DBGp::ResponseParser::GetAttribute(handler.last, wxT("missing"), wxT("default")) == wxT("default"));
+}
+// }}}
+// {{{ void ResponseParser::testDocumentBuilder()
+void ResponseParser::testDocumentBuilder() {
+	wxXmlDocument doc;
+	DBGp::DocumentBuilder builder(doc);
+	Parse("<response command=\"source\" encoding=\"base64\"><![CDATA[PD9waHAKZWNobyAxOw==]]></response>", builder);
+
+	CPPUNIT_ASSERT(doc.IsOk());
+	CPPUNIT_ASSERT(doc.GetRoot()->GetName() == wxT("response"));
+	CPPUNIT_ASSERT(doc.GetRoot()->GetPropVal(wxT("command"), wxEmptyString) == wxT("source"));
+	CPPUNIT_ASSERT(doc.GetRoot()->GetNodeContent() == wxT("<?php\necho 1;"));
+}
+// }}}
+// {{{ void ResponseParser::testEncodedContent()
+void ResponseParser::testEncodedContent() {
+	RecordingHandler handler;
+	Parse("<response><property name=\"a\" encoding=\"base64\"><![CDATA[aGVsbG8=]]></property><property name=\"b\"><![CDATA[aGVsbG8=]]></property></response>", handler);
+
+	CPPUNIT_ASSERT(handler.events.size() == 6);
+	CPPUNIT_ASSERT(handler.events[2] == wxT("end property hello"));
+	CPPUNIT_ASSERT(handler.events[4] == wxT("end property aGVsbG8="));
+}
+// }}}
+// {{{ void ResponseParser::testHandlerError()
+void ResponseParser::testHandlerError() {
+	RejectingHandler handler;
+	Parse("<response><property name=\"a\"/></response>", handler);
+}
+// }}}
+// {{{ void ResponseParser::testMalformed()
+void ResponseParser::testMalformed() {
+	RecordingHandler handler;
+	Parse("<response><property></response>", handler);
+}
+// }}}
+// {{{ void ResponseParser::testStreamHandler()
+void ResponseParser::testStreamHandler() {
+	wxXmlDocument doc;
+	RecordingHandler handler;
+	StreamingBuilder builder(doc, &handler);
+	Parse("<response command=\"context_get\"><property name=\"a\"><property name=\"b\"/></property><error code=\"1\"><message>Oops</message></error></response>", builder);
+
+	// The properties should have gone to the stream handler.
+	CPPUNIT_ASSERT(handler.events.size() == 4);
+	CPPUNIT_ASSERT(handler.events[0] == wxT("start property"));
+	CPPUNIT_ASSERT(handler.events[1] == wxT("start property"));
+
+	// The error should still be in the document.
+	CPPUNIT_ASSERT(doc.IsOk());
+	wxXmlNode *child = doc.GetRoot()->GetChildren();
+	CPPUNIT_ASSERT(child != NULL);
+	CPPUNIT_ASSERT(child->GetName() == wxT("error"));
+	CPPUNIT_ASSERT(child->GetNext() == NULL);
+	CPPUNIT_ASSERT(child->GetChildren()->GetNodeContent() == wxT("Oops"));
+}
+// }}}
+// {{{ void ResponseParser::testWhitespace()
+void ResponseParser::testWhitespace() {
+	RecordingHandler handler;
+	Parse("<response>\n\t<value>  padded  </value>\n\t<cdata><![CDATA[  ]]></cdata>\n</response>", handler);
+
+	CPPUNIT_ASSERT(handler.events.size() == 6);
+	CPPUNIT_ASSERT(handler.events[2] == wxT("end value   padded  "));
+	CPPUNIT_ASSERT(handler.events[4] == wxT("end cdata   "));
+	CPPUNIT_ASSERT(handler.events[5] == wxT("end response "));
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,157 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "SPSCQueue.h"
+
+#include <wx/init.h>
+#include <wx/thread.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SPSCQueue);
+
+/* Enough items to go around a small queue many times, so the producer and
+ * consumer spend most of the test racing each other at its edges. */
+static const int THREADED_ITEMS = 100000;
+
+// {{{ class Producer
+/* Pushes an increasing sequence of integers into a queue, spinning whenever
+ * the queue is full. */
+class Producer : public wxThread {
+	public:
+		Producer(DBGp::SPSCQueue<int> &queue, int count) : wxThread(wxTHREAD_JOINABLE), count(count), queue(queue) {}
+
+	protected:
+		virtual ExitCode Entry() {
+			for (int i = 0; i < count; i++) {
+				while (!queue.Push(i)) {
+					wxThread::Yield();
+				}
+			}
+			return 0;
+		}
+
+	private:
+		int count;
+		DBGp::SPSCQueue<int> &queue;
+};
+// }}}
+
+// {{{ void SPSCQueue::testEmpty()
+void SPSCQueue::testEmpty() {
+	DBGp::SPSCQueue<int> queue(4);
+	int item = -1;
+
+	CPPUNIT_ASSERT_EQUAL(size_t(4), queue.GetCapacity());
+	CPPUNIT_ASSERT(queue.IsEmpty());
+	CPPUNIT_ASSERT(!queue.Pop(item));
+	CPPUNIT_ASSERT_EQUAL(-1, item);
+
+	CPPUNIT_ASSERT(queue.Push(1));
+	CPPUNIT_ASSERT(!queue.IsEmpty());
+	CPPUNIT_ASSERT(queue.Pop(item));
+	CPPUNIT_ASSERT_EQUAL(1, item);
+	CPPUNIT_ASSERT(queue.IsEmpty());
+	CPPUNIT_ASSERT(!queue.Pop(item));
+}
+// }}}
+// {{{ void SPSCQueue::testFull()
+void SPSCQueue::testFull() {
+	DBGp::SPSCQueue<int> queue(3);
+	int item;
+
+	CPPUNIT_ASSERT(queue.Push(1));
+	CPPUNIT_ASSERT(queue.Push(2));
+	CPPUNIT_ASSERT(queue.Push(3));
+	CPPUNIT_ASSERT(!queue.Push(4));
+
+	// Popping one item makes room for exactly one more.
+	CPPUNIT_ASSERT(queue.Pop(item));
+	CPPUNIT_ASSERT_EQUAL(1, item);
+	CPPUNIT_ASSERT(queue.Push(4));
+	CPPUNIT_ASSERT(!queue.Push(5));
+
+	for (int expected = 2; expected <= 4; expected++) {
+		CPPUNIT_ASSERT(queue.Pop(item));
+		CPPUNIT_ASSERT_EQUAL(expected, item);
+	}
+	CPPUNIT_ASSERT(queue.IsEmpty());
+}
+// }}}
+// {{{ void SPSCQueue::testThreaded()
+void SPSCQueue::testThreaded() {
+	wxInitializer init;
+	CPPUNIT_ASSERT(init.IsOk());
+
+	DBGp::SPSCQueue<int> queue(8);
+	Producer producer(queue, THREADED_ITEMS);
+
+	CPPUNIT_ASSERT(producer.Create() == wxTHREAD_NO_ERROR);
+	CPPUNIT_ASSERT(producer.Run() == wxTHREAD_NO_ERROR);
+
+	int expected = 0, item;
+	bool ordered = true;
+	while (expected < THREADED_ITEMS) {
+		if (!queue.Pop(item)) {
+			wxThread::Yield();
+			continue;
+		}
+
+		// Don't assert here: failing would leave the producer running.
+		if (item != expected) {
+			ordered = false;
+		}
+		expected++;
+	}
+	producer.Wait();
+
+	CPPUNIT_ASSERT(ordered);
+	CPPUNIT_ASSERT(queue.IsEmpty());
+}
+// }}}
+// {{{ void SPSCQueue::testWrap()
+void SPSCQueue::testWrap() {
+	DBGp::SPSCQueue<int> queue(2);
+	int item;
+
+	// Go around the slots enough times to exercise the wrap-around.
+	for (int i = 0; i < 10; i++) {
+		CPPUNIT_ASSERT(queue.Push(i * 2));
+		CPPUNIT_ASSERT(queue.Push(i * 2 + 1));
+
+		CPPUNIT_ASSERT(queue.Pop(item));
+		CPPUNIT_ASSERT_EQUAL(i * 2, item);
+		CPPUNIT_ASSERT(queue.Pop(item));
+		CPPUNIT_ASSERT_EQUAL(i * 2 + 1, item);
+		CPPUNIT_ASSERT(queue.IsEmpty());
+	}
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
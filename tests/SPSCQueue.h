@@ -29,22 +29,27 @@
  */
 // }}}
 
-#ifndef DUBNIUM_PROPERTYTREEITEM_H
-#define DUBNIUM_PROPERTYTREEITEM_H
+#ifndef TEST_SPSCQUEUE_H
+#define TEST_SPSCQUEUE_H
 
-#include <wx/treectrl.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
 
-#include "DBGp/Property.h"
+#include "DBGp/SPSCQueue.h"
 
-class PropertyTreeItem : public wxTreeItemData {
-	public:
-		PropertyTreeItem(const DBGp::Property *prop);
-		virtual ~PropertyTreeItem();
-
-		DBGp::Property *GetProperty();
+class SPSCQueue : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(SPSCQueue);
+	CPPUNIT_TEST(testEmpty);
+	CPPUNIT_TEST(testFull);
+	CPPUNIT_TEST(testThreaded);
+	CPPUNIT_TEST(testWrap);
+	CPPUNIT_TEST_SUITE_END();
 
-	protected:
-		DBGp::Property *prop;
+	public:
+		void testEmpty();
+		void testFull();
+		void testThreaded();
+		void testWrap();
 };
 
 #endif
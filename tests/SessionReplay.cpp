@@ -0,0 +1,177 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "SessionReplay.h"
+
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SessionReplay);
+
+/* The session written by RecordSession(). */
+static const char *INIT = "<init xmlns=\"urn:debugger_protocol_v1\" appid=\"1\" idekey=\"test\" language=\"PHP\" protocol_version=\"1.0\" fileuri=\"file:///tmp/test.php\"/>";
+static const char *STATUS = "status -i 3";
+static const char *RESPONSE = "<response xmlns=\"urn:debugger_protocol_v1\" command=\"status\" transaction_id=\"3\" status=\"starting\" reason=\"ok\"/>";
+
+// {{{ void SessionReplay::setUp()
+void SessionReplay::setUp() {
+	DBGpFixture::setUp();
+	file = wxFileName::CreateTempFileName(wxT("dubnium"));
+}
+// }}}
+// {{{ void SessionReplay::tearDown()
+void SessionReplay::tearDown() {
+	wxRemoveFile(file);
+	DBGpFixture::tearDown();
+}
+// }}}
+
+// {{{ void SessionReplay::testConnection()
+void SessionReplay::testConnection() {
+	CPPUNIT_ASSERT(conn->StartRecording(file));
+	CPPUNIT_ASSERT(conn->IsRecording());
+	conn->ProcessNextResponse();
+	conn->StopRecording();
+	CPPUNIT_ASSERT(!conn->IsRecording());
+
+	DBGp::SessionReplay replay;
+	replay.Load(file);
+
+	const DBGp::SessionReplay::RecordList &records = replay.GetRecords();
+	CPPUNIT_ASSERT(!records.empty());
+	CPPUNIT_ASSERT(records[0].direction == DBGp::SessionRecorder::RECEIVED);
+	CPPUNIT_ASSERT(std::string(records[0].payload, records[0].length).find("<init") != std::string::npos);
+}
+// }}}
+// {{{ void SessionReplay::testLoad()
+void SessionReplay::testLoad() {
+	RecordSession();
+
+	DBGp::SessionReplay replay;
+	replay.Load(file);
+
+	const DBGp::SessionReplay::RecordList &records = replay.GetRecords();
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, records.size());
+	CPPUNIT_ASSERT(records[0].direction == DBGp::SessionRecorder::RECEIVED);
+	CPPUNIT_ASSERT(std::string(records[0].payload, records[0].length) == INIT);
+	CPPUNIT_ASSERT(records[1].direction == DBGp::SessionRecorder::SENT);
+	CPPUNIT_ASSERT(std::string(records[1].payload, records[1].length) == STATUS);
+	CPPUNIT_ASSERT(records[2].direction == DBGp::SessionRecorder::RECEIVED);
+	CPPUNIT_ASSERT(std::string(records[2].payload, records[2].length) == RESPONSE);
+	CPPUNIT_ASSERT(records[0].time <= records[1].time);
+	CPPUNIT_ASSERT(records[1].time <= records[2].time);
+}
+// }}}
+// {{{ void SessionReplay::testNotRecording()
+void SessionReplay::testNotRecording() {
+	wxFFile garbage(file, wxT("wb"));
+	garbage.Write("not a recording", 15);
+	garbage.Close();
+
+	DBGp::SessionReplay replay;
+	replay.Load(file);
+}
+// }}}
+// {{{ void SessionReplay::testReplay()
+void SessionReplay::testReplay() {
+	int fds[2];
+	char buffer[1024];
+	std::string received;
+	ssize_t read;
+
+	RecordSession();
+
+	DBGp::SessionReplay replay;
+	replay.Load(file);
+
+	// The IDE numbers its commands differently to the recorded session.
+	CPPUNIT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	CPPUNIT_ASSERT(write(fds[0], "status -i 7", 12) == 12);
+
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, replay.Replay(fds[1], 0));
+	close(fds[1]);
+
+	while ((read = recv(fds[0], buffer, sizeof(buffer), 0)) > 0) {
+		received.append(buffer, read);
+	}
+	close(fds[0]);
+
+	std::string response(RESPONSE);
+	response.replace(response.find("\"3\""), 3, "\"7\"");
+
+	std::string expected;
+	expected += wxString::Format(wxT("%lu"), (unsigned long) std::strlen(INIT)).mb_str();
+	expected.push_back('\0');
+	expected += INIT;
+	expected.push_back('\0');
+	expected += wxString::Format(wxT("%lu"), (unsigned long) response.length()).mb_str();
+	expected.push_back('\0');
+	expected += response;
+	expected.push_back('\0');
+
+	CPPUNIT_ASSERT(received == expected);
+}
+// }}}
+// {{{ void SessionReplay::testTruncated()
+void SessionReplay::testTruncated() {
+	RecordSession();
+
+	// A recorder that died mid-write leaves part of a header behind.
+	wxFFile append(file, wxT("ab"));
+	append.Write("\0\0\0\0\xff", 5);
+	append.Close();
+
+	DBGp::SessionReplay replay;
+	replay.Load(file);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, replay.GetRecords().size());
+}
+// }}}
+
+// {{{ void SessionReplay::RecordSession()
+void SessionReplay::RecordSession() {
+	DBGp::SessionRecorder recorder;
+
+	CPPUNIT_ASSERT(recorder.Open(file));
+	recorder.Record(DBGp::SessionRecorder::RECEIVED, INIT, std::strlen(INIT));
+	recorder.Record(DBGp::SessionRecorder::SENT, STATUS, std::strlen(STATUS));
+	recorder.Record(DBGp::SessionRecorder::RECEIVED, RESPONSE, std::strlen(RESPONSE));
+	recorder.Close();
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
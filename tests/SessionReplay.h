@@ -0,0 +1,69 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef TEST_SESSIONREPLAY_H
+#define TEST_SESSIONREPLAY_H
+
+#include "DBGp/SessionRecorder.h"
+#include "DBGp/SessionReplay.h"
+
+#include "DBGpFixture.h"
+
+class SessionReplay : public DBGpFixture {
+	CPPUNIT_TEST_SUITE(SessionReplay);
+	CPPUNIT_TEST(testConnection);
+	CPPUNIT_TEST(testLoad);
+	CPPUNIT_TEST_EXCEPTION(testNotRecording, DBGp::Error);
+	CPPUNIT_TEST(testReplay);
+	CPPUNIT_TEST(testTruncated);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp();
+		void tearDown();
+
+		void testConnection();
+		void testLoad();
+		void testNotRecording();
+		void testReplay();
+		void testTruncated();
+
+	protected:
+		/** The recording each test writes to. */
+		wxString file;
+
+		/** Records a short session: init, status and its response. */
+		void RecordSession();
+};
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,277 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Simulator.h"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Simulator);
+
+// {{{ static std::string Command(const char *command)
+static std::string Command(const char *command) {
+	return std::string(command) + '\0';
+}
+// }}}
+// {{{ static size_t Count(const std::string &haystack, const std::string &needle)
+static size_t Count(const std::string &haystack, const std::string &needle) {
+	size_t count = 0;
+
+	for (size_t i = haystack.find(needle); i != std::string::npos; i = haystack.find(needle, i + 1)) {
+		count++;
+	}
+	return count;
+}
+// }}}
+
+// {{{ void Simulator::setUp()
+void Simulator::setUp() {
+	init = new wxInitializer;
+}
+// }}}
+// {{{ void Simulator::tearDown()
+void Simulator::tearDown() {
+	delete init;
+}
+// }}}
+
+// {{{ void Simulator::testBreakpoints()
+void Simulator::testBreakpoints() {
+	DBGp::Simulator::Workload workload;
+	std::string commands;
+
+	// Every other run hits the second breakpoint; the rest are steps.
+	workload.hits.clear();
+	workload.hits.push_back(0);
+	workload.hits.push_back(2);
+
+	commands += Command("breakpoint_set -i 1 -t line -f file:///a.php -n 10");
+	commands += Command("breakpoint_set -i 2 -t line -f file:///a.php -n 42");
+	commands += Command("run -i 3");
+	commands += Command("stack_get -i 4 -d 0");
+	commands += Command("run -i 5");
+	commands += Command("stack_get -i 6 -d 0");
+	commands += Command("breakpoint_list -i 7");
+	commands += Command("breakpoint_update -i 8 -d 2 -s disabled");
+	commands += Command("run -i 9");
+	commands += Command("run -i 10");
+	commands += Command("breakpoint_get -i 11 -d 2");
+
+	std::vector<std::string> messages(Serve(workload, commands));
+	CPPUNIT_ASSERT_EQUAL((size_t) 12, messages.size());
+	CPPUNIT_ASSERT(messages[1].find("id=\"1\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[2].find("id=\"2\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[3].find("status=\"break\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[4].find("lineno=\"2\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[6].find("lineno=\"42\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[7].find("id=\"1\" type=\"line\" state=\"enabled\" filename=\"file:///a.php\" lineno=\"10\" hit_count=\"0\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[7].find("id=\"2\" type=\"line\" state=\"enabled\" filename=\"file:///a.php\" lineno=\"42\" hit_count=\"1\"") != std::string::npos);
+
+	// Disabled breakpoints aren't hit.
+	CPPUNIT_ASSERT(messages[11].find("state=\"disabled\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[11].find("hit_count=\"1\"") != std::string::npos);
+}
+// }}}
+// {{{ void Simulator::testFinished()
+void Simulator::testFinished() {
+	DBGp::Simulator::Workload workload;
+	DBGp::Simulator::Totals totals;
+	std::string commands;
+
+	workload.breaks = 1;
+	commands += Command("status -i 1");
+	commands += Command("step_into -i 2");
+	commands += Command("step_over -i 3");
+	commands += Command("step_out -i 4");
+	commands += Command("stop -i 5");
+	commands += Command("status -i 6");
+
+	std::vector<std::string> messages(Serve(workload, commands, &totals));
+	CPPUNIT_ASSERT_EQUAL((size_t) 6, messages.size());
+	CPPUNIT_ASSERT(messages[0].find("<init") != std::string::npos);
+	CPPUNIT_ASSERT(messages[0].find("idekey=\"dbgp-sim\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[1].find("status=\"starting\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[2].find("status=\"break\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[3].find("status=\"stopping\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[4].find("<error code=\"5\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[5].find("status=\"stopped\"") != std::string::npos);
+
+	// Nothing is answered after stop.
+	CPPUNIT_ASSERT_EQUAL((wxUint64) 5, totals.commands);
+	CPPUNIT_ASSERT_EQUAL(1u, totals.sessions);
+	CPPUNIT_ASSERT_EQUAL(0u, totals.failed);
+	CPPUNIT_ASSERT_EQUAL((wxUint64) 5, totals.turnaround.GetCount());
+}
+// }}}
+// {{{ void Simulator::testProperties()
+void Simulator::testProperties() {
+	DBGp::Simulator::Workload workload;
+	std::string commands;
+
+	workload.contexts = 3;
+	workload.depth = 4;
+	workload.fanOut = 5;
+	workload.nesting = 2;
+	workload.properties = 8;
+	workload.stringLength = 3;
+
+	commands += Command("feature_set -i 1 -n max_children -v \"2\"");
+	commands += Command("stack_get -i 2");
+	commands += Command("context_names -i 3");
+	commands += Command("context_get -i 4 -d 0 -c 0");
+	commands += Command("property_get -i 5 -n \"$var3->prop2\" -d 1 -c 0 -p 2");
+	commands += Command("property_get -i 6 -n \"$var3[2]\" -c 0");
+	commands += Command("context_get -i 7 -c 3");
+	commands += Command("property_value -i 8 -n \"$var2[0]\"");
+
+	std::vector<std::string> messages(Serve(workload, commands));
+	CPPUNIT_ASSERT_EQUAL((size_t) 9, messages.size());
+	CPPUNIT_ASSERT(messages[1].find("success=\"1\"") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL((size_t) 4, Count(messages[2], "<stack "));
+	CPPUNIT_ASSERT(messages[2].find("where=\"{main}\"") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, Count(messages[3], "<context "));
+
+	// One level of children is sent by default, a page at a time.
+	CPPUNIT_ASSERT_EQUAL((size_t) 8, Count(messages[4], "<property name=\"$var"));
+	CPPUNIT_ASSERT(messages[4].find("fullname=\"$var2[1]\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[4].find("fullname=\"$var2[2]\"") == std::string::npos);
+	CPPUNIT_ASSERT(messages[4].find("YWJj") != std::string::npos);
+
+	// The last page of a nested array.
+	CPPUNIT_ASSERT(messages[5].find("fullname=\"$var3-&gt;prop2\" type=\"array\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[5].find("page=\"2\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[5].find("fullname=\"$var3-&gt;prop2[4]\"") != std::string::npos);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, Count(messages[5], "<property name=\"4\""));
+
+	// $var3 is an object, so it can't be indexed like an array.
+	CPPUNIT_ASSERT(messages[6].find("<error code=\"300\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[7].find("<error code=\"302\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[8].find("size=\"3\" encoding=\"base64\"><![CDATA[YWJj]]>") != std::string::npos);
+}
+// }}}
+// {{{ void Simulator::testStdout()
+void Simulator::testStdout() {
+	DBGp::Simulator::Workload workload;
+	std::string commands;
+
+	workload.stdoutPackets = 3;
+	commands += Command("run -i 1");
+	commands += Command("stdout -i 2 -c 1");
+	commands += Command("run -i 3");
+
+	// Output is only sent once it's been asked for.
+	std::vector<std::string> messages(Serve(workload, commands));
+	CPPUNIT_ASSERT_EQUAL((size_t) 7, messages.size());
+	CPPUNIT_ASSERT(messages[1].find("command=\"run\"") != std::string::npos);
+	CPPUNIT_ASSERT(messages[2].find("command=\"stdout\"") != std::string::npos);
+	for (size_t i = 3; i < 6; i++) {
+		CPPUNIT_ASSERT(messages[i].find("<stream") != std::string::npos);
+		CPPUNIT_ASSERT(messages[i].find("type=\"stdout\"") != std::string::npos);
+	}
+	CPPUNIT_ASSERT(messages[6].find("transaction_id=\"3\"") != std::string::npos);
+}
+// }}}
+// {{{ void Simulator::testWorkload()
+void Simulator::testWorkload() {
+	DBGp::Simulator::Workload workload(DBGp::Simulator::Workload::FromString(wxT("breaks=5,contexts=3,depth=7,fanout=9,hits=1:0:2,idekey=load,nesting=4,properties=100,stdout=2,strings=1024")));
+
+	CPPUNIT_ASSERT_EQUAL(5u, workload.breaks);
+	CPPUNIT_ASSERT_EQUAL(3u, workload.contexts);
+	CPPUNIT_ASSERT_EQUAL(7u, workload.depth);
+	CPPUNIT_ASSERT_EQUAL(9u, workload.fanOut);
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, workload.hits.size());
+	CPPUNIT_ASSERT_EQUAL(1u, workload.hits[0]);
+	CPPUNIT_ASSERT_EQUAL(0u, workload.hits[1]);
+	CPPUNIT_ASSERT_EQUAL(2u, workload.hits[2]);
+	CPPUNIT_ASSERT(workload.ideKey == wxT("load"));
+	CPPUNIT_ASSERT_EQUAL(4u, workload.nesting);
+	CPPUNIT_ASSERT_EQUAL(100u, workload.properties);
+	CPPUNIT_ASSERT_EQUAL(2u, workload.stdoutPackets);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1024, workload.stringLength);
+
+	// Anything left out keeps its default.
+	workload = DBGp::Simulator::Workload::FromString(wxT("depth=2"));
+	CPPUNIT_ASSERT_EQUAL(2u, workload.depth);
+	CPPUNIT_ASSERT_EQUAL(DBGp::Simulator::Workload().properties, workload.properties);
+}
+// }}}
+// {{{ void Simulator::testWorkloadInvalid()
+void Simulator::testWorkloadInvalid() {
+	DBGp::Simulator::Workload::FromString(wxT("depth=2,colour=blue"));
+}
+// }}}
+
+// {{{ std::vector<std::string> Simulator::Serve(const DBGp::Simulator::Workload &workload, const std::string &commands, DBGp::Simulator::Totals *totals)
+std::vector<std::string> Simulator::Serve(const DBGp::Simulator::Workload &workload, const std::string &commands, DBGp::Simulator::Totals *totals) {
+	std::vector<std::string> messages;
+	std::string received;
+	char buffer[4096];
+	ssize_t read;
+	int fds[2];
+
+	/* Everything fits in the socket buffers, so the whole session can be
+	 * run on this thread: the commands are written up front, and the
+	 * simulator finishes when it reads to the end of them. */
+	CPPUNIT_ASSERT(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+	CPPUNIT_ASSERT(write(fds[0], commands.data(), commands.length()) == static_cast<ssize_t>(commands.length()));
+	shutdown(fds[0], SHUT_WR);
+
+	DBGp::Simulator simulator(workload);
+	DBGp::Simulator::Totals result(simulator.Serve(fds[1]));
+	close(fds[1]);
+
+	while ((read = recv(fds[0], buffer, sizeof(buffer), 0)) > 0) {
+		received.append(buffer, read);
+	}
+	close(fds[0]);
+
+	for (size_t i = 0; i < received.length(); ) {
+		size_t end = received.find('\0', i);
+		CPPUNIT_ASSERT(end != std::string::npos);
+
+		size_t length = std::strtoul(received.c_str() + i, NULL, 10);
+		CPPUNIT_ASSERT(end + 1 + length < received.length());
+		messages.push_back(received.substr(end + 1, length));
+		i = end + length + 2;
+	}
+
+	if (totals) {
+		*totals = result;
+	}
+	return messages;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,79 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#ifndef TEST_SIMULATOR_H
+#define TEST_SIMULATOR_H
+
+#include <string>
+#include <vector>
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
+
+#include <wx/init.h>
+
+#include "DBGp/Simulator.h"
+
+class Simulator : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(Simulator);
+	CPPUNIT_TEST(testBreakpoints);
+	CPPUNIT_TEST(testFinished);
+	CPPUNIT_TEST(testProperties);
+	CPPUNIT_TEST(testStdout);
+	CPPUNIT_TEST(testWorkload);
+	CPPUNIT_TEST_EXCEPTION(testWorkloadInvalid, DBGp::Error);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void setUp();
+		void tearDown();
+
+		void testBreakpoints();
+		void testFinished();
+		void testProperties();
+		void testStdout();
+		void testWorkload();
+		void testWorkloadInvalid();
+
+	protected:
+		wxInitializer *init;
+
+		/**
+		 * Serves a session that receives the given commands, each
+		 * NULL terminated, and returns every message the simulator
+		 * sent, starting with the init packet.
+		 */
+		std::vector<std::string> Serve(const DBGp::Simulator::Workload &workload, const std::string &commands, DBGp::Simulator::Totals *totals = NULL);
+};
+
+#endif
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
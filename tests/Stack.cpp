@@ -36,19 +36,11 @@ CPPUNIT_TEST_SUITE_REGISTRATION(Stack);
 // {{{ void Stack::setUp()
 void Stack::setUp() {
 	DBGpFixture::setUp();
-	AddResponse(wxT("xml/stack/depth.xml"));
-	AddResponse(wxT("xml/stack/get-0.xml"));
-	AddResponse(wxT("xml/stack/context.xml"));
-	AddResponse(wxT("xml/stack/context-get-0.xml"));
-	AddResponse(wxT("xml/stack/context-get-1.xml"));
-	AddResponse(wxT("xml/stack/get-1.xml"));
-	AddResponse(wxT("xml/stack/context.xml"));
-	AddResponse(wxT("xml/stack/context-get-0.xml"));
-	AddResponse(wxT("xml/stack/context-get-1.xml"));
+	AddResponse(wxT("xml/stack/get.xml"));
 	conn->ProcessNextResponse();
 
-	/* Not the generally recommended way of doing this, but it avoids a
-	 * duplicate call to stack_depth. */
+	/* Not the generally recommended way of doing this, but it avoids
+	 * going through Connection::StackGet() and copying the stack. */
 	stack = new DBGp::Stack(conn);
 }
 // }}}
@@ -64,6 +56,7 @@ void Stack::testContext() {
 	DBGp::StackLevel *level = stack->GetLevel(0);
 	CPPUNIT_ASSERT(level != NULL);
 
+	AddResponse(wxT("xml/stack/context.xml"));
 	const DBGp::StackLevel::ContextMap &contexts(level->GetContexts());
 	DBGp::StackLevel::ContextMap::const_iterator i = contexts.find(wxT("0"));
 	CPPUNIT_ASSERT(i != contexts.end());
@@ -74,6 +67,69 @@ void Stack::testContext() {
 	CPPUNIT_ASSERT(context->GetStackLevel() == level);
 }
 // }}}
+// {{{ void Stack::testFindProperty()
+void Stack::testFindProperty() {
+	DBGp::StackLevel *level = stack->GetLevel(0);
+	CPPUNIT_ASSERT(level != NULL);
+	CPPUNIT_ASSERT(level->FindProperty(wxT("str")) == NULL);
+
+	AddResponse(wxT("xml/stack/context.xml"));
+	AddResponse(wxT("xml/stack/context-get-0.xml"));
+	AddResponse(wxT("xml/stack/context-get-1.xml"));
+	level->RetrieveProperties();
+
+	DBGp::Property *zero = level->FindProperty(wxT("$arr[0]"));
+	CPPUNIT_ASSERT(zero != NULL);
+	CPPUNIT_ASSERT(zero->GetData() == wxT("42"));
+	CPPUNIT_ASSERT(zero == level->GetContexts().find(wxT("0"))->second->GetProperty(wxT("arr"))->GetChild(wxT("0")));
+
+	// Both contexts have the same properties; the local ones win.
+	DBGp::Property *nul = level->FindProperty(wxT("$obj->nul"));
+	CPPUNIT_ASSERT(nul != NULL);
+	CPPUNIT_ASSERT(nul->GetContext()->GetID() == wxT("0"));
+
+	CPPUNIT_ASSERT(level->FindProperty(wxT("$obj->missing")) == NULL);
+	CPPUNIT_ASSERT(stack->GetLevel(1)->FindProperty(wxT("str")) == NULL);
+}
+// }}}
+// {{{ void Stack::testLazyContexts()
+void Stack::testLazyContexts() {
+	DBGp::StackLevel *level = stack->GetLevel(1);
+	CPPUNIT_ASSERT(level != NULL);
+	CPPUNIT_ASSERT(level->HasContexts() == false);
+
+	AddResponse(wxT("xml/stack/context.xml"));
+	const DBGp::StackLevel::ContextMap &contexts(level->GetContexts());
+	CPPUNIT_ASSERT(level->HasContexts() == true);
+	CPPUNIT_ASSERT(contexts.size() == 2);
+
+	for (DBGp::StackLevel::ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
+		CPPUNIT_ASSERT(i->second->HasProperties() == false);
+	}
+
+	// The other frame shouldn't have been touched.
+	CPPUNIT_ASSERT(stack->GetLevel(0)->HasContexts() == false);
+}
+// }}}
+// {{{ void Stack::testRetrieveProperties()
+void Stack::testRetrieveProperties() {
+	DBGp::StackLevel *level = stack->GetLevel(0);
+	CPPUNIT_ASSERT(level != NULL);
+
+	AddResponse(wxT("xml/stack/context.xml"));
+	AddResponse(wxT("xml/stack/context-get-0.xml"));
+	AddResponse(wxT("xml/stack/context-get-1.xml"));
+	level->RetrieveProperties();
+
+	const DBGp::StackLevel::ContextMap &contexts(level->GetContexts());
+	CPPUNIT_ASSERT(contexts.size() == 2);
+
+	for (DBGp::StackLevel::ContextMap::const_iterator i = contexts.begin(); i != contexts.end(); i++) {
+		CPPUNIT_ASSERT(i->second->HasProperties() == true);
+		CPPUNIT_ASSERT(i->second->GetProperties().size() == 3);
+	}
+}
+// }}}
 // {{{ void Stack::testStackGet()
 void Stack::testStackGet() {
 	CPPUNIT_ASSERT(stack != NULL);
@@ -101,6 +157,16 @@ void Stack::testStackLevel() {
 	CPPUNIT_ASSERT(level->GetWhere() == wxT("func"));
 }
 // }}}
+// {{{ void Stack::testStackLevelDepth()
+void Stack::testStackLevelDepth() {
+	AddResponse(wxT("xml/stack/get-1.xml"));
+	DBGp::StackLevel level(conn, 1);
+	CPPUNIT_ASSERT(level.GetLevel() == 1);
+	CPPUNIT_ASSERT(level.GetLineNo() == 13);
+	CPPUNIT_ASSERT(level.GetWhere() == wxT("func"));
+	CPPUNIT_ASSERT(level.HasContexts() == false);
+}
+// }}}
 // {{{ void Stack::testStackLevelNotFound()
 void Stack::testStackLevelNotFound() {
 	stack->GetLevel(2);
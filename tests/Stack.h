@@ -37,8 +37,12 @@
 class Stack : public DBGpFixture {
 	CPPUNIT_TEST_SUITE(Stack);
 	CPPUNIT_TEST(testContext);
+	CPPUNIT_TEST(testFindProperty);
+	CPPUNIT_TEST(testLazyContexts);
+	CPPUNIT_TEST(testRetrieveProperties);
 	CPPUNIT_TEST(testStackGet);
 	CPPUNIT_TEST(testStackLevel);
+	CPPUNIT_TEST(testStackLevelDepth);
 	CPPUNIT_TEST_EXCEPTION(testStackLevelNotFound, DBGp::NotFoundError);
 	CPPUNIT_TEST_SUITE_END();
 
@@ -47,8 +51,12 @@ class Stack : public DBGpFixture {
 		virtual void tearDown();
 
 		void testContext();
+		void testFindProperty();
+		void testLazyContexts();
+		void testRetrieveProperties();
 		void testStackGet();
 		void testStackLevel();
+		void testStackLevelDepth();
 		void testStackLevelNotFound();
 
 	protected:
@@ -0,0 +1,192 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Statistics.h"
+
+#include "DBGp/Utility.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Statistics);
+
+// {{{ void Statistics::testConnection()
+void Statistics::testConnection() {
+	AddResponse(wxT("xml/feature/get-success.xml"));
+	conn->ProcessNextResponse();
+	conn->FeatureGet(wxT("test"));
+
+	DBGp::Statistics::CommandMap commands(conn->GetStatistics().GetCommands());
+	CPPUNIT_ASSERT(commands[wxT("init")].received == 1);
+	CPPUNIT_ASSERT(commands[wxT("init")].bytesReceived > 0);
+	CPPUNIT_ASSERT(commands[wxT("init")].parse.GetCount() == 1);
+	CPPUNIT_ASSERT(commands[wxT("feature_get")].received >= 1);
+
+	// The test connection doesn't really send anything.
+	CPPUNIT_ASSERT(commands[wxT("feature_get")].firstByte.GetCount() == 0);
+}
+// }}}
+// {{{ void Statistics::testForget()
+void Statistics::testForget() {
+	DBGp::Statistics statistics;
+	DBGp::Statistics::Timing timing;
+	int session;
+
+	statistics.RecordSent(&session, wxT("run"), 1, 10);
+	statistics.Forget(&session);
+
+	timing.firstByte = timing.lastByte = DBGp::GetMicroseconds();
+	statistics.RecordResponse(&session, wxT("run"), 1, 20, timing);
+
+	DBGp::Statistics::CommandMap commands(statistics.GetCommands());
+	CPPUNIT_ASSERT(commands[wxT("run")].received == 1);
+	CPPUNIT_ASSERT(commands[wxT("run")].firstByte.GetCount() == 0);
+}
+// }}}
+// {{{ void Statistics::testHistogram()
+void Statistics::testHistogram() {
+	DBGp::Histogram histogram;
+
+	CPPUNIT_ASSERT(histogram.GetCount() == 0);
+	CPPUNIT_ASSERT(histogram.GetPercentile(50.0) == 0);
+
+	for (wxUint64 i = 1; i <= 1000; i++) {
+		histogram.Record(i);
+	}
+
+	CPPUNIT_ASSERT(histogram.GetCount() == 1000);
+	CPPUNIT_ASSERT(histogram.GetMin() == 1);
+	CPPUNIT_ASSERT(histogram.GetMax() == 1000);
+	CPPUNIT_ASSERT(histogram.GetTotal() == 500500);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(500.5, histogram.GetMean(), 0.001);
+
+	// Percentiles are only kept to within a sixteenth.
+	wxUint64 median = histogram.GetPercentile(50.0);
+	CPPUNIT_ASSERT(median >= 500 && median <= 500 + 500 / 16);
+
+	wxUint64 p99 = histogram.GetPercentile(99.0);
+	CPPUNIT_ASSERT(p99 >= 990 && p99 <= 1000);
+	CPPUNIT_ASSERT(histogram.GetPercentile(100.0) == 1000);
+
+	// Small values are exact.
+	CPPUNIT_ASSERT(histogram.GetPercentile(1.0) == 10);
+
+	histogram.Reset();
+	CPPUNIT_ASSERT(histogram.GetCount() == 0);
+	CPPUNIT_ASSERT(histogram.GetMax() == 0);
+}
+// }}}
+// {{{ void Statistics::testHistogramMerge()
+void Statistics::testHistogramMerge() {
+	DBGp::Histogram a, b;
+
+	a.Record(10);
+	a.Record(20);
+	b.Record(5);
+	b.Record(40000);
+
+	a.Merge(b);
+	CPPUNIT_ASSERT(a.GetCount() == 4);
+	CPPUNIT_ASSERT(a.GetMin() == 5);
+	CPPUNIT_ASSERT(a.GetMax() == 40000);
+	CPPUNIT_ASSERT(a.GetTotal() == 40035);
+	CPPUNIT_ASSERT(a.GetPercentile(25.0) == 5);
+	CPPUNIT_ASSERT(a.GetPercentile(50.0) == 10);
+}
+// }}}
+// {{{ void Statistics::testHistogramOverflow()
+void Statistics::testHistogramOverflow() {
+	DBGp::Histogram histogram;
+	wxUint64 huge = DBGp::Histogram::GetHighestTrackable() * 4;
+
+	histogram.Record(huge);
+	CPPUNIT_ASSERT(histogram.GetMax() == huge);
+	CPPUNIT_ASSERT(histogram.GetPercentile(50.0) == huge);
+}
+// }}}
+// {{{ void Statistics::testResponse()
+void Statistics::testResponse() {
+	DBGp::Statistics statistics;
+	DBGp::Statistics::Timing timing;
+
+	statistics.RecordSent(this, wxT("stack_get"), 7, 30);
+
+	timing.firstByte = DBGp::GetMicroseconds();
+	timing.lastByte = timing.firstByte + 100;
+	timing.parse = 50;
+	timing.decode = 20;
+	statistics.RecordResponse(this, wxT("stack_get"), 7, 400, timing);
+
+	DBGp::Statistics::CommandMap commands(statistics.GetCommands());
+	const DBGp::Statistics::Command &command = commands[wxT("stack_get")];
+	CPPUNIT_ASSERT(command.sent == 1);
+	CPPUNIT_ASSERT(command.received == 1);
+	CPPUNIT_ASSERT(command.bytesSent == 30);
+	CPPUNIT_ASSERT(command.bytesReceived == 400);
+	CPPUNIT_ASSERT(command.firstByte.GetCount() == 1);
+	CPPUNIT_ASSERT(command.response.GetCount() == 1);
+	CPPUNIT_ASSERT(command.response.GetMax() >= 100);
+	CPPUNIT_ASSERT(command.parse.GetMax() == 50);
+	CPPUNIT_ASSERT(command.decode.GetMax() == 20);
+
+	// A second response to the same transaction has nothing to time.
+	statistics.RecordResponse(this, wxT("stack_get"), 7, 400, timing);
+	CPPUNIT_ASSERT(statistics.GetCommands()[wxT("stack_get")].firstByte.GetCount() == 1);
+
+	statistics.RecordReceived(wxT("stream"), 10, DBGp::Statistics::Timing());
+	DBGp::Statistics::Command totals(statistics.GetTotals());
+	CPPUNIT_ASSERT(totals.received == 3);
+	CPPUNIT_ASSERT(totals.bytesReceived == 810);
+
+	CPPUNIT_ASSERT(statistics.Format().Find(wxT("stack_get")) != wxNOT_FOUND);
+
+	statistics.Reset();
+	CPPUNIT_ASSERT(statistics.GetCommands().empty());
+}
+// }}}
+// {{{ void Statistics::testSessions()
+void Statistics::testSessions() {
+	DBGp::Statistics statistics;
+	DBGp::Statistics::Timing timing;
+	int first, second;
+
+	// Both sessions use the same transaction ID.
+	statistics.RecordSent(&first, wxT("eval"), 0, 10);
+	statistics.RecordSent(&second, wxT("eval"), 0, 10);
+
+	timing.firstByte = timing.lastByte = DBGp::GetMicroseconds();
+	statistics.RecordResponse(&first, wxT("eval"), 0, 10, timing);
+	statistics.RecordResponse(&second, wxT("eval"), 0, 10, timing);
+
+	DBGp::Statistics::CommandMap commands(statistics.GetCommands());
+	CPPUNIT_ASSERT(commands[wxT("eval")].sent == 2);
+	CPPUNIT_ASSERT(commands[wxT("eval")].firstByte.GetCount() == 2);
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
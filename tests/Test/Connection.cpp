@@ -32,11 +32,14 @@
 #include "Test/Connection.h"
 
 #include <wx/log.h>
+#include <wx/mstream.h>
 
 #ifdef __WXDEBUG__
 #include <wx/sstream.h>
 #endif
 
+#include <vector>
+
 using namespace Test;
 
 // {{{ Connection::Connection(DBGp::ConnectionID id, wxSocketBase *socket, Server *server)
@@ -53,7 +56,7 @@ void Connection::AddResponse(const wxXmlDocument &doc) {
 void Connection::ProcessNextResponse() {
 	try {
 		wxXmlDocument doc(GetMessage());
-		HandleMessage(doc);
+		DispatchMessage(doc);
 	}
 	catch (DBGp::Error e) {
 	}
@@ -73,9 +76,17 @@ wxXmlDocument Connection::GetMessage() throw (DBGp::MalformedDocumentError, DBGp
 	if (currentResponse != responses.end()) {
 		wxXmlDocument doc(*currentResponse);
 
-		// Munge the transaction ID.
+		/* Munge the transaction ID. Responses are matched up with
+		 * commands in the order they were sent, which lets pipelined
+		 * commands be tested. */
 		wxString transaction;
-		transaction << (txID - 1);
+		if (doc.GetRoot()->GetName() == wxT("response") && !outstanding.empty()) {
+			transaction << outstanding.front();
+			outstanding.pop_front();
+		}
+		else {
+			transaction << (txID - 1);
+		}
 		doc.GetRoot()->DeleteProperty(wxT("transaction_id"));
 		doc.GetRoot()->AddProperty(wxT("transaction_id"), transaction);
 
@@ -86,19 +97,35 @@ wxXmlDocument Connection::GetMessage() throw (DBGp::MalformedDocumentError, DBGp
 		wxLogDebug(wxT("Fake RX: %s"), os.GetString().c_str());
 #endif
 
-		return doc;
+		/* Round trip the document through the real parser, so that
+		 * responses are decoded and streamed exactly as they would be
+		 * when read from a socket. */
+		wxMemoryOutputStream ms;
+		doc.Save(ms, wxXML_NO_INDENTATION);
+
+		std::vector<char> payload(ms.GetSize() + 1, '\0');
+		ms.CopyTo(&payload[0], ms.GetSize());
+
+		return ParseMessage(&payload[0], ms.GetSize());
 	}
 	throw DBGp::SocketError(wxSOCKET_IOERR);
 }
 // }}}
 // {{{ DBGp::TransactionID Connection::SendCommand(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::SocketError)
 DBGp::TransactionID Connection::SendCommand(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::SocketError) {
-	return GetTransactionID();
+	DBGp::TransactionID id = GetTransactionID();
+
+	wxLogDebug(wxT("TX(%lu): %s %s"), id, command.c_str(), args.GetArguments().c_str());
+	commands.push_back(command);
+	outstanding.push_back(id);
+
+	return id;
 }
 // }}}
 // {{{ void Connection::SendCommandImmediate(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::SocketError)
 void Connection::SendCommandImmediate(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::SocketError) {
 	wxLogDebug(wxT("TX: %s %s"), command.c_str(), args.GetArguments().c_str());
+	commands.push_back(command);
 	// We need to absorb a response so it doesn't cause problems later.
 	try {
 		wxXmlDocument doc(GetMessage());
@@ -111,13 +138,5 @@ void Connection::SendCommandImmediate(const wxString &command, DBGp::MessageArgu
 	}
 }
 // }}}
-// {{{ wxXmlDocument Connection::SendCommandWait(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::EngineError, DBGp::MalformedDocumentError, DBGp::SocketError)
-wxXmlDocument Connection::SendCommandWait(const wxString &command, DBGp::MessageArguments args, const char *data, size_t dataLength) throw (DBGp::EngineError, DBGp::MalformedDocumentError, DBGp::SocketError) {
-	wxLogDebug(wxT("TX: %s %s"), command.c_str(), args.GetArguments().c_str());
-	wxXmlDocument doc(GetMessage());
-	HandleMessage(doc);
-	return doc;
-}
-// }}}
 
 // vim:set fdm=marker ts=8 sw=8 noet cin:
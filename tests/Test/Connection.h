@@ -43,18 +43,23 @@ namespace Test {
 			Connection(wxSocketBase *socket, Server *server);
 
 			void AddResponse(const wxXmlDocument &doc);
+			inline const std::list<wxString> &GetCommands() const { return commands; }
 			void ProcessNextResponse();
 
+			using DBGp::Connection::SendCommandAsync;
+			using DBGp::Connection::WaitForResponse;
+
 		protected:
 			typedef std::list<wxXmlDocument> ResponseList;
+			std::list<wxString> commands;
 			ResponseList::const_iterator currentResponse;
 			bool first;
+			std::list<DBGp::TransactionID> outstanding;
 			ResponseList responses;
 
 			wxXmlDocument GetMessage() throw (DBGp::MalformedDocumentError, DBGp::SocketError);
 			DBGp::TransactionID SendCommand(const wxString &command, DBGp::MessageArguments args, const char *data = NULL, size_t dataLength = 0) throw (DBGp::SocketError);
 			void SendCommandImmediate(const wxString &command, DBGp::MessageArguments args, const char *data = NULL, size_t dataLength = 0) throw (DBGp::SocketError);
-			wxXmlDocument SendCommandWait(const wxString &command, DBGp::MessageArguments args, const char *data = NULL, size_t dataLength = 0) throw (DBGp::EngineError, DBGp::MalformedDocumentError, DBGp::SocketError);
 	};
 }
 
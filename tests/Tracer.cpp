@@ -0,0 +1,208 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Tracer.h"
+
+#include "DBGp/Tracer.h"
+
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Tracer);
+
+// {{{ class TracingThread
+/* Records a fixed number of spans from its own thread. */
+class TracingThread : public wxThread {
+	public:
+		TracingThread(int count) : wxThread(wxTHREAD_JOINABLE), count(count) {}
+
+	protected:
+		virtual ExitCode Entry() {
+			for (int i = 0; i < count; i++) {
+				DBGp::Tracer::Record("test", "thread", 1000 + i, 1001 + i);
+			}
+			return 0;
+		}
+
+	private:
+		int count;
+};
+// }}}
+
+// {{{ static size_t CountOccurrences(const wxString &haystack, const wxString &needle)
+static size_t CountOccurrences(const wxString &haystack, const wxString &needle) {
+	size_t count = 0;
+
+	for (size_t pos = haystack.find(needle); pos != wxString::npos; pos = haystack.find(needle, pos + needle.length())) {
+		count++;
+	}
+	return count;
+}
+// }}}
+
+// {{{ void Tracer::setUp()
+void Tracer::setUp() {
+	file = wxFileName::CreateTempFileName(wxT("dubnium-trace"));
+}
+// }}}
+// {{{ void Tracer::tearDown()
+void Tracer::tearDown() {
+	if (DBGp::Tracer::IsEnabled()) {
+		DBGp::Tracer::Stop();
+	}
+	wxRemoveFile(file);
+}
+// }}}
+
+// {{{ void Tracer::testDisabled()
+void Tracer::testDisabled() {
+	CPPUNIT_ASSERT(!DBGp::Tracer::IsEnabled());
+
+	// Nothing should be recorded, and there's nothing to stop.
+	DBGp::Tracer::Record("test", "ignored", 1, 2);
+	CPPUNIT_ASSERT(!DBGp::Tracer::Stop());
+
+	DBGp::Tracer::Start(file);
+	CPPUNIT_ASSERT(DBGp::Tracer::IsEnabled());
+	CPPUNIT_ASSERT(DBGp::Tracer::Stop());
+	CPPUNIT_ASSERT(!DBGp::Tracer::IsEnabled());
+	CPPUNIT_ASSERT(ReadTrace().find(wxT("ignored")) == wxString::npos);
+}
+// }}}
+// {{{ void Tracer::testScope()
+void Tracer::testScope() {
+	{
+		DBGp::TraceScope scope("test", "before");
+	}
+
+	DBGp::Tracer::Start(file);
+	{
+		DBGp::TraceScope scope("test", "during");
+	}
+	DBGp::Tracer::Stop();
+
+	{
+		DBGp::TraceScope scope("test", "after");
+	}
+
+	wxString trace(ReadTrace());
+	CPPUNIT_ASSERT(trace.find(wxT("\"name\":\"before\"")) == wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("\"name\":\"during\",\"cat\":\"test\",\"ph\":\"X\"")) != wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("\"name\":\"after\"")) == wxString::npos);
+}
+// }}}
+// {{{ void Tracer::testThreads()
+void Tracer::testThreads() {
+	TracingThread first(10), second(20);
+
+	DBGp::Tracer::Start(file);
+	first.Create();
+	second.Create();
+	first.Run();
+	second.Run();
+	first.Wait();
+	second.Wait();
+	DBGp::Tracer::Stop();
+
+	wxString trace(ReadTrace());
+	CPPUNIT_ASSERT_EQUAL((size_t) 30, CountOccurrences(trace, wxT("\"name\":\"thread\"")));
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, CountOccurrences(trace, wxT("\"name\":\"thread_name\"")));
+}
+// }}}
+// {{{ void Tracer::testTrace()
+void Tracer::testTrace() {
+	DBGp::Tracer::Start(file);
+	DBGp::Tracer::Record("dbgp", "SendCommand", 100, 150);
+	DBGp::Tracer::Record("ui", "SetSource", 200, 190);
+	CPPUNIT_ASSERT(DBGp::Tracer::Stop());
+
+	wxString trace(ReadTrace());
+	CPPUNIT_ASSERT(trace.StartsWith(wxT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")));
+	CPPUNIT_ASSERT(trace.EndsWith(wxT("]}\n")));
+	CPPUNIT_ASSERT(trace.find(wxT("\"name\":\"SendCommand\",\"cat\":\"dbgp\",\"ph\":\"X\",\"ts\":100,\"dur\":50,")) != wxString::npos);
+
+	// Clocks that go backwards shouldn't produce negative durations.
+	CPPUNIT_ASSERT(trace.find(wxT("\"name\":\"SetSource\",\"cat\":\"ui\",\"ph\":\"X\",\"ts\":200,\"dur\":0,")) != wxString::npos);
+
+	// A new trace shouldn't include anything from the last one.
+	DBGp::Tracer::Start(file);
+	DBGp::Tracer::Record("dbgp", "GetMessage", 300, 400);
+	CPPUNIT_ASSERT(DBGp::Tracer::Stop());
+
+	trace = ReadTrace();
+	CPPUNIT_ASSERT(trace.find(wxT("SendCommand")) == wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("GetMessage")) != wxString::npos);
+}
+// }}}
+// {{{ void Tracer::testWrap()
+void Tracer::testWrap() {
+	DBGp::Tracer::Start(file, 4);
+	for (wxUint64 i = 0; i < 10; i++) {
+		DBGp::Tracer::Record("test", "wrap", i, i + 1);
+	}
+	DBGp::Tracer::Stop();
+
+	/* The oldest slot is dropped along with the overwritten events, in
+	 * case a writer was still busy with it. */
+	wxString trace(ReadTrace());
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, CountOccurrences(trace, wxT("\"name\":\"wrap\"")));
+	CPPUNIT_ASSERT(trace.find(wxT("\"ts\":6,")) == wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("\"ts\":7,")) != wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("\"ts\":9,")) != wxString::npos);
+
+	// The same goes for a buffer that has only just filled.
+	DBGp::Tracer::Start(file, 4);
+	for (wxUint64 i = 0; i < 4; i++) {
+		DBGp::Tracer::Record("test", "full", i, i + 1);
+	}
+	DBGp::Tracer::Stop();
+
+	trace = ReadTrace();
+	CPPUNIT_ASSERT_EQUAL((size_t) 3, CountOccurrences(trace, wxT("\"name\":\"full\"")));
+	CPPUNIT_ASSERT(trace.find(wxT("\"ts\":0,")) == wxString::npos);
+	CPPUNIT_ASSERT(trace.find(wxT("\"ts\":1,")) != wxString::npos);
+}
+// }}}
+
+// {{{ wxString Tracer::ReadTrace() const
+wxString Tracer::ReadTrace() const {
+	wxFFile f(file);
+	wxString trace;
+
+	CPPUNIT_ASSERT(f.IsOpened());
+	CPPUNIT_ASSERT(f.ReadAll(&trace, wxConvUTF8));
+	return trace;
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
@@ -0,0 +1,94 @@
+// {{{ Copyright notice
+/* Copyright (c) 2007-2009, Adam Harvey
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  - Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and/or other materials provided with the distribution.
+ *  - The names of its contributors may not be used to endorse or promote
+ *  products derived from this software without specific prior written
+ *  permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+// }}}
+
+#include "Transport.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(Transport);
+
+// {{{ void Transport::testDefaults()
+void Transport::testDefaults() {
+	DBGp::Transport transport;
+
+	CPPUNIT_ASSERT(transport.GetFamily() == DBGp::Transport::TCP);
+	CPPUNIT_ASSERT(transport.GetHost() == wxEmptyString);
+	CPPUNIT_ASSERT(transport.GetPort() == 9000);
+	CPPUNIT_ASSERT(transport.GetNoDelay() == true);
+	CPPUNIT_ASSERT(transport.GetQuickAck() == true);
+	CPPUNIT_ASSERT(transport.GetReceiveBufferSize() == 0);
+	CPPUNIT_ASSERT(transport.GetSendBufferSize() == 0);
+	CPPUNIT_ASSERT(transport.GetURI() == wxT("tcp://:9000"));
+}
+// }}}
+// {{{ void Transport::testInvalidPort()
+void Transport::testInvalidPort() {
+	DBGp::Transport::FromURI(wxT("tcp://localhost:90000"));
+}
+// }}}
+// {{{ void Transport::testInvalidScheme()
+void Transport::testInvalidScheme() {
+	DBGp::Transport::FromURI(wxT("udp://localhost:9000"));
+}
+// }}}
+// {{{ void Transport::testTCP()
+void Transport::testTCP() {
+	DBGp::Transport transport(DBGp::Transport::FromURI(wxT("tcp://127.0.0.1:9001")));
+	CPPUNIT_ASSERT(transport.GetFamily() == DBGp::Transport::TCP);
+	CPPUNIT_ASSERT(transport.GetHost() == wxT("127.0.0.1"));
+	CPPUNIT_ASSERT(transport.GetPort() == 9001);
+	CPPUNIT_ASSERT(transport.GetURI() == wxT("tcp://127.0.0.1:9001"));
+
+	// A bare port listens on every interface.
+	transport = DBGp::Transport::FromURI(wxT("9002"));
+	CPPUNIT_ASSERT(transport.GetFamily() == DBGp::Transport::TCP);
+	CPPUNIT_ASSERT(transport.GetHost() == wxEmptyString);
+	CPPUNIT_ASSERT(transport.GetPort() == 9002);
+
+	transport = DBGp::Transport::FromURI(wxT("tcp://:9003"));
+	CPPUNIT_ASSERT(transport.GetHost() == wxEmptyString);
+	CPPUNIT_ASSERT(transport.GetPort() == 9003);
+}
+// }}}
+// {{{ void Transport::testUnix()
+void Transport::testUnix() {
+	DBGp::Transport transport(DBGp::Transport::FromURI(wxT("unix:///tmp/dubnium.sock")));
+	CPPUNIT_ASSERT(transport.GetFamily() == DBGp::Transport::UNIX);
+	CPPUNIT_ASSERT(transport.GetPath() == wxT("/tmp/dubnium.sock"));
+	CPPUNIT_ASSERT(transport.GetURI() == wxT("unix:///tmp/dubnium.sock"));
+
+	// Switching back to TCP keeps the other options.
+	transport.SetNoDelay(false);
+	transport.SetPort(9000);
+	CPPUNIT_ASSERT(transport.GetFamily() == DBGp::Transport::TCP);
+	CPPUNIT_ASSERT(transport.GetNoDelay() == false);
+}
+// }}}
+
+// vim:set fdm=marker ts=8 sw=8 noet cin:
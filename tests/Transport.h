@@ -29,24 +29,31 @@
  */
 // }}}
 
-#include "PropertyTreeItem.h"
+#ifndef TEST_TRANSPORT_H
+#define TEST_TRANSPORT_H
 
-// {{{ PropertyTreeItem::PropertyTreeItem(const DBGp::Property *prop)
-PropertyTreeItem::PropertyTreeItem(const DBGp::Property *prop) : wxTreeItemData() {
-	// Take our own copy of the property to avoid any problems.
-	this->prop = new DBGp::Property(*prop);
-}
-// }}}
-// {{{ PropertyTreeItem::~PropertyTreeItem()
-PropertyTreeItem::~PropertyTreeItem() {
-	delete prop;
-}
-// }}}
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestFixture.h>
 
-// {{{ DBGp::Property *PropertyTreeItem::GetProperty()
-DBGp::Property *PropertyTreeItem::GetProperty() {
-	return prop;
-}
-// }}}
+#include "DBGp/Transport.h"
+
+class Transport : public CppUnit::TestFixture {
+	CPPUNIT_TEST_SUITE(Transport);
+	CPPUNIT_TEST(testDefaults);
+	CPPUNIT_TEST_EXCEPTION(testInvalidPort, DBGp::Error);
+	CPPUNIT_TEST_EXCEPTION(testInvalidScheme, DBGp::Error);
+	CPPUNIT_TEST(testTCP);
+	CPPUNIT_TEST(testUnix);
+	CPPUNIT_TEST_SUITE_END();
+
+	public:
+		void testDefaults();
+		void testInvalidPort();
+		void testInvalidScheme();
+		void testTCP();
+		void testUnix();
+};
+
+#endif
 
 // vim:set fdm=marker ts=8 sw=8 noet cin:
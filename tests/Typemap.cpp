@@ -92,5 +92,15 @@ void Typemap::testGetTypes() {
 	CPPUNIT_ASSERT(i->second.GetXsiType() == wxEmptyString);
 }
 // }}}
+// {{{ void Typemap::testTryGetType()
+void Typemap::testTryGetType() {
+	DBGp::Type type;
+	CPPUNIT_ASSERT(typemap->TryGetType(wxT("bool"), type) == true);
+	CPPUNIT_ASSERT(type.GetCommonType() == DBGp::Type::BOOL);
+
+	CPPUNIT_ASSERT(typemap->TryGetType(wxT("does not exist"), type) == false);
+	CPPUNIT_ASSERT(type.GetCommonType() == DBGp::Type::BOOL);
+}
+// }}}
 
 // vim:set fdm=marker ts=8 sw=8 noet cin:
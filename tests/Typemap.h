@@ -40,6 +40,7 @@ class Typemap : public DBGpFixture {
 	CPPUNIT_TEST_EXCEPTION(testGetMissingType, DBGp::NotFoundError);
 	CPPUNIT_TEST(testGetType);
 	CPPUNIT_TEST(testGetTypes);
+	CPPUNIT_TEST(testTryGetType);
 	CPPUNIT_TEST_SUITE_END();
 
 	public:
@@ -50,6 +51,7 @@ class Typemap : public DBGpFixture {
 		void testGetMissingType();
 		void testGetType();
 		void testGetTypes();
+		void testTryGetType();
 
 	protected:
 		DBGp::Typemap *typemap;